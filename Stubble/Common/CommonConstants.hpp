@@ -8,12 +8,42 @@ namespace Stubble
 
 static const char * FRAME_FILE_ID = "STUBBLE0001FRAMEFILE"; ///< Identifier for the frame file
 
-static const char * VOXEL_FILE_ID = "STUBBLE0001VOXELFILE"; ///< Identifier for the voxel file
+static const char * VOXEL_FILE_ID = "STUBBLE0002VOXELFILE"; ///< Identifier for the voxel file
+
+static const char * UNBAKED_VOXEL_FILE_ID = "STUBBLE0001VOXELFILE"; ///< Identifier for the voxel file without baked roots flag
 
 static const unsigned __int32 FRAME_FILE_ID_SIZE = sizeof( char ) * 20; ///< Size of the frame file identifier
 
 static const unsigned __int32 VOXEL_FILE_ID_SIZE = sizeof( char ) * 20; ///< Size of the voxel file identifier
 
+static const char * SECTIONED_FRAME_FILE_ID = "STUBBLE0003FRAMEFILE"; ///< Identifier for the sectioned frame file
+
+static const char * UNVERSIONED_SECTIONED_FRAME_FILE_ID = "STUBBLE0002FRAMEFILE"; ///< Identifier for the sectioned frame file without properties version ( not supported )
+
+static const char * SECTIONED_VOXEL_FILE_ID = "STUBBLE0004VOXELFILE"; ///< Identifier for the sectioned voxel file
+
+static const char * NARROW_SECTIONED_VOXEL_FILE_ID = "STUBBLE0003VOXELFILE"; ///< Identifier for the sectioned voxel file with 32 bit hair counts
+
+static const unsigned __int32 ZIPPED_SCALAR_PROPERTIES_VERSION = 1; ///< Layout of non-texture hair properties in zipped frame file
+
+static const unsigned __int32 UNSPLIT_SCALAR_PROPERTIES_VERSION = 2;	///< Layout of non-texture hair properties without procedural split limits
+
+static const unsigned __int32 SCALAR_PROPERTIES_VERSION = 3;	///< Current layout of non-texture hair properties
+
+///-------------------------------------------------------------------------------------------------
+/// Identifiers of sections of sectioned frame and voxel files ( see SectionedFileWriter ).
+///-------------------------------------------------------------------------------------------------
+enum FileSectionId
+{
+	TEXTURES_SECTION = 1,	///< All textures of hair properties ( uncompressed, used in place )
+	INTERPOLATION_GROUPS_SECTION,	///< Segments count of interpolation groups
+	SCALAR_PROPERTIES_SECTION,  ///< Non-texture hair properties
+	REST_POSITIONS_SECTION, ///< Rest positions of guides
+	GUIDES_SEGMENTS_SECTION,	///< Segments of guides ( uncompressed )
+	VOXEL_SECTION,  ///< Voxel data ( see Voxelization::exportVoxel )
+	KD_FOREST_SECTION   ///< Balanced KD trees of guides rest positions ( see RestPositionsDS )
+};
+
 static const unsigned __int32 BUFFER_SIZE = 1 << 24;	///< Size of the buffer for gzip
 
 static const unsigned __int32 COMPRESSION = 3;  ///< The compression quality of gzip ( 1 = FASTEST - 9 = BEST )
@@ -118,6 +118,45 @@ inline void copyToLastAndFirst( tType * aData, unsigned __int32 aCount )
   *( aData + aCount - 1 ) = *( aData + aCount - 2 ); 
 }
 
+///-------------------------------------------------------------------------------------------------
+/// Multiplies two counts ( hair, points, buffer sizes ) in 64 bits. 
+///
+/// \param	aFirst	The first count. 
+/// \param	aSecond	The second count. 
+///
+/// \exception	StubbleException	Thrown when product does not fit into 64 bits. 
+///
+/// \return	The product of counts. 
+///-------------------------------------------------------------------------------------------------
+inline unsigned __int64 multiplyCounts( unsigned __int64 aFirst, unsigned __int64 aSecond )
+{
+	if ( aSecond != 0 && aFirst > static_cast< unsigned __int64 >( -1 ) / aSecond )
+	{
+		throw StubbleException( " multiplyCounts : count does not fit into 64 bits ! " );
+	}
+	return aFirst * aSecond;
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Converts 64 bit count to narrower type ( size_t of allocation, 32 bit count of renderer ). 
+///
+/// \param	aCount	The count. 
+///
+/// \exception	StubbleException	Thrown when count can not be represented by target type. 
+///
+/// \return	The converted count. 
+///-------------------------------------------------------------------------------------------------
+template< typename tType >
+inline tType narrowCount( unsigned __int64 aCount )
+{
+	const tType result = static_cast< tType >( aCount );
+	if ( result < tType() || static_cast< unsigned __int64 >( result ) != aCount )
+	{
+		throw StubbleException( " narrowCount : count does not fit into target type ! " );
+	}
+	return result;
+}
+
 ///-------------------------------------------------------------------------------------------------
 /// Mix 2 colors. 
 ///
@@ -298,7 +337,7 @@ inline void serializePrimitives( const std::vector< Type > &aVector, std::ostrea
 	unsigned __int32 size = static_cast< unsigned __int32 >( aVector.size() );
 	aOutputStream.write( reinterpret_cast< const char * >( &size ), sizeof( unsigned __int32 ) );
 	// For every member
-	std::vector< Type >::const_iterator it;
+	typename std::vector< Type >::const_iterator it;
 	for ( it = aVector.begin(); it != aVector.end(); ++it ) // store the individual elements
 	{		
 		serialize( *it, aOutputStream );
@@ -318,7 +357,7 @@ inline void serializeObjects( const std::vector< Type > &aVector, std::ostream &
 	unsigned __int32 size = static_cast< unsigned __int32 >( aVector.size() );
 	aOutputStream.write( reinterpret_cast< const char * >( &size ), sizeof( unsigned __int32 ) );
 	// For every member
-	std::vector< Type >::const_iterator it;
+	typename std::vector< Type >::const_iterator it;
 	for ( it = aVector.begin(); it != aVector.end(); ++it ) // store the individual elements
 	{		
 		it->serialize( aOutputStream );
@@ -374,7 +413,7 @@ inline void deserializePrimitives( std::vector< Type > & aVector, std::istream &
 	aInputStream.read( reinterpret_cast< char * >( &size ), sizeof( unsigned __int32 ) );
 	// Resize vector
 	aVector.resize( size );
-	std::vector< Type >::iterator it;
+	typename std::vector< Type >::iterator it;
 	for ( it = aVector.begin(); it != aVector.end(); ++it ) // store the individual elements
 	{	
 		deserialize( *it, aInputStream );
@@ -395,7 +434,7 @@ inline void deserializeObjects( std::vector< Type > & aVector, std::istream & aI
 	aInputStream.read( reinterpret_cast< char * >( &size ), sizeof( unsigned __int32 ) );
 	// Resize vector
 	aVector.resize( size );
-	std::vector< Type >::iterator it;
+	typename std::vector< Type >::iterator it;
 	for ( it = aVector.begin(); it != aVector.end(); ++it ) // store the individual elements
 	{	
 		it->deserialize( aInputStream );
@@ -0,0 +1,182 @@
+#ifndef STUBBLE_CRITICAL_SECTION_HPP
+#define STUBBLE_CRITICAL_SECTION_HPP
+
+#ifndef NOMINMAX
+#define NOMINMAX  // windows.h: don't define min() and max() macros!
+#endif
+#include <windows.h>
+
+namespace Stubble
+{
+
+///-------------------------------------------------------------------------------------------------
+/// Critical section guarding state shared by threads, which are not created by Stubble ( renderer
+/// threads calling procedurals ), so OpenMP locks can not be used.
+///-------------------------------------------------------------------------------------------------
+class CriticalSection
+{
+public:
+
+	///-------------------------------------------------------------------------------------------------
+	/// Default constructor.
+	///-------------------------------------------------------------------------------------------------
+	inline CriticalSection();
+
+	///-------------------------------------------------------------------------------------------------
+	/// Finaliser.
+	///-------------------------------------------------------------------------------------------------
+	inline ~CriticalSection();
+
+	///-------------------------------------------------------------------------------------------------
+	/// Enters the critical section.
+	///-------------------------------------------------------------------------------------------------
+	inline void lock();
+
+	///-------------------------------------------------------------------------------------------------
+	/// Leaves the critical section.
+	///-------------------------------------------------------------------------------------------------
+	inline void unlock();
+
+private:
+
+	///-------------------------------------------------------------------------------------------------
+	/// Copy constructor ( not allowed ).
+	///-------------------------------------------------------------------------------------------------
+	CriticalSection( const CriticalSection & );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Assignment operator ( not allowed ).
+	///-------------------------------------------------------------------------------------------------
+	CriticalSection & operator=( const CriticalSection & );
+
+	CRITICAL_SECTION mCriticalSection;  ///< The critical section
+
+	friend class ConditionVariable;
+};
+
+///-------------------------------------------------------------------------------------------------
+/// Condition variable used together with critical section to wait until state guarded by the
+/// critical section is changed by another thread.
+///-------------------------------------------------------------------------------------------------
+class ConditionVariable
+{
+public:
+
+	///-------------------------------------------------------------------------------------------------
+	/// Default constructor.
+	///-------------------------------------------------------------------------------------------------
+	inline ConditionVariable();
+
+	///-------------------------------------------------------------------------------------------------
+	/// Leaves the critical section, waits until the variable is notified and enters the critical
+	/// section again. Waiting can end spuriously, so the caller must check the state again.
+	///
+	/// \param [in,out]	aCriticalSection	The held critical section.
+	///-------------------------------------------------------------------------------------------------
+	inline void wait( CriticalSection & aCriticalSection );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Wakes all waiting threads.
+	///-------------------------------------------------------------------------------------------------
+	inline void notifyAll();
+
+private:
+
+	///-------------------------------------------------------------------------------------------------
+	/// Copy constructor ( not allowed ).
+	///-------------------------------------------------------------------------------------------------
+	ConditionVariable( const ConditionVariable & );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Assignment operator ( not allowed ).
+	///-------------------------------------------------------------------------------------------------
+	ConditionVariable & operator=( const ConditionVariable & );
+
+	CONDITION_VARIABLE mConditionVariable;  ///< The condition variable
+};
+
+///-------------------------------------------------------------------------------------------------
+/// Holds critical section for the lifetime of the object ( even if exception is thrown ).
+///-------------------------------------------------------------------------------------------------
+class ScopedLock
+{
+public:
+
+	///-------------------------------------------------------------------------------------------------
+	/// Constructor. Enters the critical section.
+	///
+	/// \param [in,out]	aCriticalSection	The critical section.
+	///-------------------------------------------------------------------------------------------------
+	inline ScopedLock( CriticalSection & aCriticalSection );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Finaliser. Leaves the critical section.
+	///-------------------------------------------------------------------------------------------------
+	inline ~ScopedLock();
+
+private:
+
+	///-------------------------------------------------------------------------------------------------
+	/// Copy constructor ( not allowed ).
+	///-------------------------------------------------------------------------------------------------
+	ScopedLock( const ScopedLock & );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Assignment operator ( not allowed ).
+	///-------------------------------------------------------------------------------------------------
+	ScopedLock & operator=( const ScopedLock & );
+
+	CriticalSection & mCriticalSection; ///< The held critical section
+};
+
+// inline functions implementation
+
+inline CriticalSection::CriticalSection()
+{
+	InitializeCriticalSection( &mCriticalSection );
+}
+
+inline CriticalSection::~CriticalSection()
+{
+	DeleteCriticalSection( &mCriticalSection );
+}
+
+inline void CriticalSection::lock()
+{
+	EnterCriticalSection( &mCriticalSection );
+}
+
+inline void CriticalSection::unlock()
+{
+	LeaveCriticalSection( &mCriticalSection );
+}
+
+inline ConditionVariable::ConditionVariable()
+{
+	InitializeConditionVariable( &mConditionVariable );
+}
+
+inline void ConditionVariable::wait( CriticalSection & aCriticalSection )
+{
+	SleepConditionVariableCS( &mConditionVariable, &aCriticalSection.mCriticalSection, INFINITE );
+}
+
+inline void ConditionVariable::notifyAll()
+{
+	WakeAllConditionVariable( &mConditionVariable );
+}
+
+inline ScopedLock::ScopedLock( CriticalSection & aCriticalSection ):
+	mCriticalSection( aCriticalSection )
+{
+	mCriticalSection.lock();
+}
+
+inline ScopedLock::~ScopedLock()
+{
+	mCriticalSection.unlock();
+}
+
+} // namespace Stubble
+
+#endif // STUBBLE_CRITICAL_SECTION_HPP
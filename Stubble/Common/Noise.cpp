@@ -0,0 +1,199 @@
+#include "Noise.hpp"
+
+#include <cstring>
+#include <emmintrin.h>
+
+namespace Stubble
+{
+
+namespace
+{
+
+///-------------------------------------------------------------------------------------------------
+/// Multiplies 32 bit integers and keeps lower 32 bits of results ( SSE2 has no such instruction ).
+///
+/// \param	aA	The first factors.
+/// \param	aB	The second factors.
+///
+/// \return	The products.
+///-------------------------------------------------------------------------------------------------
+inline __m128i multiply( __m128i aA, __m128i aB )
+{
+	const __m128i even = _mm_mul_epu32( aA, aB );
+	const __m128i odd = _mm_mul_epu32( _mm_srli_si128( aA, 4 ), _mm_srli_si128( aB, 4 ) );
+	return _mm_unpacklo_epi32( _mm_shuffle_epi32( even, _MM_SHUFFLE( 0, 0, 2, 0 ) ),
+		_mm_shuffle_epi32( odd, _MM_SHUFFLE( 0, 0, 2, 0 ) ) );
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Selects values by mask.
+///
+/// \param	aMask	The mask.
+/// \param	aTrue	The values selected where mask is set.
+/// \param	aFalse	The values selected where mask is not set.
+///
+/// \return	The selected values.
+///-------------------------------------------------------------------------------------------------
+inline __m128 select( __m128 aMask, __m128 aTrue, __m128 aFalse )
+{
+	return _mm_or_ps( _mm_and_ps( aMask, aTrue ), _mm_andnot_ps( aMask, aFalse ) );
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Calculates improved Perlin noise fade curve 6t^5 - 15t^4 + 10t^3.
+///
+/// \param	aT	The position in lattice cell.
+///
+/// \return	The faded position.
+///-------------------------------------------------------------------------------------------------
+inline __m128 fade( __m128 aT )
+{
+	const __m128 poly = _mm_add_ps( _mm_mul_ps( aT, _mm_sub_ps( _mm_mul_ps( aT, _mm_set1_ps( 6.0f ) ),
+		_mm_set1_ps( 15.0f ) ) ), _mm_set1_ps( 10.0f ) );
+	return _mm_mul_ps( _mm_mul_ps( _mm_mul_ps( aT, aT ), aT ), poly );
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Linearly interpolates values.
+///
+/// \param	aT	The interpolation parameter.
+/// \param	aA	The values at 0.
+/// \param	aB	The values at 1.
+///
+/// \return	The interpolated values.
+///-------------------------------------------------------------------------------------------------
+inline __m128 lerp( __m128 aT, __m128 aA, __m128 aB )
+{
+	return _mm_add_ps( aA, _mm_mul_ps( aT, _mm_sub_ps( aB, aA ) ) );
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Selects gradient by hash of lattice point and calculates its dot product with offset from
+/// lattice point.
+///
+/// \param	aHash	The hash of lattice point.
+/// \param	aX		The x coordinate of offset.
+/// \param	aY		The y coordinate of offset.
+/// \param	aZ		The z coordinate of offset.
+///
+/// \return	The dot products.
+///-------------------------------------------------------------------------------------------------
+inline __m128 gradient( __m128i aHash, __m128 aX, __m128 aY, __m128 aZ )
+{
+	// Finalize hash
+	__m128i h = _mm_xor_si128( aHash, _mm_srli_epi32( aHash, 16 ) );
+	h = multiply( h, _mm_set1_epi32( 0x7feb352d ) );
+	h = _mm_xor_si128( h, _mm_srli_epi32( h, 15 ) );
+	h = multiply( h, _mm_set1_epi32( static_cast< int >( 0x846ca68b ) ) );
+	h = _mm_xor_si128( h, _mm_srli_epi32( h, 16 ) );
+	h = _mm_and_si128( h, _mm_set1_epi32( 15 ) );
+	// Same gradients as improved Perlin noise : u = h < 8 ? x : y, v = h < 4 ? y : h == 12 || h == 14 ? x : z
+	const __m128 u = select( _mm_castsi128_ps( _mm_cmplt_epi32( h, _mm_set1_epi32( 8 ) ) ), aX, aY );
+	const __m128 isX = _mm_castsi128_ps( _mm_or_si128( _mm_cmpeq_epi32( h, _mm_set1_epi32( 12 ) ),
+		_mm_cmpeq_epi32( h, _mm_set1_epi32( 14 ) ) ) );
+	const __m128 v = select( _mm_castsi128_ps( _mm_cmplt_epi32( h, _mm_set1_epi32( 4 ) ) ), aY,
+		select( isX, aX, aZ ) );
+	// Signs of u and v are selected by the lowest two bits of hash
+	const __m128 uSign = _mm_castsi128_ps( _mm_slli_epi32( _mm_and_si128( h, _mm_set1_epi32( 1 ) ), 31 ) );
+	const __m128 vSign = _mm_castsi128_ps( _mm_slli_epi32( _mm_and_si128( h, _mm_set1_epi32( 2 ) ), 30 ) );
+	return _mm_add_ps( _mm_xor_ps( u, uSign ), _mm_xor_ps( v, vSign ) );
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Splits coordinates to lattice cell and position in cell.
+///
+/// \param	aCoordinates				The coordinates.
+/// \param [in,out]	aCell				The lattice cell ( floor of coordinates ).
+/// \param [in,out]	aPositionInCell		The position in lattice cell <0,1).
+///-------------------------------------------------------------------------------------------------
+inline void splitCoordinates( __m128 aCoordinates, __m128i & aCell, __m128 & aPositionInCell )
+{
+	// Truncation rounds negative coordinates up, so one must be subtracted from them
+	const __m128i truncated = _mm_cvttps_epi32( aCoordinates );
+	const __m128 isRoundedUp = _mm_cmplt_ps( aCoordinates, _mm_cvtepi32_ps( truncated ) );
+	aCell = _mm_add_epi32( truncated, _mm_castps_si128( isRoundedUp ) ); // Mask is -1
+	aPositionInCell = _mm_sub_ps( aCoordinates, _mm_cvtepi32_ps( aCell ) );
+}
+
+} // unnamed namespace
+
+const unsigned __int32 Noise::SEEDS[ 3 ] = { 0x2545f491, 0x9e3779b9, 0x6a09e667 };
+
+void Noise::evaluate( const float * aPoints, unsigned __int32 aCount, float * aResults )
+{
+	// Full batches
+	for ( ; aCount >= BATCH_SIZE; aCount -= BATCH_SIZE, aPoints += 3 * BATCH_SIZE, aResults += 3 * BATCH_SIZE )
+	{
+		evaluateBatch( aPoints, aResults );
+	}
+	if ( aCount == 0 )
+	{
+		return;
+	}
+	// Remaining points are evaluated in batch padded by zeros
+	float points[ 3 * BATCH_SIZE ] = { 0 }, results[ 3 * BATCH_SIZE ];
+	memcpy( points, aPoints, sizeof( float ) * 3 * aCount );
+	evaluateBatch( points, results );
+	memcpy( aResults, results, sizeof( float ) * 3 * aCount );
+}
+
+void Noise::evaluateBatch( const float * aPoints, float * aResults )
+{
+	// Transpose points to vectors of coordinates
+	const __m128 x = _mm_setr_ps( aPoints[ 0 ], aPoints[ 3 ], aPoints[ 6 ], aPoints[ 9 ] );
+	const __m128 y = _mm_setr_ps( aPoints[ 1 ], aPoints[ 4 ], aPoints[ 7 ], aPoints[ 10 ] );
+	const __m128 z = _mm_setr_ps( aPoints[ 2 ], aPoints[ 5 ], aPoints[ 8 ], aPoints[ 11 ] );
+	// Select lattice cells and positions in them
+	__m128i cellX, cellY, cellZ;
+	__m128 x0, y0, z0;
+	splitCoordinates( x, cellX, x0 );
+	splitCoordinates( y, cellY, y0 );
+	splitCoordinates( z, cellZ, z0 );
+	const __m128 one = _mm_set1_ps( 1.0f );
+	const __m128 x1 = _mm_sub_ps( x0, one );
+	const __m128 y1 = _mm_sub_ps( y0, one );
+	const __m128 z1 = _mm_sub_ps( z0, one );
+	const __m128 u = fade( x0 );
+	const __m128 v = fade( y0 );
+	const __m128 w = fade( z0 );
+	// Hash parts of lattice coordinates, ( c + 1 ) * prime = c * prime + prime
+	const __m128i xPrime = _mm_set1_epi32( static_cast< int >( 0x8da6b343 ) );
+	const __m128i yPrime = _mm_set1_epi32( static_cast< int >( 0xd8163841 ) );
+	const __m128i zPrime = _mm_set1_epi32( static_cast< int >( 0xcb1ab31f ) );
+	const __m128i hashX0 = multiply( cellX, xPrime ), hashX1 = _mm_add_epi32( hashX0, xPrime );
+	const __m128i hashY0 = multiply( cellY, yPrime ), hashY1 = _mm_add_epi32( hashY0, yPrime );
+	const __m128i hashZ0 = multiply( cellZ, zPrime ), hashZ1 = _mm_add_epi32( hashZ0, zPrime );
+	// For every noise component
+	for ( unsigned __int32 i = 0; i < 3; ++i )
+	{
+		const __m128i seed = _mm_set1_epi32( static_cast< int >( SEEDS[ i ] ) );
+		const __m128i hashX0Y0 = _mm_xor_si128( _mm_xor_si128( seed, hashX0 ), hashY0 );
+		const __m128i hashX1Y0 = _mm_xor_si128( _mm_xor_si128( seed, hashX1 ), hashY0 );
+		const __m128i hashX0Y1 = _mm_xor_si128( _mm_xor_si128( seed, hashX0 ), hashY1 );
+		const __m128i hashX1Y1 = _mm_xor_si128( _mm_xor_si128( seed, hashX1 ), hashY1 );
+		// Blend gradients of cell corners
+		const __m128 noise = lerp( w,
+			lerp( v,
+				lerp( u, gradient( _mm_xor_si128( hashX0Y0, hashZ0 ), x0, y0, z0 ),
+					gradient( _mm_xor_si128( hashX1Y0, hashZ0 ), x1, y0, z0 ) ),
+				lerp( u, gradient( _mm_xor_si128( hashX0Y1, hashZ0 ), x0, y1, z0 ),
+					gradient( _mm_xor_si128( hashX1Y1, hashZ0 ), x1, y1, z0 ) ) ),
+			lerp( v,
+				lerp( u, gradient( _mm_xor_si128( hashX0Y0, hashZ1 ), x0, y0, z1 ),
+					gradient( _mm_xor_si128( hashX1Y0, hashZ1 ), x1, y0, z1 ) ),
+				lerp( u, gradient( _mm_xor_si128( hashX0Y1, hashZ1 ), x0, y1, z1 ),
+					gradient( _mm_xor_si128( hashX1Y1, hashZ1 ), x1, y1, z1 ) ) ) );
+		// Map <-1,1> to <0,1>
+		const __m128 half = _mm_set1_ps( 0.5f );
+		const __m128 result = _mm_min_ps( _mm_max_ps( _mm_add_ps( _mm_mul_ps( noise, half ), half ),
+			_mm_setzero_ps() ), one );
+		float results[ BATCH_SIZE ];
+		_mm_storeu_ps( results, result );
+		for ( unsigned __int32 j = 0; j < BATCH_SIZE; ++j )
+		{
+			aResults[ 3 * j + i ] = results[ j ];
+		}
+	}
+}
+
+} // namespace Stubble
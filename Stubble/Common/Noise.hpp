@@ -0,0 +1,68 @@
+#ifndef STUBBLE_NOISE_HPP
+#define STUBBLE_NOISE_HPP
+
+#include "CommonTypes.hpp"
+
+namespace Stubble
+{
+
+///-------------------------------------------------------------------------------------------------
+/// Deterministic three dimensional gradient noise with three components, used by frizz and kink
+/// instead of renderer noise ( RxNoise ). Hair generated by RenderMan DSO, mental ray shader and
+/// Maya viewport are thus identical and hair generator does not depend on renderer library.
+/// Noise is improved Perlin noise, but gradients are selected by hash of lattice point instead of
+/// permutation table, so points are evaluated in batches of BATCH_SIZE points by SSE2 code.
+/// Seed layout : component i of result is noise with seed SEEDS[ i ]. Hash of lattice point is
+/// h = seed ^ x * 0x8da6b343 ^ y * 0xd8163841 ^ z * 0xcb1ab31f ( 32 bit unsigned arithmetic )
+/// followed by h ^= h >> 16, h *= 0x7feb352d, h ^= h >> 15, h *= 0x846ca68b, h ^= h >> 16 and the
+/// lowest 4 bits of h select one of the 16 gradients of improved Perlin noise. Noise in <-1,1> is
+/// mapped to <0,1> ( same range as RxNoise ).
+/// Every point is evaluated by the same code, so result does not depend on number of points
+/// evaluated at once.
+///-------------------------------------------------------------------------------------------------
+class Noise
+{
+public:
+
+	///-------------------------------------------------------------------------------------------------
+	/// Evaluates noise at single point.
+	///
+	/// \param	aPoint				The point ( x, y, z ).
+	/// \param [in,out]	aResult		The three noise components in <0,1>.
+	///-------------------------------------------------------------------------------------------------
+	inline static void evaluate( const float * aPoint, float * aResult );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Evaluates noise at multiple points.
+	///
+	/// \param	aPoints				The points ( x, y, z triples ).
+	/// \param	aCount				Number of points.
+	/// \param [in,out]	aResults	The three noise components of every point in <0,1>.
+	///-------------------------------------------------------------------------------------------------
+	static void evaluate( const float * aPoints, unsigned __int32 aCount, float * aResults );
+
+	static const unsigned __int32 BATCH_SIZE = 4;   ///< Number of points evaluated at once
+
+	static const unsigned __int32 SEEDS[ 3 ];   ///< The seeds of noise components
+
+private:
+
+	///-------------------------------------------------------------------------------------------------
+	/// Evaluates noise at BATCH_SIZE points.
+	///
+	/// \param	aPoints				The points ( x, y, z triples ).
+	/// \param [in,out]	aResults	The three noise components of every point.
+	///-------------------------------------------------------------------------------------------------
+	static void evaluateBatch( const float * aPoints, float * aResults );
+};
+
+// inline functions implementation
+
+inline void Noise::evaluate( const float * aPoint, float * aResult )
+{
+	evaluate( aPoint, 1, aResult );
+}
+
+} // namespace Stubble
+
+#endif // STUBBLE_NOISE_HPP
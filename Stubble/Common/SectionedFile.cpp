@@ -0,0 +1,354 @@
+#define NOMINMAX  // windows.h: don't define min() and max() macros!
+#include "SectionedFile.hpp"
+
+#include "StubbleException.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <windows.h>
+#include <zlib.h>
+
+namespace Stubble
+{
+
+SectionedFileWriter::SectionedFileWriter( const char * aFileId, int aCompressionLevel ):
+	mCompressionLevel( aCompressionLevel ),
+	mIsSectionOpened( false )
+{
+	memcpy( mFileId, aFileId, FILE_ID_SIZE );
+}
+
+std::ostream & SectionedFileWriter::beginSection( unsigned __int32 aSectionId, bool aCompressed )
+{
+	if ( mIsSectionOpened )
+	{
+		throw StubbleException( " SectionedFileWriter::beginSection : previous section has not been ended ! " );
+	}
+	mSections.push_back( Section() );
+	mSections.back().mId = aSectionId;
+	mSections.back().mCompressed = aCompressed;
+	mCurrentSection.str( "" );
+	mCurrentSection.clear();
+	mIsSectionOpened = true;
+	return mCurrentSection;
+}
+
+void SectionedFileWriter::endSection()
+{
+	if ( !mIsSectionOpened )
+	{
+		throw StubbleException( " SectionedFileWriter::endSection : no section has been begun ! " );
+	}
+	mIsSectionOpened = false;
+	Section & section = mSections.back();
+	section.mData = mCurrentSection.str();
+	section.mSize = section.mData.size();
+	mCurrentSection.str( "" );
+	if ( section.mCompressed && section.mSize > 2 * PARALLEL_BLOCK_SIZE )
+	{
+		std::string compressed;
+		compressInBlocks( section.mData, mCompressionLevel, compressed );
+		section.mData.swap( compressed );
+	}
+	else if ( section.mCompressed )
+	{
+		// Compress whole section at once
+		uLongf compressedSize = compressBound( static_cast< uLong >( section.mSize ) );
+		std::string compressed( compressedSize, 0 );
+		if ( compress2( reinterpret_cast< Bytef * >( &compressed[ 0 ] ), &compressedSize,
+			reinterpret_cast< const Bytef * >( section.mData.data() ), static_cast< uLong >( section.mSize ),
+			mCompressionLevel ) != Z_OK )
+		{
+			throw StubbleException( " SectionedFileWriter::endSection : section compression failed ! " );
+		}
+		compressed.resize( compressedSize );
+		section.mData.swap( compressed );
+	}
+}
+
+void SectionedFileWriter::writeToFile( std::ostream & aOutputStream ) const
+{
+	if ( mIsSectionOpened )
+	{
+		throw StubbleException( " SectionedFileWriter::writeToFile : last section has not been ended ! " );
+	}
+	// Write file id and section table
+	aOutputStream.write( mFileId, FILE_ID_SIZE );
+	unsigned __int32 sectionsCount = static_cast< unsigned __int32 >( mSections.size() );
+	aOutputStream.write( reinterpret_cast< const char * >( &sectionsCount ), sizeof( unsigned __int32 ) );
+	unsigned __int64 headerSize = FILE_ID_SIZE + sizeof( unsigned __int32 ) +
+		sectionsCount * ( 2 * sizeof( unsigned __int32 ) + 3 * sizeof( unsigned __int64 ) );
+	// First section starts right after aligned header
+	unsigned __int64 offset = ( headerSize + SECTION_ALIGNMENT - 1 ) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+	for ( Sections::const_iterator it = mSections.begin(); it != mSections.end(); ++it )
+	{
+		unsigned __int32 compressed = it->mCompressed ? 1 : 0;
+		unsigned __int64 storedSize = it->mData.size();
+		aOutputStream.write( reinterpret_cast< const char * >( &it->mId ), sizeof( unsigned __int32 ) );
+		aOutputStream.write( reinterpret_cast< const char * >( &compressed ), sizeof( unsigned __int32 ) );
+		aOutputStream.write( reinterpret_cast< const char * >( &offset ), sizeof( unsigned __int64 ) );
+		aOutputStream.write( reinterpret_cast< const char * >( &storedSize ), sizeof( unsigned __int64 ) );
+		aOutputStream.write( reinterpret_cast< const char * >( &it->mSize ), sizeof( unsigned __int64 ) );
+		offset += ( storedSize + SECTION_ALIGNMENT - 1 ) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+	}
+	writePadding( aOutputStream, headerSize, SECTION_ALIGNMENT );
+	// Write aligned sections
+	for ( Sections::const_iterator it = mSections.begin(); it != mSections.end(); ++it )
+	{
+		aOutputStream.write( it->mData.data(), it->mData.size() );
+		writePadding( aOutputStream, it->mData.size(), SECTION_ALIGNMENT );
+	}
+}
+
+void SectionedFileWriter::compressInBlocks( const std::string & aData, int aCompressionLevel, std::string & aCompressed )
+{
+	static const size_t WINDOW_SIZE = 32 * 1024; // Deflate window size
+	static const uLong FLUSH_RESERVE = 16; // Space for empty stored block written by sync flush
+	const int blocksCount = static_cast< int >( ( aData.size() + PARALLEL_BLOCK_SIZE - 1 ) / PARALLEL_BLOCK_SIZE );
+	std::vector< std::string > blocks( blocksCount );
+	std::vector< uLong > checksums( blocksCount );
+	std::vector< int > succeeded( blocksCount, 0 );
+	#ifdef _OPENMP
+	#pragma omp parallel for schedule( dynamic )
+	#endif
+	for ( int i = 0; i < blocksCount; ++i )
+	{
+		const size_t start = static_cast< size_t >( i ) * PARALLEL_BLOCK_SIZE;
+		const uInt blockSize = static_cast< uInt >( std::min< size_t >( PARALLEL_BLOCK_SIZE, aData.size() - start ) );
+		const Bytef * input = reinterpret_cast< const Bytef * >( aData.data() ) + start;
+		const bool isLast = i == blocksCount - 1;
+		checksums[ i ] = adler32( adler32( 0, Z_NULL, 0 ), input, blockSize );
+		// Raw deflate, zlib header and trailer are written only once for all blocks
+		z_stream stream;
+		memset( &stream, 0, sizeof( z_stream ) );
+		if ( deflateInit2( &stream, aCompressionLevel, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY ) != Z_OK )
+		{
+			continue;
+		}
+		// Last window of previous block is used as dictionary, so the compression ratio is kept
+		if ( i > 0 )
+		{
+			const uInt dictionarySize = static_cast< uInt >( std::min( start, WINDOW_SIZE ) );
+			deflateSetDictionary( &stream, input - dictionarySize, dictionarySize );
+		}
+		std::string & block = blocks[ i ];
+		block.resize( deflateBound( &stream, blockSize ) + FLUSH_RESERVE );
+		stream.next_in = const_cast< Bytef * >( input );
+		stream.avail_in = blockSize;
+		stream.next_out = reinterpret_cast< Bytef * >( &block[ 0 ] );
+		stream.avail_out = static_cast< uInt >( block.size() );
+		// Sync flush ends block at byte boundary, so the next block can be appended
+		int status = deflate( &stream, isLast ? Z_FINISH : Z_SYNC_FLUSH );
+		succeeded[ i ] = isLast ? status == Z_STREAM_END :
+			status == Z_OK && stream.avail_in == 0 && stream.avail_out > 0;
+		block.resize( stream.total_out );
+		deflateEnd( &stream );
+	}
+	if ( std::find( succeeded.begin(), succeeded.end(), 0 ) != succeeded.end() )
+	{
+		throw StubbleException( " SectionedFileWriter::compressInBlocks : section compression failed ! " );
+	}
+	// Zlib header with the same level flags as deflate writes ( see RFC 1950 )
+	unsigned __int32 levelFlags = aCompressionLevel < 2 ? 0 : aCompressionLevel < 6 ? 1 : aCompressionLevel == 6 ? 2 : 3;
+	unsigned __int32 header = ( 0x78 << 8 ) | ( levelFlags << 6 );
+	header += 31 - header % 31;
+	aCompressed.clear();
+	aCompressed.push_back( static_cast< char >( header >> 8 ) );
+	aCompressed.push_back( static_cast< char >( header & 0xff ) );
+	// Concatenate blocks and combine their checksums
+	uLong checksum = adler32( 0, Z_NULL, 0 );
+	for ( int i = 0; i < blocksCount; ++i )
+	{
+		aCompressed.append( blocks[ i ] );
+		const size_t start = static_cast< size_t >( i ) * PARALLEL_BLOCK_SIZE;
+		checksum = adler32_combine( checksum, checksums[ i ],
+			static_cast< z_off_t >( std::min< size_t >( PARALLEL_BLOCK_SIZE, aData.size() - start ) ) );
+	}
+	// Zlib trailer ( big endian adler32 )
+	for ( int shift = 24; shift >= 0; shift -= 8 )
+	{
+		aCompressed.push_back( static_cast< char >( ( checksum >> shift ) & 0xff ) );
+	}
+}
+
+void SectionedFileWriter::writePadding( std::ostream & aOutputStream, unsigned __int64 aWrittenSize,
+	unsigned __int32 aAlignment )
+{
+	unsigned __int32 remainder = static_cast< unsigned __int32 >( aWrittenSize % aAlignment );
+	for ( unsigned __int32 i = remainder == 0 ? aAlignment : remainder; i < aAlignment; ++i )
+	{
+		aOutputStream.put( 0 );
+	}
+}
+
+bool SectionedFileReader::isSectionedFile( const std::string & aFileName, const char * aFileId )
+{
+	std::ifstream file( aFileName.c_str(), std::ios::binary );
+	char fileId[ SectionedFileWriter::FILE_ID_SIZE ];
+	file.read( fileId, SectionedFileWriter::FILE_ID_SIZE );
+	return file && memcmp( fileId, aFileId, SectionedFileWriter::FILE_ID_SIZE ) == 0;
+}
+
+SectionedFileReader::SectionedFileReader( const std::string & aFileName, const char * aFileId ):
+	mFile( INVALID_HANDLE_VALUE ),
+	mMapping( 0 ),
+	mData( 0 ),
+	mFileSize( 0 )
+{
+	try
+	{
+		// Map whole file to memory
+		mFile = CreateFileA( aFileName.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL, 0 );
+		if ( mFile == INVALID_HANDLE_VALUE )
+		{
+			throw StubbleException( " SectionedFileReader::SectionedFileReader : file can not be opened ! " );
+		}
+		LARGE_INTEGER fileSize;
+		if ( !GetFileSizeEx( mFile, &fileSize ) )
+		{
+			throw StubbleException( " SectionedFileReader::SectionedFileReader : file size is unknown ! " );
+		}
+		mFileSize = static_cast< unsigned __int64 >( fileSize.QuadPart );
+		if ( mFileSize < SectionedFileWriter::FILE_ID_SIZE + sizeof( unsigned __int32 ) )
+		{
+			throw StubbleException( " SectionedFileReader::SectionedFileReader : wrong file format ! " );
+		}
+		mMapping = CreateFileMappingA( mFile, 0, PAGE_READONLY, 0, 0, 0 );
+		if ( mMapping == 0 )
+		{
+			throw StubbleException( " SectionedFileReader::SectionedFileReader : file can not be mapped ! " );
+		}
+		mData = static_cast< const char * >( MapViewOfFile( mMapping, FILE_MAP_READ, 0, 0, 0 ) );
+		if ( mData == 0 )
+		{
+			throw StubbleException( " SectionedFileReader::SectionedFileReader : file can not be mapped ! " );
+		}
+		// Check file id
+		if ( memcmp( mData, aFileId, SectionedFileWriter::FILE_ID_SIZE ) != 0 )
+		{
+			throw StubbleException( " SectionedFileReader::SectionedFileReader : wrong file format ! " );
+		}
+		// Read section table
+		const char * it = mData + SectionedFileWriter::FILE_ID_SIZE;
+		unsigned __int32 sectionsCount;
+		memcpy( &sectionsCount, it, sizeof( unsigned __int32 ) );
+		it += sizeof( unsigned __int32 );
+		const unsigned __int64 entrySize = 2 * sizeof( unsigned __int32 ) + 3 * sizeof( unsigned __int64 );
+		if ( ( mFileSize - ( it - mData ) ) / entrySize < sectionsCount )
+		{
+			throw StubbleException( " SectionedFileReader::SectionedFileReader : corrupted section table ! " );
+		}
+		mSectionTable.resize( sectionsCount );
+		mInflatedSections.resize( sectionsCount, 0 );
+		for ( std::vector< SectionEntry >::iterator entryIt = mSectionTable.begin();
+			entryIt != mSectionTable.end(); ++entryIt )
+		{
+			memcpy( &entryIt->mId, it, sizeof( unsigned __int32 ) );
+			it += sizeof( unsigned __int32 );
+			memcpy( &entryIt->mCompressed, it, sizeof( unsigned __int32 ) );
+			it += sizeof( unsigned __int32 );
+			memcpy( &entryIt->mOffset, it, sizeof( unsigned __int64 ) );
+			it += sizeof( unsigned __int64 );
+			memcpy( &entryIt->mStoredSize, it, sizeof( unsigned __int64 ) );
+			it += sizeof( unsigned __int64 );
+			memcpy( &entryIt->mSize, it, sizeof( unsigned __int64 ) );
+			it += sizeof( unsigned __int64 );
+			if ( entryIt->mOffset > mFileSize || entryIt->mStoredSize > mFileSize - entryIt->mOffset ||
+				( !entryIt->mCompressed && entryIt->mStoredSize != entryIt->mSize ) )
+			{
+				throw StubbleException( " SectionedFileReader::SectionedFileReader : corrupted section table ! " );
+			}
+		}
+	}
+	catch( ... )
+	{
+		release();
+		throw;
+	}
+}
+
+SectionedFileReader::~SectionedFileReader()
+{
+	release();
+}
+
+bool SectionedFileReader::hasSection( unsigned __int32 aSectionId ) const
+{
+	for ( std::vector< SectionEntry >::const_iterator it = mSectionTable.begin(); it != mSectionTable.end(); ++it )
+	{
+		if ( it->mId == aSectionId )
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+const char * SectionedFileReader::getSectionData( unsigned __int32 aSectionId )
+{
+	size_t index = findSection( aSectionId );
+	const SectionEntry & entry = mSectionTable[ index ];
+	if ( !entry.mCompressed )
+	{
+		return mData + entry.mOffset; // Section is used in place
+	}
+	if ( mInflatedSections[ index ] == 0 ) // Not inflated yet ?
+	{
+		uLongf size = static_cast< uLongf >( entry.mSize );
+		char * inflated = new char[ entry.mSize > 0 ? static_cast< size_t >( entry.mSize ) : 1 ];
+		if ( size != entry.mSize || uncompress( reinterpret_cast< Bytef * >( inflated ), &size,
+			reinterpret_cast< const Bytef * >( mData + entry.mOffset ), static_cast< uLong >( entry.mStoredSize ) )
+			!= Z_OK || size != entry.mSize )
+		{
+			delete [] inflated;
+			throw StubbleException( " SectionedFileReader::getSectionData : section is corrupted ! " );
+		}
+		mInflatedSections[ index ] = inflated;
+	}
+	return mInflatedSections[ index ];
+}
+
+unsigned __int64 SectionedFileReader::getSectionSize( unsigned __int32 aSectionId ) const
+{
+	return mSectionTable[ findSection( aSectionId ) ].mSize;
+}
+
+size_t SectionedFileReader::findSection( unsigned __int32 aSectionId ) const
+{
+	for ( size_t i = 0; i < mSectionTable.size(); ++i )
+	{
+		if ( mSectionTable[ i ].mId == aSectionId )
+		{
+			return i;
+		}
+	}
+	throw StubbleException( " SectionedFileReader::findSection : requested section does not exist ! " );
+}
+
+void SectionedFileReader::release()
+{
+	for ( std::vector< char * >::iterator it = mInflatedSections.begin(); it != mInflatedSections.end(); ++it )
+	{
+		delete [] *it;
+		*it = 0;
+	}
+	if ( mData != 0 )
+	{
+		UnmapViewOfFile( mData );
+		mData = 0;
+	}
+	if ( mMapping != 0 )
+	{
+		CloseHandle( mMapping );
+		mMapping = 0;
+	}
+	if ( mFile != INVALID_HANDLE_VALUE )
+	{
+		CloseHandle( mFile );
+		mFile = INVALID_HANDLE_VALUE;
+	}
+}
+
+} // namespace Stubble
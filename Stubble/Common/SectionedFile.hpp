@@ -0,0 +1,276 @@
+#ifndef STUBBLE_SECTIONED_FILE_HPP
+#define STUBBLE_SECTIONED_FILE_HPP
+
+#include "CommonTypes.hpp"
+
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace Stubble
+{
+
+///-------------------------------------------------------------------------------------------------
+/// Writer of sectioned binary file. File starts with uncompressed file id and section table, which
+/// is followed by sections data. Every section starts at offset aligned to SECTION_ALIGNMENT and is
+/// either stored uncompressed ( so it can be used directly from memory mapped file ) or compressed
+/// on its own by zlib. Large sections are deflated in parallel blocks ( each block is primed by the
+/// last window of previous block and ended by sync flush ), which are concatenated to single zlib
+/// stream, so reader inflates them as any other compressed section.
+/// Sections are collected in memory and written to file at once by writeToFile method.
+///-------------------------------------------------------------------------------------------------
+class SectionedFileWriter
+{
+public:
+
+	///-------------------------------------------------------------------------------------------------
+	/// Constructor.
+	///
+	/// \param	aFileId				Identifier of the file ( FILE_ID_SIZE characters ).
+	/// \param	aCompressionLevel	The compression level of compressed sections ( 1 = FASTEST - 9 = BEST ).
+	///-------------------------------------------------------------------------------------------------
+	SectionedFileWriter( const char * aFileId, int aCompressionLevel );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Begins new section. Section data are written to returned stream until endSection is called.
+	///
+	/// \param	aSectionId	Identifier for the section.
+	/// \param	aCompressed	true to compress section.
+	///
+	/// \return	The stream of section data.
+	///-------------------------------------------------------------------------------------------------
+	std::ostream & beginSection( unsigned __int32 aSectionId, bool aCompressed );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Ends current section ( section data are compressed if requested ).
+	///-------------------------------------------------------------------------------------------------
+	void endSection();
+
+	///-------------------------------------------------------------------------------------------------
+	/// Writes file id, section table and all sections to output stream.
+	///
+	/// \param [in,out]	aOutputStream	The output stream ( must be opened in binary mode ).
+	///-------------------------------------------------------------------------------------------------
+	void writeToFile( std::ostream & aOutputStream ) const;
+
+	static const unsigned __int32 FILE_ID_SIZE = 20; ///< Size of the file identifier
+
+	static const unsigned __int32 SECTION_ALIGNMENT = 64;  ///< The alignment of sections in file
+
+	static const unsigned __int32 PARALLEL_BLOCK_SIZE = 256 * 1024;	///< The size of block of section deflated in parallel
+
+	///-------------------------------------------------------------------------------------------------
+	/// Writes zero bytes to stream, so the data written so far take multiple of aAlignment bytes.
+	///
+	/// \param [in,out]	aOutputStream	The output stream.
+	/// \param	aWrittenSize			Size of the data written so far.
+	/// \param	aAlignment				The alignment.
+	///-------------------------------------------------------------------------------------------------
+	static void writePadding( std::ostream & aOutputStream, unsigned __int64 aWrittenSize,
+		unsigned __int32 aAlignment );
+
+private:
+
+	///-------------------------------------------------------------------------------------------------
+	/// Compresses data to zlib stream by deflating blocks of PARALLEL_BLOCK_SIZE bytes in parallel.
+	///
+	/// \param	aData					The data.
+	/// \param	aCompressionLevel		The compression level ( 0 = NONE - 9 = BEST ).
+	/// \param [in,out]	aCompressed	The compressed data.
+	///-------------------------------------------------------------------------------------------------
+	static void compressInBlocks( const std::string & aData, int aCompressionLevel, std::string & aCompressed );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Single section of file.
+	///-------------------------------------------------------------------------------------------------
+	struct Section
+	{
+		unsigned __int32 mId;   ///< The identifier of section
+
+		bool mCompressed;   ///< true if section data are compressed
+
+		unsigned __int64 mSize; ///< The size of uncompressed section data
+
+		std::string mData;  ///< The ( compressed ) section data
+	};
+
+	///-------------------------------------------------------------------------------------------------
+	/// Defines an alias representing the sections .
+	///-------------------------------------------------------------------------------------------------
+	typedef std::vector< Section > Sections;
+
+	char mFileId[ FILE_ID_SIZE ];   ///< Identifier for the file
+
+	int mCompressionLevel;  ///< The compression level
+
+	Sections mSections; ///< The finished sections
+
+	std::ostringstream mCurrentSection; ///< The data of current section
+
+	bool mIsSectionOpened;  ///< true if section has been begun and not ended yet
+};
+
+///-------------------------------------------------------------------------------------------------
+/// Reader of sectioned binary file ( see SectionedFileWriter ). File is memory mapped, so
+/// uncompressed sections are accessed in place without copying. Compressed sections are inflated
+/// only when they are requested for the first time.
+/// Data returned by reader are valid until reader is destroyed. Reader is not thread-safe.
+///-------------------------------------------------------------------------------------------------
+class SectionedFileReader
+{
+public:
+
+	///-------------------------------------------------------------------------------------------------
+	/// Checks whether file is sectioned file with given file id.
+	///
+	/// \param	aFileName	Filename of the file.
+	/// \param	aFileId		Identifier of the file ( FILE_ID_SIZE characters ).
+	///
+	/// \return	true if file starts with given file id.
+	///-------------------------------------------------------------------------------------------------
+	static bool isSectionedFile( const std::string & aFileName, const char * aFileId );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Constructor. Maps file to memory and reads its section table.
+	///
+	/// \param	aFileName	Filename of the file.
+	/// \param	aFileId		Identifier of the file ( FILE_ID_SIZE characters ).
+	///-------------------------------------------------------------------------------------------------
+	SectionedFileReader( const std::string & aFileName, const char * aFileId );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Finaliser. Unmaps file and releases inflated sections.
+	///-------------------------------------------------------------------------------------------------
+	~SectionedFileReader();
+
+	///-------------------------------------------------------------------------------------------------
+	/// Query if file contains requested section.
+	///
+	/// \param	aSectionId	Identifier for the section.
+	///
+	/// \return	true if section exists.
+	///-------------------------------------------------------------------------------------------------
+	bool hasSection( unsigned __int32 aSectionId ) const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the section data. Uncompressed section data are aligned to SECTION_ALIGNMENT.
+	///
+	/// \param	aSectionId	Identifier for the section.
+	///
+	/// \return	The section data.
+	///-------------------------------------------------------------------------------------------------
+	const char * getSectionData( unsigned __int32 aSectionId );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the size of uncompressed section data.
+	///
+	/// \param	aSectionId	Identifier for the section.
+	///
+	/// \return	The section size.
+	///-------------------------------------------------------------------------------------------------
+	unsigned __int64 getSectionSize( unsigned __int32 aSectionId ) const;
+
+private:
+
+	///-------------------------------------------------------------------------------------------------
+	/// Entry of section table as stored in file.
+	///-------------------------------------------------------------------------------------------------
+	struct SectionEntry
+	{
+		unsigned __int32 mId;   ///< The identifier of section
+
+		unsigned __int32 mCompressed;   ///< Non-zero if section data are compressed
+
+		unsigned __int64 mOffset;   ///< The offset of section data from the beginning of file
+
+		unsigned __int64 mStoredSize;   ///< The size of section data stored in file
+
+		unsigned __int64 mSize; ///< The size of uncompressed section data
+	};
+
+	///-------------------------------------------------------------------------------------------------
+	/// Finds index of requested section, throws exception if section does not exist.
+	///
+	/// \param	aSectionId	Identifier for the section.
+	///
+	/// \return	The index of section in section table.
+	///-------------------------------------------------------------------------------------------------
+	size_t findSection( unsigned __int32 aSectionId ) const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Releases mapped file and inflated sections.
+	///-------------------------------------------------------------------------------------------------
+	void release();
+
+	void * mFile;   ///< The handle of mapped file
+
+	void * mMapping;	///< The handle of file mapping
+
+	const char * mData; ///< The mapped file data
+
+	unsigned __int64 mFileSize; ///< Size of the file
+
+	std::vector< SectionEntry > mSectionTable;  ///< The section table
+
+	std::vector< char * > mInflatedSections;	///< The inflated sections ( NULL if not inflated yet )
+};
+
+///-------------------------------------------------------------------------------------------------
+/// Input stream reading data from memory ( e.g. from section of memory mapped file ) without
+/// copying them.
+///-------------------------------------------------------------------------------------------------
+class MemoryInputStream : public std::istream
+{
+public:
+
+	///-------------------------------------------------------------------------------------------------
+	/// Constructor.
+	///
+	/// \param	aData	The data to be read.
+	/// \param	aSize	Size of the data.
+	///-------------------------------------------------------------------------------------------------
+	inline MemoryInputStream( const char * aData, unsigned __int64 aSize );
+
+private:
+
+	///-------------------------------------------------------------------------------------------------
+	/// Stream buffer over constant memory block.
+	///-------------------------------------------------------------------------------------------------
+	class MemoryBuffer : public std::streambuf
+	{
+	public:
+
+		///-------------------------------------------------------------------------------------------------
+		/// Constructor.
+		///
+		/// \param	aData	The data to be read.
+		/// \param	aSize	Size of the data.
+		///-------------------------------------------------------------------------------------------------
+		inline MemoryBuffer( const char * aData, unsigned __int64 aSize );
+	};
+
+	MemoryBuffer mBuffer;   ///< The buffer
+};
+
+// inline functions implementation
+
+inline MemoryInputStream::MemoryInputStream( const char * aData, unsigned __int64 aSize ):
+	std::istream( 0 ),
+	mBuffer( aData, aSize )
+{
+	rdbuf( &mBuffer );
+}
+
+inline MemoryInputStream::MemoryBuffer::MemoryBuffer( const char * aData, unsigned __int64 aSize )
+{
+	// Buffer is only read, so the data are never modified
+	char * data = const_cast< char * >( aData );
+	setg( data, data, data + aSize );
+}
+
+} // namespace Stubble
+
+#endif // STUBBLE_SECTIONED_FILE_HPP
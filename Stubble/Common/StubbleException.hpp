@@ -9,7 +9,7 @@ namespace Stubble
 ///-------------------------------------------------------------------------------------------------
 /// Exception for signalling stubble errors. 
 ///-------------------------------------------------------------------------------------------------
-class StubbleException : public std::exception
+class StubbleException : public std::runtime_error
 {
 public:
 	///-------------------------------------------------------------------------------------------------
@@ -17,7 +17,7 @@ public:
 	///
 	/// \param	aMessage	Message describing exception. 
 	///-------------------------------------------------------------------------------------------------
-	StubbleException( const char * const & aMessage ): exception( aMessage ) 
+	StubbleException( const char * const & aMessage ): runtime_error( aMessage ) 
 	{
 	}
 };
@@ -9,6 +9,7 @@ namespace HairShape
 
 void RandomGenerator::reset( __int32 aIJ, __int32 aKL )
 {
+	mIsCounterBased = false;
 	// F.James algorithm reset
 	Real s, t;
 	__int32 i, j, k, l, m;
@@ -52,6 +53,37 @@ void RandomGenerator::reset( __int32 aIJ, __int32 aKL )
 	j97 = 32;
 }
 
+void RandomGenerator::generateCounterBasedBlock()
+{
+	// Philox4x32-10 constants
+	const unsigned __int64 M0 = 0xD2511F53;
+	const unsigned __int64 M1 = 0xCD9E8D57;
+	const unsigned __int32 W0 = 0x9E3779B9;
+	const unsigned __int32 W1 = 0xBB67AE85;
+	mBlockIndex = mDraw >> 2;
+	// Counter is made of block index and stream index ( high word is zero for streams below 2^32, so
+	// their numbers do not depend on stream index width ), key is made of seed and domain
+	unsigned __int32 c0 = mBlockIndex, c1 = 0, c2 = static_cast< unsigned __int32 >( mStream ), 
+		c3 = static_cast< unsigned __int32 >( mStream >> 32 );
+	unsigned __int32 k0 = mSeed, k1 = mDomain;
+	for ( unsigned __int32 round = 0; round < 10; ++round )
+	{
+		const unsigned __int64 product0 = M0 * c0;
+		const unsigned __int64 product1 = M1 * c2;
+		c0 = static_cast< unsigned __int32 >( product1 >> 32 ) ^ c1 ^ k0;
+		c1 = static_cast< unsigned __int32 >( product1 );
+		c2 = static_cast< unsigned __int32 >( product0 >> 32 ) ^ c3 ^ k1;
+		c3 = static_cast< unsigned __int32 >( product0 );
+		// Bump key
+		k0 += W0;
+		k1 += W1;
+	}
+	mBlock[ 0 ] = c0;
+	mBlock[ 1 ] = c1;
+	mBlock[ 2 ] = c2;
+	mBlock[ 3 ] = c3;
+}
+
 } // namespace HairShape
 
 } // namespace Stubble
\ No newline at end of file
@@ -3,6 +3,8 @@
 
 #include "Common\CommonTypes.hpp"
 
+#include <cstring>
+
 namespace Stubble
 {
 
@@ -11,33 +13,81 @@ namespace HairShape
 
 ///-------------------------------------------------------------------------------------------------
 /// Class for generation of deterministic random numbers.
-/// Numbers are generated by algorithm by F. James (A Review of Pseudo-random Number Generators).
+/// Generator works in two modes. In James mode numbers are generated by algorithm by F. James 
+/// (A Review of Pseudo-random Number Generators), this mode is kept for compatibility with existing scenes.
+/// Every number depends on all previously generated numbers, so numbers must be consumed in fixed order.
+/// In counter based mode numbers are generated by Philox4x32-10 algorithm (Salmon et al., Parallel Random
+/// Numbers: As Easy as 1, 2, 3) keyed by seed, domain, stream index and draw index. Every stream ( e.g. single 
+/// hair ) can be selected and its numbers can be generated independently of other streams in O(1).
 ///-------------------------------------------------------------------------------------------------
 class RandomGenerator
 {
 public:
+
+	///----------------------------------------------------------------------------------------------------
+	/// Domains of counter based random numbers. Streams with same index in different domains are independent.
+	///----------------------------------------------------------------------------------------------------
+	enum StreamDomain
+	{
+		HAIR_ROOTS_DOMAIN = 0,		///< Random numbers used for sampling of hair roots
+		HAIR_PROPERTIES_DOMAIN = 1,	///< Random numbers used for interpolation of hair properties
+		HAIR_LOD_DOMAIN = 2			///< Random numbers used for level of detail selection of hair
+	};
+
 	///----------------------------------------------------------------------------------------------------
 	/// Default constructor.
-	/// Initialize random generator with default seed.
+	/// Initialize random generator in James mode with default seed.
 	///----------------------------------------------------------------------------------------------------
 	inline RandomGenerator();
 
 	///----------------------------------------------------------------------------------------------------
-	/// Deterministic reset of random generator with default seed. 
+	/// Deterministic reset of random generator. Generator stays in current mode, James mode is reset with 
+	/// default seed, counter based mode selects the first stream.
 	///----------------------------------------------------------------------------------------------------
 	void reset() 
 	{
-		reset( 1802, 9373 );
+		if ( mIsCounterBased )
+		{
+			setStream( 0 );
+		}
+		else
+		{
+			reset( 1802, 9373 );
+		}
 	}
 
 	///----------------------------------------------------------------------------------------------------
-	/// Deterministic reset of random generator with given seed values. 
+	/// Deterministic reset of random generator with given seed values. Switches generator to James mode.
 	///
 	/// \param	aIJ	a random generator seed value #1. 
 	/// \param	aKL	a random generator seed value #2. 
 	///----------------------------------------------------------------------------------------------------
 	void reset( __int32 aIJ, __int32 aKL );
 
+	///----------------------------------------------------------------------------------------------------
+	/// Deterministic reset of random generator with given seed. Switches generator to counter based mode
+	/// and selects the first stream.
+	///
+	/// \param	aSeed	The random generator seed. 
+	/// \param	aDomain	The domain of generated numbers. 
+	///----------------------------------------------------------------------------------------------------
+	inline void resetCounterBased( unsigned __int32 aSeed, StreamDomain aDomain );
+
+	///----------------------------------------------------------------------------------------------------
+	/// Selects stream of random numbers and starts from its first number. Stream can be selected in any order.
+	/// Has no effect in James mode.
+	///
+	/// \param	aStreamIndex	Zero-based index of the stream ( e.g. hair index ). 
+	///----------------------------------------------------------------------------------------------------
+	inline void setStream( unsigned __int64 aStreamIndex );
+
+	///----------------------------------------------------------------------------------------------------
+	/// Query if this generator is in counter based mode. 
+	///
+	/// \return	true if generator is in counter based mode, false if in James mode. 
+	///----------------------------------------------------------------------------------------------------
+	inline bool isCounterBased() const;
+
 	///----------------------------------------------------------------------------------------------------
 	/// Gets the uniform random number from [0,1] interval. 
 	///
@@ -65,26 +115,101 @@ public:
 	///----------------------------------------------------------------------------------------------------
 	inline __int32 randomInteger( __int32 aMin, __int32 aMax );
 
+	///----------------------------------------------------------------------------------------------------
+	/// Skips given number of random numbers. Generator ends in the same state as if uniformNumber
+	/// was called aCount times. Takes O(1) time in counter based mode.
+	///
+	/// \param	aCount	Number of skipped random numbers. 
+	///----------------------------------------------------------------------------------------------------
+	inline void skip( unsigned __int32 aCount );
+
+	///----------------------------------------------------------------------------------------------------
+	/// Equality operator. 
+	///
+	/// \param	aRandomGenerator	The random generator to compare to. 
+	///
+	/// \return	true if both generators are in the same state ( will generate same numbers ). 
+	///----------------------------------------------------------------------------------------------------
+	inline bool operator==( const RandomGenerator & aRandomGenerator ) const;
+
 	///----------------------------------------------------------------------------------------------------
 	/// Finaliser. 
 	///----------------------------------------------------------------------------------------------------
 	~RandomGenerator() {}
 
 private:
+
+	///----------------------------------------------------------------------------------------------------
+	/// Generates block of four counter based random numbers containing current draw.
+	///----------------------------------------------------------------------------------------------------
+	void generateCounterBasedBlock();
+
+	///< Marks that no block of counter based numbers has been generated
+	static const unsigned __int32 INVALID_BLOCK = 0xFFFFFFFF;
+
 	Real u[ 97 ]; ///< Random generator data
 	Real c, cd, cm; ///< Random generator data
 	__int32 i97, j97; ///< Random generator data
+
+	bool mIsCounterBased;	///< true if generator is in counter based mode
+
+	unsigned __int32 mSeed;	///< The seed of counter based generator
+
+	unsigned __int32 mDomain;	///< The domain of counter based generator
+
+	unsigned __int64 mStream;	///< The current stream of counter based generator
+
+	unsigned __int32 mDraw;	///< Index of next number in current stream
+
+	unsigned __int32 mBlockIndex;	///< Index of generated block of numbers ( mDraw / 4 )
+
+	unsigned __int32 mBlock[ 4 ];	///< The generated block of numbers
 };
 
 // inline functions implementation
 
-inline RandomGenerator::RandomGenerator()
+inline RandomGenerator::RandomGenerator():
+	mIsCounterBased( false ),
+	mSeed( 0 ),
+	mDomain( 0 ),
+	mStream( 0 ),
+	mDraw( 0 ),
+	mBlockIndex( INVALID_BLOCK )
 {
 	reset(); // Resets James random generator with default seed values
 }
 
+inline void RandomGenerator::resetCounterBased( unsigned __int32 aSeed, StreamDomain aDomain )
+{
+	mIsCounterBased = true;
+	mSeed = aSeed;
+	mDomain = static_cast< unsigned __int32 >( aDomain );
+	setStream( 0 );
+}
+
+inline void RandomGenerator::setStream( unsigned __int64 aStreamIndex )
+{
+	mStream = aStreamIndex;
+	mDraw = 0;
+	mBlockIndex = INVALID_BLOCK;
+}
+
+inline bool RandomGenerator::isCounterBased() const
+{
+	return mIsCounterBased;
+}
+
 inline Real RandomGenerator::uniformNumber()
 {
+	if ( mIsCounterBased )
+	{
+		if ( ( mDraw >> 2 ) != mBlockIndex ) // Current draw is not in generated block ?
+		{
+			generateCounterBasedBlock();
+		}
+		// Map 32 bit integer to [0,1) interval
+		return static_cast< Real >( mBlock[ mDraw++ & 3 ] ) * ( 1.0 / 4294967296.0 );
+	}
 	// F.James algorithm :
 	Real uni = u[i97] - u[j97];
 	
@@ -119,6 +244,32 @@ inline __int32 RandomGenerator::randomInteger( __int32 aMin, __int32 aMax )
 			( aMin + ( __int32 ) ( (aMax + 1 - aMin) * uniformNumber() ) );
 }
 
+inline void RandomGenerator::skip( unsigned __int32 aCount )
+{
+	if ( mIsCounterBased )
+	{
+		mDraw += aCount; // Block will be generated on demand
+		return;
+	}
+	for ( ; aCount > 0; --aCount )
+	{
+		uniformNumber();
+	}
+}
+
+inline bool RandomGenerator::operator==( const RandomGenerator & aRandomGenerator ) const
+{
+	if ( mIsCounterBased || aRandomGenerator.mIsCounterBased )
+	{
+		return mIsCounterBased == aRandomGenerator.mIsCounterBased && mSeed == aRandomGenerator.mSeed &&
+			mDomain == aRandomGenerator.mDomain && mStream == aRandomGenerator.mStream && 
+			mDraw == aRandomGenerator.mDraw;
+	}
+	return i97 == aRandomGenerator.i97 && j97 == aRandomGenerator.j97 && c == aRandomGenerator.c &&
+		memcmp( reinterpret_cast< const void * >( u ), reinterpret_cast< const void * >( aRandomGenerator.u ),
+		sizeof( Real ) * 97 ) == 0;
+}
+
 } // namespace HairShape
 
 } // namespace Stubble
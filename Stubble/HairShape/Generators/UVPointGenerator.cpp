@@ -10,7 +10,7 @@ namespace Stubble
 namespace HairShape
 {
 
-UVPointGenerator::UVPointGenerator(const Texture &aTexture, TriangleConstIterator & aTriangleConstIterator, RandomGenerator & aRandomNumberGenerator ):
+UVPointGenerator::UVPointGenerator(const Texture &aTexture, TriangleConstIterator aTriangleConstIterator, RandomGenerator & aRandomNumberGenerator ):
 	mVertices( 0 ),
 	mRandomNumberGenerator( aRandomNumberGenerator )
 {
@@ -33,7 +33,7 @@ public:
 	/// \param	aTriangleConstIterator			Iterator over triangles of sampled mesh.
 	/// \param [in,out]	aRandomGenerator		External random number generator. 
 	///----------------------------------------------------------------------------------------------------
-	UVPointGenerator( const Texture &aTexture, TriangleConstIterator & aTriangleConstIterator, 
+	UVPointGenerator( const Texture &aTexture, TriangleConstIterator aTriangleConstIterator, 
 		RandomGenerator & aRandomNumberGenerator );
 
 	///----------------------------------------------------------------------------------------------------
@@ -49,6 +49,16 @@ public:
 	///----------------------------------------------------------------------------------------------------
 	UVPoint next();
 
+	///----------------------------------------------------------------------------------------------------
+	/// Generation of sample of given hair. If random generator is counter based, sample depends only on
+	/// hair index, so samples can be generated in any order.
+	///
+	/// \param	aHairIndex	Zero-based index of the hair. 
+	///
+	/// \return	Generated sample. 
+	///----------------------------------------------------------------------------------------------------
+	inline UVPoint next( unsigned __int64 aHairIndex );
+
 	///-------------------------------------------------------------------------------------------------
 	/// Resets samples generation. 
 	/// Also resets external random number generator.
@@ -181,6 +191,12 @@ inline void UVPointGenerator::reset()
 	mRandomNumberGenerator.reset();
 }
 
+inline UVPoint UVPointGenerator::next( unsigned __int64 aHairIndex )
+{
+	mRandomNumberGenerator.setStream( aHairIndex );
+	return next();
+}
+
 inline Real UVPointGenerator::getDensity() const
 {
 	return mTotalDensity;
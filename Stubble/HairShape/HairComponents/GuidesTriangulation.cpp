@@ -0,0 +1,429 @@
+#include "GuidesTriangulation.hpp"
+
+#include <algorithm>
+#include <math.h>
+#include <utility>
+
+namespace Stubble
+{
+
+namespace HairShape
+{
+
+namespace HairComponents
+{
+
+namespace
+{
+
+const unsigned __int32 NO_TRIANGLE = 0xffffffff;	///< Missing neighbour of triangle
+
+const unsigned __int32 SUPER_VERTICES_COUNT = 3;	///< Number of vertices of triangle enclosing all roots
+
+const unsigned __int32 MAX_GRID_SIZE = 1024;	///< Maximal number of grid cells along each axis
+
+const Real BARYCENTRIC_TOLERANCE = 1e-9;	///< Tolerance of point on triangle edge
+
+///-------------------------------------------------------------------------------------------------
+/// Triangle of triangulation under construction.
+///-------------------------------------------------------------------------------------------------
+struct BuildTriangle
+{
+	unsigned __int32 mVertices[ 3 ];	///< The vertices ( counter-clockwise )
+
+	unsigned __int32 mNeighbours[ 3 ];  ///< The neighbour opposite to every vertex ( NO_TRIANGLE on border )
+
+	unsigned __int32 mStamp;	///< The index of the last insertion, which has removed triangle
+};
+
+///-------------------------------------------------------------------------------------------------
+/// Edge of cavity created by insertion of root.
+///-------------------------------------------------------------------------------------------------
+struct CavityEdge
+{
+	unsigned __int32 mFrom; ///< The first vertex ( counter-clockwise around cavity )
+
+	unsigned __int32 mTo;   ///< The second vertex
+
+	unsigned __int32 mOutside;  ///< The triangle outside of cavity sharing edge ( or NO_TRIANGLE )
+};
+
+///-------------------------------------------------------------------------------------------------
+/// Calculates doubled signed area of triangle. Area is positive for counter-clockwise triangle.
+///
+/// \param	aA	The first vertex ( x, y ).
+/// \param	aB	The second vertex ( x, y ).
+/// \param	aC	The third vertex ( x, y ).
+///
+/// \return	The doubled signed area.
+///-------------------------------------------------------------------------------------------------
+inline Real orientation( const Real * aA, const Real * aB, const Real * aC )
+{
+	return ( aB[ 0 ] - aA[ 0 ] ) * ( aC[ 1 ] - aA[ 1 ] ) - ( aB[ 1 ] - aA[ 1 ] ) * ( aC[ 0 ] - aA[ 0 ] );
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Query if point lies inside circumcircle of counter-clockwise triangle.
+///
+/// \param	aA	The first vertex ( x, y ).
+/// \param	aB	The second vertex ( x, y ).
+/// \param	aC	The third vertex ( x, y ).
+/// \param	aP	The point ( x, y ).
+///
+/// \return	true if point lies inside circumcircle.
+///-------------------------------------------------------------------------------------------------
+inline bool isInCircumcircle( const Real * aA, const Real * aB, const Real * aC, const Real * aP )
+{
+	const Real ax = aA[ 0 ] - aP[ 0 ], ay = aA[ 1 ] - aP[ 1 ];
+	const Real bx = aB[ 0 ] - aP[ 0 ], by = aB[ 1 ] - aP[ 1 ];
+	const Real cx = aC[ 0 ] - aP[ 0 ], cy = aC[ 1 ] - aP[ 1 ];
+	return ( ax * ax + ay * ay ) * ( bx * cy - cx * by ) - ( bx * bx + by * by ) * ( ax * cy - cx * ay ) +
+		( cx * cx + cy * cy ) * ( ax * by - bx * ay ) > 0;
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Finds triangle containing point by walking from start triangle towards point.
+///
+/// \param	aTriangles		The triangles.
+/// \param	aCoordinates	The coordinates of vertices.
+/// \param	aStart			The start triangle.
+/// \param	aPoint			The point ( x, y ).
+///
+/// \return	The triangle containing point.
+///-------------------------------------------------------------------------------------------------
+unsigned __int32 locate( const std::vector< BuildTriangle > & aTriangles, const std::vector< Real > & aCoordinates,
+	unsigned __int32 aStart, const Real * aPoint )
+{
+	unsigned __int32 current = aStart;
+	for ( size_t steps = 0; steps <= aTriangles.size(); ++steps )
+	{
+		const BuildTriangle & t = aTriangles[ current ];
+		unsigned __int32 next = current;
+		for ( unsigned __int32 i = 0; i < 3; ++i )
+		{
+			// Point lies behind edge opposite to i-th vertex ?
+			if ( orientation( &aCoordinates[ 2 * t.mVertices[ ( i + 1 ) % 3 ] ],
+				&aCoordinates[ 2 * t.mVertices[ ( i + 2 ) % 3 ] ], aPoint ) < 0 && t.mNeighbours[ i ] != NO_TRIANGLE )
+			{
+				next = t.mNeighbours[ i ];
+				break;
+			}
+		}
+		if ( next == current )
+		{
+			return current;
+		}
+		current = next;
+	}
+	// Walk has cycled due to rounding errors, test all triangles
+	for ( unsigned __int32 i = 0; i < aTriangles.size(); ++i )
+	{
+		const BuildTriangle & t = aTriangles[ i ];
+		const Real * a = &aCoordinates[ 2 * t.mVertices[ 0 ] ];
+		const Real * b = &aCoordinates[ 2 * t.mVertices[ 1 ] ];
+		const Real * c = &aCoordinates[ 2 * t.mVertices[ 2 ] ];
+		if ( orientation( a, b, aPoint ) >= 0 && orientation( b, c, aPoint ) >= 0 && orientation( c, a, aPoint ) >= 0 )
+		{
+			return i;
+		}
+	}
+	return current;
+}
+
+} // unnamed namespace
+
+GuidesTriangulation::GuidesTriangulation():
+	mGridSize( 0 ),
+	mMinU( 0 ),
+	mMinV( 0 ),
+	mScale( 0 )
+{
+}
+
+void GuidesTriangulation::build( const Real * aCoordinates, const GuideId * aGuidesIds, unsigned __int32 aCount )
+{
+	mCoordinates.clear();
+	mGuidesIds.clear();
+	mTriangles.clear();
+	mCellsStarts.clear();
+	mCellsTriangles.clear();
+	mGridSize = 0;
+	if ( aCount < 3 ) // Nothing to triangulate
+	{
+		return;
+	}
+	// Roots are normalized to unit square ( aspect ratio is kept, so triangulation stays Delaunay )
+	Real maxU = mMinU = aCoordinates[ 0 ];
+	Real maxV = mMinV = aCoordinates[ 1 ];
+	for ( const Real * it = aCoordinates + 2, * end = aCoordinates + 2 * aCount; it != end; it += 2 )
+	{
+		mMinU = std::min( mMinU, it[ 0 ] );
+		mMinV = std::min( mMinV, it[ 1 ] );
+		maxU = std::max( maxU, it[ 0 ] );
+		maxV = std::max( maxV, it[ 1 ] );
+	}
+	const Real extent = std::max( maxU - mMinU, maxV - mMinV );
+	if ( extent <= 0 ) // All roots have same coordinates
+	{
+		return;
+	}
+	mScale = 1 / extent;
+	// Insertion order along Morton curve ( 16 bits per axis )
+	static const Real QUANTIZATION = 65535;
+	std::vector< std::pair< unsigned __int32, unsigned __int32 > > order( aCount );
+	for ( unsigned __int32 i = 0; i < aCount; ++i )
+	{
+		const unsigned __int32 x = static_cast< unsigned __int32 >( ( aCoordinates[ 2 * i ] - mMinU ) * mScale * QUANTIZATION );
+		const unsigned __int32 y = static_cast< unsigned __int32 >( ( aCoordinates[ 2 * i + 1 ] - mMinV ) * mScale * QUANTIZATION );
+		unsigned __int32 code = 0;
+		for ( unsigned __int32 bit = 0; bit < 16; ++bit )
+		{
+			code |= ( ( ( x >> bit ) & 1 ) | ( ( ( y >> bit ) & 1 ) << 1 ) ) << ( 2 * bit );
+		}
+		order[ i ] = std::make_pair( code, i );
+	}
+	std::sort( order.begin(), order.end() );
+	// Start with triangle enclosing whole unit square
+	std::vector< Real > coordinates;
+	coordinates.reserve( 2 * ( aCount + SUPER_VERTICES_COUNT ) );
+	static const Real SUPER_VERTICES[ 6 ] = { -100, -100, 300, -100, -100, 300 };
+	coordinates.assign( SUPER_VERTICES, SUPER_VERTICES + 6 );
+	std::vector< GuideId > guidesIds;
+	guidesIds.reserve( aCount );
+	std::vector< BuildTriangle > triangles;
+	triangles.reserve( 2 * aCount + 1 );
+	BuildTriangle super = { { 0, 1, 2 }, { NO_TRIANGLE, NO_TRIANGLE, NO_TRIANGLE }, NO_TRIANGLE };
+	triangles.push_back( super );
+	// Insert roots one by one ( Bowyer-Watson algorithm )
+	std::vector< unsigned __int32 > cavity, stack, newTriangles;
+	std::vector< CavityEdge > edges;
+	unsigned __int32 last = 0;
+	for ( unsigned __int32 insertion = 0; insertion < aCount; ++insertion )
+	{
+		const unsigned __int32 root = order[ insertion ].second;
+		const Real point[ 2 ] = { ( aCoordinates[ 2 * root ] - mMinU ) * mScale,
+			( aCoordinates[ 2 * root + 1 ] - mMinV ) * mScale };
+		const unsigned __int32 start = locate( triangles, coordinates, last, point );
+		// Skip duplicate roots
+		bool isDuplicate = false;
+		for ( unsigned __int32 i = 0; i < 3; ++i )
+		{
+			const Real * vertex = &coordinates[ 2 * triangles[ start ].mVertices[ i ] ];
+			isDuplicate |= vertex[ 0 ] == point[ 0 ] && vertex[ 1 ] == point[ 1 ];
+		}
+		if ( isDuplicate )
+		{
+			continue;
+		}
+		// Select cavity : all triangles which circumcircle contains root
+		const unsigned __int32 vertex = static_cast< unsigned __int32 >( coordinates.size() / 2 );
+		cavity.assign( 1, start );
+		stack.assign( 1, start );
+		triangles[ start ].mStamp = insertion;
+		while ( !stack.empty() )
+		{
+			const BuildTriangle & t = triangles[ stack.back() ];
+			stack.pop_back();
+			for ( unsigned __int32 i = 0; i < 3; ++i )
+			{
+				const unsigned __int32 n = t.mNeighbours[ i ];
+				if ( n == NO_TRIANGLE || triangles[ n ].mStamp == insertion )
+				{
+					continue;
+				}
+				const BuildTriangle & neighbour = triangles[ n ];
+				if ( isInCircumcircle( &coordinates[ 2 * neighbour.mVertices[ 0 ] ],
+					&coordinates[ 2 * neighbour.mVertices[ 1 ] ], &coordinates[ 2 * neighbour.mVertices[ 2 ] ], point ) )
+				{
+					triangles[ n ].mStamp = insertion;
+					cavity.push_back( n );
+					stack.push_back( n );
+				}
+			}
+		}
+		// Select edges of cavity
+		edges.clear();
+		for ( std::vector< unsigned __int32 >::const_iterator it = cavity.begin(); it != cavity.end(); ++it )
+		{
+			const BuildTriangle & t = triangles[ *it ];
+			for ( unsigned __int32 i = 0; i < 3; ++i )
+			{
+				const unsigned __int32 n = t.mNeighbours[ i ];
+				if ( n == NO_TRIANGLE || triangles[ n ].mStamp != insertion )
+				{
+					const CavityEdge edge = { t.mVertices[ ( i + 1 ) % 3 ], t.mVertices[ ( i + 2 ) % 3 ], n };
+					edges.push_back( edge );
+				}
+			}
+		}
+		// Connect root with edges of cavity, new triangles reuse slots of removed ones
+		coordinates.push_back( point[ 0 ] );
+		coordinates.push_back( point[ 1 ] );
+		guidesIds.push_back( aGuidesIds[ root ] );
+		newTriangles.resize( edges.size() );
+		for ( unsigned __int32 i = 0; i < edges.size(); ++i )
+		{
+			if ( i < cavity.size() )
+			{
+				newTriangles[ i ] = cavity[ i ];
+			}
+			else
+			{
+				newTriangles[ i ] = static_cast< unsigned __int32 >( triangles.size() );
+				triangles.push_back( super );
+			}
+		}
+		for ( unsigned __int32 i = 0; i < edges.size(); ++i )
+		{
+			const CavityEdge & edge = edges[ i ];
+			BuildTriangle & t = triangles[ newTriangles[ i ] ];
+			t.mVertices[ 0 ] = edge.mFrom;
+			t.mVertices[ 1 ] = edge.mTo;
+			t.mVertices[ 2 ] = vertex;
+			t.mNeighbours[ 2 ] = edge.mOutside;
+			t.mStamp = NO_TRIANGLE;
+			// Neighbours inside cavity share the root and one vertex of edge
+			for ( unsigned __int32 j = 0; j < edges.size(); ++j )
+			{
+				if ( edges[ j ].mFrom == edge.mTo )
+				{
+					t.mNeighbours[ 0 ] = newTriangles[ j ];
+				}
+				if ( edges[ j ].mTo == edge.mFrom )
+				{
+					t.mNeighbours[ 1 ] = newTriangles[ j ];
+				}
+			}
+			// Outside neighbour now borders new triangle
+			if ( edge.mOutside != NO_TRIANGLE )
+			{
+				BuildTriangle & outside = triangles[ edge.mOutside ];
+				for ( unsigned __int32 j = 0; j < 3; ++j )
+				{
+					if ( outside.mVertices[ ( j + 1 ) % 3 ] == edge.mTo && outside.mVertices[ ( j + 2 ) % 3 ] == edge.mFrom )
+					{
+						outside.mNeighbours[ j ] = newTriangles[ i ];
+					}
+				}
+			}
+		}
+		last = newTriangles.front();
+	}
+	// Keep only triangles without vertices of enclosing triangle
+	mCoordinates.assign( coordinates.begin() + 2 * SUPER_VERTICES_COUNT, coordinates.end() );
+	mGuidesIds.swap( guidesIds );
+	for ( std::vector< BuildTriangle >::const_iterator it = triangles.begin(); it != triangles.end(); ++it )
+	{
+		if ( it->mVertices[ 0 ] >= SUPER_VERTICES_COUNT && it->mVertices[ 1 ] >= SUPER_VERTICES_COUNT &&
+			it->mVertices[ 2 ] >= SUPER_VERTICES_COUNT )
+		{
+			for ( unsigned __int32 i = 0; i < 3; ++i )
+			{
+				mTriangles.push_back( it->mVertices[ i ] - SUPER_VERTICES_COUNT );
+			}
+		}
+	}
+	buildGrid();
+}
+
+bool GuidesTriangulation::getEnclosingTriangle( Real aU, Real aV, GuideId * aGuidesIds, float * aWeights ) const
+{
+	if ( mTriangles.empty() )
+	{
+		return false;
+	}
+	const Real point[ 2 ] = { ( aU - mMinU ) * mScale, ( aV - mMinV ) * mScale };
+	if ( point[ 0 ] < -BARYCENTRIC_TOLERANCE || point[ 1 ] < -BARYCENTRIC_TOLERANCE ||
+		point[ 0 ] > 1 + BARYCENTRIC_TOLERANCE || point[ 1 ] > 1 + BARYCENTRIC_TOLERANCE )
+	{
+		return false; // Outside of all roots
+	}
+	// Test triangles overlapping cell of point
+	const unsigned __int32 cell = selectCell( point[ 1 ] ) * mGridSize + selectCell( point[ 0 ] );
+	for ( unsigned __int32 i = mCellsStarts[ cell ]; i < mCellsStarts[ cell + 1 ]; ++i )
+	{
+		const unsigned __int32 * triangle = &mTriangles[ 3 * mCellsTriangles[ i ] ];
+		const Real * a = &mCoordinates[ 2 * triangle[ 0 ] ];
+		const Real * b = &mCoordinates[ 2 * triangle[ 1 ] ];
+		const Real * c = &mCoordinates[ 2 * triangle[ 2 ] ];
+		const Real area = orientation( a, b, c );
+		if ( area <= 0 ) // Degenerated triangle
+		{
+			continue;
+		}
+		Real weights[ 3 ] = { orientation( b, c, point ) / area, orientation( c, a, point ) / area, 0 };
+		weights[ 2 ] = 1 - weights[ 0 ] - weights[ 1 ];
+		if ( weights[ 0 ] < -BARYCENTRIC_TOLERANCE || weights[ 1 ] < -BARYCENTRIC_TOLERANCE ||
+			weights[ 2 ] < -BARYCENTRIC_TOLERANCE )
+		{
+			continue;
+		}
+		// Point on edge may have slightly negative weights
+		Real sum = 0;
+		for ( unsigned __int32 j = 0; j < 3; ++j )
+		{
+			weights[ j ] = std::max( weights[ j ], static_cast< Real >( 0 ) );
+			sum += weights[ j ];
+		}
+		for ( unsigned __int32 j = 0; j < 3; ++j )
+		{
+			aGuidesIds[ j ] = mGuidesIds[ triangle[ j ] ];
+			aWeights[ j ] = static_cast< float >( weights[ j ] / sum );
+		}
+		return true;
+	}
+	return false;
+}
+
+void GuidesTriangulation::buildGrid()
+{
+	const unsigned __int32 trianglesCount = getTrianglesCount();
+	// Roughly one triangle per cell
+	mGridSize = static_cast< unsigned __int32 >( sqrt( static_cast< Real >( trianglesCount ) ) );
+	mGridSize = std::max( std::min( mGridSize, MAX_GRID_SIZE ), static_cast< unsigned __int32 >( 1 ) );
+	mCellsStarts.assign( mGridSize * mGridSize + 1, 0 );
+	// Count triangles of cells ( triangle is added to every cell overlapping its bounding box ), then fill them
+	std::vector< unsigned __int32 > cellsEnds;
+	for ( unsigned __int32 pass = 0; pass < 2; ++pass )
+	{
+		for ( unsigned __int32 i = 0; i < trianglesCount; ++i )
+		{
+			const Real * a = &mCoordinates[ 2 * mTriangles[ 3 * i ] ];
+			const Real * b = &mCoordinates[ 2 * mTriangles[ 3 * i + 1 ] ];
+			const Real * c = &mCoordinates[ 2 * mTriangles[ 3 * i + 2 ] ];
+			const unsigned __int32 minX = selectCell( std::min( std::min( a[ 0 ], b[ 0 ] ), c[ 0 ] ) );
+			const unsigned __int32 maxX = selectCell( std::max( std::max( a[ 0 ], b[ 0 ] ), c[ 0 ] ) );
+			const unsigned __int32 minY = selectCell( std::min( std::min( a[ 1 ], b[ 1 ] ), c[ 1 ] ) );
+			const unsigned __int32 maxY = selectCell( std::max( std::max( a[ 1 ], b[ 1 ] ), c[ 1 ] ) );
+			for ( unsigned __int32 y = minY; y <= maxY; ++y )
+			{
+				for ( unsigned __int32 x = minX; x <= maxX; ++x )
+				{
+					if ( pass == 0 )
+					{
+						++mCellsStarts[ y * mGridSize + x + 1 ];
+					}
+					else
+					{
+						mCellsTriangles[ cellsEnds[ y * mGridSize + x ]++ ] = i;
+					}
+				}
+			}
+		}
+		if ( pass == 0 )
+		{
+			for ( size_t i = 1; i < mCellsStarts.size(); ++i )
+			{
+				mCellsStarts[ i ] += mCellsStarts[ i - 1 ];
+			}
+			mCellsTriangles.resize( mCellsStarts.back() );
+			cellsEnds.assign( mCellsStarts.begin(), mCellsStarts.end() - 1 );
+		}
+	}
+}
+
+} // namespace HairComponents
+
+} // namespace HairShape
+
+} // namespace Stubble
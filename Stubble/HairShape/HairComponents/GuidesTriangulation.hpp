@@ -0,0 +1,128 @@
+#ifndef STUBBLE_GUIDES_TRIANGULATION_HPP
+#define STUBBLE_GUIDES_TRIANGULATION_HPP
+
+#include "Common\CommonTypes.hpp"
+#include "HairShape\HairComponents\Segments.hpp"
+
+#include <vector>
+
+namespace Stubble
+{
+
+namespace HairShape
+{
+
+namespace HairComponents
+{
+
+///-------------------------------------------------------------------------------------------------
+/// Delaunay triangulation of guides roots of single interpolation group in UV space of rest pose
+/// mesh. Hair root inside some triangle is interpolated only from three guides of that triangle
+/// with its barycentric coordinates as weights, so no closest guides search is needed and weights
+/// change continuously when guides are added or moved.
+/// Triangulation is built by Bowyer-Watson algorithm, roots are inserted along Morton curve, so the
+/// walk to triangle containing inserted root is short. Enclosing triangle of hair root is found by
+/// uniform grid of triangles. Roots outside of triangulation ( outside of convex hull of guides )
+/// are not covered and must be interpolated by other means.
+/// Limitation : triangulation knows only texture coordinates of roots, not the mesh topology, so
+/// triangles may span gaps between UV shells. Hair root of one shell may then be interpolated from
+/// guides of another shell ( far away on mesh ). Shells, which should not share guides, must be
+/// separated by interpolation groups.
+///-------------------------------------------------------------------------------------------------
+class GuidesTriangulation
+{
+public:
+
+	///-------------------------------------------------------------------------------------------------
+	/// Default constructor. Creates empty triangulation.
+	///-------------------------------------------------------------------------------------------------
+	GuidesTriangulation();
+
+	///-------------------------------------------------------------------------------------------------
+	/// Builds triangulation of guides roots. Roots with same texture coordinates as already inserted
+	/// root are ignored.
+	///
+	/// \param	aCoordinates	The texture coordinates of roots ( u, v pairs ).
+	/// \param	aGuidesIds		Identifiers of guides of roots.
+	/// \param	aCount			Number of roots.
+	///-------------------------------------------------------------------------------------------------
+	void build( const Real * aCoordinates, const GuideId * aGuidesIds, unsigned __int32 aCount );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets three guides of triangle enclosing given point and barycentric weights of point.
+	///
+	/// \param	aU					The u texture coordinate of point.
+	/// \param	aV					The v texture coordinate of point.
+	/// \param [in,out]	aGuidesIds	The identifiers of three guides of enclosing triangle.
+	/// \param [in,out]	aWeights	The weights of three guides ( sum to 1 ).
+	///
+	/// \return	true if point lies inside triangulation.
+	///-------------------------------------------------------------------------------------------------
+	bool getEnclosingTriangle( Real aU, Real aV, GuideId * aGuidesIds, float * aWeights ) const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the number of triangles.
+	///
+	/// \return	The triangles count.
+	///-------------------------------------------------------------------------------------------------
+	inline unsigned __int32 getTrianglesCount() const;
+
+private:
+
+	///-------------------------------------------------------------------------------------------------
+	/// Builds uniform grid of triangles used for enclosing triangle queries.
+	///-------------------------------------------------------------------------------------------------
+	void buildGrid();
+
+	///-------------------------------------------------------------------------------------------------
+	/// Selects grid cell coordinate of normalized coordinate.
+	///
+	/// \param	aCoordinate	The normalized coordinate.
+	///
+	/// \return	The cell coordinate.
+	///-------------------------------------------------------------------------------------------------
+	inline unsigned __int32 selectCell( Real aCoordinate ) const;
+
+	std::vector< Real > mCoordinates;   ///< The normalized coordinates of triangulated roots ( x, y pairs )
+
+	std::vector< GuideId > mGuidesIds;  ///< The guide of every triangulated root
+
+	std::vector< unsigned __int32 > mTriangles; ///< The indices of roots of triangles ( counter-clockwise triples )
+
+	std::vector< unsigned __int32 > mCellsStarts;   ///< The start of triangles list of every grid cell ( and the end )
+
+	std::vector< unsigned __int32 > mCellsTriangles;	///< The triangles overlapping grid cells
+
+	unsigned __int32 mGridSize; ///< Number of grid cells along each axis
+
+	Real mMinU; ///< The minimal u coordinate of roots
+
+	Real mMinV; ///< The minimal v coordinate of roots
+
+	Real mScale;	///< The scale of normalized coordinates ( inverse of larger extent of roots )
+};
+
+// inline functions implementation
+
+inline unsigned __int32 GuidesTriangulation::getTrianglesCount() const
+{
+	return static_cast< unsigned __int32 >( mTriangles.size() / 3 );
+}
+
+inline unsigned __int32 GuidesTriangulation::selectCell( Real aCoordinate ) const
+{
+	const Real cell = aCoordinate * mGridSize;
+	if ( cell <= 0 )
+	{
+		return 0;
+	}
+	return cell >= mGridSize ? mGridSize - 1 : static_cast< unsigned __int32 >( cell );
+}
+
+} // namespace HairComponents
+
+} // namespace HairShape
+
+} // namespace Stubble
+
+#endif // STUBBLE_GUIDES_TRIANGULATION_HPP
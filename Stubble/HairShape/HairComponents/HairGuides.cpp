@@ -171,11 +171,14 @@ void HairGuides::resetGuides( Real aScaleFactor )
 	mBoundingBoxDirtyFlag = true;
 }
 
-const RestPositionsDS & HairGuides::getGuidesPositionsDS( const Interpolation::InterpolationGroups & aInterpolationGroups )
+const RestPositionsDS & HairGuides::getGuidesPositionsDS( const Interpolation::InterpolationGroups & aInterpolationGroups,
+	bool aBuildTriangulations )
 {
-	if ( mRestPositionsDS.isDirty() ) // Is segments UG up-to-date ?
+	// Is segments UG up-to-date ? Triangulations are kept once built, until rest positions change
+	if ( mRestPositionsDS.isDirty() || ( aBuildTriangulations && !mRestPositionsDS.hasTriangulations() ) )
 	{
-		mRestPositionsDS.build( mRestPositions, aInterpolationGroups );
+		mRestPositionsDS.build( mRestPositions, aInterpolationGroups, 
+			aBuildTriangulations || mRestPositionsDS.hasTriangulations() );
 	}
 	return mRestPositionsDS;
 }
@@ -462,7 +465,7 @@ void HairGuides::generate( UVPointGenerator & aUVPointGenerator, const MayaMesh
 		{
 			throw StubbleException(" HairGuides::generate : No old segments to interpolate from ! ");
 		}
-		tmpSegmentsStorage = new SegmentsStorage( *mSegmentsStorage, getGuidesPositionsDS( aInterpolationGroups ), 
+		tmpSegmentsStorage = new SegmentsStorage( *mSegmentsStorage, getGuidesPositionsDS( aInterpolationGroups, false ), 
 			tmpRestPositions, aInterpolationGroups, mNumberOfGuidesToInterpolateFrom );
 	}
 	else
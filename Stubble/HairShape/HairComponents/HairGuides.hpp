@@ -128,10 +128,13 @@ public:
 	/// inside this class and updated only when this method is called ( and only if necessary ). 
 	///
 	/// \param	aInterpolationGroups	the interpolation groups object 
+	/// \param	aBuildTriangulations	true if guides triangulations are needed ( they are built only
+	/// 								once they are requested ).
 	///
 	/// \return	The guides positions data structure. 
 	///----------------------------------------------------------------------------------------------------
-	const RestPositionsDS & getGuidesPositionsDS( const Interpolation::InterpolationGroups & aInterpolationGroups );
+	const RestPositionsDS & getGuidesPositionsDS( const Interpolation::InterpolationGroups & aInterpolationGroups,
+		bool aBuildTriangulations );
 
 	///----------------------------------------------------------------------------------------------------
 	/// Draws hair guides.
@@ -1,7 +1,10 @@
 #include "RestPositionsDS.hpp"
 
+#include "Common\StubbleException.hpp"
 
+#include <algorithm>
 #include <assert.h>
+#include <cmath>
 #include <limits>
 #include <vector>
 
@@ -16,7 +19,7 @@ namespace HairShape
 namespace HairComponents
 {
 
-const float MAX_FLOAT_SQUARE_ROOT = std::sqrtf( std::numeric_limits< float >::max() );  ///< The maximum float square root
+const float MAX_FLOAT_SQUARE_ROOT = std::sqrt( std::numeric_limits< float >::max() );  ///< The maximum float square root
 
 RestPositionsDS::RestPositionsDS():
 	mDirtyBit( true ),
@@ -31,7 +34,7 @@ RestPositionsDS::~RestPositionsDS()
 }
 
 void RestPositionsDS::build( const GuidesRestPositions & aGuidesRestPositions, 
-	const Interpolation::InterpolationGroups & aInterpolationGroups )
+	const Interpolation::InterpolationGroups & aInterpolationGroups, bool aBuildTriangulations )
 {
 	// Copies only positions to local store
 	mGuidesRestPositions.resize( aGuidesRestPositions.size() );
@@ -47,31 +50,100 @@ void RestPositionsDS::build( const GuidesRestPositions & aGuidesRestPositions,
 		posIt->mVCoordinate = cIt->mPosition.getVCoordinate(); // Copy V
 	}
 	// Builds UG
-	innerBuild( aInterpolationGroups );
+	innerBuild( aInterpolationGroups, aBuildTriangulations );
 }
 
 void RestPositionsDS::getNClosestGuides( const Vector3D< Real > & aPosition, unsigned __int32 aInterpolationGroupId,
 		unsigned __int32 aN, ClosestGuides & aClosestGuidesIds ) const
+{
+	ClosestGuidesQuery query;
+	getNClosestGuides( aPosition, aInterpolationGroupId, aN, query );
+	aClosestGuidesIds.swap( query.mClosestGuides );
+}
+
+void RestPositionsDS::getNClosestGuides( const Vector3D< Real > & aPosition, unsigned __int32 aInterpolationGroupId,
+		unsigned __int32 aN, ClosestGuidesQuery & aQuery ) const
+{
+	const unsigned __int32 found = executeQuery( aPosition, aInterpolationGroupId, aN, aQuery.mQuery );
+	// Fill results ( vector keeps its capacity, so it is only reallocated if it grows )
+	aQuery.mClosestGuides.resize( found );
+	for( unsigned __int32 i = 0; i < found; ++i )
+	{
+		aQuery.mClosestGuides[ i ] = IdAndDistance( aQuery.mQuery.indeces[ i + 1 ], aQuery.mQuery.dist2[ i + 1 ] );
+	}
+}
+
+void RestPositionsDS::getNClosestGuides( const Vector3D< Real > * aPositions, 
+	const unsigned __int32 * aInterpolationGroupIds, unsigned __int32 aCount, unsigned __int32 aN, 
+	ClosestGuidesQuery & aQuery, IdAndDistance * aClosestGuides, unsigned __int32 * aClosestGuidesCounts ) const
+{
+	if ( aCount == 0 )
+	{
+		return;
+	}
+	// Calculate bounding box of positions for Morton codes quantization
+	Vector3D< Real > min = aPositions[ 0 ], max = aPositions[ 0 ];
+	for ( const Vector3D< Real > * it = aPositions + 1, * end = aPositions + aCount; it != end; ++it )
+	{
+		min.x = std::min( min.x, it->x );
+		min.y = std::min( min.y, it->y );
+		min.z = std::min( min.z, it->z );
+		max.x = std::max( max.x, it->x );
+		max.y = std::max( max.y, it->y );
+		max.z = std::max( max.z, it->z );
+	}
+	static const Real QUANTIZATION = 1023; // 10 bits per axis
+	const Real extent = std::max( std::max( max.x - min.x, max.y - min.y ), max.z - min.z );
+	const Real scale = extent > 0 ? QUANTIZATION / extent : 0;
+	// Sort key : interpolation group in upper 32 bits, Morton code of position in lower 30 bits
+	aQuery.mOrder.resize( aCount );
+	for ( unsigned __int32 i = 0; i < aCount; ++i )
+	{
+		unsigned __int64 code = 0;
+		const unsigned __int32 x = static_cast< unsigned __int32 >( ( aPositions[ i ].x - min.x ) * scale );
+		const unsigned __int32 y = static_cast< unsigned __int32 >( ( aPositions[ i ].y - min.y ) * scale );
+		const unsigned __int32 z = static_cast< unsigned __int32 >( ( aPositions[ i ].z - min.z ) * scale );
+		for ( unsigned __int32 bit = 0; bit < 10; ++bit )
+		{
+			code |= static_cast< unsigned __int64 >( ( ( x >> bit ) & 1 ) | ( ( ( y >> bit ) & 1 ) << 1 ) | 
+				( ( ( z >> bit ) & 1 ) << 2 ) ) << ( 3 * bit );
+		}
+		aQuery.mOrder[ i ].first = ( static_cast< unsigned __int64 >( aInterpolationGroupIds[ i ] ) << 32 ) | code;
+		aQuery.mOrder[ i ].second = i;
+	}
+	std::sort( aQuery.mOrder.begin(), aQuery.mOrder.end() );
+	// Execute queries in sorted order, results are stored in order of positions
+	for ( ClosestGuidesQuery::QueriesOrder::const_iterator it = aQuery.mOrder.begin(); it != aQuery.mOrder.end(); ++it )
+	{
+		const unsigned __int32 i = it->second;
+		const unsigned __int32 found = executeQuery( aPositions[ i ], aInterpolationGroupIds[ i ], aN, aQuery.mQuery );
+		IdAndDistance * closestGuides = aClosestGuides + static_cast< size_t >( i ) * aN;
+		for( unsigned __int32 j = 0; j < found; ++j )
+		{
+			closestGuides[ j ] = IdAndDistance( aQuery.mQuery.indeces[ j + 1 ], aQuery.mQuery.dist2[ j + 1 ] );
+		}
+		aClosestGuidesCounts[ i ] = found;
+	}
+}
+
+inline unsigned __int32 RestPositionsDS::executeQuery( const Vector3D< Real > & aPosition, 
+	unsigned __int32 aInterpolationGroupId, unsigned __int32 aN, KdTree::CKNNQuery & aQuery ) const
 {
 	// Structure can not be dirty
 	assert( !mDirtyBit );
-	// Convert position to float
-	Vector3D< float > pos( static_cast< float >( aPosition.x ), static_cast< float >( aPosition.y ), 
-			static_cast< float >( aPosition.z ));
 	if ( mKdForest[ aInterpolationGroupId ].GetNumPoints() < 1 )
 	{
-		aClosestGuidesIds.clear();
-		return;
+		return 0;
 	}
-	// Init query
-	KdTree::CKNNQuery query( aN );
-	query.Init( pos , aN, MAX_FLOAT_SQUARE_ROOT );
+	// Convert position to float
+	Vector3D< float > pos( static_cast< float >( aPosition.x ), static_cast< float >( aPosition.y ), 
+			static_cast< float >( aPosition.z ));
+	// Init query ( memory is only allocated if query has not been used for so many guides yet )
+	aQuery.Reserve( static_cast< int >( aN ) );
+	aQuery.Init( pos , static_cast< int >( aN ), MAX_FLOAT_SQUARE_ROOT );
 	// Execute query
-    mKdForest[ aInterpolationGroupId ].KNNQuery(query, mKdForest[ aInterpolationGroupId ].truePred);
-	// Fill results
-	aClosestGuidesIds.resize( query.found );
-	for( int i = 0; i < query.found; ++i )
-		aClosestGuidesIds[ i ] = IdAndDistance( query.indeces[ i + 1 ], query.dist2[ i + 1 ] );
+	mKdForest[ aInterpolationGroupId ].KNNQuery( aQuery, mKdForest[ aInterpolationGroupId ].truePred );
+	return static_cast< unsigned __int32 >( aQuery.found );
 }
 
 void RestPositionsDS::exportToFile( std::ostream & aOutputStream ) const
@@ -92,7 +164,62 @@ void RestPositionsDS::exportToFile( std::ostream & aOutputStream ) const
 }
 
 void RestPositionsDS::importFromFile( std::istream & aInputStream, 
-	const Interpolation::InterpolationGroups & aInterpolationGroups )
+	const Interpolation::InterpolationGroups & aInterpolationGroups, bool aBuildTriangulations )
+{
+	importPositions( aInputStream );
+	// Builds UG
+	innerBuild( aInterpolationGroups, aBuildTriangulations );
+}
+
+void RestPositionsDS::exportKdForestToFile( std::ostream & aOutputStream ) const
+{
+	// Structure can not be dirty
+	assert( !mDirtyBit );
+	// First export forest size
+	aOutputStream.write( reinterpret_cast< const char * >( &mForestSize ), sizeof( unsigned __int32 ) );
+	// For every tree
+	for( unsigned __int32 i = 0; i < mForestSize; ++i )
+	{
+		mKdForest[ i ].ExportBalanced( aOutputStream );
+	}
+}
+
+void RestPositionsDS::importFromFile( std::istream & aInputStream, std::istream & aKdForestStream,
+	const Interpolation::InterpolationGroups & aInterpolationGroups, bool aBuildTriangulations )
+{
+	importPositions( aInputStream );
+	// Import forest size
+	unsigned __int32 forestSize = 0;
+	aKdForestStream.read( reinterpret_cast< char * >( &forestSize ), sizeof( unsigned __int32 ) );
+	if ( forestSize != aInterpolationGroups.getGroupsCount() )
+	{
+		throw StubbleException(" RestPositionsDS::importFromFile : kd forest does not match interpolation groups ! ");
+	}
+	// Allocate forest
+	delete[] mKdForest;
+	mForestSize = forestSize;
+	mKdForest = new KdTree[ mForestSize ];
+	// Import balanced trees, tree nodes point to imported rest positions
+	FloatVector * firstPosition = mGuidesRestPositions.empty() ? 0 : &mGuidesRestPositions.front().mPosition;
+	for( unsigned __int32 i = 0; i < mForestSize; ++i )
+	{
+		if ( !mKdForest[ i ].ImportBalanced( aKdForestStream, firstPosition, sizeof( Position ), 
+			mGuidesRestPositions.size() ) )
+		{
+			throw StubbleException(" RestPositionsDS::importFromFile : corrupted kd forest ! ");
+		}
+	}
+	// Triangulations are expensive and only needed by triangulation interpolation mode
+	mTriangulations.clear();
+	if ( aBuildTriangulations )
+	{
+		buildTriangulations( aInterpolationGroups );
+	}
+	// Import is done
+	mDirtyBit = false;
+}
+
+void RestPositionsDS::importPositions( std::istream & aInputStream )
 {
 	// First import rest positions size
 	unsigned __int32 size;
@@ -107,11 +234,10 @@ void RestPositionsDS::importFromFile( std::istream & aInputStream,
 		aInputStream.read( reinterpret_cast< char * >( &it->mUCoordinate ), sizeof( Real ) );
 		aInputStream.read( reinterpret_cast< char * >( &it->mVCoordinate ), sizeof( Real ) );
 	}
-	// Builds UG
-	innerBuild( aInterpolationGroups );
 }
 
-void RestPositionsDS::innerBuild( const Interpolation::InterpolationGroups & aInterpolationGroups )
+void RestPositionsDS::innerBuild( const Interpolation::InterpolationGroups & aInterpolationGroups, 
+	bool aBuildTriangulations )
 {
 	// Prepare group ids
 	GroupIds groupIds( mGuidesRestPositions.size() );
@@ -148,10 +274,38 @@ void RestPositionsDS::innerBuild( const Interpolation::InterpolationGroups & aIn
 	{
 		mKdForest[ i ].BuildUp();
 	}
+	// Triangulations are expensive and only needed by triangulation interpolation mode
+	mTriangulations.clear();
+	if ( aBuildTriangulations )
+	{
+		buildTriangulations( aInterpolationGroups );
+	}
 	// Build is done
 	mDirtyBit = false;
 }
 
+void RestPositionsDS::buildTriangulations( const Interpolation::InterpolationGroups & aInterpolationGroups )
+{
+	// Split texture coordinates of roots by interpolation groups
+	std::vector< std::vector< Real > > coordinates( aInterpolationGroups.getGroupsCount() );
+	std::vector< GuidesIds > guidesIds( aInterpolationGroups.getGroupsCount() );
+	for ( unsigned __int32 i = 0; i < mGuidesRestPositions.size(); ++i )
+	{
+		const Position & pos = mGuidesRestPositions[ i ];
+		const unsigned __int32 groupId = aInterpolationGroups.getGroupId( pos.mUCoordinate, pos.mVCoordinate );
+		coordinates[ groupId ].push_back( pos.mUCoordinate );
+		coordinates[ groupId ].push_back( pos.mVCoordinate );
+		guidesIds[ groupId ].push_back( i );
+	}
+	// Triangulate every group
+	mTriangulations.resize( aInterpolationGroups.getGroupsCount() );
+	for( unsigned __int32 i = 0; i < mTriangulations.size(); ++i )
+	{
+		mTriangulations[ i ].build( coordinates[ i ].empty() ? 0 : &coordinates[ i ][ 0 ], 
+			guidesIds[ i ].empty() ? 0 : &guidesIds[ i ][ 0 ], static_cast< unsigned __int32 >( guidesIds[ i ].size() ) );
+	}
+}
+
 } // namespace HairComponents
 
 } // namespace HairShape
@@ -2,12 +2,15 @@
 #define STUBBLE_REST_POSITIONS_DS_HPP
 
 #include "HairShape\HairComponents\GuidePosition.hpp"
+#include "HairShape\HairComponents\GuidesTriangulation.hpp"
 #include "HairShape\HairComponents\Segments.hpp"
 #include "HairShape\Interpolation\InterpolationGroups.hpp"
 
 #include "kdtmpl.h"
 
 #include <fstream>
+#include <utility>
+#include <vector>
 
 namespace Stubble
 {
@@ -56,13 +59,69 @@ typedef Vector3D< float > FloatVector;
 ///----------------------------------------------------------------------------------------------------
 typedef KdTreeTmplPtr< FloatVector, FloatVector > KdTree;
 
+///-------------------------------------------------------------------------------------------------
+/// Reusable memory of closest guides queries. Once the query has been executed for the largest
+/// requested number of guides, following queries do not allocate any memory.
+/// Every thread must use its own query object.
+///-------------------------------------------------------------------------------------------------
+class ClosestGuidesQuery
+{
+	friend class RestPositionsDS; // Fills query memory
+
+public:
+
+	///-------------------------------------------------------------------------------------------------
+	/// Default constructor. 
+	///-------------------------------------------------------------------------------------------------
+	inline ClosestGuidesQuery();
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the closest guides found by the last single position query.
+	///
+	/// \return	The closest guides.
+	///-------------------------------------------------------------------------------------------------
+	inline const ClosestGuides & getClosestGuides() const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the closest guides found by the last single position query.
+	///
+	/// \return	The closest guides ( can be modified by caller ).
+	///-------------------------------------------------------------------------------------------------
+	inline ClosestGuides & getClosestGuides();
+
+private:
+
+	///-------------------------------------------------------------------------------------------------
+	/// Copy constructor ( query owns its memory, so it can not be copied ). 
+	///-------------------------------------------------------------------------------------------------
+	ClosestGuidesQuery( const ClosestGuidesQuery & );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Assignment operator ( query owns its memory, so it can not be copied ). 
+	///-------------------------------------------------------------------------------------------------
+	ClosestGuidesQuery & operator=( const ClosestGuidesQuery & );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Defines an alias representing the order of batch queries ( sort key and position index ).
+	///-------------------------------------------------------------------------------------------------
+	typedef std::vector< std::pair< unsigned __int64, unsigned __int32 > > QueriesOrder;
+
+	KdTree::CKNNQuery mQuery;   ///< The KD tree query
+
+	ClosestGuides mClosestGuides;   ///< The closest guides of the last single position query
+
+	QueriesOrder mOrder;	///< The spatially sorted order of batch queries
+};
+
 ///-------------------------------------------------------------------------------------------------
 /// Guides' roots rest positions data structure for closest points queries.
 /// Roots of guides of different interpolation groups are stored in separate KD trees,
 /// any query is executed only for one requested interpolation group.
 /// Enables queries for n closest guides' roots in requested interpolation group from given point.
+/// Roots of every interpolation group are also triangulated in UV space, so the enclosing triangle
+/// of guides can be queried instead of closest guides.
 /// Can export/import rest position roots of guides to/from binary stream, during import KD trees 
-/// are rebuild.
+/// are rebuild. Already balanced KD trees can be exported/imported as well, so the rebuild is avoided.
 /// This class uses float numbers instead of Real, because KD tree structure also uses only float.
 ///-------------------------------------------------------------------------------------------------
 class RestPositionsDS
@@ -83,12 +142,14 @@ public:
 	///-------------------------------------------------------------------------------------------------
 	/// Builds the internal KD Trees for closest points queries.
 	/// Roots of guides of different interpolation groups are stored in separate KD trees. 
+	/// Guides triangulations are only built if requested, otherwise getEnclosingGuides always fails.
 	///
 	/// \param	aGuidesRestPositions	The guides rest positions. 
 	/// \param	aInterpolationGroups	The interpolation groups.
+	/// \param	aBuildTriangulations	true to build guides triangulations.
 	///-------------------------------------------------------------------------------------------------
 	void build( const GuidesRestPositions & aGuidesRestPositions, 
-		const Interpolation::InterpolationGroups & aInterpolationGroups );
+		const Interpolation::InterpolationGroups & aInterpolationGroups, bool aBuildTriangulations );
 
 	///-------------------------------------------------------------------------------------------------
 	/// Gets the n closest guides from requested position in world coordinates.
@@ -102,6 +163,53 @@ public:
 	void getNClosestGuides( const Vector3D< Real > & aPosition, unsigned __int32 aInterpolationGroupId,
 		unsigned __int32 aN, ClosestGuides & aClosestGuides ) const;
 
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the n closest guides from requested position in world coordinates without allocating any
+	/// memory ( all memory is taken from reusable query object ). Only guides from requested 
+	/// interpolation group are returned.
+	///
+	/// \param	aPosition					The requested position in world coordinates. 
+	/// \param	aInterpolationGroupId		Identifier for a interpolation group. 
+	/// \param	aN							Number of closest guides to return. 
+	/// \param [in,out]	aQuery				The reusable query, closest guides are stored in it. 
+	///-------------------------------------------------------------------------------------------------
+	void getNClosestGuides( const Vector3D< Real > & aPosition, unsigned __int32 aInterpolationGroupId,
+		unsigned __int32 aN, ClosestGuidesQuery & aQuery ) const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the n closest guides for every position of array. Positions are queried in spatially 
+	/// sorted order ( grouped by interpolation group and sorted along Morton curve ), so the following 
+	/// queries traverse the same parts of KD tree. Results are stored in order of positions, closest
+	/// guides of i-th position start at aClosestGuides[ i * aN ] and are returned in the same order
+	/// as by single position query.
+	///
+	/// \param	aPositions					The requested positions in world coordinates. 
+	/// \param	aInterpolationGroupIds		Identifiers of interpolation groups of positions. 
+	/// \param	aCount						Number of positions. 
+	/// \param	aN							Number of closest guides to return for every position. 
+	/// \param [in,out]	aQuery				The reusable query. 
+	/// \param [in,out]	aClosestGuides		The closest guides ( aCount * aN items ). 
+	/// \param [in,out]	aClosestGuidesCounts	Numbers of found closest guides ( aCount items ). 
+	///-------------------------------------------------------------------------------------------------
+	void getNClosestGuides( const Vector3D< Real > * aPositions, const unsigned __int32 * aInterpolationGroupIds,
+		unsigned __int32 aCount, unsigned __int32 aN, ClosestGuidesQuery & aQuery, IdAndDistance * aClosestGuides,
+		unsigned __int32 * aClosestGuidesCounts ) const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets three guides of requested interpolation group, which roots triangle encloses requested
+	/// texture coordinates, and barycentric weights of these guides.
+	///
+	/// \param	aU						The requested u texture coordinate. 
+	/// \param	aV						The requested v texture coordinate. 
+	/// \param	aInterpolationGroupId	Identifier for a interpolation group. 
+	/// \param [in,out]	aGuidesIds		The identifiers of three guides. 
+	/// \param [in,out]	aWeights		The weights of three guides. 
+	///
+	/// \return	true if texture coordinates lie inside triangulation of interpolation group.
+	///-------------------------------------------------------------------------------------------------
+	inline bool getEnclosingGuides( Real aU, Real aV, unsigned __int32 aInterpolationGroupId, 
+		GuideId * aGuidesIds, float * aWeights ) const;
+
 	///-------------------------------------------------------------------------------------------------
 	/// Informs the structure about changes of roots rest pose positions or change of interpolation 
 	/// groups.
@@ -117,6 +225,13 @@ public:
 	///-------------------------------------------------------------------------------------------------
 	inline bool isDirty() const;
 
+	///-------------------------------------------------------------------------------------------------
+	/// Query if guides triangulations have been built. 
+	///
+	/// \return	true if triangulations have been built.
+	///-------------------------------------------------------------------------------------------------
+	inline bool hasTriangulations() const;
+
 	///-------------------------------------------------------------------------------------------------
 	/// Exports data structure to file.
 	/// Only roots rest positions and texture coordinates are exported to binary stream, KD trees will
@@ -131,22 +246,73 @@ public:
 	/// Imports data from file and builds the internal data structures.
 	/// Only roots rest positions and texture coordinates are imported, KD trees are rebuild afterwards.
 	/// Texture coordinates are used to distinguish guide's interpolation group.
+	/// Guides triangulations are only built if requested, otherwise getEnclosingGuides always fails.
 	///
 	/// \param [in,out]	aInputStream	The input stream. 
 	/// \param	aInterpolationGroups	The interpolation groups.
+	/// \param	aBuildTriangulations	true to build guides triangulations.
 	///-------------------------------------------------------------------------------------------------
 	void importFromFile( std::istream & aInputStream,
-		const Interpolation::InterpolationGroups & aInterpolationGroups );
+		const Interpolation::InterpolationGroups & aInterpolationGroups, bool aBuildTriangulations );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Exports balanced KD trees to file. Trees only refer to rest positions by their indices, so
+	/// rest positions must be exported by exportToFile too.
+	///
+	/// \param [in,out]	aOutputStream	The output stream. 
+	///-------------------------------------------------------------------------------------------------
+	void exportKdForestToFile( std::ostream & aOutputStream ) const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Imports roots rest positions and already balanced KD trees from files. KD trees are not rebuild.
+	/// Guides triangulations are only built if requested, otherwise getEnclosingGuides always fails.
+	///
+	/// \param [in,out]	aInputStream		The input stream of rest positions ( see exportToFile ). 
+	/// \param [in,out]	aKdForestStream		The input stream of KD trees ( see exportKdForestToFile ). 
+	/// \param	aInterpolationGroups		The interpolation groups.
+	/// \param	aBuildTriangulations		true to build guides triangulations.
+	///-------------------------------------------------------------------------------------------------
+	void importFromFile( std::istream & aInputStream, std::istream & aKdForestStream,
+		const Interpolation::InterpolationGroups & aInterpolationGroups, bool aBuildTriangulations );
 
 private:
 
+	///-------------------------------------------------------------------------------------------------
+	/// Imports roots rest positions from file. 
+	///
+	/// \param [in,out]	aInputStream	The input stream. 
+	///-------------------------------------------------------------------------------------------------
+	void importPositions( std::istream & aInputStream );
+
 	///-------------------------------------------------------------------------------------------------
 	/// Builds the KD trees from already stored guides rest positions.
 	/// Builds separete tree for every interpolation group. 
 	/// 
 	/// \param	aInterpolationGroups	The interpolation groups.
+	/// \param	aBuildTriangulations	true to build guides triangulations too.
 	///-------------------------------------------------------------------------------------------------
-	void innerBuild( const Interpolation::InterpolationGroups & aInterpolationGroups );
+	void innerBuild( const Interpolation::InterpolationGroups & aInterpolationGroups, bool aBuildTriangulations );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Builds triangulations of roots from already stored guides rest positions.
+	/// Builds separate triangulation for every interpolation group. 
+	/// 
+	/// \param	aInterpolationGroups	The interpolation groups.
+	///-------------------------------------------------------------------------------------------------
+	void buildTriangulations( const Interpolation::InterpolationGroups & aInterpolationGroups );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Executes closest guides query in KD tree of interpolation group. 
+	///
+	/// \param	aPosition				The requested position in world coordinates. 
+	/// \param	aInterpolationGroupId	Identifier for a interpolation group. 
+	/// \param	aN						Number of closest guides to return. 
+	/// \param [in,out]	aQuery			The KD tree query. 
+	///
+	/// \return	Number of found guides.
+	///-------------------------------------------------------------------------------------------------
+	inline unsigned __int32 executeQuery( const Vector3D< Real > & aPosition, unsigned __int32 aInterpolationGroupId,
+		unsigned __int32 aN, KdTree::CKNNQuery & aQuery ) const;
 
 	///-------------------------------------------------------------------------------------------------
 	/// Rest position of guide root.
@@ -183,10 +349,26 @@ private:
 	KdTree *mKdForest;	///< KDTree forest for closest points query ( separate tree for each interpolation group )
 
 	unsigned int mForestSize;	///< Size of the forrest
+
+	std::vector< GuidesTriangulation > mTriangulations;	///< Triangulations of roots ( one for each interpolation group )
 };
 
 // inline functions implementation
 
+inline ClosestGuidesQuery::ClosestGuidesQuery()
+{
+}
+
+inline const ClosestGuides & ClosestGuidesQuery::getClosestGuides() const
+{
+	return mClosestGuides;
+}
+
+inline ClosestGuides & ClosestGuidesQuery::getClosestGuides()
+{
+	return mClosestGuides;
+}
+
 inline void RestPositionsDS::setDirty()
 {
 	mDirtyBit = true;
@@ -197,6 +379,18 @@ inline bool RestPositionsDS::isDirty() const
 	return mDirtyBit;
 }
 
+inline bool RestPositionsDS::hasTriangulations() const
+{
+	return !mTriangulations.empty();
+}
+
+inline bool RestPositionsDS::getEnclosingGuides( Real aU, Real aV, unsigned __int32 aInterpolationGroupId, 
+	GuideId * aGuidesIds, float * aWeights ) const
+{
+	return aInterpolationGroupId < mTriangulations.size() && 
+		mTriangulations[ aInterpolationGroupId ].getEnclosingTriangle( aU, aV, aGuidesIds, aWeights );
+}
+
 } // namespace HairComponents
 
 } // namespace HairShape
@@ -12,6 +12,8 @@
 //#include "Vec3.h"
 
 // standard headers
+#include <istream>
+#include <ostream>
 #include <vector>
 
 /// Kd-tree data structure by Henrik Wann Jensen.
@@ -104,18 +106,33 @@ public:
     float     *dist2;
     const     T **index;
 	unsigned int *indeces;
+    int       capacity;
 
-    CKNNQuery(int maxGatherCount)
+    CKNNQuery() : max(0), found(0), got_heap(0), dist2(0), index(0), indeces(0), capacity(0)
     {
-      dist2 = new float [maxGatherCount + 1];
-      index = new T const*[maxGatherCount + 1];
-	  indeces = new unsigned int [maxGatherCount + 1];
+    }
+    CKNNQuery(int maxGatherCount) : dist2(0), index(0), indeces(0), capacity(0)
+    {
+      Reserve(maxGatherCount);
     }
     ~CKNNQuery()
     {
       delete [] dist2; delete [] index; delete[] indeces;
     }
 
+    /// Makes the query able to gather maxGatherCount items, memory is only reallocated if it grows,
+    /// so the same query object can be reused without any allocation
+    inline void Reserve(int maxGatherCount)
+    {
+      if (maxGatherCount <= capacity)
+        return;
+      delete [] dist2; delete [] index; delete[] indeces;
+      dist2 = new float [maxGatherCount + 1];
+      index = new T const*[maxGatherCount + 1];
+      indeces = new unsigned int [maxGatherCount + 1];
+      capacity = maxGatherCount;
+    }
+
     inline void Init(const TVec3 &p, int maxphotons, float initrad) 
     {
       pos      = p; 
@@ -159,6 +176,14 @@ public:
      It balances kd-tree before searching.
   */
   void BuildUp();
+
+  /// Writes the balanced tree (bbox and item index and split plane of every node) to binary stream.
+  void ExportBalanced(std::ostream &os) const;
+
+  /// Reads the tree balanced by BuildUp and written by ExportBalanced, no balancing is done.
+  /// Item of every node is found by its index as (char*)firstItem + index * itemStride.
+  /// Returns false if the stream fails or an item index is not smaller than itemCount.
+  bool ImportBalanced(std::istream &is, T* firstItem, size_t itemStride, size_t itemCount);
 							   
   /// Finds items within a given radius from the center.
   template<class Tlist>
@@ -332,6 +357,60 @@ KdTreeTmplPtr<T,TVec3>::Init( T* array, size_t length )
 	BuildUp();
 }
 
+// --------------------------------------------------------------------
+//   KdTreeTmplPtr::ExportBalanced()
+// --------------------------------------------------------------------
+template<class T, class TVec3>
+void
+KdTreeTmplPtr<T,TVec3>::ExportBalanced(std::ostream &os) const
+{
+  os.write((const char*)&_numPoints, sizeof(int));
+  for (int i=0; i<3; i++) {
+    const float bboxMin = _bbox_min[i], bboxMax = _bbox_max[i];
+    os.write((const char*)&bboxMin, sizeof(float));
+    os.write((const char*)&bboxMax, sizeof(float));
+  }
+  for (int i=1; i<=_numPoints; i++) {
+    const unsigned int index = _points[i].GetIndex();
+    // leaves are copied by _balanceSegment without setting the plane
+    const int plane = 2*i <= _numPoints ? _points[i].GetPlane() : 0;
+    os.write((const char*)&index, sizeof(unsigned int));
+    os.write((const char*)&plane, sizeof(int));
+  }
+}
+
+// --------------------------------------------------------------------
+//   KdTreeTmplPtr::ImportBalanced()
+// --------------------------------------------------------------------
+template<class T, class TVec3>
+bool
+KdTreeTmplPtr<T,TVec3>::ImportBalanced(std::istream &is, T* firstItem, size_t itemStride, size_t itemCount)
+{
+  Clear();
+  int numPoints = 0;
+  is.read((char*)&numPoints, sizeof(int));
+  if (!is || numPoints < 0 || (size_t)numPoints > itemCount)
+    return false;
+  for (int i=0; i<3; i++) {
+    is.read((char*)&_bbox_min[i], sizeof(float));
+    is.read((char*)&_bbox_max[i], sizeof(float));
+  }
+  _points.resize(numPoints+1);
+  for (int i=1; i<=numPoints; i++) {
+    unsigned int index;
+    int plane;
+    is.read((char*)&index, sizeof(unsigned int));
+    is.read((char*)&plane, sizeof(int));
+    if (!is || index >= itemCount || plane < 0 || plane > 2)
+      return false;
+    _points[i] = CTreeNode((T*)((char*)firstItem + index * itemStride), index);
+    _points[i].SetPlane(plane);
+  }
+  _numPoints = numPoints;
+  _halfNumPoints = _numPoints / 2 - 1;
+  return true;
+}
+
 // --------------------------------------------------------------------
 //  KdTreeTmplPtr::_medianSplit()
 // --------------------------------------------------------------------
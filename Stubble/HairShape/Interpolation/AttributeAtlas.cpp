@@ -0,0 +1,142 @@
+#include "AttributeAtlas.hpp"
+
+#include "HairProperties.hpp"
+
+#include <algorithm>
+
+namespace Stubble
+{
+
+namespace HairShape
+{
+
+namespace Interpolation
+{
+
+AttributeAtlas::AttributeAtlas():
+	mWidth( 1 ),
+	mHeight( 1 )
+{
+	std::fill( mUniforms, mUniforms + ATTRIBUTES_COUNT, 1.0f );
+}
+
+void AttributeAtlas::build( const HairProperties & aHairProperties )
+{
+	// Fold constant textures to uniforms and select atlas resolution
+	mWidth = mHeight = 1;
+	mChannels.clear();
+	std::vector< std::pair< const Texture *, unsigned __int32 > > varying;
+	addTexture( aHairProperties.getScaleTexture(), SCALE, 1, varying );
+	addTexture( aHairProperties.getRandScaleTexture(), RAND_SCALE, 1, varying );
+	addTexture( aHairProperties.getRootThicknessTexture(), ROOT_THICKNESS, 1, varying );
+	addTexture( aHairProperties.getTipThicknessTexture(), TIP_THICKNESS, 1, varying );
+	addTexture( aHairProperties.getRootOpacityTexture(), ROOT_OPACITY, 1, varying );
+	addTexture( aHairProperties.getTipOpacityTexture(), TIP_OPACITY, 1, varying );
+	addTexture( aHairProperties.getRootColorTexture(), ROOT_COLOR, 3, varying );
+	addTexture( aHairProperties.getTipColorTexture(), TIP_COLOR, 3, varying );
+	addTexture( aHairProperties.getHueVariationTexture(), HUE_VARIATION, 1, varying );
+	addTexture( aHairProperties.getValueVariationTexture(), VALUE_VARIATION, 1, varying );
+	addTexture( aHairProperties.getMutantHairColorTexture(), MUTANT_HAIR_COLOR, 3, varying );
+	addTexture( aHairProperties.getPercentMutantHairTexture(), PERCENT_MUTANT_HAIR, 1, varying );
+	addTexture( aHairProperties.getRootFrizzTexture(), ROOT_FRIZZ, 1, varying );
+	addTexture( aHairProperties.getTipFrizzTexture(), TIP_FRIZZ, 1, varying );
+	addTexture( aHairProperties.getFrizzXFrequencyTexture(), FRIZZ_X_FREQUENCY, 1, varying );
+	addTexture( aHairProperties.getFrizzYFrequencyTexture(), FRIZZ_Y_FREQUENCY, 1, varying );
+	addTexture( aHairProperties.getFrizzZFrequencyTexture(), FRIZZ_Z_FREQUENCY, 1, varying );
+	addTexture( aHairProperties.getFrizzAnimTexture(), FRIZZ_ANIM, 1, varying );
+	addTexture( aHairProperties.getFrizzAnimSpeedTexture(), FRIZZ_ANIM_SPEED, 1, varying );
+	addTexture( aHairProperties.getRootKinkTexture(), ROOT_KINK, 1, varying );
+	addTexture( aHairProperties.getTipKinkTexture(), TIP_KINK, 1, varying );
+	addTexture( aHairProperties.getKinkXFrequencyTexture(), KINK_X_FREQUENCY, 1, varying );
+	addTexture( aHairProperties.getKinkYFrequencyTexture(), KINK_Y_FREQUENCY, 1, varying );
+	addTexture( aHairProperties.getKinkZFrequencyTexture(), KINK_Z_FREQUENCY, 1, varying );
+	addTexture( aHairProperties.getRootSplayTexture(), ROOT_SPLAY, 1, varying );
+	addTexture( aHairProperties.getTipSplayTexture(), TIP_SPLAY, 1, varying );
+	addTexture( aHairProperties.getCenterSplayTexture(), CENTER_SPLAY, 1, varying );
+	addTexture( aHairProperties.getTwistTexture(), TWIST, 1, varying );
+	addTexture( aHairProperties.getOffsetTexture(), OFFSET, 1, varying );
+	addTexture( aHairProperties.getAspectTexture(), ASPECT, 1, varying );
+	addTexture( aHairProperties.getRandomizeStrandTexture(), RANDOMIZE_STRAND, 1, varying );
+	// Fill interleaved texels of varying textures
+	const unsigned __int32 channelsCount = static_cast< unsigned __int32 >( mChannels.size() );
+	mAtlas.resize( static_cast< size_t >( mWidth ) * mHeight * channelsCount );
+	unsigned __int32 channel = 0;
+	for ( std::vector< std::pair< const Texture *, unsigned __int32 > >::const_iterator it = varying.begin();
+		it != varying.end(); ++it )
+	{
+		const Texture & texture = *it->first;
+		const unsigned __int32 valuesCount = it->second;
+		const unsigned __int32 width = texture.getWidth();
+		const unsigned __int32 height = texture.getHeight();
+		const unsigned __int32 components = texture.getColorCompomentsCount();
+		const float * data = texture.getRawData();
+		float * atlasIt = &mAtlas[ channel ];
+		for ( unsigned __int32 y = 0; y < mHeight; ++y )
+		{
+			for ( unsigned __int32 x = 0; x < mWidth; ++x, atlasIt += channelsCount )
+			{
+				for ( unsigned __int32 i = 0; i < valuesCount; ++i )
+				{
+					// Missing color components are replaced by the first one
+					const unsigned __int32 component = i < components ? i : 0;
+					if ( width == mWidth && height == mHeight ) // Same resolution -> exact copy
+					{
+						atlasIt[ i ] = data[ ( y * width + x ) * components + component ];
+						continue;
+					}
+					// Resample texture at position of atlas texel
+					const Real u = mWidth > 1 ? static_cast< Real >( x ) / ( mWidth - 1 ) : 0;
+					const Real v = mHeight > 1 ? static_cast< Real >( y ) / ( mHeight - 1 ) : 0;
+					const unsigned __int32 x0 = static_cast< unsigned __int32 > ( floor( u * ( width - 1 ) ) );
+					const unsigned __int32 y0 = static_cast< unsigned __int32 > ( floor( v * ( height - 1 ) ) );
+					const unsigned __int32 x1 = static_cast< unsigned __int32 > ( ceil( u * ( width - 1 ) ) );
+					const unsigned __int32 y1 = static_cast< unsigned __int32 > ( ceil( v * ( height - 1 ) ) );
+					atlasIt[ i ] = static_cast< float >( interpolate(
+						data[ ( y0 * width + x0 ) * components + component ],
+						data[ ( y1 * width + x0 ) * components + component ],
+						data[ ( y0 * width + x1 ) * components + component ],
+						data[ ( y1 * width + x1 ) * components + component ],
+						static_cast< Real >( x1 ) - u * ( width - 1 ), static_cast< Real >( y1 ) - v * ( height - 1 ) ) );
+				}
+			}
+		}
+		channel += valuesCount;
+	}
+}
+
+void AttributeAtlas::addTexture( const Texture & aTexture, Attribute aAttribute, unsigned __int32 aValuesCount,
+	std::vector< std::pair< const Texture *, unsigned __int32 > > & aVarying )
+{
+	const unsigned __int32 components = aTexture.getColorCompomentsCount();
+	const unsigned __int32 texelsCount = aTexture.getWidth() * aTexture.getHeight();
+	const float * data = aTexture.getRawData();
+	// Is every texel equal to the first one ?
+	bool isConstant = true;
+	for ( const float * it = data + components, * end = data + texelsCount * components;
+		it != end && isConstant; ++it )
+	{
+		isConstant = *it == data[ ( it - data ) % components ];
+	}
+	for ( unsigned __int32 i = 0; i < aValuesCount; ++i )
+	{
+		mUniforms[ aAttribute + i ] = isConstant ? data[ i < components ? i : 0 ] : 0;
+	}
+	if ( isConstant )
+	{
+		return; // No sampling needed
+	}
+	// Atlas has resolution of the most detailed texture
+	mWidth = std::max( mWidth, aTexture.getWidth() );
+	mHeight = std::max( mHeight, aTexture.getHeight() );
+	for ( unsigned __int32 i = 0; i < aValuesCount; ++i )
+	{
+		mChannels.push_back( aAttribute + i );
+	}
+	aVarying.push_back( std::make_pair( &aTexture, aValuesCount ) );
+}
+
+} // namespace Interpolation
+
+} // namespace HairShape
+
+} // namespace Stubble
@@ -0,0 +1,194 @@
+#ifndef STUBBLE_ATTRIBUTE_ATLAS_HPP
+#define STUBBLE_ATTRIBUTE_ATLAS_HPP
+
+#include "Common\CommonFunctions.hpp"
+#include "Common\CommonTypes.hpp"
+#include "HairShape\Texture\Texture.hpp"
+
+#include <math.h>
+#include <string.h>
+#include <utility>
+#include <vector>
+
+namespace Stubble
+{
+
+namespace HairShape
+{
+
+namespace Interpolation
+{
+
+class HairProperties;
+
+///-------------------------------------------------------------------------------------------------
+/// Interleaved atlas of all textures of per hair attributes. All varying textures are resampled to
+/// common resolution and their texels are stored next to each other, so single bilinear fetch at
+/// hair root returns values of all attributes. Constant textures are not stored in atlas, their
+/// values are folded into uniforms copied to result without any sampling.
+/// Textures with resolution of atlas are copied exactly, so for them the sampled values equal
+/// values returned by Texture::realAtUV. Textures with lower resolution are bilinearly resampled.
+///-------------------------------------------------------------------------------------------------
+class AttributeAtlas
+{
+public:
+
+	///-------------------------------------------------------------------------------------------------
+	/// Values that represent indices of attributes in sampled values. Color attributes take three
+	/// following values.
+	///-------------------------------------------------------------------------------------------------
+	enum Attribute
+	{
+		SCALE = 0,  ///< The scale texture
+		RAND_SCALE, ///< The rand scale texture
+		ROOT_THICKNESS, ///< The root thickness texture
+		TIP_THICKNESS,  ///< The tip thickness texture
+		ROOT_OPACITY,   ///< The root opacity texture
+		TIP_OPACITY,	///< The tip opacity texture
+		ROOT_COLOR, ///< The root color texture
+		TIP_COLOR = ROOT_COLOR + 3, ///< The tip color texture
+		HUE_VARIATION = TIP_COLOR + 3,  ///< The hue variation texture
+		VALUE_VARIATION,	///< The value variation texture
+		MUTANT_HAIR_COLOR,  ///< The mutant hair color texture
+		PERCENT_MUTANT_HAIR = MUTANT_HAIR_COLOR + 3,	///< The percent mutant hair texture
+		ROOT_FRIZZ, ///< The root frizz texture
+		TIP_FRIZZ,  ///< The tip frizz texture
+		FRIZZ_X_FREQUENCY,  ///< The frizz x coordinate frequency texture
+		FRIZZ_Y_FREQUENCY,  ///< The frizz y coordinate frequency texture
+		FRIZZ_Z_FREQUENCY,  ///< The frizz z coordinate frequency texture
+		FRIZZ_ANIM, ///< The frizz animation texture
+		FRIZZ_ANIM_SPEED,   ///< The frizz animation speed texture
+		ROOT_KINK,  ///< The root kink texture
+		TIP_KINK,   ///< The tip kink texture
+		KINK_X_FREQUENCY,   ///< The kink x coordinate frequency texture
+		KINK_Y_FREQUENCY,   ///< The kink y coordinate frequency texture
+		KINK_Z_FREQUENCY,   ///< The kink z coordinate frequency texture
+		ROOT_SPLAY, ///< The root splay texture
+		TIP_SPLAY,  ///< The tip splay texture
+		CENTER_SPLAY,   ///< The center splay texture
+		TWIST,  ///< The twist texture
+		OFFSET, ///< The offset texture
+		ASPECT, ///< The aspect texture
+		RANDOMIZE_STRAND,   ///< The randomize strand texture
+		ATTRIBUTES_COUNT	///< Number of sampled values
+	};
+
+	///-------------------------------------------------------------------------------------------------
+	/// Default constructor. Creates atlas with all attributes equal to 1.
+	///-------------------------------------------------------------------------------------------------
+	AttributeAtlas();
+
+	///-------------------------------------------------------------------------------------------------
+	/// Builds atlas from current textures of hair properties. Must be called whenever any attribute
+	/// texture changes.
+	///
+	/// \param	aHairProperties	The hair properties.
+	///-------------------------------------------------------------------------------------------------
+	void build( const HairProperties & aHairProperties );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Samples all attributes at given UV coordinates.
+	///
+	/// \param	aU					The u coordinate.
+	/// \param	aV					The v coordinate.
+	/// \param [in,out]	aValues		The sampled values ( ATTRIBUTES_COUNT values ).
+	///-------------------------------------------------------------------------------------------------
+	inline void sample( Real aU, Real aV, float * aValues ) const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the number of varying attributes values stored in every atlas texel.
+	///
+	/// \return	The number of channels.
+	///-------------------------------------------------------------------------------------------------
+	inline unsigned __int32 getChannelsCount() const;
+
+private:
+
+	///-------------------------------------------------------------------------------------------------
+	/// Adds texture of attribute to atlas, or folds it into uniforms if it is constant.
+	///
+	/// \param	aTexture		The texture.
+	/// \param	aAttribute		The attribute.
+	/// \param	aValuesCount	Number of values of attribute ( 3 for colors, 1 otherwise ).
+	/// \param [in,out]	aVarying	The varying textures and their attributes.
+	///-------------------------------------------------------------------------------------------------
+	void addTexture( const Texture & aTexture, Attribute aAttribute, unsigned __int32 aValuesCount,
+		std::vector< std::pair< const Texture *, unsigned __int32 > > & aVarying );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Bilinearly interpolates value between four texels ( same formula as Texture::realAtUV ).
+	///
+	/// \param	aU0V0	The value of texel [ x0, y0 ].
+	/// \param	aU0V1	The value of texel [ x0, y1 ].
+	/// \param	aU1V0	The value of texel [ x1, y0 ].
+	/// \param	aU1V1	The value of texel [ x1, y1 ].
+	/// \param	aURatio	The ratio between texels in direction U.
+	/// \param	aVRatio	The ratio between texels in direction V.
+	///
+	/// \return	The interpolated value.
+	///-------------------------------------------------------------------------------------------------
+	inline static Real interpolate( float aU0V0, float aU0V1, float aU1V0, float aU1V1, Real aURatio,
+		Real aVRatio );
+
+	float mUniforms[ ATTRIBUTES_COUNT ];	///< The values of constant attributes ( 0 for varying attributes )
+
+	std::vector< unsigned __int32 > mChannels;  ///< The attribute value index of every atlas channel
+
+	std::vector< float > mAtlas;	///< The interleaved texels of all varying attributes
+
+	unsigned __int32 mWidth;	///< The atlas width
+
+	unsigned __int32 mHeight;   ///< The atlas height
+};
+
+// inline functions implementation
+
+inline void AttributeAtlas::sample( Real aU, Real aV, float * aValues ) const
+{
+	memcpy( aValues, mUniforms, sizeof( float ) * ATTRIBUTES_COUNT );
+	const unsigned __int32 channelsCount = static_cast< unsigned __int32 >( mChannels.size() );
+	if ( channelsCount == 0 )
+	{
+		return; // All attributes are constant
+	}
+	// Select surrounding texels same way as Texture::realAtUV
+	aU = clamp( aU, 0.0, 1.0 );
+	aV = clamp( aV, 0.0, 1.0 );
+	const unsigned __int32 x0 = static_cast< unsigned __int32 > ( floor( aU * ( mWidth - 1 ) ) );
+	const unsigned __int32 y0 = static_cast< unsigned __int32 > ( floor( aV * ( mHeight - 1 ) ) );
+	const unsigned __int32 x1 = static_cast< unsigned __int32 > ( ceil( aU * ( mWidth - 1 ) ) );
+	const unsigned __int32 y1 = static_cast< unsigned __int32 > ( ceil( aV * ( mHeight - 1 ) ) );
+	const Real uRatio = static_cast< Real >( x1 ) - aU * ( mWidth - 1 );
+	const Real vRatio = static_cast< Real >( y1 ) - aV * ( mHeight - 1 );
+	const float * u0v0 = &mAtlas[ ( y0 * mWidth + x0 ) * channelsCount ];
+	const float * u0v1 = &mAtlas[ ( y1 * mWidth + x0 ) * channelsCount ];
+	const float * u1v0 = &mAtlas[ ( y0 * mWidth + x1 ) * channelsCount ];
+	const float * u1v1 = &mAtlas[ ( y1 * mWidth + x1 ) * channelsCount ];
+	// All varying attributes are interpolated from the same four texels
+	for ( unsigned __int32 i = 0; i < channelsCount; ++i )
+	{
+		aValues[ mChannels[ i ] ] = static_cast< float >(
+			interpolate( u0v0[ i ], u0v1[ i ], u1v0[ i ], u1v1[ i ], uRatio, vRatio ) );
+	}
+}
+
+inline unsigned __int32 AttributeAtlas::getChannelsCount() const
+{
+	return static_cast< unsigned __int32 >( mChannels.size() );
+}
+
+inline Real AttributeAtlas::interpolate( float aU0V0, float aU0V1, float aU1V0, float aU1V1, Real aURatio,
+	Real aVRatio )
+{
+	const Real v0 = aURatio * aU0V0 + ( 1 - aURatio ) * aU1V0;
+	const Real v1 = aURatio * aU0V1 + ( 1 - aURatio ) * aU1V1;
+	return aVRatio * v0 + ( 1 - aVRatio ) * v1;
+}
+
+} // namespace Interpolation
+
+} // namespace HairShape
+
+} // namespace Stubble
+
+#endif // STUBBLE_ATTRIBUTE_ATLAS_HPP
@@ -0,0 +1,120 @@
+#include "BakedHairRoot.hpp"
+
+#include "Common\StubbleException.hpp"
+
+#include <math.h>
+
+namespace Stubble
+{
+
+namespace HairShape
+{
+
+namespace Interpolation
+{
+
+void BakedHairRoot::selectGuides( const HairProperties & aHairProperties, const MeshPoint & aRestPosition )
+{
+	HairComponents::ClosestGuidesQuery query;
+	selectGuides( aHairProperties, aRestPosition, query );
+}
+
+void BakedHairRoot::selectGuides( const HairProperties & aHairProperties, const MeshPoint & aRestPosition,
+	HairComponents::ClosestGuidesQuery & aQuery )
+{
+	// Get interpolation group
+	selectInterpolationGroup( aHairProperties, aRestPosition );
+	if ( selectTriangleGuides( aHairProperties, aRestPosition ) ) // No closest guides search needed
+	{
+		return;
+	}
+	// First selected closest guides
+	aHairProperties.getGuidesRestPositionsDS().getNClosestGuides( aRestPosition.getPosition(), mInterpolationGroupId,
+		getClosestGuidesQueryCount( aHairProperties ), aQuery );
+	HairComponents::ClosestGuides & guidesIds = aQuery.getClosestGuides();
+	calculateWeights( guidesIds.empty() ? 0 : &guidesIds[ 0 ], static_cast< unsigned __int32 >( guidesIds.size() ) );
+}
+
+void BakedHairRoot::calculateWeights( HairComponents::IdAndDistance * aClosestGuides, 
+	unsigned __int32 aClosestGuidesCount )
+{
+	mGuidesCount = 0;
+	if ( aClosestGuidesCount == 0 ) // Nothing to interpolate from
+	{
+		return;
+	}
+	HairComponents::IdAndDistance * const begin = aClosestGuides;
+	HairComponents::IdAndDistance * const end = aClosestGuides + aClosestGuidesCount;
+	// Get distance from farthest guide
+	float maxDistance = sqrtf( begin->mDistance ); // Returns max as first ( 'cos it uses max-heap )
+	// Select closest guide
+	const HairComponents::IdAndDistance * closest = begin;
+	for ( const HairComponents::IdAndDistance * guideIdIt = begin;
+		guideIdIt != end; ++guideIdIt )
+	{
+		if ( closest->mDistance > guideIdIt->mDistance )
+		{
+			closest = guideIdIt;
+		}
+	}
+	// Too close to some guide
+	if ( closest->mDistance < static_cast< float >( EPSILON ) || aClosestGuidesCount == 1 )
+	{
+		// Hair will be just copied from guide
+		mGuidesWeights[ 0 ].mGuideId = closest->mGuideId;
+		mGuidesWeights[ 0 ].mWeight = 1;
+		mGuidesCount = 1;
+		return;
+	}
+	// In next calculations, we will always ignore the farthest guide
+	// Bias distance with respect to farthest guide
+	for ( HairComponents::IdAndDistance * guideIdIt = begin + 1;
+		guideIdIt != end; ++guideIdIt )
+	{
+		float & distance = guideIdIt->mDistance;
+		distance = sqrtf( distance );
+		distance = ( maxDistance - distance ) / ( maxDistance * distance );
+		distance *= distance;
+	}
+	// Finaly calculate cumulated distance
+	float cumulatedDistance = 0;
+	for ( const HairComponents::IdAndDistance * guideIdIt = begin + 1;
+		guideIdIt != end; ++guideIdIt )
+	{
+		cumulatedDistance += guideIdIt->mDistance;
+	}
+	float inverseCumulatedDistance = 1.0f / cumulatedDistance;
+	// Calculate weights
+	for ( const HairComponents::IdAndDistance * guideIdIt = begin + 1;
+		guideIdIt != end; ++guideIdIt, ++mGuidesCount )
+	{
+		mGuidesWeights[ mGuidesCount ].mGuideId = guideIdIt->mGuideId;
+		mGuidesWeights[ mGuidesCount ].mWeight = guideIdIt->mDistance * inverseCumulatedDistance;
+	}
+}
+
+void BakedHairRoot::exportToFile( std::ostream & aOutputStream ) const
+{
+	aOutputStream << mUVPoint;
+	aOutputStream.write( reinterpret_cast< const char * >( &mInterpolationGroupId ), sizeof( unsigned __int32 ) );
+	aOutputStream.write( reinterpret_cast< const char * >( &mGuidesCount ), sizeof( unsigned __int32 ) );
+	aOutputStream.write( reinterpret_cast< const char * >( mGuidesWeights ), sizeof( GuideWeight ) * mGuidesCount );
+}
+
+void BakedHairRoot::importFromFile( std::istream & aInputStream )
+{
+	aInputStream >> mUVPoint;
+	aInputStream.read( reinterpret_cast< char * >( &mInterpolationGroupId ), sizeof( unsigned __int32 ) );
+	aInputStream.read( reinterpret_cast< char * >( &mGuidesCount ), sizeof( unsigned __int32 ) );
+	if ( mGuidesCount > MAX_GUIDES_COUNT )
+	{
+		throw StubbleException( " BakedHairRoot::importFromFile : too many guides to interpolate from ! " );
+	}
+	aInputStream.read( reinterpret_cast< char * >( mGuidesWeights ), sizeof( GuideWeight ) * mGuidesCount );
+}
+
+} // namespace Interpolation
+
+} // namespace HairShape
+
+} // namespace Stubble
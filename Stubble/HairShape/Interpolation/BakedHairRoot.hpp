@@ -0,0 +1,170 @@
+#ifndef STUBBLE_BAKED_HAIR_ROOT_HPP
+#define STUBBLE_BAKED_HAIR_ROOT_HPP
+
+#include "HairProperties.hpp"
+#include "HairShape/Mesh/MeshPoint.hpp"
+#include "HairShape/Mesh/UVPoint.hpp"
+
+#include <istream>
+#include <ostream>
+
+namespace Stubble
+{
+
+namespace HairShape
+{
+
+namespace Interpolation
+{
+
+///-------------------------------------------------------------------------------------------------
+/// Frame invariant data of single interpolated hair root : position on rest pose mesh, interpolation
+/// group and guides used for interpolation with their weights. These data can be calculated during
+/// export of voxel and stored in voxel file, so the renderer does not need to sample hair root
+/// and query closest guides for every hair in every motion sample.
+///-------------------------------------------------------------------------------------------------
+struct BakedHairRoot
+{
+	///-------------------------------------------------------------------------------------------------
+	/// Guide used for interpolation and its weight.
+	///-------------------------------------------------------------------------------------------------
+	struct GuideWeight
+	{
+		unsigned __int32 mGuideId;  ///< Identifier for the guide
+
+		float mWeight;  ///< The weight of the guide
+	};
+
+	///< Maximum number of guides to interpolate from ( see interpolation_samples attribute )
+	static const unsigned __int32 MAX_GUIDES_COUNT = 20;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Selects interpolation group of hair and calculates weights of the closest guides, that hair
+	/// will be interpolated from.
+	///
+	/// \param	aHairProperties	The hair properties.
+	/// \param	aRestPosition	The rest position of hair.
+	///-------------------------------------------------------------------------------------------------
+	void selectGuides( const HairProperties & aHairProperties, const MeshPoint & aRestPosition );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Selects interpolation group of hair and calculates weights of the closest guides, that hair
+	/// will be interpolated from. Closest guides are queried with reusable query, so no memory is
+	/// allocated.
+	///
+	/// \param	aHairProperties	The hair properties.
+	/// \param	aRestPosition	The rest position of hair.
+	/// \param [in,out]	aQuery	The reusable closest guides query.
+	///-------------------------------------------------------------------------------------------------
+	void selectGuides( const HairProperties & aHairProperties, const MeshPoint & aRestPosition,
+		HairComponents::ClosestGuidesQuery & aQuery );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Selects three guides of guides triangulation triangle enclosing hair root and calculates their
+	/// barycentric weights. Interpolation group must be already selected.
+	///
+	/// \param	aHairProperties	The hair properties.
+	/// \param	aRestPosition	The rest position of hair.
+	///
+	/// \return	true if guides triangulation is used and hair root lies inside it, otherwise closest
+	/// 		guides must be selected.
+	///-------------------------------------------------------------------------------------------------
+	inline bool selectTriangleGuides( const HairProperties & aHairProperties, const MeshPoint & aRestPosition );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Selects interpolation group of hair. Used together with calculateWeights, when closest guides
+	/// of many hair are queried at once.
+	///
+	/// \param	aHairProperties	The hair properties.
+	/// \param	aRestPosition	The rest position of hair.
+	///-------------------------------------------------------------------------------------------------
+	inline void selectInterpolationGroup( const HairProperties & aHairProperties, const MeshPoint & aRestPosition );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Calculates weights of the closest guides, that hair will be interpolated from.
+	///
+	/// \param [in,out]	aClosestGuides	The closest guides ( farthest first ), distances are modified. 
+	/// \param	aClosestGuidesCount		Number of the closest guides. 
+	///-------------------------------------------------------------------------------------------------
+	void calculateWeights( HairComponents::IdAndDistance * aClosestGuides, unsigned __int32 aClosestGuidesCount );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the number of the closest guides, that must be queried for every hair.
+	///
+	/// \param	aHairProperties	The hair properties.
+	///
+	/// \return	The number of the closest guides.
+	///-------------------------------------------------------------------------------------------------
+	inline static unsigned __int32 getClosestGuidesQueryCount( const HairProperties & aHairProperties );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Exports baked root to file.
+	///
+	/// \param [in,out]	aOutputStream	The output stream.
+	///-------------------------------------------------------------------------------------------------
+	void exportToFile( std::ostream & aOutputStream ) const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Imports baked root from file.
+	///
+	/// \param [in,out]	aInputStream	The input stream.
+	///-------------------------------------------------------------------------------------------------
+	void importFromFile( std::istream & aInputStream );
+
+	UVPoint mUVPoint;   ///< The position of hair root on rest pose mesh
+
+	unsigned __int32 mInterpolationGroupId; ///< Identifier for the interpolation group of hair
+
+	unsigned __int32 mGuidesCount;  ///< Number of guides to interpolate from ( 0 means no guide exists )
+
+	GuideWeight mGuidesWeights[ MAX_GUIDES_COUNT ];  ///< The guides to interpolate from and their weights
+};
+
+// inline functions implementation
+
+inline void BakedHairRoot::selectInterpolationGroup( const HairProperties & aHairProperties, 
+	const MeshPoint & aRestPosition )
+{
+	mInterpolationGroupId = aHairProperties.getInterpolationGroups().
+		getGroupId( aRestPosition.getUCoordinate(), aRestPosition.getVCoordinate() );
+}
+
+inline bool BakedHairRoot::selectTriangleGuides( const HairProperties & aHairProperties, 
+	const MeshPoint & aRestPosition )
+{
+	HairComponents::GuideId guidesIds[ 3 ];
+	float weights[ 3 ];
+	if ( !aHairProperties.isGuidesTriangulationUsed() || !aHairProperties.getGuidesRestPositionsDS().
+		getEnclosingGuides( aRestPosition.getUCoordinate(), aRestPosition.getVCoordinate(), mInterpolationGroupId,
+		guidesIds, weights ) )
+	{
+		return false;
+	}
+	// Guides with zero weight are not needed
+	mGuidesCount = 0;
+	for ( unsigned __int32 i = 0; i < 3; ++i )
+	{
+		if ( weights[ i ] > 0 )
+		{
+			mGuidesWeights[ mGuidesCount ].mGuideId = guidesIds[ i ];
+			mGuidesWeights[ mGuidesCount ].mWeight = weights[ i ];
+			++mGuidesCount;
+		}
+	}
+	return true;
+}
+
+inline unsigned __int32 BakedHairRoot::getClosestGuidesQueryCount( const HairProperties & aHairProperties )
+{
+	unsigned __int32 guidesCount = aHairProperties.getNumberOfGuidesToInterpolateFrom();
+	guidesCount = guidesCount < MAX_GUIDES_COUNT ? guidesCount : MAX_GUIDES_COUNT;
+	return guidesCount + 1; // One more, because the farthest guide is always ignored
+}
+
+} // namespace Interpolation
+
+} // namespace HairShape
+
+} // namespace Stubble
+
+#endif // STUBBLE_BAKED_HAIR_ROOT_HPP
@@ -0,0 +1,505 @@
+#ifndef STUBBLE_BUFFERED_OUTPUT_GENERATOR_HPP
+#define STUBBLE_BUFFERED_OUTPUT_GENERATOR_HPP
+
+#include "OutputGenerator.hpp"
+
+#include <cstring>
+
+namespace Stubble
+{
+
+namespace HairShape
+{
+
+namespace Interpolation
+{
+
+///-------------------------------------------------------------------------------------------------
+/// Output generator that only stores outputed hair, so it can be later sent to another output
+/// generator. Used by parallel hair generation : each block of hair is generated to its own
+/// buffered output generator and blocks are then flushed to final output generator in hair order.
+/// Template parameter tOutputGenerator is the type of final output generator, its types are used.
+///-------------------------------------------------------------------------------------------------
+template< typename tOutputGenerator >
+class BufferedOutputGenerator : public OutputGenerator< tOutputGenerator >
+{
+public:
+
+	///-------------------------------------------------------------------------------------------------
+	/// Defines an alias representing type of the position .
+	///-------------------------------------------------------------------------------------------------
+	typedef typename tOutputGenerator::PositionType PositionType;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Defines an alias representing type of the color .
+	///-------------------------------------------------------------------------------------------------
+	typedef typename tOutputGenerator::ColorType ColorType;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Defines an alias representing type of the normal .
+	///-------------------------------------------------------------------------------------------------
+	typedef typename tOutputGenerator::NormalType NormalType;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Defines an alias representing type of the width .
+	///-------------------------------------------------------------------------------------------------
+	typedef typename tOutputGenerator::WidthType WidthType;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Defines an alias representing type of the opacity .
+	///-------------------------------------------------------------------------------------------------
+	typedef typename tOutputGenerator::OpacityType OpacityType;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Defines an alias representing type of the uv coordinate .
+	///-------------------------------------------------------------------------------------------------
+	typedef typename tOutputGenerator::UVCoordinateType UVCoordinateType;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Defines an alias representing type of the index .
+	///-------------------------------------------------------------------------------------------------
+	typedef typename tOutputGenerator::IndexType IndexType;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Default constructor.
+	///-------------------------------------------------------------------------------------------------
+	inline BufferedOutputGenerator();
+
+	///-------------------------------------------------------------------------------------------------
+	/// Finaliser.
+	///-------------------------------------------------------------------------------------------------
+	inline ~BufferedOutputGenerator();
+
+	///-------------------------------------------------------------------------------------------------
+	/// Begins an output of interpolated hair.
+	/// Must be called before any hair is outputed.
+	///
+	/// \param	aMaxHairCount	Number of a maximum hair.
+	/// \param	aMaxPointsCount	Number of a maximum points.
+	///-------------------------------------------------------------------------------------------------
+	inline void beginOutput( unsigned __int64 aMaxHairCount, unsigned __int32 aMaxPointsCount );
+
+	///----------------------------------------------------------------------------------------------------
+	/// Ends an output.
+	///----------------------------------------------------------------------------------------------------
+	inline void endOutput();
+
+	///-------------------------------------------------------------------------------------------------
+	/// Query if normals are used by final output generator.
+	///
+	/// \return	true if normals are used. 
+	///-------------------------------------------------------------------------------------------------
+	inline bool areNormalsUsed() const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Sets whether normals are used by final output generator. By default normals are used.
+	///
+	/// \param	aNormalsUsed	true if normals are used. 
+	///-------------------------------------------------------------------------------------------------
+	inline void setNormalsUsed( bool aNormalsUsed );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Begins an output of single interpolated hair.
+	///
+	/// \param	aMaxPointsCount	Number of a maximum points on current hair.
+	///-------------------------------------------------------------------------------------------------
+	inline void beginHair( unsigned __int32 aMaxPointsCount );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Ends an output of single interpolated hair.
+	///
+	/// \param	aPointsCount	Number of points on finished hair.
+	///-------------------------------------------------------------------------------------------------
+	inline void endHair( unsigned __int32 aPointsCount );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the pointer to hair points positions.
+	///
+	/// \return	Pointer to position buffer.
+	///-------------------------------------------------------------------------------------------------
+	inline PositionType * positionPointer();
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the pointer to hair points colors.
+	///
+	/// \return	Pointer to color buffer.
+	///-------------------------------------------------------------------------------------------------
+	inline ColorType * colorPointer();
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the pointer to hair points normals.
+	///
+	/// \return	Pointer to normal buffer.
+	///-------------------------------------------------------------------------------------------------
+	inline NormalType * normalPointer();
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the pointer to hair points widths.
+	///
+	/// \return	Pointer to width buffer.
+	///-------------------------------------------------------------------------------------------------
+	inline WidthType * widthPointer();
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the pointer to hair points opacities.
+	///
+	/// \return	Pointer to opacity buffer.
+	///-------------------------------------------------------------------------------------------------
+	inline OpacityType * opacityPointer();
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the pointer to hair UV coordinates.
+	///
+	/// \return	Pointer to UV coordinates buffer.
+	///-------------------------------------------------------------------------------------------------
+	inline UVCoordinateType * hairUVCoordinatePointer();
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the pointer to hair strand UV coordinates.
+	///
+	/// \return	Pointer to strand UV coordinates buffer.
+	///-------------------------------------------------------------------------------------------------
+	inline UVCoordinateType * strandUVCoordinatePointer();
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the pointer to hair indices.
+	///
+	/// \return	Pointer to hair indices buffer.
+	///-------------------------------------------------------------------------------------------------
+	inline IndexType * hairIndexPointer();
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the pointer to strand indices.
+	///
+	/// \return	Pointer to strand indices buffer.
+	///-------------------------------------------------------------------------------------------------
+	inline IndexType * strandIndexPointer();
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the number of stored hair.
+	///
+	/// \return	The hair count.
+	///-------------------------------------------------------------------------------------------------
+	inline unsigned __int32 getHairCount() const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Sends all stored hair to final output generator.
+	/// Hair indices are renumbered, so they continue from given hair index.
+	///
+	/// \param [in,out]	aOutputGenerator	The final output generator.
+	/// \param [in,out]	aHairIndex			The index of last outputed hair, will be updated.
+	///-------------------------------------------------------------------------------------------------
+	inline void flush( tOutputGenerator & aOutputGenerator, unsigned __int64 & aHairIndex ) const;
+
+private:
+
+	///-------------------------------------------------------------------------------------------------
+	/// Frees all memory.
+	///-------------------------------------------------------------------------------------------------
+	inline void freeMemory();
+
+	unsigned __int32 mMaxHairCount;	///< Maximum number of the hair ( allocated space for hair )
+
+	size_t mBuffersSize;  ///< Size of the per point buffers
+
+	unsigned __int32 mHairCount;	///< Number of the stored hair
+
+	unsigned __int32 * mMaxPointsCount;	///< Maximum points count of each hair ( passed to beginHair )
+
+	unsigned __int32 * mPointsCount;	///< Number of points of each hair ( passed to endHair )
+
+	PositionType * mPositionData;   ///< Information describing the position of the hair
+
+	PositionType * mPositionDataPointer;	///< The position data pointer
+
+	ColorType * mColorData; ///< Information describing the color of the hair
+
+	ColorType * mColorDataPointer;  ///< The color data pointer
+
+	NormalType * mNormalData;   ///< Information describing the normals of the hair points
+
+	NormalType * mNormalDataPointer;	///< The normal data pointer
+
+	WidthType * mWidthData; ///< Information describing the width of the hair
+
+	WidthType * mWidthDataPointer;  ///< The width data pointer
+
+	OpacityType * mOpacityData; ///< Information describing the opacity of the hair
+
+	OpacityType * mOpacityDataPointer;  ///< The opacity data pointer
+
+	UVCoordinateType * mHairUVCoordinateData;   ///< Information describing the hair uv coordinates
+
+	UVCoordinateType * mStrandUVCoordinateData; ///< Information describing the strand uv coordinates
+
+	IndexType * mHairIndexData;   ///< Information describing the hair indices
+
+	IndexType * mStrandIndexData;  ///< Information describing the strand indices
+
+	bool mNormalsUsed;  ///< true if normals are used by final output generator
+};
+
+// inline functions implementation
+
+template< typename tOutputGenerator >
+inline BufferedOutputGenerator< tOutputGenerator >::BufferedOutputGenerator():
+	mMaxHairCount( 0 ),
+	mBuffersSize( 0 ),
+	mHairCount( 0 ),
+	mMaxPointsCount( 0 ),
+	mPointsCount( 0 ),
+	mPositionData( 0 ),
+	mPositionDataPointer( 0 ),
+	mColorData( 0 ),
+	mColorDataPointer( 0 ),
+	mNormalData( 0 ),
+	mNormalDataPointer( 0 ),
+	mWidthData( 0 ),
+	mWidthDataPointer( 0 ),
+	mOpacityData( 0 ),
+	mOpacityDataPointer( 0 ),
+	mHairUVCoordinateData( 0 ),
+	mStrandUVCoordinateData( 0 ),
+	mHairIndexData( 0 ),
+	mStrandIndexData( 0 ),
+	mNormalsUsed( true )
+{
+}
+
+template< typename tOutputGenerator >
+inline BufferedOutputGenerator< tOutputGenerator >::~BufferedOutputGenerator()
+{
+	freeMemory();
+}
+
+template< typename tOutputGenerator >
+inline void BufferedOutputGenerator< tOutputGenerator >::beginOutput( unsigned __int64 aMaxHairCount,
+	unsigned __int32 aMaxPointsCount )
+{
+	// Calculate needed buffers size, every point buffer has up to 3 components, so its size must fit into size_t
+	const unsigned __int64 newBuffersSize = multiplyCounts( aMaxHairCount, aMaxPointsCount );
+	narrowCount< size_t >( multiplyCounts( newBuffersSize, 3 ) );
+	// Need to allocate more memory ?
+	if ( newBuffersSize > mBuffersSize || aMaxHairCount > mMaxHairCount )
+	{
+		try
+		{
+			// Kill old memory
+			freeMemory();
+			// Allocate new memory
+			mMaxHairCount = narrowCount< unsigned __int32 >( aMaxHairCount );
+			mBuffersSize = static_cast< size_t >( newBuffersSize );
+			mMaxPointsCount = new unsigned __int32[ mMaxHairCount ];
+			mPointsCount = new unsigned __int32[ mMaxHairCount ];
+			mPositionData = new PositionType[ mBuffersSize * 3 ];
+			mColorData = new ColorType[ mBuffersSize * 3 ];
+			mNormalData = new NormalType[ mBuffersSize * 3 ];
+			mWidthData = new WidthType[ mBuffersSize ];
+			mOpacityData = new OpacityType[ mBuffersSize * 3 ];
+			mHairUVCoordinateData = new UVCoordinateType[ mMaxHairCount * 2 ];
+			mStrandUVCoordinateData = new UVCoordinateType[ mMaxHairCount * 2 ];
+			mHairIndexData = new IndexType[ mMaxHairCount ];
+			mStrandIndexData = new IndexType[ mMaxHairCount ];
+		}
+		catch( ... )
+		{
+			freeMemory();
+			throw;
+		}
+	}
+	// Resets pointers to buffers
+	mHairCount = 0;
+	mPositionDataPointer = mPositionData;
+	mColorDataPointer = mColorData;
+	mNormalDataPointer = mNormalData;
+	mWidthDataPointer = mWidthData;
+	mOpacityDataPointer = mOpacityData;
+}
+
+template< typename tOutputGenerator >
+inline void BufferedOutputGenerator< tOutputGenerator >::endOutput()
+{
+	/* EMPTY */
+}
+
+template< typename tOutputGenerator >
+inline bool BufferedOutputGenerator< tOutputGenerator >::areNormalsUsed() const
+{
+	return mNormalsUsed;
+}
+
+template< typename tOutputGenerator >
+inline void BufferedOutputGenerator< tOutputGenerator >::setNormalsUsed( bool aNormalsUsed )
+{
+	mNormalsUsed = aNormalsUsed;
+}
+
+template< typename tOutputGenerator >
+inline void BufferedOutputGenerator< tOutputGenerator >::beginHair( unsigned __int32 aMaxPointsCount )
+{
+	mMaxPointsCount[ mHairCount ] = aMaxPointsCount;
+}
+
+template< typename tOutputGenerator >
+inline void BufferedOutputGenerator< tOutputGenerator >::endHair( unsigned __int32 aPointsCount )
+{
+	unsigned __int32 countMinus2 = aPointsCount - 2; // Other data than points have 2 fewer items
+	// Move pointers
+	mPositionDataPointer += aPointsCount * 3;
+	mColorDataPointer += countMinus2 * 3;
+	mNormalDataPointer += countMinus2 * 3;
+	mWidthDataPointer += countMinus2;
+	mOpacityDataPointer += countMinus2 * 3;
+	// Store points count
+	mPointsCount[ mHairCount ] = aPointsCount;
+	++mHairCount;
+}
+
+template< typename tOutputGenerator >
+inline typename BufferedOutputGenerator< tOutputGenerator >::PositionType *
+	BufferedOutputGenerator< tOutputGenerator >::positionPointer()
+{
+	return mPositionDataPointer;
+}
+
+template< typename tOutputGenerator >
+inline typename BufferedOutputGenerator< tOutputGenerator >::ColorType *
+	BufferedOutputGenerator< tOutputGenerator >::colorPointer()
+{
+	return mColorDataPointer;
+}
+
+template< typename tOutputGenerator >
+inline typename BufferedOutputGenerator< tOutputGenerator >::NormalType *
+	BufferedOutputGenerator< tOutputGenerator >::normalPointer()
+{
+	return mNormalDataPointer;
+}
+
+template< typename tOutputGenerator >
+inline typename BufferedOutputGenerator< tOutputGenerator >::WidthType *
+	BufferedOutputGenerator< tOutputGenerator >::widthPointer()
+{
+	return mWidthDataPointer;
+}
+
+template< typename tOutputGenerator >
+inline typename BufferedOutputGenerator< tOutputGenerator >::OpacityType *
+	BufferedOutputGenerator< tOutputGenerator >::opacityPointer()
+{
+	return mOpacityDataPointer;
+}
+
+template< typename tOutputGenerator >
+inline typename BufferedOutputGenerator< tOutputGenerator >::UVCoordinateType *
+	BufferedOutputGenerator< tOutputGenerator >::hairUVCoordinatePointer()
+{
+	return mHairUVCoordinateData + mHairCount * 2;
+}
+
+template< typename tOutputGenerator >
+inline typename BufferedOutputGenerator< tOutputGenerator >::UVCoordinateType *
+	BufferedOutputGenerator< tOutputGenerator >::strandUVCoordinatePointer()
+{
+	return mStrandUVCoordinateData + mHairCount * 2;
+}
+
+template< typename tOutputGenerator >
+inline typename BufferedOutputGenerator< tOutputGenerator >::IndexType *
+	BufferedOutputGenerator< tOutputGenerator >::hairIndexPointer()
+{
+	return mHairIndexData + mHairCount;
+}
+
+template< typename tOutputGenerator >
+inline typename BufferedOutputGenerator< tOutputGenerator >::IndexType *
+	BufferedOutputGenerator< tOutputGenerator >::strandIndexPointer()
+{
+	return mStrandIndexData + mHairCount;
+}
+
+template< typename tOutputGenerator >
+inline unsigned __int32 BufferedOutputGenerator< tOutputGenerator >::getHairCount() const
+{
+	return mHairCount;
+}
+
+template< typename tOutputGenerator >
+inline void BufferedOutputGenerator< tOutputGenerator >::flush( tOutputGenerator & aOutputGenerator,
+	unsigned __int64 & aHairIndex ) const
+{
+	const PositionType * positionIt = mPositionData;
+	const ColorType * colorIt = mColorData;
+	const NormalType * normalIt = mNormalData;
+	const WidthType * widthIt = mWidthData;
+	const OpacityType * opacityIt = mOpacityData;
+	// For every stored hair
+	for ( unsigned __int32 i = 0; i < mHairCount; ++i )
+	{
+		const unsigned __int32 pointsCount = mPointsCount[ i ];
+		const unsigned __int32 countMinus2 = pointsCount - 2; // Other data than points have 2 fewer items
+		aOutputGenerator.beginHair( mMaxPointsCount[ i ] );
+		// Copy per point data
+		memcpy( reinterpret_cast< void * >( aOutputGenerator.positionPointer() ),
+			reinterpret_cast< const void * >( positionIt ), sizeof( PositionType ) * 3 * pointsCount );
+		memcpy( reinterpret_cast< void * >( aOutputGenerator.colorPointer() ),
+			reinterpret_cast< const void * >( colorIt ), sizeof( ColorType ) * 3 * countMinus2 );
+		memcpy( reinterpret_cast< void * >( aOutputGenerator.normalPointer() ),
+			reinterpret_cast< const void * >( normalIt ), sizeof( NormalType ) * 3 * countMinus2 );
+		memcpy( reinterpret_cast< void * >( aOutputGenerator.widthPointer() ),
+			reinterpret_cast< const void * >( widthIt ), sizeof( WidthType ) * countMinus2 );
+		memcpy( reinterpret_cast< void * >( aOutputGenerator.opacityPointer() ),
+			reinterpret_cast< const void * >( opacityIt ), sizeof( OpacityType ) * 3 * countMinus2 );
+		positionIt += pointsCount * 3;
+		colorIt += countMinus2 * 3;
+		normalIt += countMinus2 * 3;
+		widthIt += countMinus2;
+		opacityIt += countMinus2 * 3;
+		// Copy per hair data, hair index is renumbered ( and wraps around in 32 bit index type )
+		* aOutputGenerator.hairIndexPointer() = static_cast< IndexType >( ++aHairIndex );
+		* aOutputGenerator.strandIndexPointer() = mStrandIndexData[ i ];
+		* aOutputGenerator.hairUVCoordinatePointer() = mHairUVCoordinateData[ i * 2 ];
+		* ( aOutputGenerator.hairUVCoordinatePointer() + 1 ) = mHairUVCoordinateData[ i * 2 + 1 ];
+		* aOutputGenerator.strandUVCoordinatePointer() = mStrandUVCoordinateData[ i * 2 ];
+		* ( aOutputGenerator.strandUVCoordinatePointer() + 1 ) = mStrandUVCoordinateData[ i * 2 + 1 ];
+		aOutputGenerator.endHair( pointsCount );
+	}
+}
+
+template< typename tOutputGenerator >
+inline void BufferedOutputGenerator< tOutputGenerator >::freeMemory()
+{
+	delete [] mMaxPointsCount;
+	delete [] mPointsCount;
+	delete [] mPositionData;
+	delete [] mColorData;
+	delete [] mNormalData;
+	delete [] mWidthData;
+	delete [] mOpacityData;
+	delete [] mHairUVCoordinateData;
+	delete [] mStrandUVCoordinateData;
+	delete [] mHairIndexData;
+	delete [] mStrandIndexData;
+	mMaxHairCount = 0;
+	mBuffersSize = 0;
+	mHairCount = 0;
+	mMaxPointsCount = 0;
+	mPointsCount = 0;
+	mPositionData = 0;
+	mColorData = 0;
+	mNormalData = 0;
+	mWidthData = 0;
+	mOpacityData = 0;
+	mHairUVCoordinateData = 0;
+	mStrandUVCoordinateData = 0;
+	mHairIndexData = 0;
+	mStrandIndexData = 0;
+}
+
+} // namespace Interpolation
+
+} // namespace HairShape
+
+} // namespace Stubble
+
+#endif // STUBBLE_BUFFERED_OUTPUT_GENERATOR_HPP
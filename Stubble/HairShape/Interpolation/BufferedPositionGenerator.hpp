@@ -0,0 +1,167 @@
+#ifndef STUBBLE_BUFFERED_POSITION_GENERATOR_HPP
+#define STUBBLE_BUFFERED_POSITION_GENERATOR_HPP
+
+#include "PositionGenerator.hpp"
+
+namespace Stubble
+{
+
+namespace HairShape
+{
+
+namespace Interpolation
+{
+
+///-------------------------------------------------------------------------------------------------
+/// Position generator distributing positions generated in advance by another position generator.
+/// Used by parallel hair generation : positions of whole block of hair are generated sequentially
+/// and then distributed to hair generators running in parallel.
+///-------------------------------------------------------------------------------------------------
+class BufferedPositionGenerator : public PositionGenerator
+{
+public:
+
+	///-------------------------------------------------------------------------------------------------
+	/// Generated hair position.
+	///-------------------------------------------------------------------------------------------------
+	struct GeneratedPosition
+	{
+		MeshPoint mCurrentPosition; ///< The current position of the hair ( already displaced )
+
+		MeshPoint mRestPosition; ///< The rest position of the hair
+
+		const BakedHairRoot * mBakedRoot; ///< The baked root of the hair ( NULL if roots are not baked )
+	};
+
+	///-------------------------------------------------------------------------------------------------
+	/// Default constructor.
+	///-------------------------------------------------------------------------------------------------
+	inline BufferedPositionGenerator();
+
+	///-------------------------------------------------------------------------------------------------
+	/// Recieves generated hair positions from outside.
+	///
+	/// \param	aGeneratedPositions	The generated positions.
+	/// \param	aCount				Number of hair.
+	/// \param	aHairIndex			Zero-based index of the first hair.
+	///-------------------------------------------------------------------------------------------------
+	inline void set( const GeneratedPosition * aGeneratedPositions, unsigned __int32 aCount,
+		unsigned __int64 aHairIndex );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Generates position of interpolated hair.
+	/// Only distributes positions received from set method ( which must be called first ).
+	///
+	/// \param [in,out]	aCurrentPosition	The current position of hair on mesh.
+	/// \param [in,out]	aRestPosition		The rest position of hair in 3D space.
+	///-------------------------------------------------------------------------------------------------
+	inline void generate( MeshPoint & aCurrentPosition, MeshPoint & aRestPosition );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Generates position of interpolated hair on displaced mesh.
+	/// Only distributes positions received from set method, which are already displaced.
+	///
+	/// \param [in,out]	aCurrentPosition	The current position of hair on displaced mesh.
+	/// \param [in,out]	aRestPosition		The rest position of hair in 3D space.
+	/// \param aDisplacementTexture			The texture defining displacement of mesh.
+	///	\param aDisplacementFactor			The displacement texture will be mutliplied by this factor.
+	///-------------------------------------------------------------------------------------------------
+	inline void generate( MeshPoint & aCurrentPosition, MeshPoint & aRestPosition,
+		const Texture & aDisplacementTexture, Real aDisplacementFactor );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the number of the hair to be interpolated.
+	///
+	/// \return	The hair count.
+	///-------------------------------------------------------------------------------------------------
+	inline unsigned __int64 getHairCount() const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the index of first hair which position is generated by this generator.
+	///
+	/// \return	The index of first hair which position is generated by this generator.
+	///-------------------------------------------------------------------------------------------------
+	inline unsigned __int64 getHairStartIndex() const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the baked root of the last distributed hair.
+	///
+	/// \return	The baked root of the last distributed hair or NULL if roots are not baked. 
+	///-------------------------------------------------------------------------------------------------
+	inline const BakedHairRoot * getBakedRoot() const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Resets distributing generated values.
+	///-------------------------------------------------------------------------------------------------
+	inline void reset();
+
+private:
+
+	const GeneratedPosition * mGeneratedPositions;	///< The generated positions
+
+	const GeneratedPosition * mCurrentPosition;   ///< The current position, that will be returned
+
+	unsigned __int32 mCount;	///< Number of the interpolated hair.
+
+	unsigned __int64 mHairIndex;	///< Zero-based index of the first hair
+};
+
+// inline functions implementation
+
+inline BufferedPositionGenerator::BufferedPositionGenerator():
+	mGeneratedPositions( 0 ),
+	mCurrentPosition( 0 ),
+	mCount( 0 ),
+	mHairIndex( 0 )
+{
+}
+
+inline void BufferedPositionGenerator::set( const GeneratedPosition * aGeneratedPositions, unsigned __int32 aCount,
+	unsigned __int64 aHairIndex )
+{
+	mGeneratedPositions = aGeneratedPositions;
+	mCurrentPosition = mGeneratedPositions;
+	mCount = aCount;
+	mHairIndex = aHairIndex;
+}
+
+inline void BufferedPositionGenerator::generate( MeshPoint & aCurrentPosition, MeshPoint & aRestPosition )
+{
+	aCurrentPosition = mCurrentPosition->mCurrentPosition;
+	aRestPosition = mCurrentPosition->mRestPosition;
+	++mCurrentPosition; // Move to next generated position
+}
+
+inline void BufferedPositionGenerator::generate( MeshPoint & aCurrentPosition, MeshPoint & aRestPosition,
+	const Texture & aDisplacementTexture, Real aDisplacementFactor )
+{
+	generate( aCurrentPosition, aRestPosition ); // Positions have been displaced during generation
+}
+
+inline unsigned __int64 BufferedPositionGenerator::getHairCount() const
+{
+	return mCount;
+}
+
+inline unsigned __int64 BufferedPositionGenerator::getHairStartIndex() const
+{
+	return mHairIndex;
+}
+
+inline const BakedHairRoot * BufferedPositionGenerator::getBakedRoot() const
+{
+	return ( mCurrentPosition - 1 )->mBakedRoot; // Current position has been already moved to next position
+}
+
+inline void BufferedPositionGenerator::reset()
+{
+	mCurrentPosition = mGeneratedPositions;
+}
+
+} // namespace Interpolation
+
+} // namespace HairShape
+
+} // namespace Stubble
+
+#endif // STUBBLE_BUFFERED_POSITION_GENERATOR_HPP
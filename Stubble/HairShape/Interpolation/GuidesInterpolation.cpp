@@ -0,0 +1,168 @@
+#include "GuidesInterpolation.hpp"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#include <emmintrin.h>
+#include <immintrin.h>
+
+// AVX code must be explicitly enabled for single function by gcc, msvc always emits it
+#ifdef __GNUC__
+	#define STUBBLE_AVX_FUNCTION __attribute__( ( target( "avx" ) ) )
+#else
+	#define STUBBLE_AVX_FUNCTION
+#endif
+
+namespace Stubble
+{
+
+namespace HairShape
+{
+
+namespace Interpolation
+{
+
+GuidesInterpolation::InstructionSet GuidesInterpolation::mInstructionSet =
+	GuidesInterpolation::getSupportedInstructionSet();
+
+GuidesInterpolation::Kernel GuidesInterpolation::mKernel =
+	GuidesInterpolation::getKernel( GuidesInterpolation::mInstructionSet );
+
+GuidesInterpolation::InstructionSet GuidesInterpolation::getInstructionSet()
+{
+	return mInstructionSet;
+}
+
+GuidesInterpolation::InstructionSet GuidesInterpolation::getSupportedInstructionSet()
+{
+	// Query processor features : SSE2 is bit 26 of edx, AVX is bit 28 and OSXSAVE bit 27 of ecx
+	unsigned int ecx = 0, edx = 0;
+#ifdef _MSC_VER
+	int info[ 4 ];
+	__cpuid( info, 1 );
+	ecx = static_cast< unsigned int >( info[ 2 ] );
+	edx = static_cast< unsigned int >( info[ 3 ] );
+#else
+	unsigned int eax, ebx;
+	if ( !__get_cpuid( 1, &eax, &ebx, &ecx, &edx ) )
+	{
+		return SCALAR;
+	}
+#endif
+	if ( ( edx & ( 1 << 26 ) ) == 0 )
+	{
+		return SCALAR;
+	}
+	if ( ( ecx & ( 1 << 27 ) ) == 0 || ( ecx & ( 1 << 28 ) ) == 0 )
+	{
+		return SSE2;
+	}
+	// Operating system must also save AVX registers on context switch
+#ifdef _MSC_VER
+	const unsigned __int64 xcr0 = _xgetbv( 0 );
+#else
+	unsigned int xcr0Low, xcr0High;
+	__asm__ ( "xgetbv" : "=a" ( xcr0Low ), "=d" ( xcr0High ) : "c" ( 0 ) );
+	const unsigned __int64 xcr0 = xcr0Low;
+#endif
+	return ( xcr0 & 6 ) == 6 ? AVX : SSE2;
+}
+
+void GuidesInterpolation::setInstructionSet( InstructionSet aInstructionSet )
+{
+	const InstructionSet supported = getSupportedInstructionSet();
+	mInstructionSet = aInstructionSet < supported ? aInstructionSet : supported;
+	mKernel = getKernel( mInstructionSet );
+}
+
+GuidesInterpolation::Kernel GuidesInterpolation::getKernel( InstructionSet aInstructionSet )
+{
+	switch ( aInstructionSet )
+	{
+	case AVX:
+		return &interpolateAVX;
+	case SSE2:
+		return &interpolateSSE2;
+	default:
+		return &interpolateScalar;
+	}
+}
+
+void GuidesInterpolation::interpolateScalar( Real * aResult, const Real * const * aGuides, const Real * aWeights,
+	unsigned __int32 aGuidesCount, unsigned __int32 aValuesCount )
+{
+	// For every coordinate sum weighted coordinates of all guides
+	for ( unsigned __int32 i = 0; i < aValuesCount; ++i )
+	{
+		Real sum = 0;
+		for ( unsigned __int32 j = 0; j < aGuidesCount; ++j )
+		{
+			sum += aWeights[ j ] * aGuides[ j ][ i ];
+		}
+		aResult[ i ] = sum;
+	}
+}
+
+void GuidesInterpolation::interpolateSSE2( Real * aResult, const Real * const * aGuides, const Real * aWeights,
+	unsigned __int32 aGuidesCount, unsigned __int32 aValuesCount )
+{
+	unsigned __int32 i = 0;
+	// Two coordinates at once, the sum stays in register for all guides
+	for ( ; i + 2 <= aValuesCount; i += 2 )
+	{
+		__m128d sum = _mm_setzero_pd();
+		for ( unsigned __int32 j = 0; j < aGuidesCount; ++j )
+		{
+			sum = _mm_add_pd( sum, _mm_mul_pd( _mm_set1_pd( aWeights[ j ] ), _mm_loadu_pd( aGuides[ j ] + i ) ) );
+		}
+		_mm_storeu_pd( aResult + i, sum );
+	}
+	// Remaining coordinate
+	if ( i < aValuesCount )
+	{
+		Real sum = 0;
+		for ( unsigned __int32 j = 0; j < aGuidesCount; ++j )
+		{
+			sum += aWeights[ j ] * aGuides[ j ][ i ];
+		}
+		aResult[ i ] = sum;
+	}
+}
+
+STUBBLE_AVX_FUNCTION
+void GuidesInterpolation::interpolateAVX( Real * aResult, const Real * const * aGuides, const Real * aWeights,
+	unsigned __int32 aGuidesCount, unsigned __int32 aValuesCount )
+{
+	unsigned __int32 i = 0;
+	// Four coordinates at once, the sum stays in register for all guides
+	for ( ; i + 4 <= aValuesCount; i += 4 )
+	{
+		__m256d sum = _mm256_setzero_pd();
+		for ( unsigned __int32 j = 0; j < aGuidesCount; ++j )
+		{
+			sum = _mm256_add_pd( sum,
+				_mm256_mul_pd( _mm256_set1_pd( aWeights[ j ] ), _mm256_loadu_pd( aGuides[ j ] + i ) ) );
+		}
+		_mm256_storeu_pd( aResult + i, sum );
+	}
+	// Remaining coordinates
+	for ( ; i < aValuesCount; ++i )
+	{
+		Real sum = 0;
+		for ( unsigned __int32 j = 0; j < aGuidesCount; ++j )
+		{
+			sum += aWeights[ j ] * aGuides[ j ][ i ];
+		}
+		aResult[ i ] = sum;
+	}
+	// Avoid penalty of switching from AVX to SSE code
+	_mm256_zeroupper();
+}
+
+} // namespace Interpolation
+
+} // namespace HairShape
+
+} // namespace Stubble
@@ -0,0 +1,127 @@
+#ifndef STUBBLE_GUIDES_INTERPOLATION_HPP
+#define STUBBLE_GUIDES_INTERPOLATION_HPP
+
+#include "Common\CommonTypes.hpp"
+
+namespace Stubble
+{
+
+namespace HairShape
+{
+
+namespace Interpolation
+{
+
+///-------------------------------------------------------------------------------------------------
+/// Kernel blending guides segments to interpolated hair. Guide vertices are stored as continuous
+/// array of x, y, z coordinates, so weighted sum of guides is computed over flat coordinates arrays
+/// without any per-point or per-component work. Kernel implementation ( scalar, SSE2 or AVX ) is
+/// selected at runtime by capabilities of processor.
+/// All implementations accumulate in double precision in the same order, so they return identical
+/// results. Compared to accumulation of weighted guides points in hair points precision ( float ),
+/// which was used before, interpolated points differ at most by number of guides float ulps of the
+/// largest coordinate ( relative error below 1e-6 for 20 guides ).
+///-------------------------------------------------------------------------------------------------
+class GuidesInterpolation
+{
+public:
+
+	///-------------------------------------------------------------------------------------------------
+	/// Values that represent instruction set used by kernel.
+	///-------------------------------------------------------------------------------------------------
+	enum InstructionSet
+	{
+		SCALAR, ///< Plain C++ implementation
+		SSE2,   ///< SSE2 implementation ( 2 coordinates at once )
+		AVX ///< AVX implementation ( 4 coordinates at once )
+	};
+
+	///-------------------------------------------------------------------------------------------------
+	/// Computes weighted sum of guides coordinates.
+	///
+	/// \param [in,out]	aResult		The result coordinates ( aValuesCount values ).
+	/// \param	aGuides				Pointers to coordinates of guides to interpolate from.
+	/// \param	aWeights			The weights of guides.
+	/// \param	aGuidesCount		Number of guides ( result is zero if there are no guides ).
+	/// \param	aValuesCount		Number of coordinates ( 3 * number of points ).
+	///-------------------------------------------------------------------------------------------------
+	inline static void interpolate( Real * aResult, const Real * const * aGuides, const Real * aWeights,
+		unsigned __int32 aGuidesCount, unsigned __int32 aValuesCount );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the instruction set used by kernel.
+	///
+	/// \return	The instruction set.
+	///-------------------------------------------------------------------------------------------------
+	static InstructionSet getInstructionSet();
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the best instruction set supported by processor.
+	///
+	/// \return	The supported instruction set.
+	///-------------------------------------------------------------------------------------------------
+	static InstructionSet getSupportedInstructionSet();
+
+	///-------------------------------------------------------------------------------------------------
+	/// Selects the instruction set used by kernel, instruction set is limited to the supported one.
+	/// Mainly used to compare results of different implementations.
+	///
+	/// \param	aInstructionSet	The instruction set.
+	///-------------------------------------------------------------------------------------------------
+	static void setInstructionSet( InstructionSet aInstructionSet );
+
+private:
+
+	///-------------------------------------------------------------------------------------------------
+	/// Defines an alias representing the kernel implementation.
+	///-------------------------------------------------------------------------------------------------
+	typedef void ( *Kernel )( Real * aResult, const Real * const * aGuides, const Real * aWeights,
+		unsigned __int32 aGuidesCount, unsigned __int32 aValuesCount );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Scalar implementation of interpolate.
+	///-------------------------------------------------------------------------------------------------
+	static void interpolateScalar( Real * aResult, const Real * const * aGuides, const Real * aWeights,
+		unsigned __int32 aGuidesCount, unsigned __int32 aValuesCount );
+
+	///-------------------------------------------------------------------------------------------------
+	/// SSE2 implementation of interpolate.
+	///-------------------------------------------------------------------------------------------------
+	static void interpolateSSE2( Real * aResult, const Real * const * aGuides, const Real * aWeights,
+		unsigned __int32 aGuidesCount, unsigned __int32 aValuesCount );
+
+	///-------------------------------------------------------------------------------------------------
+	/// AVX implementation of interpolate.
+	///-------------------------------------------------------------------------------------------------
+	static void interpolateAVX( Real * aResult, const Real * const * aGuides, const Real * aWeights,
+		unsigned __int32 aGuidesCount, unsigned __int32 aValuesCount );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the kernel implementing selected instruction set.
+	///
+	/// \param	aInstructionSet	The instruction set.
+	///
+	/// \return	The kernel.
+	///-------------------------------------------------------------------------------------------------
+	static Kernel getKernel( InstructionSet aInstructionSet );
+
+	static Kernel mKernel;  ///< The kernel used by interpolate
+
+	static InstructionSet mInstructionSet;  ///< The instruction set of used kernel
+};
+
+// inline functions implementation
+
+inline void GuidesInterpolation::interpolate( Real * aResult, const Real * const * aGuides, const Real * aWeights,
+	unsigned __int32 aGuidesCount, unsigned __int32 aValuesCount )
+{
+	mKernel( aResult, aGuides, aWeights, aGuidesCount, aValuesCount );
+}
+
+} // namespace Interpolation
+
+} // namespace HairShape
+
+} // namespace Stubble
+
+#endif // STUBBLE_GUIDES_INTERPOLATION_HPP
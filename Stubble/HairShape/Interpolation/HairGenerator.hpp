@@ -2,11 +2,18 @@
 #define STUBBLE_HAIR_GENERATOR_HPP
 
 #include "Primitives/BoundingBox.hpp"
+#include "BakedHairRoot.hpp"
+#include "BufferedOutputGenerator.hpp"
+#include "BufferedPositionGenerator.hpp"
+#include "GuidesInterpolation.hpp"
 #include "HairProperties.hpp"
+#include "MotionSamplesCache.hpp"
 #include "HairShape/Generators/RandomGenerator.hpp"
 #include "OutputGenerator.hpp"
 #include "PositionGenerator.hpp"
 
+#include <limits>
+
 namespace Stubble
 {
 
@@ -45,6 +52,34 @@ public:
 	///-------------------------------------------------------------------------------------------------
 	void generate( const HairProperties & aHairProperties );
 
+	///-------------------------------------------------------------------------------------------------
+	/// Generates interpolated hair with random generator starting in given state. 
+	/// Used by parallel generation to generate single block of hair.
+	///
+	/// \param	aHairProperties	The hair properties. 
+	/// \param	aRandom			The start state of random generator. 
+	///-------------------------------------------------------------------------------------------------
+	void generate( const HairProperties & aHairProperties, const RandomGenerator & aRandom );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Generates interpolated hair in multiple threads.
+	/// Hair are split into blocks, blocks are generated in parallel and then sent to output generator
+	/// in hair index order, so generated hair are identical to hair generated by generate method.
+	/// If OpenMP is not available, generate method is used instead.
+	///
+	/// \param	aHairProperties	The hair properties. 
+	///-------------------------------------------------------------------------------------------------
+	void generateParallel( const HairProperties & aHairProperties );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Generates interpolated hair in multiple threads with random generator starting in given state. 
+	/// Used to continue generation of hair, which is split into multiple parts.
+	///
+	/// \param	aHairProperties	The hair properties. 
+	/// \param	aRandom			The start state of random generator. 
+	///-------------------------------------------------------------------------------------------------
+	void generateParallel( const HairProperties & aHairProperties, const RandomGenerator & aRandom );
+
 	///-------------------------------------------------------------------------------------------------
 	/// Calculates the bounding box of hair.
 	/// Uses position generator to generate hair positions, output generator is not used.
@@ -65,6 +100,65 @@ public:
 	///-------------------------------------------------------------------------------------------------
 	inline const BoundingBox & getBoundingBox() const;
 
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the state of random generator after last generation. Generation of following hair can 
+	/// continue from this state.
+	///
+	/// \return	The random generator. 
+	///-------------------------------------------------------------------------------------------------
+	inline const RandomGenerator & getRandom() const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Sets the detail size used for level of detail selection ( only if level of detail is enabled
+	/// by hair properties ). By default hair are generated with full detail.
+	///
+	/// \param	aDetailSize	Size of the detail ( area of hair bounding box on screen in pixels ). 
+	///-------------------------------------------------------------------------------------------------
+	inline void setDetailSize( Real aDetailSize );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Sets the size of one pixel in world space, which converts decimation tolerance given in pixels
+	/// to world space. If pixel size is unknown ( default ), decimation in screen space is not used.
+	///
+	/// \param	aPixelSize	Size of the pixel in world units ( 0 if unknown ). 
+	///-------------------------------------------------------------------------------------------------
+	inline void setPixelSize( Real aPixelSize );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Sets the maximum number of threads used by parallel generation. Caller, which is itself run
+	/// by many threads ( renderer ), should limit threads, so cores are not oversubscribed.
+	///
+	/// \param	aThreadsCount	The threads count ( 0 to use OpenMP default ). 
+	///-------------------------------------------------------------------------------------------------
+	inline void setThreadsCount( int aThreadsCount );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the number of not degenerated hair dropped by level of detail during last generation, that
+	/// have used the same random numbers as generated hair ( only if random generator is not counter based ).
+	///
+	/// \return	The dropped hair count. 
+	///-------------------------------------------------------------------------------------------------
+	inline unsigned __int64 getDroppedHairCount() const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Sets the cache shared by motion samples of the same hair range. Recording generator stores frame
+	/// invariant data of every hair to cache, other generators only evaluate time dependent parts of
+	/// hair and take everything else from cache. Cache is not used by default.
+	///
+	/// \param [in,out]	aCache	The motion samples cache or 0 if no cache should be used.
+	/// \param	aRecord			true if frame invariant data should be stored to cache, false if they
+	/// 						should be taken from cache.
+	///-------------------------------------------------------------------------------------------------
+	inline void setMotionSamplesCache( MotionSamplesCache * aCache, bool aRecord );
+
+	static const unsigned __int32 PARALLEL_BLOCK_SIZE = 64; ///< Number of main hair in block of parallel generation
+
+	static const unsigned __int32 PARALLEL_BLOCKS_PER_THREAD = 4; ///< Number of blocks per thread generated at once
+
+	static const unsigned __int32 OUTPUT_BATCH_SIZE = 4;	///< Number of hair points with colors calculated at once
+
+	static const unsigned __int32 STRAND_BATCH_SIZE = 16;   ///< Number of hair in strand with points generated at once
+
 private:
 
 	/* For easier usage, we will create aliases for output types */
@@ -117,18 +211,127 @@ private:
 	///-------------------------------------------------------------------------------------------------
 	/// Defines an alias representing the matrix .
 	///-------------------------------------------------------------------------------------------------
-	typedef Matrix< PositionType > Matrix;
+	typedef Stubble::Matrix< PositionType > Matrix;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Values that represent optional stages of hair generation. Generation loop is instantiated for
+	/// every combination of stages, so stages disabled by hair properties are compiled out of it.
+	///-------------------------------------------------------------------------------------------------
+	enum Feature
+	{
+		FEATURE_FRIZZ = 1,  ///< Frizz is applied to hair
+		FEATURE_KINK = 2,   ///< Kink is applied to hair
+		FEATURE_MULTI_STRAND = 4,   ///< Hair are generated in multi strands
+		FEATURE_NORMALS = 8 ///< Normals are calculated and outputed
+	};
 
 	///-------------------------------------------------------------------------------------------------
-	/// Interpolate hair segments from N closest guides. 
+	/// Block of hair generated by single thread during parallel generation.
+	///-------------------------------------------------------------------------------------------------
+	struct ParallelBlock
+	{
+		///-------------------------------------------------------------------------------------------------
+		/// Default constructor. 
+		///-------------------------------------------------------------------------------------------------
+		inline ParallelBlock();
+
+		BufferedPositionGenerator mPositionGenerator;   ///< The positions of block hair
+
+		BufferedOutputGenerator< tOutputGenerator > mOutputGenerator; ///< The generated hair of block
+
+		/// The block hair generator
+		HairGenerator< BufferedPositionGenerator, BufferedOutputGenerator< tOutputGenerator > > mHairGenerator;
+
+		RandomGenerator mRandom;	///< The random generator state at the start of block
+
+		unsigned __int32 mNotCutHairCount;  ///< Number of hair in block that have not been cut at root
+
+		bool mDirty;	///< true if block must be generated ( again )
+	};
+
+	///-------------------------------------------------------------------------------------------------
+	/// Generates position of single hair. 
 	///
-	/// \param [in,out]	aPoints			The hair points. 
-	/// \param	aCount					Number of points. 
-	/// \param	aRestPosition			The rest position of hair. 
-	/// \param	aInterpolationGroupId	Identifier for a interpolation group. 
+	/// \param [in,out]	aCurrentPosition	The current position of hair. 
+	/// \param [in,out]	aRestPosition		The rest position of hair. 
+	///-------------------------------------------------------------------------------------------------
+	inline void generatePosition( MeshPoint & aCurrentPosition, MeshPoint & aRestPosition );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Selects the stages of hair generation, which can change generated hair. Stage is disabled only
+	/// if it has no effect on any hair ( e.g. zero root and tip frizz ), so generated hair stay the same.
+	///
+	/// \param	aHairProperties	The hair properties. 
+	///
+	/// \return	Combination of Feature flags. 
+	///-------------------------------------------------------------------------------------------------
+	inline unsigned __int32 selectFeatures( const HairProperties & aHairProperties ) const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Generates interpolated hair with random generator starting in given state. Implements generate
+	/// method, only stages selected by template parameter tFeatures are executed.
+	///
+	/// \param	aHairProperties	The hair properties. 
+	/// \param	aRandom			The start state of random generator. 
+	///-------------------------------------------------------------------------------------------------
+	template< unsigned __int32 tFeatures >
+	void generateWithFeatures( const HairProperties & aHairProperties, const RandomGenerator & aRandom );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Resets random generator to mode and seed selected by hair properties. 
+	///
+	/// \param	aHairProperties	The hair properties. 
 	///-------------------------------------------------------------------------------------------------
-	inline void interpolateFromGuides( Point * aPoints, unsigned __int32 aCount, const MeshPoint &aRestPosition, 
-		unsigned __int32 aInterpolationGroupId );
+	inline void resetRandom( const HairProperties & aHairProperties );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Selects ratio of generated hair, segments and hair width scale from detail size and level of
+	/// detail hair properties. 
+	///-------------------------------------------------------------------------------------------------
+	inline void selectLevelOfDetail();
+
+	///-------------------------------------------------------------------------------------------------
+	/// Query if hair is dropped by level of detail. Decision only depends on hair index, so hair
+	/// generated with lower detail are always subset of hair generated with higher detail.
+	///
+	/// \param	aHairIndex	Zero-based index of the main hair. 
+	///
+	/// \return	true if hair is dropped. 
+	///-------------------------------------------------------------------------------------------------
+	inline bool isDroppedByLevelOfDetail( unsigned __int64 aHairIndex );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Selects number of hair points with respect to level of detail. 
+	///
+	/// \param	aGuidePointsCount	Number of guide points. 
+	///
+	/// \return	Number of hair points. 
+	///-------------------------------------------------------------------------------------------------
+	inline unsigned __int32 selectCurvePointsCount( unsigned __int32 aGuidePointsCount ) const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the baked root of last generated hair. If position generator does not provide baked roots,
+	/// interpolation group and closest guides are selected now.
+	///
+	/// \param	aRestPosition	The rest position of hair. 
+	///
+	/// \return	The baked root of hair. 
+	///-------------------------------------------------------------------------------------------------
+	inline const BakedHairRoot & selectHairRoot( const MeshPoint & aRestPosition );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Interpolate hair segments from N closest guides. If hair has less points than guides ( due to
+	/// level of detail ), only subset of guides points is used.
+	///
+	/// \param [in,out]	aPoints		The hair points. 
+	/// \param	aCount				Number of points. 
+	/// \param	aCurvePointsCount	Number of curve points ( before cut ). 
+	/// \param	aGuidePointsCount	Number of guide points. 
+	/// \param	aHairRoot			The hair root with selected guides and their weights. 
+	/// \param [in,out] aBuffer		Buffer for interpolated coordinates ( at least 3 * aCount values ). 
+	///-------------------------------------------------------------------------------------------------
+	inline void interpolateFromGuides( Point * aPoints, unsigned __int32 aCount, unsigned __int32 aCurvePointsCount,
+		unsigned __int32 aGuidePointsCount, const BakedHairRoot & aHairRoot, Real * aBuffer );
 
 	///-------------------------------------------------------------------------------------------------
 	/// Checks for hair degeneration. Deletes duplicate points and returns true if hair has degenerated
@@ -144,16 +347,36 @@ private:
 		unsigned __int32 & aCurvePointsCount );
 
 	///-------------------------------------------------------------------------------------------------
-	/// Applies the scale to hair points. 
+	/// Samples all per hair attributes textures at hair root by single fetch from attribute atlas.
+	/// Result is stored in HairGenerator object variables.
+	///
+	/// \param	aRestPosition	The rest position of hair. 
+	///-------------------------------------------------------------------------------------------------
+	inline void selectAttributes( const MeshPoint &aRestPosition );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Selects the scale of hair. Result is stored in HairGenerator object variables.
+	///-------------------------------------------------------------------------------------------------
+	inline void selectScale();
+
+	///-------------------------------------------------------------------------------------------------
+	/// Applies the selected scale to hair points. 
 	///
 	/// \param [in,out]	aPoints	The hair points. 
 	/// \param	aCount			Number of hair points. 
+	///-------------------------------------------------------------------------------------------------
+	inline void applyScale( Point * aPoints, unsigned __int32 aCount );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Selects the frizz properties and static frizz noise of hair. Result is stored in HairGenerator
+	/// object variables.
+	///
 	/// \param	aRestPosition	The rest position of hair. 
 	///-------------------------------------------------------------------------------------------------
-	inline void applyScale( Point * aPoints, unsigned __int32 aCount, const MeshPoint &aRestPosition );
+	inline void selectFrizzProperties( const MeshPoint &aRestPosition );
 
 	///-------------------------------------------------------------------------------------------------
-	/// Applies the frizz to hair points. 
+	/// Applies the selected frizz to hair points, only animated frizz noise is calculated. 
 	///
 	/// \param [in,out]	aPoints		The hair points. 
 	/// \param	aCount				Number of points. 
@@ -164,15 +387,16 @@ private:
 		const MeshPoint &aRestPosition );
 
 	///-------------------------------------------------------------------------------------------------
-	/// Applies the kink to hair points. 
+	/// Applies the kink to hair points. Noise of all points is evaluated at once.
 	///
 	/// \param [in,out]	aPoints		The hair points. 
 	/// \param	aCount				Number of points. 
 	/// \param	aCurvePointsCount	Number of curve points, used for curve parameter t calculation. 
 	/// \param	aRestPosition		The rest position of hair. 
+	/// \param [in,out] aBuffer		Buffer for noise inputs and results ( at least 6 * aCount values ). 
 	///-------------------------------------------------------------------------------------------------
 	inline void applyKink( Point * aPoints, unsigned __int32 aCount, unsigned __int32 aCurvePointsCount, 
-		const MeshPoint &aRestPosition );
+		const MeshPoint &aRestPosition, float * aBuffer );
 
 	///-------------------------------------------------------------------------------------------------
 	/// Transforms points by requested transform matrix. 
@@ -230,10 +454,8 @@ private:
 
 	///-------------------------------------------------------------------------------------------------
 	/// Select hair color, opacity and width. Result is stored in HairGenerator object variables.
-	///
-	/// \param	aRestPosition	The rest position of hair. 
 	///-------------------------------------------------------------------------------------------------
-	inline void selectHairColorOpacityWidth( const MeshPoint & aRestPosition );
+	inline void selectHairColorOpacityWidth();
 
 	///-------------------------------------------------------------------------------------------------
 	/// Only calls the same number of random values generation as selectHairColorOpacityWidth. This 
@@ -253,11 +475,36 @@ private:
 	///-------------------------------------------------------------------------------------------------
 	inline bool skipPoint( const Point * aPoints, const Vector * aTangents );
 
+	///-------------------------------------------------------------------------------------------------
+	/// Selects decimation tolerance in world space from hair properties and pixel size.
+	///-------------------------------------------------------------------------------------------------
+	inline void selectDecimationTolerance();
+
+	///-------------------------------------------------------------------------------------------------
+	/// Decimates hair points, so the Catmull-Rom curve through kept points ( rendered with duplicated
+	/// end points ) stays within decimation tolerance from the full curve. Only end points are kept at
+	/// first, then every span between two successive kept points is measured : the kept curve is
+	/// evaluated at parameters of removed points and of middles of full curve segments ( points are
+	/// uniformly spaced in curve parameter ) and compared with them. The worst point of every span
+	/// exceeding tolerance is kept ( span of single segment keeps its removed neighbour point, which
+	/// changes its tangent ) and all spans are measured again, until no span exceeds tolerance. 
+	/// Removed points are marked by negated curve parameter.
+	///
+	/// \param	aPoints				Hair points. 
+	/// \param	aCount				Number of points. 
+	/// \param [in,out]	aParams	The curve parameters of points. 
+	///-------------------------------------------------------------------------------------------------
+	inline void decimatePoints( const Point * aPoints, unsigned __int32 aCount, PositionType * aParams ) const;
+
 	///-------------------------------------------------------------------------------------------------
 	/// Generates final hair points positions, normals, colors, opacities, widths.
+	/// Points are selected first ( either by skip threshold or by decimation ), then positions and 
+	/// normals are calculated point by point, colors, opacities and widths are calculated in batches
+	/// of OUTPUT_BATCH_SIZE points.
 	/// Uses output generator pointer to output all hair properties.
 	/// Method beginHair of output generator must precede calling of this method.
 	/// This method expects all colors to be in HSV and converts them back to RGB before outputing.
+	/// Normals are only calculated if tFeatures contains FEATURE_NORMALS.
 	///
 	/// \param [in,out] aPoints		Hair points ( may be modified if cut is applied ). 
 	/// \param [in,out] aTangents	Hair tangents ( may be modified if cut is applied ).
@@ -265,20 +512,25 @@ private:
 	/// \param	aCurvePointsCount	Number of curve points, used for curve parameter t calculation. 
 	/// \param	aRestPosition		The rest position of hair. 
 	/// \param  aCutFactor			Parametric representation of hair cut.
+	/// \param [in,out] aBuffer		Buffer for curve parameters of outputed points 
+	/// 							( at least 2 * ( aCount + 2 * OUTPUT_BATCH_SIZE ) values ).
 	/// 
 	/// \return final number of hair points.
 	///-------------------------------------------------------------------------------------------------
+	template< unsigned __int32 tFeatures >
 	inline unsigned __int32 generateHair( Point * aPoints, Vector * aTangents, unsigned __int32 aCount, 
-		unsigned __int32 aCurvePointsCount, const MeshPoint &aRestPosition, PositionType aCutFactor );
+		unsigned __int32 aCurvePointsCount, const MeshPoint &aRestPosition, PositionType aCutFactor,
+		PositionType * aBuffer );
 
 	///-------------------------------------------------------------------------------------------------
-	/// Output hair index and u v coordinates. 
+	/// Output hair index and u v coordinates. Hair index is 64 bit, output generators with 32 bit
+	/// index type receive it wrapped around.
 	///
 	/// \param	aHairIndex		Zero-based index of a hair. 
 	/// \param	aStrandIndex	Zero-based index of a strand. 
 	/// \param	aRestPosition	The hair rest position. 
 	///-------------------------------------------------------------------------------------------------
-	inline void outputHairIndexAndUVs( IndexType aHairIndex, IndexType aStrandIndex, const MeshPoint &aRestPosition );
+	inline void outputHairIndexAndUVs( unsigned __int64 aHairIndex, IndexType aStrandIndex, const MeshPoint &aRestPosition );
 
 	///-------------------------------------------------------------------------------------------------
 	/// Samples disk. Uses two samples from [-1,1]^2 to sample disk and returns phi angle and radius.
@@ -294,24 +546,74 @@ private:
 
 	///-------------------------------------------------------------------------------------------------
 	/// Selects multi strand properties. 
+	///-------------------------------------------------------------------------------------------------
+	inline void selectMultiStrandProperties();
+
+	///-------------------------------------------------------------------------------------------------
+	/// Selects twist angle of each hair point from selected twist of whole hair. 
+	///
+	/// \param	aCurvePointsCount	Number of curve points. 
+	///-------------------------------------------------------------------------------------------------
+	inline void selectTwist( unsigned __int32 aCurvePointsCount );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Selects random position of hair in strand on disk around main hair. 
 	///
-	/// \param	aRestPosition		The hair rest position.
-	/// \param	aCurvePointsCount	Number of curve points, used for twist calculation.  
+	/// \param [in,out]	aCosPhi	The cosine of angle of hair position. 
+	/// \param [in,out]	aSinPhi	The sine of angle of hair position. 
 	///-------------------------------------------------------------------------------------------------
-	inline void selectMultiStrandProperties( const MeshPoint &aRestPosition, unsigned __int32 aCurvePointsCount );
+	inline void selectPositionInStrand( PositionType & aCosPhi, PositionType & aSinPhi );
 
 	///-------------------------------------------------------------------------------------------------
-	/// Generates a hair positions in strand (main hair) local space. 
+	/// Calculates frame shared by all hair in strand. Every point of hair in strand equals 
+	/// base + cosAxis * cos( phi ) + sinAxis * sin( phi ), where phi is angle of hair position on disk
+	/// around main hair. Splay, offset, twist and aspect are thus evaluated only once per strand and
+	/// frame is directly transformed to current world space ( transform is affine ).
 	///
-	/// \param [in,out]	aPoints		The new hair points. 
+	/// \param [in,out]	aFrame		The frame : aCount bases, aCount cos axes and aCount sin axes. 
 	/// \param	aCount				Number of points. 
 	/// \param	aCurvePointsCount	Number of curve points, used for curve parameter t calculation. 
-	/// \param	aMainHairPoints		The main hair points. 
-	/// \param	aMainHairNormals	The main hair normals. 
-	/// \param	aMainHairBinormals	The main hair binormals. 
+	/// \param	aMainHairPoints		The main hair points in local space. 
+	/// \param	aMainHairNormals	The main hair normals in local space. 
+	/// \param	aMainHairBinormals	The main hair binormals in local space. 
+	/// \param	aTransformMatrix	The local to current world space transform matrix. 
+	///-------------------------------------------------------------------------------------------------
+	inline void calculateStrandFrame( Point * aFrame, unsigned __int32 aCount, unsigned __int32 aCurvePointsCount,
+		const Point * aMainHairPoints, const Vector * aMainHairNormals, const Vector * aMainHairBinormals,
+		const Matrix & aTransformMatrix );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Generates current world space positions of multiple hair in strand at once from strand frame.
+	///
+	/// \param [in,out]	aPoints		The new hair points, hair j starts at aPoints + j * aStride. 
+	/// \param	aStride				The distance between first points of following hair. 
+	/// \param	aHairCount			Number of generated hair. 
+	/// \param	aCounts				Number of points of every hair. 
+	/// \param	aCosPhis			The cosine of angle of every hair position in strand. 
+	/// \param	aSinPhis			The sine of angle of every hair position in strand. 
+	/// \param	aFrame				The strand frame. 
+	/// \param	aFrameCount			Number of points of strand frame. 
+	///-------------------------------------------------------------------------------------------------
+	inline void generateHairInStrand( Point * aPoints, unsigned __int32 aStride, unsigned __int32 aHairCount,
+		const unsigned __int32 * aCounts, const PositionType * aCosPhis, const PositionType * aSinPhis,
+		const Point * aFrame, unsigned __int32 aFrameCount );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Stores frame invariant data of generated hair to motion samples cache. 
+	///
+	/// \param [in,out]	aHair	The cached hair. 
+	/// \param	aCutFactor		The cut factor of hair. 
+	/// \param	aHairRoot		The hair root with selected guides and their weights. 
+	///-------------------------------------------------------------------------------------------------
+	inline void storeToCache( MotionSamplesCache::Hair & aHair, PositionType aCutFactor, 
+		const BakedHairRoot & aHairRoot ) const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Loads frame invariant data of hair from motion samples cache. 
+	///
+	/// \param	aHair	The cached hair. 
 	///-------------------------------------------------------------------------------------------------
-	inline void generateHairInStrand( Point * aPoints, unsigned __int32 aCount, unsigned __int32 aCurvePointsCount,
-		const Point * aMainHairPoints, const Vector * aMainHairNormals, const Vector * aMainHairBinormals );
+	inline void loadFromCache( const MotionSamplesCache::Hair & aHair );
 
 	///-------------------------------------------------------------------------------------------------
 	/// Calculates the bounding box of single hair.
@@ -336,8 +638,54 @@ private:
 
 	RandomGenerator mRandom;	///< The random generator
 
+	// Level of detail
+
+	Real mDetailSize;   ///< Size of the detail ( area of hair bounding box on screen in pixels )
+
+	Real mLodHairRatio; ///< The ratio of generated hair
+
+	Real mLodSegmentsRatio; ///< The ratio of generated hair segments
+
+	WidthType mLodWidthScale;   ///< The scale of hair width, which keeps coverage of dropped hair
+
+	RandomGenerator mLodRandom; ///< The random generator used for level of detail selection
+
+	unsigned __int64 mDroppedHairCount; ///< Number of dropped not degenerated hair
+
+	// Decimation
+
+	Real mPixelSize;	///< Size of the pixel in world units ( 0 if unknown )
+
+	PositionType mDecimationTolerance;  ///< The decimation tolerance in world space ( 0 if not used )
+
+	// Motion blur
+
+	MotionSamplesCache * mMotionSamplesCache;   ///< The cache shared by motion samples ( 0 if not used )
+
+	bool mIsRecordingMotionSamples; ///< true if frame invariant data are stored to cache
+
 	// Generated hair tmp properties
 
+	BakedHairRoot mHairRoot;	///< The hair root selected by hair generator ( if roots are not baked )
+
+	float mAttributes[ AttributeAtlas::ATTRIBUTES_COUNT ];  ///< The attributes textures values at hair root
+
+	HairComponents::ClosestGuidesQuery mClosestGuidesQuery;  ///< The reusable closest guides query of hair roots
+
+	PositionType mScale;	///< The scale factor
+
+	Real mFrizzFrequency[ 3 ];  ///< The frizz frequencies
+
+	Real mRootFrizz;	///< The root frizz
+
+	Real mTipFrizz; ///< The tip frizz
+
+	Real mFrizzAnim;	///< The frizz animation factor
+
+	Real mFrizzAnimSpeed;   ///< The frizz animation speed
+
+	Real mStaticFrizz[ 3 ]; ///< The displacement by static frizz noise
+
 	ColorType mRootColor[ 3 ];  ///< The root color
 
 	ColorType mTipColor[ 3 ];   ///< The tip color
@@ -354,6 +702,8 @@ private:
 
 	// Multi-strands properties
 
+	PositionType mTwist;	///< The twist angle of whole hair
+
 	PositionType mCosTwist; ///< The cosine of twist angle
 
 	PositionType mSinTwist; ///< The sine of twist angle
@@ -373,6 +723,8 @@ private:
 	// Debug info
 
 	BoundingBox mBoundingBox;   ///< The bounding box of generated hair points
+
+	int mThreadsCount;  ///< The maximum number of threads of parallel generation ( 0 for OpenMP default )
 };
 
 // inline functions implementation
@@ -381,7 +733,17 @@ template< typename tPositionGenerator, typename tOutputGenerator >
 inline HairGenerator< tPositionGenerator, tOutputGenerator >::HairGenerator
 	( tPositionGenerator & aPositionGenerator, tOutputGenerator & aOutputGenerator ):
 	mPositionGenerator( aPositionGenerator ),
-	mOutputGenerator( aOutputGenerator )
+	mOutputGenerator( aOutputGenerator ),
+	mDetailSize( std::numeric_limits< Real >::max() ),
+	mLodHairRatio( 1 ),
+	mLodSegmentsRatio( 1 ),
+	mLodWidthScale( 1 ),
+	mDroppedHairCount( 0 ),
+	mPixelSize( 0 ),
+	mDecimationTolerance( 0 ),
+	mMotionSamplesCache( 0 ),
+	mIsRecordingMotionSamples( false ),
+	mThreadsCount( 0 )
 {
 }
 
@@ -392,6 +754,57 @@ getBoundingBox() const
 	return mBoundingBox;
 }
 
+template< typename tPositionGenerator, typename tOutputGenerator >
+inline const RandomGenerator & HairGenerator< tPositionGenerator, tOutputGenerator >::
+getRandom() const
+{
+	return mRandom;
+}
+
+template< typename tPositionGenerator, typename tOutputGenerator >
+inline void HairGenerator< tPositionGenerator, tOutputGenerator >::
+setDetailSize( Real aDetailSize )
+{
+	mDetailSize = aDetailSize;
+}
+
+template< typename tPositionGenerator, typename tOutputGenerator >
+inline void HairGenerator< tPositionGenerator, tOutputGenerator >::
+setPixelSize( Real aPixelSize )
+{
+	mPixelSize = aPixelSize;
+}
+
+template< typename tPositionGenerator, typename tOutputGenerator >
+inline void HairGenerator< tPositionGenerator, tOutputGenerator >::
+setThreadsCount( int aThreadsCount )
+{
+	mThreadsCount = aThreadsCount;
+}
+
+template< typename tPositionGenerator, typename tOutputGenerator >
+inline unsigned __int64 HairGenerator< tPositionGenerator, tOutputGenerator >::
+getDroppedHairCount() const
+{
+	return mDroppedHairCount;
+}
+
+template< typename tPositionGenerator, typename tOutputGenerator >
+inline void HairGenerator< tPositionGenerator, tOutputGenerator >::
+setMotionSamplesCache( MotionSamplesCache * aCache, bool aRecord )
+{
+	mMotionSamplesCache = aCache;
+	mIsRecordingMotionSamples = aRecord;
+}
+
+template< typename tPositionGenerator, typename tOutputGenerator >
+inline HairGenerator< tPositionGenerator, tOutputGenerator >::ParallelBlock::ParallelBlock():
+	mHairGenerator( mPositionGenerator, mOutputGenerator ),
+	mNotCutHairCount( 0 ),
+	mDirty( false )
+{
+}
+
 } // namespace Interpolation
 
 } // namespace HairShape
@@ -3,12 +3,16 @@
 
 #include "Common/CommonFunctions.hpp"
 #include "Common/CatmullRomUtilities.hpp"
+#include "Common/Noise.hpp"
 
 #include "HairGenerator.hpp"
 
 #include <algorithm>
 #include <cmath>
-#include <rx.h>
+#include <string>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #undef min
 #undef max
@@ -24,6 +28,73 @@ namespace Interpolation
 
 template< typename tPositionGenerator, typename tOutputGenerator >
 void HairGenerator< tPositionGenerator, tOutputGenerator >::generate( const HairProperties & aHairProperties )
+{
+	resetRandom( aHairProperties );
+	generate( aHairProperties, mRandom );
+}
+
+template< typename tPositionGenerator, typename tOutputGenerator >
+void HairGenerator< tPositionGenerator, tOutputGenerator >::generate( const HairProperties & aHairProperties,
+	const RandomGenerator & aRandom )
+{
+	// Stages are selected once for all hair, generation loop of selected stages is already instantiated
+	switch ( selectFeatures( aHairProperties ) )
+	{
+	case 0:
+		generateWithFeatures< 0 >( aHairProperties, aRandom );
+		break;
+	case 1:
+		generateWithFeatures< 1 >( aHairProperties, aRandom );
+		break;
+	case 2:
+		generateWithFeatures< 2 >( aHairProperties, aRandom );
+		break;
+	case 3:
+		generateWithFeatures< 3 >( aHairProperties, aRandom );
+		break;
+	case 4:
+		generateWithFeatures< 4 >( aHairProperties, aRandom );
+		break;
+	case 5:
+		generateWithFeatures< 5 >( aHairProperties, aRandom );
+		break;
+	case 6:
+		generateWithFeatures< 6 >( aHairProperties, aRandom );
+		break;
+	case 7:
+		generateWithFeatures< 7 >( aHairProperties, aRandom );
+		break;
+	case 8:
+		generateWithFeatures< 8 >( aHairProperties, aRandom );
+		break;
+	case 9:
+		generateWithFeatures< 9 >( aHairProperties, aRandom );
+		break;
+	case 10:
+		generateWithFeatures< 10 >( aHairProperties, aRandom );
+		break;
+	case 11:
+		generateWithFeatures< 11 >( aHairProperties, aRandom );
+		break;
+	case 12:
+		generateWithFeatures< 12 >( aHairProperties, aRandom );
+		break;
+	case 13:
+		generateWithFeatures< 13 >( aHairProperties, aRandom );
+		break;
+	case 14:
+		generateWithFeatures< 14 >( aHairProperties, aRandom );
+		break;
+	default:
+		generateWithFeatures< FEATURE_FRIZZ | FEATURE_KINK | FEATURE_MULTI_STRAND | FEATURE_NORMALS >( 
+			aHairProperties, aRandom );
+	}
+}
+
+template< typename tPositionGenerator, typename tOutputGenerator >
+template< unsigned __int32 tFeatures >
+void HairGenerator< tPositionGenerator, tOutputGenerator >::generateWithFeatures( 
+	const HairProperties & aHairProperties, const RandomGenerator & aRandom )
 {
 	mBoundingBox.clear();
 	// Store pointer to hair properties, so we don't need to send it to every function
@@ -34,74 +105,150 @@ void HairGenerator< tPositionGenerator, tOutputGenerator >::generate( const Hair
 	Point * points = new Point[ maxPointsCount ];
 	// The first point always equals the second one, so it will not be included in many calculations
 	Point * pointsPlusOne = points + 1; 
-	Point * pointsStrand = new Point[ maxPointsCount ];
+	// Points of batch of hair in strand, every hair has maxPointsCount points
+	Point * pointsStrand = new Point[ STRAND_BATCH_SIZE * maxPointsCount ];
 	Point * pointsStrandPlusOne = pointsStrand + 1; 
+	Point * strandFrame = new Point[ 3 * maxPointsCount ];
 	Vector * tangents = new Vector[ maxPointsCount ];
 	Vector * tangentsPlusOne = tangents + 1; 
 	Vector * normals = new Vector[ maxPointsCount ];
 	Vector * binormals = new Vector[ maxPointsCount ];
+	Real * interpolated = new Real[ 3 * maxPointsCount ];
+	float * noise = new float[ 6 * maxPointsCount ];
+	PositionType * parameters = new PositionType[ 2 * ( maxPointsCount + 2 * OUTPUT_BATCH_SIZE ) ];
 	// Prepare matrix
 	Matrix localToCurr;
-	// Resets random generator
-	mRandom.reset();
+	// Sets random generator state
+	mRandom = aRandom;
+	// Select level of detail
+	selectLevelOfDetail();
+	mDroppedHairCount = 0;
+	selectDecimationTolerance();
 	// Indices
-	IndexType hairInStrand = 
+	const unsigned __int64 hairInStrand = 
 		std::max( aHairProperties.getMultiStrandCount(), static_cast< unsigned __int32 >( 1 ) );
-	IndexType hairIndex = static_cast< IndexType >( mPositionGenerator.getHairStartIndex() * hairInStrand );
+	unsigned __int64 hairIndex = multiplyCounts( mPositionGenerator.getHairStartIndex(), hairInStrand );
 	IndexType strandIndex = static_cast< IndexType >( mPositionGenerator.getHairStartIndex() );
+	// The first motion sample stores frame invariant data to cache, following samples reuse them
+	const bool isReplaying = mMotionSamplesCache != 0 && !mIsRecordingMotionSamples;
 	// Start output
-	mOutputGenerator.beginOutput( mPositionGenerator.getHairCount() * hairInStrand, maxPointsCount );
+	mOutputGenerator.beginOutput( multiplyCounts( mPositionGenerator.getHairCount(), hairInStrand ), maxPointsCount );
 	// For every main hair
-	for ( unsigned __int32 i = 0; i < mPositionGenerator.getHairCount(); ++i, ++strandIndex )
+	for ( unsigned __int64 i = 0; i < mPositionGenerator.getHairCount(); ++i, ++strandIndex )
 	{
+		// Every main hair uses its own random stream ( only if random generator is counter based )
+		mRandom.setStream( mPositionGenerator.getHairStartIndex() + i );
 		// Generate position
 		MeshPoint currPos;
 		MeshPoint restPos;
-		Real displaceFactor = mHairProperties->getDisplacement();
-		if ( displaceFactor == 0 )
+		generatePosition( currPos, restPos );
+		MotionSamplesCache::Hair * cachedHair = mMotionSamplesCache == 0 ? 0 :
+			&mMotionSamplesCache->getHair( mPositionGenerator.getHairStartIndex() + i );
+		PositionType cutFactor;
+		bool isDropped = false;
+		const BakedHairRoot * hairRoot;
+		if ( isReplaying )
 		{
-			mPositionGenerator.generate( currPos, restPos );
+			if ( cachedHair->mState != MotionSamplesCache::HAIR_GENERATED )
+			{
+				mDroppedHairCount += cachedHair->mState == MotionSamplesCache::HAIR_DROPPED ? 1 : 0;
+				continue; // The hair has not been generated by the first motion sample
+			}
+			// Take cut factor, guides, scale, frizz, color, opacity, width and strand properties from cache
+			cutFactor = static_cast< PositionType >( cachedHair->mCutFactor );
+			hairRoot = &cachedHair->mHairRoot;
+			loadFromCache( *cachedHair );
+			// Kink is not cached, it needs attributes
+			selectAttributes( restPos );
 		}
 		else
 		{
-			mPositionGenerator.generate( currPos, restPos, mHairProperties->getDisplacementTexture(), 
-				mHairProperties->getDisplacement() );
-		}
-		// Determine cut factor
-		PositionType cutFactor = static_cast< PositionType >( 
-			aHairProperties.getCutTexture().realAtUV( restPos.getUCoordinate(), restPos.getVCoordinate() ) );
-		if ( cutFactor == 0 )
-		{
-			continue; // The hair has been cut at root
+			if ( cachedHair != 0 )
+			{
+				cachedHair->mState = MotionSamplesCache::HAIR_SKIPPED;
+			}
+			// Determine cut factor
+			cutFactor = static_cast< PositionType >( 
+				aHairProperties.getCutTexture().realAtUV( restPos.getUCoordinate(), restPos.getVCoordinate() ) );
+			if ( cutFactor == 0 )
+			{
+				continue; // The hair has been cut at root
+			}
+			// Level of detail may drop the hair
+			isDropped = isDroppedByLevelOfDetail( mPositionGenerator.getHairStartIndex() + i );
+			if ( isDropped && mRandom.isCounterBased() )
+			{
+				continue; // Other hair do not depend on random numbers of dropped hair
+			}
+			// Get interpolation group and guides to interpolate from
+			hairRoot = &selectHairRoot( restPos );
+			// Sample all attributes textures at once
+			selectAttributes( restPos );
+			// Select scale and frizz
+			selectScale();
+			if ( ( tFeatures & FEATURE_FRIZZ ) != 0 )
+			{
+				selectFrizzProperties( restPos );
+			}
 		}
-		// Get interpolation group
-		unsigned __int32 groupId = aHairProperties.getInterpolationGroups().
-			getGroupId( restPos.getUCoordinate(), restPos.getVCoordinate() );
-		// Get points count = segments count + 1
-		unsigned __int32 ptsCountBeforeCut = aHairProperties.getInterpolationGroups().
+		const unsigned __int32 groupId = hairRoot->mInterpolationGroupId;
+		// Get guide points count = segments count + 1
+		const unsigned __int32 guidePtsCount = aHairProperties.getInterpolationGroups().
 			getGroupSegmentsCount( groupId ) + 1;
+		// Get points count, level of detail may select less points than guides have
+		unsigned __int32 ptsCountBeforeCut = selectCurvePointsCount( guidePtsCount );
 		// Calculate points count after cut, if cut < 1 than we need to include one more point for cut calculation
 		unsigned __int32 ptsCountAfterCut = 
 			static_cast< unsigned __int32 >( std::ceil( cutFactor * ptsCountBeforeCut ) ) + 2;
 		// Limit pts count
 		ptsCountAfterCut = ptsCountBeforeCut < ptsCountAfterCut ? ptsCountBeforeCut : ptsCountAfterCut;
 		// Interpolate points of hair from closest guides
-		interpolateFromGuides( pointsPlusOne, ptsCountAfterCut, restPos, groupId );
+		interpolateFromGuides( pointsPlusOne, ptsCountAfterCut, ptsCountBeforeCut, guidePtsCount, *hairRoot, 
+			interpolated );
 		// Apply scale to points 
-		applyScale( pointsPlusOne, ptsCountAfterCut, restPos );
+		applyScale( pointsPlusOne, ptsCountAfterCut );
 		// Apply frizz and kink to points 
-		applyFrizz( pointsPlusOne, ptsCountAfterCut, ptsCountBeforeCut, restPos );
-		applyKink( pointsPlusOne, ptsCountAfterCut, ptsCountBeforeCut, restPos );
+		if ( ( tFeatures & FEATURE_FRIZZ ) != 0 )
+		{
+			applyFrizz( pointsPlusOne, ptsCountAfterCut, ptsCountBeforeCut, restPos );
+		}
+		if ( ( tFeatures & FEATURE_KINK ) != 0 )
+		{
+			applyKink( pointsPlusOne, ptsCountAfterCut, ptsCountBeforeCut, restPos, noise );
+		}
 		// Check degenerate
 		if ( checkDegenerateHair( pointsPlusOne, ptsCountAfterCut, ptsCountBeforeCut ) )
 		{
 			continue; // The hair has degenerated to zero length
 		}
+		if ( isDropped )
+		{
+			// Consume color and strands random numbers, so the following hair stay the same
+			mRandom.skip( 3 + 3 * aHairProperties.getMultiStrandCount() );
+			++mDroppedHairCount;
+			if ( cachedHair != 0 )
+			{
+				cachedHair->mState = MotionSamplesCache::HAIR_DROPPED;
+			}
+			continue;
+		}
 		// Calculate local space to current world space transform
 		currPos.getWorldTransformMatrix( localToCurr );
-		// Select hair color, opacity and width
-		selectHairColorOpacityWidth( restPos );
-		if ( aHairProperties.getMultiStrandCount() ) // Uses multi strands ?
+		if ( !isReplaying )
+		{
+			// Select hair color, opacity and width
+			selectHairColorOpacityWidth();
+			// Get multi-strands properties
+			if ( ( tFeatures & FEATURE_MULTI_STRAND ) != 0 )
+			{
+				selectMultiStrandProperties();
+			}
+			if ( cachedHair != 0 )
+			{
+				storeToCache( *cachedHair, cutFactor, *hairRoot );
+			}
+		}
+		if ( ( tFeatures & FEATURE_MULTI_STRAND ) != 0 ) // Uses multi strands ?
 		{
 			// Duplicate first and last point ( last points need to be duplicated, 
 			// only if cut has not decreased points count, so we will use total points count )
@@ -113,39 +260,76 @@ void HairGenerator< tPositionGenerator, tOutputGenerator >::generate( const Hair
 			copyToLastAndFirst( tangents, ptsCountBeforeCut + 2 );
 			// Create full rotation minimizing frame for main hair
 			calculateNormalsAndBinormals( normals, binormals, pointsPlusOne, tangentsPlusOne, ptsCountAfterCut );
-			// Get multi-strands properties
-			selectMultiStrandProperties( restPos, ptsCountBeforeCut );
-			// Generate all hair in strand
-			for ( unsigned __int32 j = 0; j < aHairProperties.getMultiStrandCount(); ++j )
+			// Get twist of every hair point
+			selectTwist( ptsCountBeforeCut );
+			// Calculate frame shared by all hair in strand
+			calculateStrandFrame( strandFrame, ptsCountAfterCut, ptsCountBeforeCut, pointsPlusOne, normals,
+				binormals, localToCurr );
+			MotionSamplesCache::Strand * cachedStrands = cachedHair == 0 ? 0 :
+				mMotionSamplesCache->getStrands( mPositionGenerator.getHairStartIndex() + i );
+			// Generate all hair in strand in batches
+			const unsigned __int32 strandHairCount = aHairProperties.getMultiStrandCount();
+			for ( unsigned __int32 batchStart = 0; batchStart < strandHairCount; batchStart += STRAND_BATCH_SIZE )
 			{
-				// Randomized cut factor
-				PositionType randomizedCutFactor = cutFactor * static_cast< PositionType >( 1 - mRandomizeScale * mRandom.uniformNumber() );
-				// Recalculate points count
-				unsigned __int32 ptsCountAfterRandomizedCut = static_cast< unsigned __int32 >( std::ceil( randomizedCutFactor * ptsCountBeforeCut ) ) + 2;
-				ptsCountAfterRandomizedCut = ptsCountBeforeCut < ptsCountAfterRandomizedCut ? ptsCountBeforeCut : ptsCountAfterRandomizedCut;
-				// First generate points
-				generateHairInStrand( pointsStrandPlusOne, ptsCountAfterRandomizedCut, ptsCountBeforeCut, pointsPlusOne,
-					normals, binormals );
-				// Convert positions to current world space
-				transformPoints( pointsStrandPlusOne, ptsCountAfterRandomizedCut, localToCurr );
-				// Duplicate first and last point ( last points need to be duplicated, 
-				// only if cut has not decreased points count, so we will use total points count )
-				// These duplicated points are used for curve points calculation at any given param t
-				copyToLastAndFirst( pointsStrand, ptsCountBeforeCut + 2 );
-				// Calculate tangents
-				calculateTangents( tangentsPlusOne, pointsStrandPlusOne, ptsCountAfterRandomizedCut );
-				// Duplicate tangents ( same reason as with points duplication )
-				copyToLastAndFirst( tangents, ptsCountBeforeCut + 2 );
-				// Finally begin hair output ( first and last points are duplicated )
-				mOutputGenerator.beginHair( ptsCountAfterRandomizedCut + 2 );
-				// Output indices and uv coordinates
-				outputHairIndexAndUVs( ++hairIndex, strandIndex, restPos );
-				// Generate final hair : calculates normals, colors, opacity, width and may reject some points,
-				// so final points count is returned ( including two duplicated points : first and last )
-				unsigned __int32 pointsCount = generateHair( pointsStrandPlusOne, tangentsPlusOne, ptsCountAfterRandomizedCut, 
-					ptsCountBeforeCut, restPos, randomizedCutFactor );
-				// End hair generation
-				mOutputGenerator.endHair( pointsCount );
+				const unsigned __int32 batchCount = std::min( static_cast< unsigned __int32 >( STRAND_BATCH_SIZE ), 
+					strandHairCount - batchStart );
+				PositionType randomizedCutFactors[ STRAND_BATCH_SIZE ], cosPhis[ STRAND_BATCH_SIZE ], 
+					sinPhis[ STRAND_BATCH_SIZE ];
+				unsigned __int32 ptsCountsAfterRandomizedCut[ STRAND_BATCH_SIZE ];
+				// Select cut and position of every hair in batch
+				for ( unsigned __int32 j = batchStart, k = 0; k < batchCount; ++j, ++k )
+				{
+					if ( isReplaying )
+					{
+						randomizedCutFactors[ k ] = static_cast< PositionType >( cachedStrands[ j ].mCutFactor );
+						cosPhis[ k ] = static_cast< PositionType >( cachedStrands[ j ].mCosPhi );
+						sinPhis[ k ] = static_cast< PositionType >( cachedStrands[ j ].mSinPhi );
+					}
+					else
+					{
+						// Randomized cut factor
+						randomizedCutFactors[ k ] = cutFactor * 
+							static_cast< PositionType >( 1 - mRandomizeScale * mRandom.uniformNumber() );
+						// Random position on disk around main hair
+						selectPositionInStrand( cosPhis[ k ], sinPhis[ k ] );
+						if ( cachedStrands != 0 )
+						{
+							cachedStrands[ j ].mCutFactor = static_cast< float >( randomizedCutFactors[ k ] );
+							cachedStrands[ j ].mCosPhi = static_cast< float >( cosPhis[ k ] );
+							cachedStrands[ j ].mSinPhi = static_cast< float >( sinPhis[ k ] );
+						}
+					}
+					// Recalculate points count
+					unsigned __int32 ptsCountAfterRandomizedCut = static_cast< unsigned __int32 >( std::ceil( randomizedCutFactors[ k ] * ptsCountBeforeCut ) ) + 2;
+					ptsCountsAfterRandomizedCut[ k ] = ptsCountBeforeCut < ptsCountAfterRandomizedCut ? ptsCountBeforeCut : ptsCountAfterRandomizedCut;
+				}
+				// Generate current world space points of all hair in batch at once
+				generateHairInStrand( pointsStrandPlusOne, maxPointsCount, batchCount, ptsCountsAfterRandomizedCut,
+					cosPhis, sinPhis, strandFrame, ptsCountAfterCut );
+				// Output every hair in batch
+				for ( unsigned __int32 k = 0; k < batchCount; ++k )
+				{
+					Point * strandPoints = pointsStrand + k * maxPointsCount;
+					// Duplicate first and last point ( last points need to be duplicated, 
+					// only if cut has not decreased points count, so we will use total points count )
+					// These duplicated points are used for curve points calculation at any given param t
+					copyToLastAndFirst( strandPoints, ptsCountBeforeCut + 2 );
+					// Calculate tangents
+					calculateTangents( tangentsPlusOne, strandPoints + 1, ptsCountsAfterRandomizedCut[ k ] );
+					// Duplicate tangents ( same reason as with points duplication )
+					copyToLastAndFirst( tangents, ptsCountBeforeCut + 2 );
+					// Finally begin hair output ( first and last points are duplicated )
+					mOutputGenerator.beginHair( ptsCountsAfterRandomizedCut[ k ] + 2 );
+					// Output indices and uv coordinates
+					outputHairIndexAndUVs( ++hairIndex, strandIndex, restPos );
+					// Generate final hair : calculates normals, colors, opacity, width and may reject some points,
+					// so final points count is returned ( including two duplicated points : first and last )
+					unsigned __int32 pointsCount = generateHair< tFeatures >( strandPoints + 1, tangentsPlusOne, 
+						ptsCountsAfterRandomizedCut[ k ], ptsCountBeforeCut, restPos, randomizedCutFactors[ k ], 
+						parameters );
+					// End hair generation
+					mOutputGenerator.endHair( pointsCount );
+				}
 			}
 		}
 		else // Single hair only
@@ -166,8 +350,8 @@ void HairGenerator< tPositionGenerator, tOutputGenerator >::generate( const Hair
 			outputHairIndexAndUVs( ++hairIndex, strandIndex, restPos );
 			// Generate final hair : calculates normals, colors, opacity, width and may reject some points,
 			// so final points count is returned ( including two duplicated points : first and last )
-			unsigned __int32 pointsCount = generateHair( pointsPlusOne, tangentsPlusOne, ptsCountAfterCut, 
-				ptsCountBeforeCut, restPos, cutFactor );
+			unsigned __int32 pointsCount = generateHair< tFeatures >( pointsPlusOne, tangentsPlusOne, ptsCountAfterCut, 
+				ptsCountBeforeCut, restPos, cutFactor, parameters );
 			// End hair generation
 			mOutputGenerator.endHair( pointsCount );
 		}
@@ -176,9 +360,168 @@ void HairGenerator< tPositionGenerator, tOutputGenerator >::generate( const Hair
 	// Release memory of local buffers
 	delete [] points;
 	delete [] pointsStrand;
+	delete [] strandFrame;
 	delete [] tangents;
 	delete [] normals;
 	delete [] binormals;
+	delete [] interpolated;
+	delete [] noise;
+	delete [] parameters;
+}
+
+template< typename tPositionGenerator, typename tOutputGenerator >
+void HairGenerator< tPositionGenerator, tOutputGenerator >::generateParallel( const HairProperties & aHairProperties )
+{
+	resetRandom( aHairProperties );
+	generateParallel( aHairProperties, mRandom );
+}
+
+template< typename tPositionGenerator, typename tOutputGenerator >
+void HairGenerator< tPositionGenerator, tOutputGenerator >::generateParallel( const HairProperties & aHairProperties,
+	const RandomGenerator & aRandom )
+{
+#ifndef _OPENMP
+	generate( aHairProperties, aRandom ); // No threads, generate sequentially
+#else
+	mBoundingBox.clear();
+	// Store pointer to hair properties, so we don't need to send it to every function
+	mHairProperties = & aHairProperties;
+	// Get max points count = segments + 1 ( + 2 for duplicate of first and last point )
+	const unsigned __int32 maxPointsCount = aHairProperties.getInterpolationGroups().getMaxSegmentsCount() + 3;
+	// Random numbers used by every not cut hair : scale, color ( 3 ) and 3 for every hair in strand,
+	// but degenerated hair only uses the scale random number
+	const unsigned __int32 randomsPerHair = 4 + 3 * aHairProperties.getMultiStrandCount();
+	const unsigned __int32 randomsPerDegeneratedHair = 1;
+	// Indices
+	const unsigned __int64 hairInStrand = 
+		std::max( aHairProperties.getMultiStrandCount(), static_cast< unsigned __int32 >( 1 ) );
+	unsigned __int64 hairIndex = multiplyCounts( mPositionGenerator.getHairStartIndex(), hairInStrand );
+	const unsigned __int64 hairStartIndex = mPositionGenerator.getHairStartIndex();
+	const unsigned __int64 hairCount = mPositionGenerator.getHairCount();
+	// Hair taken from motion samples cache do not use any random number
+	const bool isReplaying = mMotionSamplesCache != 0 && !mIsRecordingMotionSamples;
+	// Prepare blocks and buffer for positions of all blocks
+	const int threadsCount = mThreadsCount > 0 ? mThreadsCount : omp_get_max_threads();
+	const int blocksCount = threadsCount * static_cast< int >( PARALLEL_BLOCKS_PER_THREAD );
+	const unsigned __int32 roundSize = static_cast< unsigned __int32 >( blocksCount ) * PARALLEL_BLOCK_SIZE;
+	ParallelBlock * blocks = new ParallelBlock[ blocksCount ];
+	BufferedPositionGenerator::GeneratedPosition * positions = 
+		new BufferedPositionGenerator::GeneratedPosition[ roundSize ];
+	std::string error;
+	// Sets random generator state
+	mRandom = aRandom;
+	// Start output
+	mOutputGenerator.beginOutput( multiplyCounts( hairCount, hairInStrand ), maxPointsCount );
+	// Every round generates one block of hair by each parallel block
+	for ( unsigned __int64 roundStart = 0; roundStart < hairCount && error.empty(); roundStart += roundSize )
+	{
+		// Generate positions sequentially ( position generator may not be thread safe ) and predict random 
+		// generator state at the start of each block : we expect that there are no degenerated hair
+		RandomGenerator random = mRandom;
+		BufferedPositionGenerator::GeneratedPosition * positionIt = positions;
+		int usedBlocksCount = 0;
+		for ( unsigned __int64 blockStart = roundStart; usedBlocksCount < blocksCount && blockStart < hairCount; 
+			++usedBlocksCount, blockStart += PARALLEL_BLOCK_SIZE )
+		{
+			ParallelBlock & block = blocks[ usedBlocksCount ];
+			const unsigned __int32 blockSize = static_cast< unsigned __int32 >( std::min( 
+				static_cast< unsigned __int64 >( PARALLEL_BLOCK_SIZE ), hairCount - blockStart ) );
+			block.mPositionGenerator.set( positionIt, blockSize, hairStartIndex + blockStart );
+			block.mHairGenerator.setDetailSize( mDetailSize );
+			block.mHairGenerator.setPixelSize( mPixelSize );
+			// Block generator must calculate normals only if final output generator needs them
+			block.mOutputGenerator.setNormalsUsed( mOutputGenerator.areNormalsUsed() );
+			// Cache is indexed by hair index, so every block uses its own part of cache
+			block.mHairGenerator.setMotionSamplesCache( mMotionSamplesCache, mIsRecordingMotionSamples );
+			block.mRandom = random;
+			block.mNotCutHairCount = 0;
+			block.mDirty = true;
+			for ( unsigned __int32 i = 0; i < blockSize; ++i, ++positionIt )
+			{
+				generatePosition( positionIt->mCurrentPosition, positionIt->mRestPosition );
+				positionIt->mBakedRoot = mPositionGenerator.getBakedRoot();
+				// Hair cut at root does not use any random number
+				if ( !isReplaying && aHairProperties.getCutTexture().realAtUV( positionIt->mRestPosition.getUCoordinate(), 
+					positionIt->mRestPosition.getVCoordinate() ) != 0 )
+				{
+					++block.mNotCutHairCount;
+				}
+			}
+			random.skip( block.mNotCutHairCount * randomsPerHair );
+		}
+		// Counter based random generator selects stream of every hair, so blocks are independent
+		const bool isRandomPredicted = !mRandom.isCounterBased() && !isReplaying;
+		// Generate blocks in parallel, until all blocks have been generated with correct random generator state
+		for ( bool dirty = true; dirty && error.empty(); )
+		{
+			#pragma omp parallel for schedule( dynamic ) num_threads( threadsCount )
+			for ( int i = 0; i < usedBlocksCount; ++i )
+			{
+				ParallelBlock & block = blocks[ i ];
+				if ( !block.mDirty )
+				{
+					continue;
+				}
+				// Exceptions must not leave parallel region, the first error is rethrown after the round
+				try
+				{
+					block.mPositionGenerator.reset();
+					block.mHairGenerator.generate( aHairProperties, block.mRandom );
+				}
+				catch( std::exception & ex )
+				{
+					#pragma omp critical
+					if ( error.empty() )
+					{
+						error = ex.what();
+					}
+				}
+				catch( ... )
+				{
+					#pragma omp critical
+					if ( error.empty() )
+					{
+						error = " HairGenerator::generateParallel : unknown error during hair generation ! ";
+					}
+				}
+				block.mDirty = false;
+			}
+			// Calculate real random generator states from number of generated ( not degenerated ) hair
+			dirty = false;
+			random = mRandom;
+			for ( int i = 0; i < usedBlocksCount && isRandomPredicted; ++i )
+			{
+				ParallelBlock & block = blocks[ i ];
+				if ( !( block.mRandom == random ) ) // Misprediction, block must be generated again
+				{
+					block.mRandom = random;
+					block.mDirty = dirty = true;
+				}
+				// Hair dropped by level of detail have used the same random numbers as generated hair, counts
+				// of single block never exceed PARALLEL_BLOCK_SIZE
+				const unsigned __int64 generatedHairCount = 
+					block.mOutputGenerator.getHairCount() / hairInStrand + block.mHairGenerator.getDroppedHairCount();
+				random.skip( block.mNotCutHairCount * randomsPerDegeneratedHair + 
+					static_cast< unsigned __int32 >( generatedHairCount ) * ( randomsPerHair - randomsPerDegeneratedHair ) );
+			}
+		}
+		mRandom = random;
+		// Send generated hair to output generator in hair order
+		for ( int i = 0; i < usedBlocksCount && error.empty(); ++i )
+		{
+			blocks[ i ].mOutputGenerator.flush( mOutputGenerator, hairIndex );
+			mBoundingBox.expand( blocks[ i ].mHairGenerator.getBoundingBox() );
+		}
+	}
+	// Release memory of blocks
+	delete [] blocks;
+	delete [] positions;
+	if ( !error.empty() )
+	{
+		throw StubbleException( error.c_str() );
+	}
+	mOutputGenerator.endOutput();
+#endif
 }
 
 template< typename tPositionGenerator, typename tOutputGenerator >
@@ -194,34 +537,31 @@ void HairGenerator< tPositionGenerator, tOutputGenerator >::
 	Point * points = new Point[ maxPointsCount ];
 	// The first point always equals the second one, so it will not be included in many calculations
 	Point * pointsPlusOne = points + 1; 
-	Point * pointsStrand = new Point[ maxPointsCount ];
+	// Points of batch of hair in strand, every hair has maxPointsCount points
+	Point * pointsStrand = new Point[ STRAND_BATCH_SIZE * maxPointsCount ];
 	Point * pointsStrandPlusOne = pointsStrand + 1; 
+	Point * strandFrame = new Point[ 3 * maxPointsCount ];
 	Vector * tangents = new Vector[ maxPointsCount ];
 	Vector * tangentsPlusOne = tangents + 1; 
 	Vector * normals = new Vector[ maxPointsCount ];
 	Vector * binormals = new Vector[ maxPointsCount ];
+	Real * interpolated = new Real[ 3 * maxPointsCount ];
+	float * noise = new float[ 6 * maxPointsCount ];
 	// Prepare matrix
 	Matrix localToCurr;
 	// Resets random generator
-	mRandom.reset();
+	resetRandom( aHairProperties );
 	// Calculate hair count
-	unsigned __int32 hairCount = static_cast< unsigned __int32 >( aHairGenerateRatio * mPositionGenerator.getHairCount() );
+	unsigned __int64 hairCount = static_cast< unsigned __int64 >( aHairGenerateRatio * mPositionGenerator.getHairCount() );
 	// For every main hair
-	for ( unsigned __int32 i = 0; i < hairCount; ++i )
+	for ( unsigned __int64 i = 0; i < hairCount; ++i )
 	{
+		// Every main hair uses its own random stream ( only if random generator is counter based )
+		mRandom.setStream( mPositionGenerator.getHairStartIndex() + i );
 		// Generate position
 		MeshPoint currPos;
 		MeshPoint restPos;
-		Real displaceFactor = mHairProperties->getDisplacement();
-		if ( displaceFactor == 0 )
-		{
-			mPositionGenerator.generate( currPos, restPos );
-		}
-		else
-		{
-			mPositionGenerator.generate( currPos, restPos, mHairProperties->getDisplacementTexture(), 
-				mHairProperties->getDisplacement() );
-		}
+		generatePosition( currPos, restPos );
 		// Determine cut factor
 		PositionType cutFactor = static_cast< PositionType >( 
 			aHairProperties.getCutTexture().realAtUV( restPos.getUCoordinate(), restPos.getVCoordinate() ) );
@@ -229,9 +569,11 @@ void HairGenerator< tPositionGenerator, tOutputGenerator >::
 		{
 			continue; // The hair has been cut at root
 		}
-		// Get interpolation group
-		unsigned __int32 groupId = aHairProperties.getInterpolationGroups().
-			getGroupId( restPos.getUCoordinate(), restPos.getVCoordinate() );
+		// Get interpolation group and guides to interpolate from
+		const BakedHairRoot & hairRoot = selectHairRoot( restPos );
+		// Sample all attributes textures at once
+		selectAttributes( restPos );
+		const unsigned __int32 groupId = hairRoot.mInterpolationGroupId;
 		// Get points count = segments count + 1
 		unsigned __int32 ptsCountBeforeCut = aHairProperties.getInterpolationGroups().
 			getGroupSegmentsCount( groupId ) + 1;
@@ -241,12 +583,15 @@ void HairGenerator< tPositionGenerator, tOutputGenerator >::
 		// Limit pts count
 		ptsCountAfterCut = ptsCountBeforeCut < ptsCountAfterCut ? ptsCountBeforeCut : ptsCountAfterCut;
 		// Interpolate points of hair from closest guides
-		interpolateFromGuides( pointsPlusOne, ptsCountAfterCut, restPos, groupId );
+		interpolateFromGuides( pointsPlusOne, ptsCountAfterCut, ptsCountBeforeCut, ptsCountBeforeCut, hairRoot,
+			interpolated );
 		// Apply scale to points 
-		applyScale( pointsPlusOne, ptsCountAfterCut, restPos );
+		selectScale();
+		applyScale( pointsPlusOne, ptsCountAfterCut );
 		// Apply frizz and kink to points 
+		selectFrizzProperties( restPos );
 		applyFrizz( pointsPlusOne, ptsCountAfterCut, ptsCountBeforeCut, restPos );
-		applyKink( pointsPlusOne, ptsCountAfterCut, ptsCountBeforeCut, restPos );
+		applyKink( pointsPlusOne, ptsCountAfterCut, ptsCountBeforeCut, restPos, noise );
 		// Check degenerate
 		if ( checkDegenerateHair( pointsPlusOne, ptsCountAfterCut, ptsCountBeforeCut ) )
 		{
@@ -269,31 +614,51 @@ void HairGenerator< tPositionGenerator, tOutputGenerator >::
 			// Create full rotation minimizing frame for main hair
 			calculateNormalsAndBinormals( normals, binormals, pointsPlusOne, tangentsPlusOne, ptsCountAfterCut );
 			// Get multi-strands properties
-			selectMultiStrandProperties( restPos, ptsCountBeforeCut );
-			// Generate all hair in strand
-			for ( unsigned __int32 j = 0; j < aHairProperties.getMultiStrandCount(); ++j )
+			selectMultiStrandProperties();
+			selectTwist( ptsCountBeforeCut );
+			// Calculate frame shared by all hair in strand
+			calculateStrandFrame( strandFrame, ptsCountAfterCut, ptsCountBeforeCut, pointsPlusOne, normals,
+				binormals, localToCurr );
+			// Generate all hair in strand in batches
+			const unsigned __int32 strandHairCount = aHairProperties.getMultiStrandCount();
+			for ( unsigned __int32 batchStart = 0; batchStart < strandHairCount; batchStart += STRAND_BATCH_SIZE )
 			{
-				// Randomized cut factor
-				PositionType randomizedCutFactor = cutFactor * static_cast< PositionType >( 1 - mRandomizeScale * mRandom.uniformNumber() );
-				// Recalculate points count
-				unsigned __int32 ptsCountAfterRandomizedCut = static_cast< unsigned __int32 >( std::ceil( randomizedCutFactor * ptsCountBeforeCut ) ) + 2;
-				ptsCountAfterRandomizedCut = ptsCountBeforeCut < ptsCountAfterRandomizedCut ? ptsCountBeforeCut : ptsCountAfterRandomizedCut;
-				// First generate points
-				generateHairInStrand( pointsStrandPlusOne, ptsCountAfterRandomizedCut, ptsCountBeforeCut, pointsPlusOne,
-					normals, binormals );
-				// Convert positions to current world space
-				transformPoints( pointsStrandPlusOne, ptsCountAfterRandomizedCut, localToCurr );
-				// Duplicate first and last point ( last points need to be duplicated, 
-				// only if cut has not decreased points count, so we will use total points count )
-				// These duplicated points are used for curve points calculation at any given param t
-				copyToLastAndFirst( pointsStrand, ptsCountBeforeCut + 2 );
-				// Calculate tangents
-				calculateTangents( tangentsPlusOne, pointsStrandPlusOne, ptsCountAfterRandomizedCut );
-				// Duplicate tangents ( same reason as with points duplication )
-				copyToLastAndFirst( tangents, ptsCountBeforeCut + 2 );
-				// Finally updates bounding box
-				updateBoundingBox( pointsStrandPlusOne, tangentsPlusOne, ptsCountAfterRandomizedCut, 
-					ptsCountBeforeCut, aBoundingBox, randomizedCutFactor );
+				const unsigned __int32 batchCount = std::min( static_cast< unsigned __int32 >( STRAND_BATCH_SIZE ), 
+					strandHairCount - batchStart );
+				PositionType randomizedCutFactors[ STRAND_BATCH_SIZE ], cosPhis[ STRAND_BATCH_SIZE ], 
+					sinPhis[ STRAND_BATCH_SIZE ];
+				unsigned __int32 ptsCountsAfterRandomizedCut[ STRAND_BATCH_SIZE ];
+				// Select cut and position of every hair in batch
+				for ( unsigned __int32 k = 0; k < batchCount; ++k )
+				{
+					// Randomized cut factor
+					randomizedCutFactors[ k ] = cutFactor * 
+						static_cast< PositionType >( 1 - mRandomizeScale * mRandom.uniformNumber() );
+					// Random position on disk around main hair
+					selectPositionInStrand( cosPhis[ k ], sinPhis[ k ] );
+					// Recalculate points count
+					unsigned __int32 ptsCountAfterRandomizedCut = static_cast< unsigned __int32 >( std::ceil( randomizedCutFactors[ k ] * ptsCountBeforeCut ) ) + 2;
+					ptsCountsAfterRandomizedCut[ k ] = ptsCountBeforeCut < ptsCountAfterRandomizedCut ? ptsCountBeforeCut : ptsCountAfterRandomizedCut;
+				}
+				// Generate current world space points of all hair in batch at once
+				generateHairInStrand( pointsStrandPlusOne, maxPointsCount, batchCount, ptsCountsAfterRandomizedCut,
+					cosPhis, sinPhis, strandFrame, ptsCountAfterCut );
+				// Update bounding box by every hair in batch
+				for ( unsigned __int32 k = 0; k < batchCount; ++k )
+				{
+					Point * strandPoints = pointsStrand + k * maxPointsCount;
+					// Duplicate first and last point ( last points need to be duplicated, 
+					// only if cut has not decreased points count, so we will use total points count )
+					// These duplicated points are used for curve points calculation at any given param t
+					copyToLastAndFirst( strandPoints, ptsCountBeforeCut + 2 );
+					// Calculate tangents
+					calculateTangents( tangentsPlusOne, strandPoints + 1, ptsCountsAfterRandomizedCut[ k ] );
+					// Duplicate tangents ( same reason as with points duplication )
+					copyToLastAndFirst( tangents, ptsCountBeforeCut + 2 );
+					// Finally updates bounding box
+					updateBoundingBox( strandPoints + 1, tangentsPlusOne, ptsCountsAfterRandomizedCut[ k ], 
+						ptsCountBeforeCut, aBoundingBox, randomizedCutFactors[ k ] );
+				}
 			}
 		}
 		else // Single hair only
@@ -315,103 +680,191 @@ void HairGenerator< tPositionGenerator, tOutputGenerator >::
 	}
 	// Enlarge bounding box by hair thickness
 	Real maxThick = std::max( mHairProperties->getRootThickness(), mHairProperties->getTipThickness() ) * 0.5;
+	if ( mHairProperties->isLevelOfDetailUsed() )
+	{
+		maxThick /= mHairProperties->getLodMinimumHairRatio(); // Level of detail may widen hair
+	}
 	Vector3D< Real > thickVector( maxThick, maxThick, maxThick );
 	aBoundingBox.expand( aBoundingBox.max() + thickVector );
 	aBoundingBox.expand( aBoundingBox.min() - thickVector );
 	// Release memory of local buffers
 	delete [] points;
 	delete [] pointsStrand;
+	delete [] strandFrame;
 	delete [] tangents;
 	delete [] normals;
 	delete [] binormals;
+	delete [] interpolated;
+	delete [] noise;
 }
 
 template< typename tPositionGenerator, typename tOutputGenerator >
 inline void HairGenerator< tPositionGenerator, tOutputGenerator >::
-	interpolateFromGuides( Point * aPoints, unsigned __int32 aCount, const MeshPoint &aRestPosition, 
-	unsigned __int32 aInterpolationGroupId )
+	generatePosition( MeshPoint & aCurrentPosition, MeshPoint & aRestPosition )
 {
-	// First selected closest guides
-	HairComponents::ClosestGuides guidesIds;
-	mHairProperties->getGuidesRestPositionsDS().getNClosestGuides( aRestPosition.getPosition(), aInterpolationGroupId,
-		mHairProperties->getNumberOfGuidesToInterpolateFrom() + 1, guidesIds );
-	if ( guidesIds.size() == 0 ) // Nothing to interpolate from
+	Real displaceFactor = mHairProperties->getDisplacement();
+	if ( displaceFactor == 0 )
 	{
-		// Null points of hair
-		for ( Point * end = aPoints + aCount, *it = aPoints; it != end; ++it )
-		{
-			*it = Point( 0, 0, 0 );
-		}
-		return;
+		mPositionGenerator.generate( aCurrentPosition, aRestPosition );
 	}
-	// Get distance from farthest guide
-	float maxDistance = sqrtf( guidesIds.begin()->mDistance ); // Returns max as first ( 'cos it uses max-heap )
-	// Select closest guide
-	HairComponents::ClosestGuides::const_iterator closest = guidesIds.begin();
-	for ( HairComponents::ClosestGuides::const_iterator guideIdIt = guidesIds.begin(); 
-		guideIdIt != guidesIds.end(); ++guideIdIt )
+	else
 	{
-		if ( closest->mDistance > guideIdIt->mDistance )
-		{
-			closest = guideIdIt;
-		}
+		mPositionGenerator.generate( aCurrentPosition, aRestPosition, mHairProperties->getDisplacementTexture(), 
+			mHairProperties->getDisplacement() );
 	}
-	// Too close to some guide
-	if ( closest->mDistance < static_cast< float >( EPSILON ) || guidesIds.size() == 1 )
+}
+
+template< typename tPositionGenerator, typename tOutputGenerator >
+inline unsigned __int32 HairGenerator< tPositionGenerator, tOutputGenerator >::
+	selectFeatures( const HairProperties & aHairProperties ) const
+{
+	unsigned __int32 features = 0;
+	// Zero displace factor at every hair point leaves hair points unchanged
+	if ( ( aHairProperties.getRootFrizz() != 0 && aHairProperties.getRootFrizzTexture().getMaxAbsoluteValue() != 0 ) ||
+		( aHairProperties.getTipFrizz() != 0 && aHairProperties.getTipFrizzTexture().getMaxAbsoluteValue() != 0 ) )
 	{
-		// Guide segment points iterator
-		HairComponents::Segments::const_iterator segIt = mHairProperties->getGuidesSegments()
-			[ closest->mGuideId ].mSegments.begin();
-		// For every hair point - just copy from guide
-		for ( Point * end = aPoints + aCount, *it = aPoints; it != end; ++it, ++segIt )
-		{
-			*it = Vector3D< PositionType >( static_cast< PositionType >( segIt->x ), 
-											 static_cast< PositionType >( segIt->y ),
-											 static_cast< PositionType >( segIt->z ) );
-		}
+		features |= FEATURE_FRIZZ;
 	}
-	else
+	if ( ( aHairProperties.getRootKink() != 0 && aHairProperties.getRootKinkTexture().getMaxAbsoluteValue() != 0 ) ||
+		( aHairProperties.getTipKink() != 0 && aHairProperties.getTipKinkTexture().getMaxAbsoluteValue() != 0 ) )
+	{
+		features |= FEATURE_KINK;
+	}
+	if ( aHairProperties.getMultiStrandCount() != 0 )
+	{
+		features |= FEATURE_MULTI_STRAND;
+	}
+	if ( mOutputGenerator.areNormalsUsed() )
+	{
+		features |= FEATURE_NORMALS;
+	}
+	return features;
+}
+
+template< typename tPositionGenerator, typename tOutputGenerator >
+inline void HairGenerator< tPositionGenerator, tOutputGenerator >::
+	resetRandom( const HairProperties & aHairProperties )
+{
+	mRandom = RandomGenerator(); // James random generator with default seed
+	if ( aHairProperties.isRandomCounterBased() )
+	{
+		mRandom.resetCounterBased( aHairProperties.getRandomSeed(), RandomGenerator::HAIR_PROPERTIES_DOMAIN );
+	}
+}
+
+template< typename tPositionGenerator, typename tOutputGenerator >
+inline void HairGenerator< tPositionGenerator, tOutputGenerator >::
+	selectLevelOfDetail()
+{
+	mLodHairRatio = 1;
+	mLodSegmentsRatio = 1;
+	mLodWidthScale = 1;
+	if ( !mHairProperties->isLevelOfDetailUsed() || mDetailSize >= mHairProperties->getLodFullDetailSize() )
+	{
+		return; // Full detail
+	}
+	const Real detailRatio = std::max( mDetailSize, static_cast< Real >( 0 ) ) / 
+		mHairProperties->getLodFullDetailSize();
+	// Hair count is proportional to area on screen, so hair density per pixel stays the same
+	mLodHairRatio = std::max( detailRatio, mHairProperties->getLodMinimumHairRatio() );
+	// Points count is proportional to size on screen
+	mLodSegmentsRatio = std::max( std::sqrt( detailRatio ), mHairProperties->getLodMinimumSegmentsRatio() );
+	// Remaining hair are widened, so they cover the same area as all hair
+	mLodWidthScale = static_cast< WidthType >( 1 / mLodHairRatio );
+	mLodRandom.resetCounterBased( mHairProperties->getRandomSeed(), RandomGenerator::HAIR_LOD_DOMAIN );
+}
+
+template< typename tPositionGenerator, typename tOutputGenerator >
+inline bool HairGenerator< tPositionGenerator, tOutputGenerator >::
+	isDroppedByLevelOfDetail( unsigned __int64 aHairIndex )
+{
+	if ( mLodHairRatio >= 1 )
+	{
+		return false;
+	}
+	// Every hair has fixed random number, hair is kept if its number is lower than ratio of generated hair
+	mLodRandom.setStream( aHairIndex );
+	return mLodRandom.uniformNumber() >= mLodHairRatio;
+}
+
+template< typename tPositionGenerator, typename tOutputGenerator >
+inline unsigned __int32 HairGenerator< tPositionGenerator, tOutputGenerator >::
+	selectCurvePointsCount( unsigned __int32 aGuidePointsCount ) const
+{
+	if ( mLodSegmentsRatio >= 1 )
+	{
+		return aGuidePointsCount;
+	}
+	unsigned __int32 count = static_cast< unsigned __int32 >( 
+		std::ceil( mLodSegmentsRatio * ( aGuidePointsCount - 1 ) ) ) + 1;
+	// Keep at least two segments, so hair can still bend
+	count = std::max( count, static_cast< unsigned __int32 >( 3 ) );
+	return std::min( count, aGuidePointsCount );
+}
+
+template< typename tPositionGenerator, typename tOutputGenerator >
+inline const BakedHairRoot & HairGenerator< tPositionGenerator, tOutputGenerator >::
+	selectHairRoot( const MeshPoint & aRestPosition )
+{
+	const BakedHairRoot * bakedRoot = mPositionGenerator.getBakedRoot();
+	if ( bakedRoot != 0 ) // Roots have been baked during export
+	{
+		return *bakedRoot;
+	}
+	mHairRoot.selectGuides( *mHairProperties, aRestPosition, mClosestGuidesQuery );
+	return mHairRoot;
+}
+
+template< typename tPositionGenerator, typename tOutputGenerator >
+inline void HairGenerator< tPositionGenerator, tOutputGenerator >::
+	interpolateFromGuides( Point * aPoints, unsigned __int32 aCount, unsigned __int32 aCurvePointsCount,
+	unsigned __int32 aGuidePointsCount, const BakedHairRoot & aHairRoot, Real * aBuffer )
+{
+	if ( aCurvePointsCount != aGuidePointsCount ) // Level of detail has decreased points count
 	{
-		// In next calculations, we will always ignore the farthest guide
-		// Bias distance with respect to farthest guide
-		for ( HairComponents::ClosestGuides::iterator guideIdIt = guidesIds.begin() + 1; 
-			guideIdIt != guidesIds.end(); ++guideIdIt )
-		{
-			float & distance = guideIdIt->mDistance;
-			distance = sqrtf( distance );
-			distance = ( maxDistance - distance ) / ( maxDistance * distance );
-			distance *= distance;
-		}
-		// Finaly calculate cumulated distance
-		float cumulatedDistance = 0;
-		for ( HairComponents::ClosestGuides::const_iterator guideIdIt = guidesIds.begin() + 1; 
-			guideIdIt != guidesIds.end(); ++guideIdIt )
-		{
-			cumulatedDistance += guideIdIt->mDistance;
-		}
-		float inverseCumulatedDistance = 1.0f / cumulatedDistance;
 		// Null points of hair
 		for ( Point * end = aPoints + aCount, *it = aPoints; it != end; ++it )
 		{
 			*it = Point( 0, 0, 0 );
 		}
-		// For every old guide segments to interpolate from
-		for ( HairComponents::ClosestGuides::const_iterator guideIdIt = guidesIds.begin() + 1; 
-			guideIdIt != guidesIds.end(); ++guideIdIt )
-		{
-			// Guide segment points iterator
-			HairComponents::Segments::const_iterator segIt = mHairProperties->getGuidesSegments()
-				[ guideIdIt->mGuideId ].mSegments.begin();
-			// Calculate weight
-			const Real weight = static_cast< Real >( guideIdIt->mDistance * inverseCumulatedDistance ); 
-			// For every hair point
-			for ( Point * end = aPoints + aCount, *it = aPoints; it != end; ++it, ++segIt )
+		// Every hair point is interpolated from the nearest guide point ( first and last points are kept )
+		const unsigned __int32 curveSegments = aCurvePointsCount - 1;
+		const unsigned __int32 guideSegments = aGuidePointsCount - 1;
+		for ( const BakedHairRoot::GuideWeight * guideIt = aHairRoot.mGuidesWeights, 
+			* guideEnd = aHairRoot.mGuidesWeights + aHairRoot.mGuidesCount; guideIt != guideEnd; ++guideIt )
+		{
+			const HairComponents::Segments & segments = mHairProperties->getGuidesSegments()
+				[ guideIt->mGuideId ].mSegments;
+			const Real weight = static_cast< Real >( guideIt->mWeight ); 
+			unsigned __int32 i = 0;
+			for ( Point * end = aPoints + aCount, *it = aPoints; it != end; ++it, ++i )
 			{
-				*it += Vector3D< PositionType >( static_cast< PositionType >( segIt->x * weight ), 
-												 static_cast< PositionType >( segIt->y * weight ),
-												 static_cast< PositionType >( segIt->z * weight ) );
+				const Vector3D< Real > & segment = 
+					segments[ ( 2 * i * guideSegments + curveSegments ) / ( 2 * curveSegments ) ];
+				*it += Vector3D< PositionType >( static_cast< PositionType >( segment.x * weight ), 
+												 static_cast< PositionType >( segment.y * weight ),
+												 static_cast< PositionType >( segment.z * weight ) );
 			}
 		}
+		return;
+	}
+	// Select guides coordinates and weights
+	const Real * guides[ BakedHairRoot::MAX_GUIDES_COUNT ];
+	Real weights[ BakedHairRoot::MAX_GUIDES_COUNT ];
+	for ( unsigned __int32 i = 0; i < aHairRoot.mGuidesCount; ++i )
+	{
+		guides[ i ] = reinterpret_cast< const Real * >( &mHairProperties->getGuidesSegments()
+			[ aHairRoot.mGuidesWeights[ i ].mGuideId ].mSegments.front() );
+		weights[ i ] = static_cast< Real >( aHairRoot.mGuidesWeights[ i ].mWeight );
+	}
+	// Blend all guides at once ( nothing to interpolate from if there are no guides )
+	GuidesInterpolation::interpolate( aBuffer, guides, weights, aHairRoot.mGuidesCount, 3 * aCount );
+	// Convert to hair points precision
+	const Real * coordIt = aBuffer;
+	for ( Point * end = aPoints + aCount, *it = aPoints; it != end; ++it, coordIt += 3 )
+	{
+		*it = Point( static_cast< PositionType >( coordIt[ 0 ] ), static_cast< PositionType >( coordIt[ 1 ] ),
+			static_cast< PositionType >( coordIt[ 2 ] ) );
 	}
 }
 
@@ -438,75 +891,92 @@ inline bool HairGenerator< tPositionGenerator, tOutputGenerator >::
 
 template< typename tPositionGenerator, typename tOutputGenerator >
 inline void HairGenerator< tPositionGenerator, tOutputGenerator >::
-	applyScale( Point * aPoints, unsigned __int32 aCount, const MeshPoint &aRestPosition )
+	selectAttributes( const MeshPoint &aRestPosition )
+{
+	mHairProperties->getAttributeAtlas().sample( aRestPosition.getUCoordinate(), aRestPosition.getVCoordinate(),
+		mAttributes );
+}
+
+template< typename tPositionGenerator, typename tOutputGenerator >
+inline void HairGenerator< tPositionGenerator, tOutputGenerator >::
+	selectScale()
 {
 	// Get the scale factor = scale * scaleTexture * ( 1 - randScale * randScaleTexture * random )
-	PositionType scale = static_cast< PositionType >( 
-		mHairProperties->getScale() * mHairProperties->getScaleTexture().
-		realAtUV( aRestPosition.getUCoordinate(), aRestPosition.getVCoordinate() ) *
-		( 1 - mHairProperties->getRandScale() * mHairProperties->getRandScaleTexture().
-		realAtUV( aRestPosition.getUCoordinate(), aRestPosition.getVCoordinate() ) * mRandom.uniformNumber() ) );
+	mScale = static_cast< PositionType >( 
+		mHairProperties->getScale() * mAttributes[ AttributeAtlas::SCALE ] *
+		( 1 - mHairProperties->getRandScale() * mAttributes[ AttributeAtlas::RAND_SCALE ] * 
+		mRandom.uniformNumber() ) );
+}
+
+template< typename tPositionGenerator, typename tOutputGenerator >
+inline void HairGenerator< tPositionGenerator, tOutputGenerator >::
+	applyScale( Point * aPoints, unsigned __int32 aCount )
+{
 	// Scale every point
 	for ( Point * end = aPoints + aCount, *it = aPoints; it != end; ++it )
 	{
-		*it *= scale;
+		*it *= mScale;
 	}
 }
 
 template< typename tPositionGenerator, typename tOutputGenerator >
 inline void HairGenerator< tPositionGenerator, tOutputGenerator >::
-	applyFrizz( Point * aPoints, unsigned __int32 aCount, unsigned __int32 aCurvePointsCount, 
-	const MeshPoint &aRestPosition )
+	selectFrizzProperties( const MeshPoint &aRestPosition )
 {
 	// Gather Frizz properties for this hair
-	Real u = aRestPosition.getUCoordinate();
-	Real v = aRestPosition.getVCoordinate();
-	Real freqX = mHairProperties->getFrizzXFrequency() * mHairProperties->getFrizzXFrequencyTexture().
-		realAtUV( u, v );
-	Real freqY = mHairProperties->getFrizzYFrequency() * mHairProperties->getFrizzYFrequencyTexture().
-		realAtUV( u, v );
-	Real freqZ = mHairProperties->getFrizzZFrequency() * mHairProperties->getFrizzZFrequencyTexture().
-		realAtUV( u, v );
-	Real rootDisplaceFactor = mHairProperties->getRootFrizz() * mHairProperties->getRootFrizzTexture().
-		realAtUV( u, v );
-	Real tipDisplaceFactor = mHairProperties->getTipFrizz() * mHairProperties->getTipFrizzTexture().
-		realAtUV( u, v );
-	Real frizzAnimFactor = mHairProperties->getFrizzAnim() * mHairProperties->getFrizzAnimTexture().
-		realAtUV( u, v );
-	Real frizzStaticFactor = 1 - frizzAnimFactor;
-	Real frizzTimeFactor = mHairProperties->getFrizzAnimSpeed() * mHairProperties->getFrizzAnimSpeedTexture().
-		realAtUV( u, v ) * mHairProperties->getCurrentTime(); 
-	RtFloat in[ 3 ], staticNoise[ 3 ], animNoise[ 3 ], displace[ 3 ];
+	mFrizzFrequency[ 0 ] = mHairProperties->getFrizzXFrequency() * mAttributes[ AttributeAtlas::FRIZZ_X_FREQUENCY ];
+	mFrizzFrequency[ 1 ] = mHairProperties->getFrizzYFrequency() * mAttributes[ AttributeAtlas::FRIZZ_Y_FREQUENCY ];
+	mFrizzFrequency[ 2 ] = mHairProperties->getFrizzZFrequency() * mAttributes[ AttributeAtlas::FRIZZ_Z_FREQUENCY ];
+	mRootFrizz = mHairProperties->getRootFrizz() * mAttributes[ AttributeAtlas::ROOT_FRIZZ ];
+	mTipFrizz = mHairProperties->getTipFrizz() * mAttributes[ AttributeAtlas::TIP_FRIZZ ];
+	mFrizzAnim = mHairProperties->getFrizzAnim() * mAttributes[ AttributeAtlas::FRIZZ_ANIM ];
+	mFrizzAnimSpeed = mHairProperties->getFrizzAnimSpeed() * mAttributes[ AttributeAtlas::FRIZZ_ANIM_SPEED ];
+	Real frizzStaticFactor = 1 - mFrizzAnim;
+	float in[ 3 ], staticNoise[ 3 ];
 	// Calculate static noise at root
 	Vector3D< Real > root = aRestPosition.getPosition();
-	in[ 0 ] = static_cast< RtFloat >( freqX * root.x );
-	in[ 1 ] = static_cast< RtFloat >( freqY * root.y );
-	in[ 2 ] = static_cast< RtFloat >( freqZ * root.z );
-	RxNoise( 3, in, 3, staticNoise );
-	// Calculate anim noise at root
-	in[ 0 ] = static_cast< RtFloat >( freqX * root.x + mHairProperties->getFrizzAnimDirection().x * frizzTimeFactor );
-	in[ 1 ] = static_cast< RtFloat >( freqY * root.y + mHairProperties->getFrizzAnimDirection().y * frizzTimeFactor );
-	in[ 2 ] = static_cast< RtFloat >( freqZ * root.z + mHairProperties->getFrizzAnimDirection().z * frizzTimeFactor );
-	RxNoise( 3, in, 3, animNoise );
+	in[ 0 ] = static_cast< float >( mFrizzFrequency[ 0 ] * root.x );
+	in[ 1 ] = static_cast< float >( mFrizzFrequency[ 1 ] * root.y );
+	in[ 2 ] = static_cast< float >( mFrizzFrequency[ 2 ] * root.z );
+	Noise::evaluate( in, staticNoise );
+	// Static part of displace vector, noise is transformed from <0,1> -> <-1,1> in applyFrizz
+	mStaticFrizz[ 0 ] = frizzStaticFactor * ( staticNoise[ 0 ] - 0.5f );
+	mStaticFrizz[ 1 ] = frizzStaticFactor * ( staticNoise[ 1 ] - 0.5f );
+	mStaticFrizz[ 2 ] = frizzStaticFactor * ( staticNoise[ 2 ] - 0.5f );
+}
+
+template< typename tPositionGenerator, typename tOutputGenerator >
+inline void HairGenerator< tPositionGenerator, tOutputGenerator >::
+	applyFrizz( Point * aPoints, unsigned __int32 aCount, unsigned __int32 aCurvePointsCount, 
+	const MeshPoint &aRestPosition )
+{
+	float in[ 3 ], animNoise[ 3 ] = { 0.5f, 0.5f, 0.5f }, displace[ 3 ];
+	if ( mFrizzAnim != 0 ) // Anim noise has no effect otherwise
+	{
+		// Calculate anim noise at root
+		Real frizzTimeFactor = mFrizzAnimSpeed * mHairProperties->getCurrentTime(); 
+		Vector3D< Real > root = aRestPosition.getPosition();
+		in[ 0 ] = static_cast< float >( mFrizzFrequency[ 0 ] * root.x + mHairProperties->getFrizzAnimDirection().x * frizzTimeFactor );
+		in[ 1 ] = static_cast< float >( mFrizzFrequency[ 1 ] * root.y + mHairProperties->getFrizzAnimDirection().y * frizzTimeFactor );
+		in[ 2 ] = static_cast< float >( mFrizzFrequency[ 2 ] * root.z + mHairProperties->getFrizzAnimDirection().z * frizzTimeFactor );
+		Noise::evaluate( in, animNoise );
+	}
 	// Combine anim and static noise to final displace vector, also transform noise from <0,1> -> <-1,1>
-	displace[ 0 ] = 2 * static_cast< RtFloat >( frizzStaticFactor * ( staticNoise[ 0 ] - 0.5f ) + 
-		frizzAnimFactor * ( animNoise[ 0 ] - 0.5f ) );
-	displace[ 1 ] = 2 * static_cast< RtFloat >( frizzStaticFactor * ( staticNoise[ 1 ] - 0.5f ) + 
-		frizzAnimFactor * ( animNoise[ 1 ] - 0.5f ) );
-	displace[ 2 ] = 2 * static_cast< RtFloat >( frizzStaticFactor * ( staticNoise[ 2 ] - 0.5f ) + 
-		frizzAnimFactor * ( animNoise[ 2 ] - 0.5f ) );
-	displace[ 2 ] = static_cast< RtFloat >( -abs( displace[ 2 ] ) );
+	displace[ 0 ] = 2 * static_cast< float >( mStaticFrizz[ 0 ] + mFrizzAnim * ( animNoise[ 0 ] - 0.5f ) );
+	displace[ 1 ] = 2 * static_cast< float >( mStaticFrizz[ 1 ] + mFrizzAnim * ( animNoise[ 1 ] - 0.5f ) );
+	displace[ 2 ] = 2 * static_cast< float >( mStaticFrizz[ 2 ] + mFrizzAnim * ( animNoise[ 2 ] - 0.5f ) );
+	displace[ 2 ] = static_cast< float >( -abs( displace[ 2 ] ) );
 	// Calculate max displace factor
-	Real maxFactor = std::max( rootDisplaceFactor, tipDisplaceFactor );  
+	Real maxFactor = std::max( mRootFrizz, mTipFrizz );  
 	// Curve t param
-	RtFloat step = 1.0f / ( aCurvePointsCount - 1 ), t = step;
+	float step = 1.0f / ( aCurvePointsCount - 1 ), t = step;
 	// For every point on cut curve except the first one
 	for( Point * it = aPoints + 1, * end = aPoints + aCount; it != end; t += step, ++it )
 	{
 		// Calculate displace factor
-		RtFloat t2 = t * t; 
-		RtFloat tipT = t2, rootT = 4 * ( t - t2 );
-		Real displaceFactor = std::min( rootDisplaceFactor * rootT + tipDisplaceFactor * tipT, maxFactor );
+		float t2 = t * t; 
+		float tipT = t2, rootT = 4 * ( t - t2 );
+		Real displaceFactor = std::min( mRootFrizz * rootT + mTipFrizz * tipT, maxFactor );
 		// Apply displace
 		it->x += static_cast< PositionType >( displaceFactor * displace[ 0 ] );
 		it->y += static_cast< PositionType >( displaceFactor * displace[ 1 ] );
@@ -517,33 +987,31 @@ inline void HairGenerator< tPositionGenerator, tOutputGenerator >::
 template< typename tPositionGenerator, typename tOutputGenerator >
 inline void HairGenerator< tPositionGenerator, tOutputGenerator >::
 	applyKink( Point * aPoints, unsigned __int32 aCount, unsigned __int32 aCurvePointsCount, 
-	const MeshPoint &aRestPosition )
+	const MeshPoint &aRestPosition, float * aBuffer )
 {
 	// Gather kink properties for this hair
-	Real u = aRestPosition.getUCoordinate();
-	Real v = aRestPosition.getVCoordinate();
-	Real freqX = mHairProperties->getKinkXFrequency() * mHairProperties->getKinkXFrequencyTexture().
-		realAtUV( u, v );
-	Real freqY = mHairProperties->getKinkYFrequency() * mHairProperties->getKinkYFrequencyTexture().
-		realAtUV( u, v );
-	Real freqZ = mHairProperties->getKinkZFrequency() * mHairProperties->getKinkZFrequencyTexture().
-		realAtUV( u, v );
-	Real rootDisplaceFactor = mHairProperties->getRootKink() * mHairProperties->getRootKinkTexture().
-		realAtUV( u, v );
-	Real tipDisplaceFactor = mHairProperties->getTipKink() * mHairProperties->getTipKinkTexture().
-		realAtUV( u, v );
+	Real freqX = mHairProperties->getKinkXFrequency() * mAttributes[ AttributeAtlas::KINK_X_FREQUENCY ];
+	Real freqY = mHairProperties->getKinkYFrequency() * mAttributes[ AttributeAtlas::KINK_Y_FREQUENCY ];
+	Real freqZ = mHairProperties->getKinkZFrequency() * mAttributes[ AttributeAtlas::KINK_Z_FREQUENCY ];
+	Real rootDisplaceFactor = mHairProperties->getRootKink() * mAttributes[ AttributeAtlas::ROOT_KINK ];
+	Real tipDisplaceFactor = mHairProperties->getTipKink() * mAttributes[ AttributeAtlas::TIP_KINK ];
+	// Evaluate noise of every point on cut curve except the first one at once
+	float * in = aBuffer, * out = aBuffer + 3 * aCount;
+	float * inIt = in;
+	for( const Point * it = aPoints + 1, * end = aPoints + aCount; it != end; ++it, inIt += 3 )
+	{
+		Point rest = aRestPosition.toWorld( *it );
+		inIt[ 0 ] = static_cast< float >( freqX * rest.x );
+		inIt[ 1 ] = static_cast< float >( freqY * rest.y );
+		inIt[ 2 ] = static_cast< float >( freqZ * rest.z );
+	}
+	Noise::evaluate( in, aCount - 1, out );
 	// Curve t param
 	Real step = 1.0f / ( aCurvePointsCount - 1 ), t = step, oneMinusT = 1 - step;
 	// For every point on cut curve except the first one
-	for( Point * it = aPoints + 1, * end = aPoints + aCount; it != end; t += step, ++it, oneMinusT = 1 - t )
+	for( Point * it = aPoints + 1, * end = aPoints + aCount; it != end; t += step, ++it, oneMinusT = 1 - t, out += 3 )
 	{
-		Point rest = aRestPosition.toWorld( *it );
-		RtFloat in[ 3 ] = { static_cast< RtFloat >( freqX * rest.x ),
-			static_cast< RtFloat >( freqY * rest.y ), 
-			static_cast< RtFloat >( freqZ * rest.z ) }, 
-			out[ 3 ];
 		// Remember to shift noise from <0,1> to <-1,1> (factor *= 2; and out[ i ] -=0.5 solves that )
-		RxNoise( 3, in, 3, out );
 		Real factor = 2 * ( t * tipDisplaceFactor + oneMinusT * rootDisplaceFactor );
 		it->x += static_cast< PositionType >( ( out[ 0 ] - 0.5 ) * factor );
 		it->y += static_cast< PositionType >( ( out[ 1 ] - 0.5 ) * factor );
@@ -639,27 +1107,21 @@ inline void HairGenerator< tPositionGenerator, tOutputGenerator >::
 
 template< typename tPositionGenerator, typename tOutputGenerator >
 inline void HairGenerator< tPositionGenerator, tOutputGenerator >::
-	selectHairColorOpacityWidth( const MeshPoint & aRestPosition )
+	selectHairColorOpacityWidth()
 {
-	// Store uv coordinates
-	const Real u = aRestPosition.getUCoordinate();
-	const Real v = aRestPosition.getVCoordinate();
 	// Calculate hue shift
-	Real hueVar = mHairProperties->getHueVariation() * 
-		mHairProperties->getHueVariationTexture().realAtUV( u, v ) * 2;
+	Real hueVar = mHairProperties->getHueVariation() * mAttributes[ AttributeAtlas::HUE_VARIATION ] * 2;
 	ColorType hueShift = static_cast< ColorType >( ( mRandom.uniformNumber() - 0.5f ) * hueVar );
 	// Calculate value shift
-	Real valueVar = mHairProperties->getValueVariation() * 
-		mHairProperties->getValueVariationTexture().realAtUV( u, v ) * 2;
+	Real valueVar = mHairProperties->getValueVariation() * mAttributes[ AttributeAtlas::VALUE_VARIATION ] * 2;
 	ColorType valueShift = static_cast< ColorType >( ( mRandom.uniformNumber() - 0.5f ) * valueVar );
 	// Determine whether the hair is mutant
 	if ( mRandom.uniformNumber() < 
-		mHairProperties->getPercentMutantHair() * mHairProperties->getPercentMutantHairTexture().realAtUV( u, v ) / 100 )
+		mHairProperties->getPercentMutantHair() * mAttributes[ AttributeAtlas::PERCENT_MUTANT_HAIR ] / 100 )
 	{
 		// Select mutant hair color as root color
-		Texture::Color3 mutantHairColor;
-		mHairProperties->getMutantHairColorTexture().colorAtUV( u, v, mutantHairColor );
-		mixColor( mRootColor, mHairProperties->getMutantHairColor(), mutantHairColor );
+		mixColor( mRootColor, mHairProperties->getMutantHairColor(), 
+			mAttributes + AttributeAtlas::MUTANT_HAIR_COLOR );
 		// Applies hue-value shift
 		applyHueValueShift( mRootColor, valueShift, hueShift );
 		// Copy it to tip color
@@ -671,13 +1133,9 @@ inline void HairGenerator< tPositionGenerator, tOutputGenerator >::
 	else
 	{
 		// Select root color
-		Texture::Color3 rootColor;
-		mHairProperties->getRootColorTexture().colorAtUV( u, v, rootColor );
-		mixColor( mRootColor, mHairProperties->getRootColor(), rootColor );
+		mixColor( mRootColor, mHairProperties->getRootColor(), mAttributes + AttributeAtlas::ROOT_COLOR );
 		// Select tip color
-		Texture::Color3 tipColor;
-		mHairProperties->getTipColorTexture().colorAtUV( u, v, tipColor );
-		mixColor( mTipColor, mHairProperties->getTipColor(), tipColor );
+		mixColor( mTipColor, mHairProperties->getTipColor(), mAttributes + AttributeAtlas::TIP_COLOR );
 		// Applies hue-value shift
 		applyHueValueShift( mRootColor, valueShift, hueShift );
 		applyHueValueShift( mTipColor, valueShift, hueShift );
@@ -690,14 +1148,16 @@ inline void HairGenerator< tPositionGenerator, tOutputGenerator >::
 	}
 	// Handle opacity
 	mRootOpacity = static_cast< OpacityType >( 
-		mHairProperties->getRootOpacity() * mHairProperties->getRootOpacityTexture().realAtUV( u, v ) );
+		mHairProperties->getRootOpacity() * mAttributes[ AttributeAtlas::ROOT_OPACITY ] );
 	mTipOpacity = static_cast< OpacityType >( 
-		mHairProperties->getTipOpacity() * mHairProperties->getTipOpacityTexture().realAtUV( u, v ) );
+		mHairProperties->getTipOpacity() * mAttributes[ AttributeAtlas::TIP_OPACITY ] );
 	// Handle width
 	mRootWidth = static_cast< WidthType >( 
-		mHairProperties->getRootThickness() * mHairProperties->getRootThicknessTexture().realAtUV( u, v ) );
+		mHairProperties->getRootThickness() * mAttributes[ AttributeAtlas::ROOT_THICKNESS ] ) *
+		mLodWidthScale;
 	mTipWidth = static_cast< WidthType >( 
-		mHairProperties->getTipThickness() * mHairProperties->getTipThicknessTexture().realAtUV( u, v ) );
+		mHairProperties->getTipThickness() * mAttributes[ AttributeAtlas::TIP_THICKNESS ] ) *
+		mLodWidthScale;
 }
 
 template< typename tPositionGenerator, typename tOutputGenerator >
@@ -720,92 +1180,283 @@ inline bool HairGenerator< tPositionGenerator, tOutputGenerator >::
 }
 
 template< typename tPositionGenerator, typename tOutputGenerator >
+inline void HairGenerator< tPositionGenerator, tOutputGenerator >::
+	selectDecimationTolerance()
+{
+	Real tolerance = mHairProperties->getDecimationTolerance();
+	if ( mHairProperties->isDecimationInScreenSpace() )
+	{
+		tolerance *= mPixelSize; // Pixel size is 0 if unknown -> decimation is not used
+	}
+	mDecimationTolerance = static_cast< PositionType >( tolerance );
+}
+
+template< typename tPositionGenerator, typename tOutputGenerator >
+inline void HairGenerator< tPositionGenerator, tOutputGenerator >::
+	decimatePoints( const Point * aPoints, unsigned __int32 aCount, PositionType * aParams ) const
+{
+	if ( aCount < 3 )
+	{
+		return; // No point to remove
+	}
+	const unsigned __int32 last = aCount - 1;
+	const PositionType tolerancePwr2 = mDecimationTolerance * mDecimationTolerance;
+	// Only end points are kept at first ( inner points have positive curve parameter )
+	for ( unsigned __int32 i = 1; i < last; ++i )
+	{
+		aParams[ i ] = -aParams[ i ];
+	}
+	for ( bool refined = true; refined; )
+	{
+		refined = false;
+		// For every span between successive kept points ( previous and next kept points form its tangents )
+		unsigned __int32 previous = 0;
+		for ( unsigned __int32 first = 0; first < last; )
+		{
+			unsigned __int32 second = first + 1;
+			while ( aParams[ second ] < 0 )
+			{
+				++second;
+			}
+			unsigned __int32 next = second;
+			while ( next < last && aParams[ ++next ] < 0 )
+			{
+				/* EMPTY */
+			}
+			const Point span[ 4 ] = { aPoints[ previous ], aPoints[ first ], aPoints[ second ], aPoints[ next ] };
+			const PositionType spanLength = static_cast< PositionType >( second - first );
+			PositionType maxErrorPwr2 = 0;
+			unsigned __int32 worst = first + 1;
+			// Test points between first and second ( even j ) and middles of curve segments ( odd j )
+			for ( unsigned __int32 j = 2 * first + 1; j < 2 * second; ++j )
+			{
+				const unsigned __int32 i = ( j + 1 ) / 2;
+				Point tested = aPoints[ i ];
+				PositionType u = static_cast< PositionType >( i - first ) / spanLength;
+				if ( j % 2 != 0 ) // Middle of full curve segment ending at point i
+				{
+					const Point segment[ 4 ] = { aPoints[ i < 2 ? 0 : i - 2 ], aPoints[ i - 1 ], aPoints[ i ], 
+						aPoints[ std::min( i + 1, last ) ] };
+					catmullRomEval( tested, segment, static_cast< PositionType >( 0.5f ) );
+					u -= static_cast< PositionType >( 0.5f ) / spanLength;
+				}
+				Point kept;
+				catmullRomEval( kept, span, u );
+				const PositionType errorPwr2 = ( tested - kept ).sizePwr2();
+				if ( errorPwr2 > maxErrorPwr2 )
+				{
+					maxErrorPwr2 = errorPwr2;
+					worst = std::min( i, second - 1 );
+				}
+			}
+			if ( maxErrorPwr2 > tolerancePwr2 && second - first > 1 )
+			{
+				// Keep the worst point, following span gets it as its previous kept point
+				aParams[ worst ] = -aParams[ worst ];
+				refined = true;
+				previous = worst;
+			}
+			else if ( maxErrorPwr2 > tolerancePwr2 )
+			{
+				// Single segment deviates only by its tangents, removed neighbour point is kept
+				worst = previous + 1 < first ? first - 1 : second + 1;
+				aParams[ worst ] = -aParams[ worst ];
+				refined = true;
+				previous = first;
+			}
+			else
+			{
+				previous = first;
+			}
+			first = second;
+		}
+	}
+}
+
+template< typename tPositionGenerator, typename tOutputGenerator >
+template< unsigned __int32 tFeatures >
 inline unsigned __int32 HairGenerator< tPositionGenerator, tOutputGenerator >::
 	generateHair( Point * aPoints, Vector * aTangents, unsigned __int32 aCount, 
-		unsigned __int32 aCurvePointsCount, const MeshPoint & aRestPosition, PositionType aCutFactor )
+		unsigned __int32 aCurvePointsCount, const MeshPoint & aRestPosition, PositionType aCutFactor,
+		PositionType * aBuffer )
 {
-	// Select output pointers and skip first position ( first equals second, will be copied later )
-	PositionType *posOutIt = mOutputGenerator.positionPointer() + 3;
-	NormalType *normalOutIt = mOutputGenerator.normalPointer();
-	ColorType *colorIt = mOutputGenerator.colorPointer();
-	OpacityType *opacityIt = mOutputGenerator.opacityPointer();
-	WidthType *widthIt = mOutputGenerator.widthPointer();
-	// We need to store previous normal, for next normal calculation
-	// First point has normal in tangent direction
-	Vector normal = Vector( static_cast< NormalType >( aRestPosition.getTangent().x ),
-							static_cast< NormalType >( aRestPosition.getTangent().y ),
-							static_cast< NormalType >( aRestPosition.getTangent().z ) ); 
-	// Ortho-normalize to tangent NxT = B , BxT = N'
-	normal = Vector::crossProduct( Vector::crossProduct( *aTangents, normal ), *aTangents );
-	unsigned __int32 count = 0;
+	// Curve parameters of points ( negative for points, which are not outputed )
+	PositionType * params = aBuffer;
+	PositionType * oneMinusParams = aBuffer + aCount + 2 * OUTPUT_BATCH_SIZE;
 	// Select parameter step and iteration end
 	--aCurvePointsCount; // Points count -> segments count
 	PositionType step = 1.0f / aCurvePointsCount;
 	bool iterationEnd = false;
+	// Skip threshold is only used if points are not decimated
+	const bool isDecimated = mDecimationTolerance > 0;
 	// We have to ensure that cut procedure is only executed if needed
 	aCutFactor = aCutFactor == 1 ? 2 : aCutFactor; 
-	// Iterate with curve parameter t until iteration end is signaled
+	// Iterate with curve parameter t until iteration end is signaled, selects points for output
+	unsigned __int32 selectedCount = 0;
+	Point * pointIt = aPoints;
+	Vector * tangentIt = aTangents;
 	for ( PositionType t = 0, oneMinusT = 1; !iterationEnd; 
-		t += step, oneMinusT = 1 - t, ++aPoints, ++aTangents )
+		t += step, oneMinusT = 1 - t, ++pointIt, ++tangentIt, ++selectedCount )
 	{
 		if ( t > aCutFactor ) // Reached curve cut end
 		{
 			// Calculate new point position
 			Point newPos;
-			catmullRomEval( newPos, aPoints - 2, 1 - ( t - aCutFactor ) * aCurvePointsCount );
+			catmullRomEval( newPos, pointIt - 2, 1 - ( t - aCutFactor ) * aCurvePointsCount );
 			t = aCutFactor;
+			oneMinusT = 1 - aCutFactor;
 			iterationEnd = true;
 			// Move current point to next and calculate tangent
-			aTangents[ 1 ] = ( aPoints[ 2 ] - newPos ) * 0.5;
-			aPoints[ 1 ] = *aPoints;
+			tangentIt[ 1 ] = ( pointIt[ 2 ] - newPos ) * 0.5;
+			pointIt[ 1 ] = *pointIt;
 			// Set current point and calculate tangent
-			*aPoints = newPos;
-			*aTangents = ( aPoints[ 1 ] - *( aPoints - 1 ) ) * 0.5;
+			*pointIt = newPos;
+			*tangentIt = ( pointIt[ 1 ] - *( pointIt - 1 ) ) * 0.5;
 		}
 		else // Did not reach 
 		{
 			iterationEnd = ( t + step ) > 1; // Reached curve end ?
-			if ( !iterationEnd && t != 0 && skipPoint( aPoints, aTangents ) )
+			if ( !isDecimated && !iterationEnd && t != 0 && skipPoint( pointIt, tangentIt ) )
 			{
-				continue; // Skip this point
+				params[ selectedCount ] = -1; // Skip this point
+				continue;
 			}
 		}
+		// Store curve parameter for colors, opacities and widths calculation
+		params[ selectedCount ] = t;
+		oneMinusParams[ selectedCount ] = oneMinusT;
+	}
+	// Remove points, which are not needed to keep curve within decimation tolerance
+	if ( isDecimated )
+	{
+		decimatePoints( aPoints, selectedCount, params );
+	}
+	// Select output pointers and skip first position ( first equals second, will be copied later )
+	PositionType *posOutIt = mOutputGenerator.positionPointer() + 3;
+	NormalType *normalOutIt = mOutputGenerator.normalPointer();
+	// We need to store previous normal, for next normal calculation
+	// First point has normal in tangent direction
+	Vector normal;
+	if ( ( tFeatures & FEATURE_NORMALS ) != 0 )
+	{
+		normal = Vector( static_cast< NormalType >( aRestPosition.getTangent().x ),
+						 static_cast< NormalType >( aRestPosition.getTangent().y ),
+						 static_cast< NormalType >( aRestPosition.getTangent().z ) ); 
+		// Ortho-normalize to tangent NxT = B , BxT = N'
+		normal = Vector::crossProduct( Vector::crossProduct( *aTangents, normal ), *aTangents );
+	}
+	// Outputs positions and normals of selected points. Skipped points never contribute to normals, 
+	// decimated points do : normals of rotation minimizing frame depend on previous normal, so it is 
+	// propagated through every point of decimated curve to stay independent of decimation tolerance
+	unsigned __int32 count = 0;
+	for ( unsigned __int32 i = 0; i < selectedCount; ++i )
+	{
+		if ( isDecimated && ( tFeatures & FEATURE_NORMALS ) != 0 && i != 0 )
+		{
+			normal = calculateNormal( aPoints + i, aTangents + i, normal );
+		}
+		if ( params[ i ] < 0 )
+		{
+			continue; // Point was skipped or decimated
+		}
+		// Not decimated curve : normal is calculated only for outputed points
+		if ( !isDecimated && ( tFeatures & FEATURE_NORMALS ) != 0 && i != 0 )
+		{
+			normal = calculateNormal( aPoints + i, aTangents + i, normal );
+		}
 		// Calculate bbox
 #ifdef CALCULATE_BBOX
-		mBoundingBox.expand( Vector3D< Real >( aPoints->x, aPoints->y, aPoints->z ) );
+		mBoundingBox.expand( Vector3D< Real >( aPoints[ i ].x, aPoints[ i ].y, aPoints[ i ].z ) );
 #endif
 		// Begin output
 		// Output position
-		memcpy( reinterpret_cast< void * >( posOutIt ), reinterpret_cast< const void * >( aPoints  ), 
+		memcpy( reinterpret_cast< void * >( posOutIt ), reinterpret_cast< const void * >( aPoints + i ), 
 			sizeof( PositionType ) * 3 );
 		posOutIt += 3;
 		// Output normal
-		if ( t != 0 )
-		{
-			normal = calculateNormal( aPoints, aTangents, normal );
-		}
-		memcpy( reinterpret_cast< void * >( normalOutIt ), reinterpret_cast< const void * >( &normal ),
-				sizeof( NormalType ) * 3 );
-		normalOutIt += 3;
-		// Finally output color, opacity, width
-		ColorType tmp[ 3 ];
-		tmp[ 0 ] = circleValue( t * mHueDistance + mRootColor[ 0 ], 0.0f, 360.0f ); //Hue
-		tmp[ 1 ] = t * mTipColor[ 1 ] + oneMinusT * mRootColor[ 1 ]; //Saturation
-		tmp[ 2 ] = t * mTipColor[ 2 ] + oneMinusT * mRootColor[ 2 ]; //Value
-		opacityIt[ 2 ] = opacityIt[ 1 ] = opacityIt[ 0 ] =
-			clamp( t * mTipOpacity + oneMinusT * mRootOpacity, 0.0f, 1.0f );
-		opacityIt += 3;
-		// Convert color from HSV to RGB before outputing
-		HSVtoRGB( colorIt, tmp );
-		clamp( colorIt[ 0 ], 0.0f, 1.0f );
-		clamp( colorIt[ 1 ], 0.0f, 1.0f );
-		clamp( colorIt[ 2 ], 0.0f, 1.0f );
-		colorIt += 3;
-		* ( widthIt++ ) = t * mTipWidth + oneMinusT * mRootWidth; 
+		if ( ( tFeatures & FEATURE_NORMALS ) != 0 )
+		{
+			memcpy( reinterpret_cast< void * >( normalOutIt ), reinterpret_cast< const void * >( &normal ),
+					sizeof( NormalType ) * 3 );
+			normalOutIt += 3;
+		}
+		// Compact curve parameters of outputed points
+		params[ count ] = params[ i ];
+		oneMinusParams[ count ] = oneMinusParams[ i ];
 		// Increase segments count
 		++count;
 	}
-
+	// Pad parameters to whole batches
+	for ( unsigned __int32 i = count; i < count + OUTPUT_BATCH_SIZE; ++i )
+	{
+		params[ i ] = 0;
+		oneMinusParams[ i ] = 1;
+	}
+	// Hue of hair is usually constant ( only saturation and value are interpolated from root to tip ), then
+	// hue sector of HSV to RGB conversion is selected once for whole hair and every RGB component is
+	// computed as value * ( 1 - factor * saturation ), which gives the same result as HSVtoRGB
+	const bool isHueConstant = mHueDistance == 0;
+	ColorType rgbFactors[ 3 ] = { 0, 0, 0 };
+	if ( isHueConstant )
+	{
+		const ColorType hue = circleValue( mRootColor[ 0 ], 0.0f, 360.0f );
+		const unsigned __int8 hi = static_cast< unsigned __int8 >( std::floor( hue / 60 ) ) % 6;
+		const ColorType f = hue / 60 - hi;
+		// Factors of value ( 0 ), p ( 1 ), q ( f ) and t ( 1 - f ) components of every sector
+		const ColorType factors[ 6 ][ 3 ] = { { 0, 1 - f, 1 }, { f, 0, 1 }, { 1, 0, 1 - f }, 
+			{ 1, f, 0 }, { 1 - f, 1, 0 }, { 0, 1, f } };
+		memcpy( rgbFactors, factors[ hi ], sizeof( ColorType ) * 3 );
+	}
+	// Output colors, opacities and widths in batches of points
+	ColorType *colorIt = mOutputGenerator.colorPointer();
+	OpacityType *opacityIt = mOutputGenerator.opacityPointer();
+	WidthType *widthIt = mOutputGenerator.widthPointer();
+	for ( unsigned __int32 i = 0; i < count; i += OUTPUT_BATCH_SIZE )
+	{
+		const PositionType * t = params + i;
+		const PositionType * oneMinusT = oneMinusParams + i;
+		ColorType saturation[ OUTPUT_BATCH_SIZE ], value[ OUTPUT_BATCH_SIZE ], rgb[ OUTPUT_BATCH_SIZE ][ 3 ];
+		OpacityType opacity[ OUTPUT_BATCH_SIZE ];
+		WidthType width[ OUTPUT_BATCH_SIZE ];
+		for ( unsigned __int32 j = 0; j < OUTPUT_BATCH_SIZE; ++j )
+		{
+			saturation[ j ] = t[ j ] * mTipColor[ 1 ] + oneMinusT[ j ] * mRootColor[ 1 ];
+			value[ j ] = t[ j ] * mTipColor[ 2 ] + oneMinusT[ j ] * mRootColor[ 2 ];
+			opacity[ j ] = clamp( t[ j ] * mTipOpacity + oneMinusT[ j ] * mRootOpacity, 0.0f, 1.0f );
+			width[ j ] = t[ j ] * mTipWidth + oneMinusT[ j ] * mRootWidth;
+		}
+		// Convert color from HSV to RGB before outputing
+		if ( isHueConstant )
+		{
+			for ( unsigned __int32 j = 0; j < OUTPUT_BATCH_SIZE; ++j )
+			{
+				rgb[ j ][ 0 ] = value[ j ] * ( 1 - rgbFactors[ 0 ] * saturation[ j ] );
+				rgb[ j ][ 1 ] = value[ j ] * ( 1 - rgbFactors[ 1 ] * saturation[ j ] );
+				rgb[ j ][ 2 ] = value[ j ] * ( 1 - rgbFactors[ 2 ] * saturation[ j ] );
+			}
+		}
+		else
+		{
+			for ( unsigned __int32 j = 0; j < OUTPUT_BATCH_SIZE; ++j )
+			{
+				const ColorType hsv[ 3 ] = { circleValue( t[ j ] * mHueDistance + mRootColor[ 0 ], 0.0f, 360.0f ),
+					saturation[ j ], value[ j ] };
+				HSVtoRGB( rgb[ j ], hsv );
+			}
+		}
+		// Copy only outputed points of last batch
+		const unsigned __int32 batchCount = std::min( static_cast< unsigned __int32 >( OUTPUT_BATCH_SIZE ), count - i );
+		for ( unsigned __int32 j = 0; j < batchCount; ++j, colorIt += 3, opacityIt += 3 )
+		{
+			colorIt[ 0 ] = rgb[ j ][ 0 ];
+			colorIt[ 1 ] = rgb[ j ][ 1 ];
+			colorIt[ 2 ] = rgb[ j ][ 2 ];
+			opacityIt[ 2 ] = opacityIt[ 1 ] = opacityIt[ 0 ] = opacity[ j ];
+		}
+		memcpy( reinterpret_cast< void * >( widthIt ), reinterpret_cast< const void * >( width ),
+			sizeof( WidthType ) * batchCount );
+		widthIt += batchCount;
+	}
 	// Finally duplicates first & last hair points
 	count += 2;
 	copyToLastAndFirst< PositionType, 3 > ( mOutputGenerator.positionPointer(), count );
@@ -815,13 +1466,13 @@ inline unsigned __int32 HairGenerator< tPositionGenerator, tOutputGenerator >::
 
 template< typename tPositionGenerator, typename tOutputGenerator >
 inline void HairGenerator< tPositionGenerator, tOutputGenerator >::
-	outputHairIndexAndUVs( IndexType aHairIndex, IndexType aStrandIndex, const MeshPoint &aRestPosition )
+	outputHairIndexAndUVs( unsigned __int64 aHairIndex, IndexType aStrandIndex, const MeshPoint &aRestPosition )
 {
 	// Store uv coordinates
 	const UVCoordinateType u = static_cast< UVCoordinateType >( aRestPosition.getUCoordinate() );
 	const UVCoordinateType v = static_cast< UVCoordinateType >( aRestPosition.getVCoordinate() );
 	// Output indices
-	* mOutputGenerator.hairIndexPointer() = aHairIndex;
+	* mOutputGenerator.hairIndexPointer() = static_cast< IndexType >( aHairIndex );
 	* mOutputGenerator.strandIndexPointer() = aStrandIndex;
 	// Output uv coordinates
 	* mOutputGenerator.hairUVCoordinatePointer() = u;
@@ -858,51 +1509,65 @@ inline void HairGenerator< tPositionGenerator, tOutputGenerator >::
 
 template< typename tPositionGenerator, typename tOutputGenerator >
 inline void HairGenerator< tPositionGenerator, tOutputGenerator >::
-	selectMultiStrandProperties( const MeshPoint &aRestPosition, unsigned __int32 aCurvePointsCount )
+	selectMultiStrandProperties()
 {
-	// Store uv coordinates
-	const Real u = aRestPosition.getUCoordinate();
-	const Real v = aRestPosition.getVCoordinate();
-	// Select twist and divide it by aCurvePointsCount - 1 to get twist angle for each hair point
-	PositionType twist = static_cast< PositionType >( mHairProperties->getTwist() * 
-		mHairProperties->getTwistTexture().realAtUV( u, v ) ) / ( aCurvePointsCount - 1 );
-	// Calculate cos, sin
-	mCosTwist = static_cast< PositionType >( cos( twist ) );
-	mSinTwist = static_cast< PositionType >( sin( twist ) );
+	// Select twist of whole hair
+	mTwist = static_cast< PositionType >( mHairProperties->getTwist() * 
+		mAttributes[ AttributeAtlas::TWIST ] );
 	// Select tip splay
 	mTipSplay = static_cast< PositionType >( mHairProperties->getTipSplay() * 
-		mHairProperties->getTipSplayTexture().realAtUV( u, v ) );
+		mAttributes[ AttributeAtlas::TIP_SPLAY ] );
 	// Select center splay
 	mCenterSplay = static_cast< PositionType >( mHairProperties->getCenterSplay() * 
-		mHairProperties->getCenterSplayTexture().realAtUV( u, v ) );
+		mAttributes[ AttributeAtlas::CENTER_SPLAY ] );
 	// Select root splay
 	mRootSplay = static_cast< PositionType >( mHairProperties->getRootSplay() * 
-		mHairProperties->getRootSplayTexture().realAtUV( u, v ) );
+		mAttributes[ AttributeAtlas::ROOT_SPLAY ] );
 	// Select randomize scale
 	mRandomizeScale = static_cast< PositionType >( mHairProperties->getRandomizeStrand() * 
-		mHairProperties->getRandomizeStrandTexture().realAtUV( u, v ) );
+		mAttributes[ AttributeAtlas::RANDOMIZE_STRAND ] );
 	// Select offset of tips
 	mOffset = static_cast< PositionType >( mHairProperties->getOffset() * 
-		mHairProperties->getOffsetTexture().realAtUV( u, v ) );
+		mAttributes[ AttributeAtlas::OFFSET ] );
 	// Select aspect ratio of disk samples
 	mAspect = static_cast< PositionType >( mHairProperties->getAspect() * 
-		mHairProperties->getAspectTexture().realAtUV( u, v ) );
+		mAttributes[ AttributeAtlas::ASPECT ] );
 }
 
 template< typename tPositionGenerator, typename tOutputGenerator >
 inline void HairGenerator< tPositionGenerator, tOutputGenerator >::
-	generateHairInStrand( Point * aPoints, unsigned __int32 aCount, unsigned __int32 aCurvePointsCount,
-	const Point * aMainHairPoints, const Vector * aMainHairNormals, const Vector * aMainHairBinormals )
+	selectTwist( unsigned __int32 aCurvePointsCount )
+{
+	// Divide twist by aCurvePointsCount - 1 to get twist angle for each hair point
+	PositionType twist = mTwist / ( aCurvePointsCount - 1 );
+	// Calculate cos, sin
+	mCosTwist = static_cast< PositionType >( cos( twist ) );
+	mSinTwist = static_cast< PositionType >( sin( twist ) );
+}
+
+template< typename tPositionGenerator, typename tOutputGenerator >
+inline void HairGenerator< tPositionGenerator, tOutputGenerator >::
+	selectPositionInStrand( PositionType & aCosPhi, PositionType & aSinPhi )
 {
 	// Generate relative position on disk ( first must transform [0-1]^2 numbers to [-1,1]^2 )
-	PositionType cosPhi, sinPhi, radius;
+	PositionType radius;
 	sampleDisk( static_cast< PositionType >( 2 * mRandom.uniformNumber() - 1 ), 
-		static_cast< PositionType >( 2 * mRandom.uniformNumber() - 1 ) , cosPhi, sinPhi, radius );
+		static_cast< PositionType >( 2 * mRandom.uniformNumber() - 1 ) , aCosPhi, aSinPhi, radius );
+}
+
+template< typename tPositionGenerator, typename tOutputGenerator >
+inline void HairGenerator< tPositionGenerator, tOutputGenerator >::
+	calculateStrandFrame( Point * aFrame, unsigned __int32 aCount, unsigned __int32 aCurvePointsCount,
+	const Point * aMainHairPoints, const Vector * aMainHairNormals, const Vector * aMainHairBinormals,
+	const Matrix & aTransformMatrix )
+{
+	Point * bases = aFrame, * cosAxes = aFrame + aCount, * sinAxes = aFrame + 2 * aCount;
+	// Twist accumulated from root
+	PositionType cosTwist = 1, sinTwist = 0;
 	// Curve t param
 	PositionType step = 1.0f / ( aCurvePointsCount - 1 ), t = 0;
 	// For every point on cut curve
-	for( Point * it = aPoints, * end = aPoints + aCount; it != end; 
-		t += step, ++it, ++aMainHairPoints, ++aMainHairNormals, ++aMainHairBinormals )
+	for( unsigned __int32 i = 0; i < aCount; ++i, t += step )
 	{
 		// Calculate 4 * ( t - 0.5 )^2
 		static const PositionType half = static_cast< PositionType >( 0.5f );
@@ -911,18 +1576,116 @@ inline void HairGenerator< tPositionGenerator, tOutputGenerator >::
 		// Calculate radius and offset
 		PositionType currRadius = ( t <= half ? mRootSplay : mTipSplay ) * tMinusHalf2M4 + ( 1 - tMinusHalf2M4 ) * mCenterSplay, 
 			offset = mOffset * t * t * t;
-		// Calculate final position :
-		// mainHairPos + position on plane defined by normal and binormal * radius + offset in direction of normal
-		*it = ( *aMainHairPoints + ( *aMainHairNormals * cosPhi + *aMainHairBinormals * sinPhi * mAspect ) * currRadius +
-			*aMainHairNormals * offset );
-		// Add twist to cosPhi and sinPhi using trigonometric formulas
-		PositionType newSinPhi = sinPhi * mCosTwist + mSinTwist * cosPhi;
-		cosPhi *= mCosTwist;
-		cosPhi -= mSinTwist * sinPhi;
-		sinPhi = newSinPhi;
+		// Position of hair in strand is :
+		// mainHairPos + offset in direction of normal + ( normal * cos( phi + twist ) + 
+		// binormal * aspect * sin( phi + twist ) ) * radius, cos( phi + twist ) and sin( phi + twist ) 
+		// are expanded, so phi is separated from the rest
+		const Vector normal = aMainHairNormals[ i ] * currRadius;
+		const Vector binormal = aMainHairBinormals[ i ] * ( mAspect * currRadius );
+		bases[ i ] = Point::transformPoint( aMainHairPoints[ i ] + aMainHairNormals[ i ] * offset, aTransformMatrix );
+		cosAxes[ i ] = Point::transform( normal * cosTwist + binormal * sinTwist, aTransformMatrix );
+		sinAxes[ i ] = Point::transform( binormal * cosTwist - normal * sinTwist, aTransformMatrix );
+		// Add twist using trigonometric formulas
+		PositionType newSinTwist = sinTwist * mCosTwist + mSinTwist * cosTwist;
+		cosTwist *= mCosTwist;
+		cosTwist -= mSinTwist * sinTwist;
+		sinTwist = newSinTwist;
 	} 
 }
 
+template< typename tPositionGenerator, typename tOutputGenerator >
+inline void HairGenerator< tPositionGenerator, tOutputGenerator >::
+	generateHairInStrand( Point * aPoints, unsigned __int32 aStride, unsigned __int32 aHairCount,
+	const unsigned __int32 * aCounts, const PositionType * aCosPhis, const PositionType * aSinPhis,
+	const Point * aFrame, unsigned __int32 aFrameCount )
+{
+	const PositionType * bases = reinterpret_cast< const PositionType * >( aFrame );
+	const PositionType * cosAxes = reinterpret_cast< const PositionType * >( aFrame + aFrameCount );
+	const PositionType * sinAxes = reinterpret_cast< const PositionType * >( aFrame + 2 * aFrameCount );
+	// For every hair
+	for ( unsigned __int32 j = 0; j < aHairCount; ++j )
+	{
+		PositionType * positions = reinterpret_cast< PositionType * >( aPoints + j * aStride );
+		const PositionType cosPhi = aCosPhis[ j ], sinPhi = aSinPhis[ j ];
+		// All coordinates are calculated by the same formula, so points are processed as one array of 
+		// coordinates ( loop without dependencies, which is vectorized by compiler )
+		const int coordinatesCount = static_cast< int >( 3 * aCounts[ j ] );
+		for ( int i = 0; i < coordinatesCount; ++i )
+		{
+			positions[ i ] = bases[ i ] + cosAxes[ i ] * cosPhi + sinAxes[ i ] * sinPhi;
+		}
+	}
+}
+
+template< typename tPositionGenerator, typename tOutputGenerator >
+inline void HairGenerator< tPositionGenerator, tOutputGenerator >::
+	storeToCache( MotionSamplesCache::Hair & aHair, PositionType aCutFactor, const BakedHairRoot & aHairRoot ) const
+{
+	aHair.mState = MotionSamplesCache::HAIR_GENERATED;
+	aHair.mHairRoot = aHairRoot;
+	aHair.mCutFactor = static_cast< float >( aCutFactor );
+	aHair.mScale = static_cast< float >( mScale );
+	for ( unsigned __int32 i = 0; i < 3; ++i )
+	{
+		aHair.mFrizzFrequency[ i ] = mFrizzFrequency[ i ];
+		aHair.mStaticFrizz[ i ] = mStaticFrizz[ i ];
+		aHair.mRootColor[ i ] = static_cast< float >( mRootColor[ i ] );
+		aHair.mTipColor[ i ] = static_cast< float >( mTipColor[ i ] );
+	}
+	aHair.mRootFrizz = mRootFrizz;
+	aHair.mTipFrizz = mTipFrizz;
+	aHair.mFrizzAnim = mFrizzAnim;
+	aHair.mFrizzAnimSpeed = mFrizzAnimSpeed;
+	aHair.mHueDistance = static_cast< float >( mHueDistance );
+	aHair.mRootOpacity = static_cast< float >( mRootOpacity );
+	aHair.mTipOpacity = static_cast< float >( mTipOpacity );
+	aHair.mRootWidth = static_cast< float >( mRootWidth );
+	aHair.mTipWidth = static_cast< float >( mTipWidth );
+	if ( mHairProperties->getMultiStrandCount() ) // Multi strand properties are only selected if used
+	{
+		aHair.mTwist = static_cast< float >( mTwist );
+		aHair.mTipSplay = static_cast< float >( mTipSplay );
+		aHair.mCenterSplay = static_cast< float >( mCenterSplay );
+		aHair.mRootSplay = static_cast< float >( mRootSplay );
+		aHair.mRandomizeScale = static_cast< float >( mRandomizeScale );
+		aHair.mOffset = static_cast< float >( mOffset );
+		aHair.mAspect = static_cast< float >( mAspect );
+	}
+}
+
+template< typename tPositionGenerator, typename tOutputGenerator >
+inline void HairGenerator< tPositionGenerator, tOutputGenerator >::
+	loadFromCache( const MotionSamplesCache::Hair & aHair )
+{
+	mScale = static_cast< PositionType >( aHair.mScale );
+	for ( unsigned __int32 i = 0; i < 3; ++i )
+	{
+		mFrizzFrequency[ i ] = aHair.mFrizzFrequency[ i ];
+		mStaticFrizz[ i ] = aHair.mStaticFrizz[ i ];
+		mRootColor[ i ] = static_cast< ColorType >( aHair.mRootColor[ i ] );
+		mTipColor[ i ] = static_cast< ColorType >( aHair.mTipColor[ i ] );
+	}
+	mRootFrizz = aHair.mRootFrizz;
+	mTipFrizz = aHair.mTipFrizz;
+	mFrizzAnim = aHair.mFrizzAnim;
+	mFrizzAnimSpeed = aHair.mFrizzAnimSpeed;
+	mHueDistance = static_cast< ColorType >( aHair.mHueDistance );
+	mRootOpacity = static_cast< OpacityType >( aHair.mRootOpacity );
+	mTipOpacity = static_cast< OpacityType >( aHair.mTipOpacity );
+	mRootWidth = static_cast< WidthType >( aHair.mRootWidth );
+	mTipWidth = static_cast< WidthType >( aHair.mTipWidth );
+	if ( mHairProperties->getMultiStrandCount() ) // Multi strand properties are only selected if used
+	{
+		mTwist = static_cast< PositionType >( aHair.mTwist );
+		mTipSplay = static_cast< PositionType >( aHair.mTipSplay );
+		mCenterSplay = static_cast< PositionType >( aHair.mCenterSplay );
+		mRootSplay = static_cast< PositionType >( aHair.mRootSplay );
+		mRandomizeScale = static_cast< PositionType >( aHair.mRandomizeScale );
+		mOffset = static_cast< PositionType >( aHair.mOffset );
+		mAspect = static_cast< PositionType >( aHair.mAspect );
+	}
+}
+
 template< typename tPositionGenerator, typename tOutputGenerator >
 inline void HairGenerator< tPositionGenerator, tOutputGenerator >::
 	updateBoundingBox( Point * aPoints, Vector * aTangents, unsigned __int32 aCount, 
@@ -934,6 +1697,8 @@ inline void HairGenerator< tPositionGenerator, tOutputGenerator >::
 	bool iterationEnd = false;
 	// We have to ensure that cut procedure is only executed if needed
 	aCutFactor = aCutFactor == 1 ? 2 : aCutFactor; 
+	// Decimated points are selected by whole curve, so all points are used for bounding box
+	const bool isDecimated = mHairProperties->getDecimationTolerance() > 0;
 	// Iterate with curve parameter t until iteration end is signaled
 	for ( PositionType t = 0, oneMinusT = 1; !iterationEnd; 
 		t += step, oneMinusT = 1 - t, ++aPoints, ++aTangents )
@@ -955,7 +1720,7 @@ inline void HairGenerator< tPositionGenerator, tOutputGenerator >::
 		else // Did not reach 
 		{
 			iterationEnd = ( t + step ) > 1; // Reached curve end ?
-			if ( !iterationEnd && t != 0 && skipPoint( aPoints, aTangents ) )
+			if ( !isDecimated && !iterationEnd && t != 0 && skipPoint( aPoints, aTangents ) )
 			{
 				continue; // Skip this point
 			}
@@ -1,5 +1,8 @@
 #include "HairProperties.hpp"
 
+#include <algorithm>
+#include <math.h>
+
 namespace Stubble
 {
 
@@ -15,6 +18,7 @@ HairProperties::HairProperties():
 	mInterpolationGroups( 0 ),
 	mInterpolationGroupsTexture( 0 ),
 	mNumberOfGuidesToInterpolateFrom( 3 ),
+	mIsGuidesTriangulationUsed( false ),
 	mGuidesRestPositionsDS( 0 ),
 	mGuidesSegments( 0 ),
 	mAreNormalsCalculated( false ),
@@ -82,7 +86,19 @@ HairProperties::HairProperties():
 	mAspectTexture( 0 ),
 	mAspect( 1 ),
 	mRandomizeStrandTexture( 0 ),
-	mRandomizeStrand( 0 )
+	mRandomizeStrand( 0 ),
+	mIsRandomCounterBased( false ),
+	mRandomSeed( 0 ),
+	mRootsOrder( ROOTS_GENERATION_ORDER ),
+	mIsLevelOfDetailUsed( false ),
+	mLodFullDetailSize( 10000 ),
+	mLodMinimumHairRatio( 0.05 ),
+	mLodMinimumSegmentsRatio( 0.25 ),
+	mDecimationTolerance( 0 ),
+	mIsDecimationInScreenSpace( false ),
+	mCommitSize( 1000000 ),
+	mMaxProceduralCommitsCount( 4 ),
+	mMaxProceduralChildrenCount( 16 )
 {
 	 mRootColor[ 0 ] = mRootColor[ 1 ] = mRootColor[ 2 ] = 1;
 	 mTipColor[ 0 ] = mTipColor[ 1 ] = mTipColor[ 2 ] = 1;
@@ -162,6 +178,66 @@ HairProperties::~HairProperties()
 	delete mRandomizeStrandTexture;
 }
 
+void HairProperties::updateAttributeAtlas()
+{
+	mAttributeAtlas.build( *this );
+}
+
+Real HairProperties::calculateMaxHairReach() const
+{
+	static const Real SQRT_3 = 1.7320508075688772;
+	// Interpolated hair points are convex combinations of guides points ( in local space of hair root )
+	Real guidesReach = 0;
+	const HairComponents::GuidesSegments & guides = getGuidesSegments();
+	for ( HairComponents::GuidesSegments::const_iterator guideIt = guides.begin(); guideIt != guides.end(); ++guideIt )
+	{
+		for ( HairComponents::Segments::const_iterator segIt = guideIt->mSegments.begin();
+			segIt != guideIt->mSegments.end(); ++segIt )
+		{
+			guidesReach = std::max( guidesReach, segIt->size() );
+		}
+	}
+	// Scale factor = scale * scaleTexture * ( 1 - randScale * randScaleTexture * random )
+	Real scale = fabs( getScale() ) * getScaleTexture().getMaxAbsoluteValue() *
+		std::max( 1.0, fabs( 1 - fabs( getRandScale() ) * 
+		getRandScaleTexture().getMaxAbsoluteValue() ) );
+	// Every frizz displace component is at most max( root frizz, tip frizz ) * ( static factor + anim factor )
+	Real frizzAnim = fabs( getFrizzAnim() ) * getFrizzAnimTexture().getMaxAbsoluteValue();
+	Real frizz = std::max( fabs( getRootFrizz() ) * getRootFrizzTexture().getMaxAbsoluteValue(),
+		fabs( getTipFrizz() ) * getTipFrizzTexture().getMaxAbsoluteValue() ) *
+		std::max( 1.0, fabs( 1 - frizzAnim ) + frizzAnim );
+	// Every kink displace component is at most max( root kink, tip kink )
+	Real kink = std::max( fabs( getRootKink() ) * getRootKinkTexture().getMaxAbsoluteValue(),
+		fabs( getTipKink() ) * getTipKinkTexture().getMaxAbsoluteValue() );
+	Real hairReach = guidesReach * scale + SQRT_3 * ( frizz + kink );
+	if ( getMultiStrandCount() ) // Uses multi strands ?
+	{
+		// Strand hair is displaced from main hair by splay radius on ellipse ( defined by aspect ) and by offset
+		Real splay = std::max( std::max( 
+			fabs( getRootSplay() ) * getRootSplayTexture().getMaxAbsoluteValue(),
+			fabs( getCenterSplay() ) * getCenterSplayTexture().getMaxAbsoluteValue() ),
+			fabs( getTipSplay() ) * getTipSplayTexture().getMaxAbsoluteValue() );
+		Real aspect = std::max( 1.0, 
+			fabs( getAspect() ) * getAspectTexture().getMaxAbsoluteValue() );
+		hairReach += splay * aspect + 
+			fabs( getOffset() ) * getOffsetTexture().getMaxAbsoluteValue();
+	}
+	// Catmull-rom curve may overshoot its control points : control points of coresponding bezier patches
+	// are at most 4/3 times ( 16/9 times next to the cut point ) farther from root than curve points
+	hairReach *= 2;
+	// Enlarge by hair thickness ( level of detail may widen hair )
+	Real maxThick = std::max( 
+		fabs( getRootThickness() ) * getRootThicknessTexture().getMaxAbsoluteValue(),
+		fabs( getTipThickness() ) * getTipThicknessTexture().getMaxAbsoluteValue() ) * 0.5;
+	if ( isLevelOfDetailUsed() )
+	{
+		maxThick /= getLodMinimumHairRatio();
+	}
+	// Finally hair root may be displaced from mesh in the direction of normal
+	return hairReach + maxThick + 
+		fabs( getDisplacement() ) * getDisplacementTexture().getMaxAbsoluteValue();
+}
+
 } // namespace Interpolation
 
 } // namespace HairShape
@@ -4,6 +4,7 @@
 #include "HairShape/HairComponents/Segments.hpp"
 #include "HairShape/HairComponents/RestPositionsDS.hpp"
 #include "HairShape/Texture/Texture.hpp"
+#include "AttributeAtlas.hpp"
 #include "InterpolationGroups.hpp"
 
 namespace Stubble
@@ -23,6 +24,18 @@ class HairProperties
 {
 public:
 
+	///-------------------------------------------------------------------------------------------------
+	/// Values that represent orders in which roots of hair in voxel are processed.
+	///-------------------------------------------------------------------------------------------------
+	enum RootsOrder
+	{
+		ROOTS_GENERATION_ORDER = 0, ///< Roots are processed in order of generation
+		ROOTS_UV_MORTON_ORDER,  ///< Roots are ordered by Morton curve in UV space
+		ROOTS_UV_HILBERT_ORDER, ///< Roots are ordered by Hilbert curve in UV space
+		ROOTS_POSITION_MORTON_ORDER,	///< Roots are ordered by Morton curve over rest pose positions
+		ROOTS_ORDERS_COUNT  ///< Number of roots orders
+	};
+
 	///-------------------------------------------------------------------------------------------------
 	/// Finaliser. 
 	///-------------------------------------------------------------------------------------------------
@@ -58,6 +71,15 @@ public:
 	///----------------------------------------------------------------------------------------------------
 	inline unsigned __int32 getNumberOfGuidesToInterpolateFrom() const;
 
+	///----------------------------------------------------------------------------------------------------
+	/// Query if hair are interpolated from three guides of enclosing triangle of guides triangulation
+	/// instead of closest guides. Hair outside of triangulation are still interpolated from closest
+	/// guides. Triangles may span gaps between UV shells ( see GuidesTriangulation ).
+	///
+	/// \return	true if guides triangulation is used. 
+	///----------------------------------------------------------------------------------------------------
+	inline bool isGuidesTriangulationUsed() const;
+
 	///----------------------------------------------------------------------------------------------------
 	/// Gets the guides segments. 
 	///
@@ -555,6 +577,115 @@ public:
 	///-------------------------------------------------------------------------------------------------
 	inline Real getRandomizeStrand() const;
 
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the atlas of all per hair attributes textures. 
+	///
+	/// \return	The attribute atlas. 
+	///-------------------------------------------------------------------------------------------------
+	inline const AttributeAtlas & getAttributeAtlas() const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Query if counter based random generator is used. Otherwise James random generator is used,
+	/// which gives same results as older versions.
+	///
+	/// \return	true if counter based random generator is used. 
+	///-------------------------------------------------------------------------------------------------
+	inline bool isRandomCounterBased() const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the seed of counter based random generator. 
+	///
+	/// \return	The random seed. 
+	///-------------------------------------------------------------------------------------------------
+	inline unsigned __int32 getRandomSeed() const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the order in which roots of hair in voxel are processed. Hair indices are assigned to
+	/// roots in this order, so neighbouring hair share guides, triangles and texels.
+	///
+	/// \return	The roots order. 
+	///-------------------------------------------------------------------------------------------------
+	inline RootsOrder getRootsOrder() const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Query if level of detail is used. Renderer then decreases number of hair and their points
+	/// for voxels covering small area of the screen.
+	///
+	/// \return	true if level of detail is used.
+	///-------------------------------------------------------------------------------------------------
+	inline bool isLevelOfDetailUsed() const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the level of detail full detail size. Voxels with detail size ( area in pixels ) greater
+	/// or equal to this size are generated with full detail.
+	///
+	/// \return	The level of detail full detail size.
+	///-------------------------------------------------------------------------------------------------
+	inline Real getLodFullDetailSize() const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the level of detail minimum hair ratio. At least this part of hair is always generated.
+	///
+	/// \return	The level of detail minimum hair ratio.
+	///-------------------------------------------------------------------------------------------------
+	inline Real getLodMinimumHairRatio() const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the level of detail minimum segments ratio. At least this part of hair segments is always
+	/// generated.
+	///
+	/// \return	The level of detail minimum segments ratio.
+	///-------------------------------------------------------------------------------------------------
+	inline Real getLodMinimumSegmentsRatio() const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the decimation tolerance. If it is greater than zero, hair points are decimated so that
+	/// the rendered curve stays within this distance from the full interpolated curve ( measured at
+	/// all interpolated points and middles of their segments ) and skip threshold is not used.
+	///
+	/// \return	The decimation tolerance ( world units or pixels ).
+	///-------------------------------------------------------------------------------------------------
+	inline Real getDecimationTolerance() const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Query if decimation tolerance is given in screen space ( pixels ) instead of world space.
+	///
+	/// \return	true if decimation tolerance is given in pixels.
+	///-------------------------------------------------------------------------------------------------
+	inline bool isDecimationInScreenSpace() const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the commit size. Renderer sends generated hair in parts, each part contains at most this
+	/// number of hair points. This limits memory used by renderer plugin.
+	///
+	/// \return	The commit size.
+	///-------------------------------------------------------------------------------------------------
+	inline unsigned __int32 getCommitSize() const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the maximal commits count of procedural. RenderMan procedural, whose hair have more points
+	/// than this number of commits, is split to child procedurals.
+	///
+	/// \return	The maximal procedural commits count.
+	///-------------------------------------------------------------------------------------------------
+	inline unsigned __int32 getMaxProceduralCommitsCount() const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the maximal children count of procedural. Larger procedurals are split recursively.
+	///
+	/// \return	The maximal procedural children count.
+	///-------------------------------------------------------------------------------------------------
+	inline unsigned __int32 getMaxProceduralChildrenCount() const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Calculates upper bound of distance between any point of interpolated hair curve and its root.
+	/// Bound is derived from the longest guide and maximal values of scale, frizz, kink and 
+	/// multi-strand properties ( including their textures ) and is enlarged by hair thickness.
+	///
+	/// \return	The maximal hair reach. 
+	///-------------------------------------------------------------------------------------------------
+	Real calculateMaxHairReach() const;
+
 protected:
 	
 	///-------------------------------------------------------------------------------------------------
@@ -578,6 +709,8 @@ protected:
 
 	unsigned __int32 mNumberOfGuidesToInterpolateFrom;  ///< Number of guides to interpolate from
 
+	bool mIsGuidesTriangulationUsed;	///< true if hair are interpolated from triangles of guides
+
 	const HairComponents::GuidesSegments * mGuidesSegments;   ///< The guides segments
 
 	const HairComponents::RestPositionsDS * mGuidesRestPositionsDS;   ///< The guides rest positions data structure
@@ -719,6 +852,38 @@ protected:
 	Texture * mRandomizeStrandTexture;  ///< The randomize strand texture
 
 	Real mRandomizeStrand;  ///< The randomize strand
+
+	bool mIsRandomCounterBased;	///< true if counter based random generator is used
+
+	unsigned __int32 mRandomSeed;   ///< The seed of counter based random generator
+
+	unsigned __int32 mRootsOrder;   ///< The order of hair roots in voxel ( see RootsOrder )
+
+	bool mIsLevelOfDetailUsed;	///< true if level of detail is used
+
+	Real mLodFullDetailSize;	///< The level of detail full detail size
+
+	Real mLodMinimumHairRatio;  ///< The level of detail minimum hair ratio
+
+	Real mLodMinimumSegmentsRatio;  ///< The level of detail minimum segments ratio
+
+	Real mDecimationTolerance;  ///< The decimation tolerance ( 0 if skip threshold is used )
+
+	bool mIsDecimationInScreenSpace;	///< true if decimation tolerance is given in pixels
+
+	unsigned __int32 mCommitSize;   ///< Maximum number of hair points sent to renderer at once
+
+	unsigned __int32 mMaxProceduralCommitsCount;	///< Maximum number of commits of single procedural
+
+	unsigned __int32 mMaxProceduralChildrenCount;   ///< Maximum number of children of single procedural
+
+	///-------------------------------------------------------------------------------------------------
+	/// Rebuilds the attribute atlas from current textures. Must be called by deriving class whenever
+	/// any attribute texture changes.
+	///-------------------------------------------------------------------------------------------------
+	void updateAttributeAtlas();
+
+	AttributeAtlas mAttributeAtlas; ///< The atlas of all per hair attributes textures
 };
 
 // inline functions implementation
@@ -743,6 +908,11 @@ inline unsigned __int32 HairProperties::getNumberOfGuidesToInterpolateFrom() con
 	return mNumberOfGuidesToInterpolateFrom;
 }
 
+inline bool HairProperties::isGuidesTriangulationUsed() const
+{
+	return mIsGuidesTriangulationUsed;
+}
+
 inline const HairComponents::GuidesSegments & HairProperties::getGuidesSegments() const
 {
 	return *mGuidesSegments;
@@ -1099,6 +1269,71 @@ inline Real HairProperties::getRandomizeStrand() const
 	return mRandomizeStrand;
 }
 
+inline const AttributeAtlas & HairProperties::getAttributeAtlas() const
+{
+	return mAttributeAtlas;
+}
+
+inline bool HairProperties::isRandomCounterBased() const
+{
+	return mIsRandomCounterBased;
+}
+
+inline unsigned __int32 HairProperties::getRandomSeed() const
+{
+	return mRandomSeed;
+}
+
+inline HairProperties::RootsOrder HairProperties::getRootsOrder() const
+{
+	return mRootsOrder < ROOTS_ORDERS_COUNT ? static_cast< RootsOrder >( mRootsOrder ) : ROOTS_GENERATION_ORDER;
+}
+
+inline bool HairProperties::isLevelOfDetailUsed() const
+{
+	return mIsLevelOfDetailUsed;
+}
+
+inline Real HairProperties::getLodFullDetailSize() const
+{
+	return mLodFullDetailSize;
+}
+
+inline Real HairProperties::getLodMinimumHairRatio() const
+{
+	return mLodMinimumHairRatio;
+}
+
+inline Real HairProperties::getLodMinimumSegmentsRatio() const
+{
+	return mLodMinimumSegmentsRatio;
+}
+
+inline Real HairProperties::getDecimationTolerance() const
+{
+	return mDecimationTolerance;
+}
+
+inline bool HairProperties::isDecimationInScreenSpace() const
+{
+	return mIsDecimationInScreenSpace;
+}
+
+inline unsigned __int32 HairProperties::getCommitSize() const
+{
+	return mCommitSize;
+}
+
+inline unsigned __int32 HairProperties::getMaxProceduralCommitsCount() const
+{
+	return mMaxProceduralCommitsCount;
+}
+
+inline unsigned __int32 HairProperties::getMaxProceduralChildrenCount() const
+{
+	return mMaxProceduralChildrenCount;
+}
+
 } // namespace Interpolation
 
 } // namespace HairShape
@@ -0,0 +1,84 @@
+#include "HairRootsOrder.hpp"
+
+#include "Primitives/BoundingBox.hpp"
+
+#include <algorithm>
+#include <math.h>
+#include <utility>
+#include <vector>
+
+namespace Stubble
+{
+
+namespace HairShape
+{
+
+namespace Interpolation
+{
+
+void HairRootsOrder::generateRoots( const HairProperties & aHairProperties, UVPointGenerator & aUVPointGenerator,
+	const Mesh & aRestPoseMesh, unsigned __int64 aHairStartIndex, unsigned __int32 aHairCount,
+	UVPoint * aRoots )
+{
+	// Generate roots in usual order
+	for ( unsigned __int32 i = 0; i < aHairCount; ++i )
+	{
+		aRoots[ i ] = aUVPointGenerator.next( aHairStartIndex + i );
+	}
+	const HairProperties::RootsOrder order = aHairProperties.getRootsOrder();
+	if ( order == HairProperties::ROOTS_GENERATION_ORDER || aHairCount < 2 )
+	{
+		return;
+	}
+	// Select keys of roots ( uv coordinates or rest pose positions ) and their bounds
+	const bool isPositionOrder = order == HairProperties::ROOTS_POSITION_MORTON_ORDER;
+	std::vector< Vector3D< Real > > keys( aHairCount );
+	BoundingBox bounds;
+	for ( unsigned __int32 i = 0; i < aHairCount; ++i )
+	{
+		MeshPoint restPos = aRestPoseMesh.getMeshPoint( aRoots[ i ] );
+		keys[ i ] = isPositionOrder ? restPos.getPosition() :
+			Vector3D< Real >( restPos.getUCoordinate(), restPos.getVCoordinate(), 0 );
+		bounds.expand( keys[ i ] );
+	}
+	// Quantize keys to cells of grid over bounds and calculate their codes
+	const Real maxCell = static_cast< Real >( ( 1u << ( isPositionOrder ? BITS_3D : BITS_2D ) ) - 1 );
+	const Vector3D< Real > size = bounds.max() - bounds.min();
+	std::vector< std::pair< unsigned __int32, unsigned __int32 > > codes( aHairCount );
+	for ( unsigned __int32 i = 0; i < aHairCount; ++i )
+	{
+		unsigned __int32 cell[ 3 ];
+		for ( unsigned __int32 j = 0; j < 3; ++j )
+		{
+			cell[ j ] = size[ j ] > 0 ? static_cast< unsigned __int32 >(
+				floor( ( keys[ i ][ j ] - bounds.min()[ j ] ) / size[ j ] * maxCell + 0.5 ) ) : 0;
+		}
+		unsigned __int32 code;
+		switch ( order )
+		{
+		case HairProperties::ROOTS_UV_HILBERT_ORDER:
+			code = hilbertCode( cell[ 0 ], cell[ 1 ] );
+			break;
+		case HairProperties::ROOTS_POSITION_MORTON_ORDER:
+			code = mortonCode( cell[ 0 ], cell[ 1 ], cell[ 2 ] );
+			break;
+		default:
+			code = mortonCode( cell[ 0 ], cell[ 1 ] );
+			break;
+		}
+		codes[ i ] = std::make_pair( code, i );
+	}
+	// Sort roots by codes, same codes are sorted by order of generation
+	std::sort( codes.begin(), codes.end() );
+	std::vector< UVPoint > generated( aRoots, aRoots + aHairCount );
+	for ( unsigned __int32 i = 0; i < aHairCount; ++i )
+	{
+		aRoots[ i ] = generated[ codes[ i ].second ];
+	}
+}
+
+} // namespace Interpolation
+
+} // namespace HairShape
+
+} // namespace Stubble
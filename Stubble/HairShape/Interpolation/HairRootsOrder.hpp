@@ -0,0 +1,179 @@
+#ifndef STUBBLE_HAIR_ROOTS_ORDER_HPP
+#define STUBBLE_HAIR_ROOTS_ORDER_HPP
+
+#include "HairProperties.hpp"
+#include "HairShape/Generators/UVPointGenerator.hpp"
+#include "HairShape/Mesh/Mesh.hpp"
+#include "HairShape/Mesh/UVPoint.hpp"
+
+namespace Stubble
+{
+
+namespace HairShape
+{
+
+namespace Interpolation
+{
+
+///-------------------------------------------------------------------------------------------------
+/// Orders roots of hair in voxel along space filling curve ( Morton or Hilbert curve ) over UV space
+/// or rest pose positions. Consecutive hair then lie close to each other, so they use the same
+/// guides, triangles and texels, which stay in caches.
+/// Roots are first generated in usual order, then their keys are quantized over bounds of all roots
+/// and sorted by curve code ( ties are broken by generation order ). Hair index k of voxel then
+/// belongs to k-th root in curve order, so random streams of hair stay deterministic. Order depends
+/// only on roots and rest pose mesh, so Maya and renderer generate the same hair.
+///-------------------------------------------------------------------------------------------------
+class HairRootsOrder
+{
+public:
+
+	///-------------------------------------------------------------------------------------------------
+	/// Generates roots of hair in voxel in order selected by hair properties. Random generator used
+	/// by uv point generator must be reset before.
+	///
+	/// \param	aHairProperties				The hair properties.
+	/// \param [in,out]	aUVPointGenerator	The uv point generator.
+	/// \param	aRestPoseMesh				The rest pose mesh.
+	/// \param	aHairStartIndex				Index of the first hair.
+	/// \param	aHairCount					Number of the hair.
+	/// \param [in,out]	aRoots				The ordered roots ( aHairCount roots ).
+	///-------------------------------------------------------------------------------------------------
+	static void generateRoots( const HairProperties & aHairProperties, UVPointGenerator & aUVPointGenerator,
+		const Mesh & aRestPoseMesh, unsigned __int64 aHairStartIndex, unsigned __int32 aHairCount,
+		UVPoint * aRoots );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Query if roots of hair are ordered by space filling curve.
+	///
+	/// \param	aHairProperties	The hair properties.
+	///
+	/// \return	true if roots are not processed in order of generation.
+	///-------------------------------------------------------------------------------------------------
+	inline static bool isOrdered( const HairProperties & aHairProperties );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Calculates Morton code of two dimensional cell.
+	///
+	/// \param	aX	The x coordinate of cell ( BITS_2D bits ).
+	/// \param	aY	The y coordinate of cell ( BITS_2D bits ).
+	///
+	/// \return	The Morton code.
+	///-------------------------------------------------------------------------------------------------
+	inline static unsigned __int32 mortonCode( unsigned __int32 aX, unsigned __int32 aY );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Calculates Morton code of three dimensional cell.
+	///
+	/// \param	aX	The x coordinate of cell ( BITS_3D bits ).
+	/// \param	aY	The y coordinate of cell ( BITS_3D bits ).
+	/// \param	aZ	The z coordinate of cell ( BITS_3D bits ).
+	///
+	/// \return	The Morton code.
+	///-------------------------------------------------------------------------------------------------
+	inline static unsigned __int32 mortonCode( unsigned __int32 aX, unsigned __int32 aY, unsigned __int32 aZ );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Calculates distance of two dimensional cell along Hilbert curve.
+	///
+	/// \param	aX	The x coordinate of cell ( BITS_2D bits ).
+	/// \param	aY	The y coordinate of cell ( BITS_2D bits ).
+	///
+	/// \return	The Hilbert code.
+	///-------------------------------------------------------------------------------------------------
+	inline static unsigned __int32 hilbertCode( unsigned __int32 aX, unsigned __int32 aY );
+
+	static const unsigned __int32 BITS_2D = 16; ///< Number of bits of cell coordinate in UV space
+
+	static const unsigned __int32 BITS_3D = 10; ///< Number of bits of cell coordinate in 3D space
+
+private:
+
+	///-------------------------------------------------------------------------------------------------
+	/// Inserts one zero bit after every of lower 16 bits.
+	///
+	/// \param	aValue	The value.
+	///
+	/// \return	The spread value.
+	///-------------------------------------------------------------------------------------------------
+	inline static unsigned __int32 spreadBits2( unsigned __int32 aValue );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Inserts two zero bits after every of lower 10 bits.
+	///
+	/// \param	aValue	The value.
+	///
+	/// \return	The spread value.
+	///-------------------------------------------------------------------------------------------------
+	inline static unsigned __int32 spreadBits3( unsigned __int32 aValue );
+};
+
+// inline functions implementation
+
+inline bool HairRootsOrder::isOrdered( const HairProperties & aHairProperties )
+{
+	return aHairProperties.getRootsOrder() != HairProperties::ROOTS_GENERATION_ORDER;
+}
+
+inline unsigned __int32 HairRootsOrder::mortonCode( unsigned __int32 aX, unsigned __int32 aY )
+{
+	return spreadBits2( aX ) | ( spreadBits2( aY ) << 1 );
+}
+
+inline unsigned __int32 HairRootsOrder::mortonCode( unsigned __int32 aX, unsigned __int32 aY, unsigned __int32 aZ )
+{
+	return spreadBits3( aX ) | ( spreadBits3( aY ) << 1 ) | ( spreadBits3( aZ ) << 2 );
+}
+
+inline unsigned __int32 HairRootsOrder::hilbertCode( unsigned __int32 aX, unsigned __int32 aY )
+{
+	static const unsigned __int32 MAX_CELL = ( 1u << BITS_2D ) - 1;
+	unsigned __int32 code = 0;
+	for ( unsigned __int32 s = 1u << ( BITS_2D - 1 ); s > 0; s >>= 1 )
+	{
+		const unsigned __int32 rx = ( aX & s ) != 0 ? 1 : 0;
+		const unsigned __int32 ry = ( aY & s ) != 0 ? 1 : 0;
+		code += s * s * ( ( 3 * rx ) ^ ry );
+		// Rotate quadrant, so the curve continues in lower bits
+		if ( ry == 0 )
+		{
+			if ( rx == 1 )
+			{
+				aX = MAX_CELL - aX;
+				aY = MAX_CELL - aY;
+			}
+			const unsigned __int32 tmp = aX;
+			aX = aY;
+			aY = tmp;
+		}
+	}
+	return code;
+}
+
+inline unsigned __int32 HairRootsOrder::spreadBits2( unsigned __int32 aValue )
+{
+	aValue &= 0x0000ffff;
+	aValue = ( aValue | ( aValue << 8 ) ) & 0x00ff00ff;
+	aValue = ( aValue | ( aValue << 4 ) ) & 0x0f0f0f0f;
+	aValue = ( aValue | ( aValue << 2 ) ) & 0x33333333;
+	aValue = ( aValue | ( aValue << 1 ) ) & 0x55555555;
+	return aValue;
+}
+
+inline unsigned __int32 HairRootsOrder::spreadBits3( unsigned __int32 aValue )
+{
+	aValue &= 0x000003ff;
+	aValue = ( aValue | ( aValue << 16 ) ) & 0xff0000ff;
+	aValue = ( aValue | ( aValue << 8 ) ) & 0x0300f00f;
+	aValue = ( aValue | ( aValue << 4 ) ) & 0x030c30c3;
+	aValue = ( aValue | ( aValue << 2 ) ) & 0x09249249;
+	return aValue;
+}
+
+} // namespace Interpolation
+
+} // namespace HairShape
+
+} // namespace Stubble
+
+#endif // STUBBLE_HAIR_ROOTS_ORDER_HPP
@@ -9,9 +9,6 @@
 #include "MayaPositionGenerator.hpp"
 
 #include <vector>
-#ifdef _OPENMP
-#include <omp.h>
-#endif
 
 namespace Stubble
 {
@@ -29,7 +26,7 @@ namespace Maya
 /// Class for generating and displaying interpolated hair inside Maya.
 /// Positions of hair are generated by this class and then send to MayaPositionGenerator which
 /// propagates them to HairGenerator then MayaOutputGenerator is used for drawing.
-/// Generation of hair is done in multiple threads.
+/// Generation of hair is done in multiple threads ( see HairGenerator::generateParallel ).
 ///-------------------------------------------------------------------------------------------------
 class InterpolatedHair
 {
@@ -37,7 +34,6 @@ public:
 
 	///-------------------------------------------------------------------------------------------------
 	/// Default constructor. 
-	/// Inits internal data structures for each computation thread.
 	///-------------------------------------------------------------------------------------------------
 	inline InterpolatedHair();
 
@@ -49,7 +45,7 @@ public:
 	///-------------------------------------------------------------------------------------------------
 	/// Generates interpolated hair. 
 	/// Generates hair positions on mesh using aUVPointGenerator, calculates positions on current and
-	/// rest pose mesh and finally splits hair equaly among threads and execute parallel hair generation.
+	/// rest pose mesh and finally executes parallel hair generation.
 	///
 	/// \param [in,out]	aUVPointGenerator	The uv point generator. 
 	/// \param	aCurrentMesh				The current mesh. 
@@ -86,31 +82,11 @@ public:
 
 private:
 
-	///-------------------------------------------------------------------------------------------------
-	/// Data of hair interpolated by one thread.
-	/// Stores generated positions of hair, hair count, generator and final outputer of hair.
-	///-------------------------------------------------------------------------------------------------
-	class ThreadData
-	{
-	public:
-
-		///-------------------------------------------------------------------------------------------------
-		/// Default constructor. 
-		///-------------------------------------------------------------------------------------------------
-		inline ThreadData();
-
-		MayaPositionGenerator mPositionGenerator;   ///< The hair position generator
-
-		MayaOutputGenerator mOutputGenerator;   ///< The output hair generator
-
-		HairGenerator< MayaPositionGenerator, MayaOutputGenerator > mHairGenerator; ///< The hair generator
-	};
+	MayaPositionGenerator mPositionGenerator;   ///< The hair position generator
 
-	ThreadData * mThreads;  ///< The threads data
+	MayaOutputGenerator mOutputGenerator;   ///< The output hair generator
 
-	ThreadData * mThreadsEnd;   ///< The threads array end pointer
-
-	unsigned __int32 mThreadsCount; ///< Number of threads
+	HairGenerator< MayaPositionGenerator, MayaOutputGenerator > mHairGenerator; ///< The hair generator
 
 	MayaPositionGenerator::GeneratedPosition * mGeneratedPositions; ///< The generated hair positions for all threads
 
@@ -122,23 +98,15 @@ private:
 // inline functions implementation
 
 inline InterpolatedHair::InterpolatedHair():
+	mHairGenerator( mPositionGenerator, mOutputGenerator ),
 	mGeneratedPositions( 0 ),
-	mAllocatedHairCount( 0 ),
-	mThreadsCount( 
-	#ifdef _OPENMP
-		omp_get_max_threads()
-	#else
-		1
-	#endif
-	)
+	mHairCount( 0 ),
+	mAllocatedHairCount( 0 )
 {
-	mThreads = new ThreadData[ mThreadsCount ];
-	mThreadsEnd = mThreads + mThreadsCount;
 }
 
 inline InterpolatedHair::~InterpolatedHair()
 {
-	delete [] mThreads;
 	delete [] mGeneratedPositions;
 }
 
@@ -169,21 +137,8 @@ inline void InterpolatedHair::generate( UVPointGenerator & aUVPointGenerator, co
 	}
 	// Copy new hair count
 	mHairCount = aCount;
-	// Calculate number of hair per thread
-	unsigned __int32 aCountPerThread = ( mHairCount / mThreadsCount ) + ( mHairCount % mThreadsCount );
-	MayaPositionGenerator::GeneratedPosition * current = mGeneratedPositions, * end = mGeneratedPositions + aCount;
-	// For every thread - single threaded
-	for ( ThreadData * it = mThreads; it != mThreadsEnd; ++it )
-	{
-		// Next block start
-		MayaPositionGenerator::GeneratedPosition * next = current + aCountPerThread;
-		next = next > end ? end : next;
-		// Sets hair positions start and hair count
-		it->mPositionGenerator.set( current, static_cast< unsigned __int32 >( next - current ), 
-			static_cast< unsigned __int32 >( current - mGeneratedPositions ) );
-		// Move to next block of positions
-		current = next;
-	}
+	// Sets hair positions start and hair count
+	mPositionGenerator.set( mGeneratedPositions, mHairCount, 0 );
 	// Generate hair
 	propertiesUpdate( aHairProperties);
 }
@@ -202,38 +157,22 @@ inline void InterpolatedHair::meshUpdate( const MayaMesh & aCurrentMesh, const H
 
 inline void InterpolatedHair::propertiesUpdate( const HairProperties & aHairProperties )
 {
-	// For every thread - multi threaded
-	#ifdef _OPENMP
-    #pragma omp parallel for
-    #endif
-	for ( int i = 0; i < static_cast< int >( mThreadsCount ); ++i )
+	if ( mPositionGenerator.getHairCount() > 0 )
 	{
-		ThreadData * it = mThreads + i;
-		if ( it->mPositionGenerator.getHairCount() > 0 )
-		{
-			it->mPositionGenerator.reset();
-			it->mHairGenerator.generate( aHairProperties );
-		}
+		mPositionGenerator.reset();
+		// Multi threaded, but same hair as if generated sequentially
+		mHairGenerator.generateParallel( aHairProperties );
 	}
 }
 
 inline void InterpolatedHair::draw()
 {
-	// For every thread - single threaded
-	for ( ThreadData * it = mThreads; it != mThreadsEnd; ++it )
+	if ( mPositionGenerator.getHairCount() > 0 )
 	{
-		if ( it->mPositionGenerator.getHairCount() > 0 )
-		{
-			it->mOutputGenerator.draw();
-		}
+		mOutputGenerator.draw();
 	}
 }
 
-inline InterpolatedHair::ThreadData::ThreadData():
-	mHairGenerator( mPositionGenerator, mOutputGenerator )
-{
-}
-
 } // namespace Maya
 
 } // namespace Interpolation
@@ -26,6 +26,7 @@ MObject MayaHairProperties::segmentsCountAttr; ///< The segments count attribute
 MObject MayaHairProperties::interpolationGroupsSelectableAttr; ///< The interpolation groups selectable attribute
 MObject MayaHairProperties::interpolationGroupsColorsAttr;   ///< The interpolation groups colors attribute
 MObject MayaHairProperties::numberOfGuidesToInterpolateFromAttr; ///< Number of guides to interpolate from attribute
+MObject MayaHairProperties::isGuidesTriangulationUsedAttr; ///< The is guides triangulation used attribute
 MObject MayaHairProperties::areNormalsCalculatedAttr;	///< The are normals calculated attribute
 MObject MayaHairProperties::scaleTextureAttr;	///< The scale texture attribute
 MObject MayaHairProperties::scaleAttr;   ///< The scale attribute
@@ -101,6 +102,18 @@ MObject MayaHairProperties::aspectTextureAttr;	///< The aspect texture attribute
 MObject MayaHairProperties::aspectAttr;	///< The aspect attribute
 MObject MayaHairProperties::randomizeStrandTextureAttr;	///< The randomizeStrand texture attribute
 MObject MayaHairProperties::randomizeStrandAttr;	///< The randomizeStrand attribute
+MObject MayaHairProperties::isRandomCounterBasedAttr;	///< The is random counter based attribute
+MObject MayaHairProperties::randomSeedAttr;	///< The random seed attribute
+MObject MayaHairProperties::rootsOrderAttr;	///< The roots order attribute
+MObject MayaHairProperties::isLevelOfDetailUsedAttr;	///< The is level of detail used attribute
+MObject MayaHairProperties::lodFullDetailSizeAttr;	///< The level of detail full detail size attribute
+MObject MayaHairProperties::lodMinimumHairRatioAttr;	///< The level of detail minimum hair ratio attribute
+MObject MayaHairProperties::lodMinimumSegmentsRatioAttr;	///< The level of detail minimum segments ratio attribute
+MObject MayaHairProperties::decimationToleranceAttr;	///< The decimation tolerance attribute
+MObject MayaHairProperties::isDecimationInScreenSpaceAttr;	///< The is decimation in screen space attribute
+MObject MayaHairProperties::commitSizeAttr;	///< The commit size attribute
+MObject MayaHairProperties::maxProceduralCommitsCountAttr;	///< The maximal procedural commits count attribute
+MObject MayaHairProperties::maxProceduralChildrenCountAttr;	///< The maximal procedural children count attribute
 /* TEXTURE DIMENSIONS FOR SAMPLING ATTRIBUTES */
 /// The density texture sampling dimesion in U attribute
 MObject MayaHairProperties::densityTextureSamplingUDimensionAttr;
@@ -249,107 +262,142 @@ MObject MayaHairProperties::randomizeStrandTextureSamplingVDimensionAttr;
 
 /* METHODS */
 
-void MayaHairProperties::exportToFile( std::ostream & aOutputStream ) const
+void MayaHairProperties::exportToFile( SectionedFileWriter & aFrameFile ) const
 {	
-	// Export textures
-	mDensityTexture->exportToFile( aOutputStream );
-	mInterpolationGroupsTexture->exportToFile( aOutputStream );
-	mCutTexture->exportToFile( aOutputStream );
-	mScaleTexture->exportToFile( aOutputStream );
-	mRandScaleTexture->exportToFile( aOutputStream );
-	mRootThicknessTexture->exportToFile( aOutputStream );
-	mTipThicknessTexture->exportToFile( aOutputStream );
-	mDisplacementTexture->exportToFile( aOutputStream );
-	mRootOpacityTexture->exportToFile( aOutputStream );
-	mTipOpacityTexture->exportToFile( aOutputStream );
-	mRootColorTexture->exportToFile( aOutputStream );
-	mTipColorTexture->exportToFile( aOutputStream );
-	mHueVariationTexture->exportToFile( aOutputStream );
-	mValueVariationTexture->exportToFile( aOutputStream );
-	mMutantHairColorTexture->exportToFile( aOutputStream );
-	mPercentMutantHairTexture->exportToFile( aOutputStream );
-	mRootFrizzTexture->exportToFile( aOutputStream );
-	mTipFrizzTexture->exportToFile( aOutputStream );
-	mFrizzXFrequencyTexture->exportToFile( aOutputStream );
-	mFrizzYFrequencyTexture->exportToFile( aOutputStream );
-	mFrizzZFrequencyTexture->exportToFile( aOutputStream );
-	mFrizzAnimTexture->exportToFile( aOutputStream );
-	mFrizzAnimSpeedTexture->exportToFile( aOutputStream );
-	mRootKinkTexture->exportToFile( aOutputStream );
-	mTipKinkTexture->exportToFile( aOutputStream );
-	mKinkXFrequencyTexture->exportToFile( aOutputStream );
-	mKinkYFrequencyTexture->exportToFile( aOutputStream );
-	mKinkZFrequencyTexture->exportToFile( aOutputStream );
-	mRootSplayTexture->exportToFile( aOutputStream );
-	mTipSplayTexture->exportToFile( aOutputStream );
-	mCenterSplayTexture->exportToFile( aOutputStream );
-	mTwistTexture->exportToFile( aOutputStream );
-	mOffsetTexture->exportToFile( aOutputStream );
-	mAspectTexture->exportToFile( aOutputStream );
-	mRandomizeStrandTexture->exportToFile( aOutputStream );
+	// Export textures ( uncompressed, so the renderer can use them in place )
+	std::ostream & textures = aFrameFile.beginSection( TEXTURES_SECTION, false );
+	mDensityTexture->exportAlignedToFile( textures );
+	mInterpolationGroupsTexture->exportAlignedToFile( textures );
+	mCutTexture->exportAlignedToFile( textures );
+	mScaleTexture->exportAlignedToFile( textures );
+	mRandScaleTexture->exportAlignedToFile( textures );
+	mRootThicknessTexture->exportAlignedToFile( textures );
+	mTipThicknessTexture->exportAlignedToFile( textures );
+	mDisplacementTexture->exportAlignedToFile( textures );
+	mRootOpacityTexture->exportAlignedToFile( textures );
+	mTipOpacityTexture->exportAlignedToFile( textures );
+	mRootColorTexture->exportAlignedToFile( textures );
+	mTipColorTexture->exportAlignedToFile( textures );
+	mHueVariationTexture->exportAlignedToFile( textures );
+	mValueVariationTexture->exportAlignedToFile( textures );
+	mMutantHairColorTexture->exportAlignedToFile( textures );
+	mPercentMutantHairTexture->exportAlignedToFile( textures );
+	mRootFrizzTexture->exportAlignedToFile( textures );
+	mTipFrizzTexture->exportAlignedToFile( textures );
+	mFrizzXFrequencyTexture->exportAlignedToFile( textures );
+	mFrizzYFrequencyTexture->exportAlignedToFile( textures );
+	mFrizzZFrequencyTexture->exportAlignedToFile( textures );
+	mFrizzAnimTexture->exportAlignedToFile( textures );
+	mFrizzAnimSpeedTexture->exportAlignedToFile( textures );
+	mRootKinkTexture->exportAlignedToFile( textures );
+	mTipKinkTexture->exportAlignedToFile( textures );
+	mKinkXFrequencyTexture->exportAlignedToFile( textures );
+	mKinkYFrequencyTexture->exportAlignedToFile( textures );
+	mKinkZFrequencyTexture->exportAlignedToFile( textures );
+	mRootSplayTexture->exportAlignedToFile( textures );
+	mTipSplayTexture->exportAlignedToFile( textures );
+	mCenterSplayTexture->exportAlignedToFile( textures );
+	mTwistTexture->exportAlignedToFile( textures );
+	mOffsetTexture->exportAlignedToFile( textures );
+	mAspectTexture->exportAlignedToFile( textures );
+	mRandomizeStrandTexture->exportAlignedToFile( textures );
+	aFrameFile.endSection();
 	// Write segments count
-	mInterpolationGroups->exportSegmentsCountToFile( aOutputStream );
+	mInterpolationGroups->exportSegmentsCountToFile( aFrameFile.beginSection( INTERPOLATION_GROUPS_SECTION, true ) );
+	aFrameFile.endSection();
 	// Write non-texture hair properties
-	aOutputStream.write( reinterpret_cast< const char * >( & mCurrentTime ), sizeof( Time ) );	
-	aOutputStream.write( reinterpret_cast< const char * >( & mScale ), sizeof( Real ) );	
-	aOutputStream.write( reinterpret_cast< const char * >( & mRandScale ), sizeof( Real ) );	
-	aOutputStream.write( reinterpret_cast< const char * >( & mRootThickness ), sizeof( Real ) );	
-	aOutputStream.write( reinterpret_cast< const char * >( & mTipThickness ), sizeof( Real ) );	
-	aOutputStream.write( reinterpret_cast< const char * >( & mDisplacement ), sizeof( Real ) );	
-	aOutputStream.write( reinterpret_cast< const char * >( & mSkipThreshold ), sizeof( Real ) );
-	aOutputStream.write( reinterpret_cast< const char * >( & mRootOpacity ), sizeof( Real ) );	
-	aOutputStream.write( reinterpret_cast< const char * >( & mTipOpacity ), sizeof( Real ) );	
-	aOutputStream.write( reinterpret_cast< const char * >( mRootColor ), 3 * sizeof( Real ) );	
-	aOutputStream.write( reinterpret_cast< const char * >( mTipColor ), 3 * sizeof( Real ) );	
-	aOutputStream.write( reinterpret_cast< const char * >( & mHueVariation ), sizeof( Real ) );	
-	aOutputStream.write( reinterpret_cast< const char * >( & mValueVariation ), sizeof( Real ) );	
-	aOutputStream.write( reinterpret_cast< const char * >( mMutantHairColor ), 3 * sizeof( Real ) );	
-	aOutputStream.write( reinterpret_cast< const char * >( & mPercentMutantHair ), sizeof( Real ) );
-	aOutputStream.write( reinterpret_cast< const char * >( & mRootFrizz ), sizeof( Real ) );	
-	aOutputStream.write( reinterpret_cast< const char * >( & mTipFrizz ), sizeof( Real ) );	
-	aOutputStream.write( reinterpret_cast< const char * >( & mFrizzXFrequency ), sizeof( Real ) );	
-	aOutputStream.write( reinterpret_cast< const char * >( & mFrizzYFrequency ), sizeof( Real ) );	
-	aOutputStream.write( reinterpret_cast< const char * >( & mFrizzZFrequency ), sizeof( Real ) );	
-	aOutputStream.write( reinterpret_cast< const char * >( & mFrizzAnim ), sizeof( Real ) );	
-	aOutputStream.write( reinterpret_cast< const char * >( & mFrizzAnimSpeed ), sizeof( Real ) );	
-	aOutputStream << mFrizzAnimDirection;
-	aOutputStream.write( reinterpret_cast< const char * >( & mRootKink ), sizeof( Real ) );	
-	aOutputStream.write( reinterpret_cast< const char * >( & mTipKink ), sizeof( Real ) );	
-	aOutputStream.write( reinterpret_cast< const char * >( & mKinkXFrequency ), sizeof( Real ) );	
-	aOutputStream.write( reinterpret_cast< const char * >( & mKinkYFrequency ), sizeof( Real ) );	
-	aOutputStream.write( reinterpret_cast< const char * >( & mKinkZFrequency ), sizeof( Real ) );	
-	aOutputStream.write( reinterpret_cast< const char * >( & mMultiStrandCount ), sizeof( unsigned __int32 ) );	
-	aOutputStream.write( reinterpret_cast< const char * >( & mRootSplay ), sizeof( Real ) );	
-	aOutputStream.write( reinterpret_cast< const char * >( & mTipSplay ), sizeof( Real ) );	
-	aOutputStream.write( reinterpret_cast< const char * >( & mCenterSplay ), sizeof( Real ) );	
-	aOutputStream.write( reinterpret_cast< const char * >( & mTwist ), sizeof( Real ) );	
-	aOutputStream.write( reinterpret_cast< const char * >( & mOffset ), sizeof( Real ) );	
-	aOutputStream.write( reinterpret_cast< const char * >( & mAspect ), sizeof( Real ) );	
-	aOutputStream.write( reinterpret_cast< const char * >( & mRandomizeStrand ), sizeof( Real ) );
+	std::ostream & properties = aFrameFile.beginSection( SCALAR_PROPERTIES_SECTION, true );
+	properties.write( reinterpret_cast< const char * >( & SCALAR_PROPERTIES_VERSION ), sizeof( unsigned __int32 ) );
+	properties.write( reinterpret_cast< const char * >( & mCurrentTime ), sizeof( Time ) );	
+	properties.write( reinterpret_cast< const char * >( & mScale ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mRandScale ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mRootThickness ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mTipThickness ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mDisplacement ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mSkipThreshold ), sizeof( Real ) );
+	properties.write( reinterpret_cast< const char * >( & mRootOpacity ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mTipOpacity ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( mRootColor ), 3 * sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( mTipColor ), 3 * sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mHueVariation ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mValueVariation ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( mMutantHairColor ), 3 * sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mPercentMutantHair ), sizeof( Real ) );
+	properties.write( reinterpret_cast< const char * >( & mRootFrizz ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mTipFrizz ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mFrizzXFrequency ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mFrizzYFrequency ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mFrizzZFrequency ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mFrizzAnim ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mFrizzAnimSpeed ), sizeof( Real ) );	
+	properties << mFrizzAnimDirection;
+	properties.write( reinterpret_cast< const char * >( & mRootKink ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mTipKink ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mKinkXFrequency ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mKinkYFrequency ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mKinkZFrequency ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mMultiStrandCount ), sizeof( unsigned __int32 ) );	
+	properties.write( reinterpret_cast< const char * >( & mRootSplay ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mTipSplay ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mCenterSplay ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mTwist ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mOffset ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mAspect ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mRandomizeStrand ), sizeof( Real ) );
+	properties.write( reinterpret_cast< const char * >( & mIsRandomCounterBased ), sizeof( bool ) );
+	properties.write( reinterpret_cast< const char * >( & mRandomSeed ), sizeof( unsigned __int32 ) );
+	properties.write( reinterpret_cast< const char * >( & mIsLevelOfDetailUsed ), sizeof( bool ) );
+	properties.write( reinterpret_cast< const char * >( & mLodFullDetailSize ), sizeof( Real ) );
+	properties.write( reinterpret_cast< const char * >( & mLodMinimumHairRatio ), sizeof( Real ) );
+	properties.write( reinterpret_cast< const char * >( & mLodMinimumSegmentsRatio ), sizeof( Real ) );
+	properties.write( reinterpret_cast< const char * >( & mDecimationTolerance ), sizeof( Real ) );
+	properties.write( reinterpret_cast< const char * >( & mIsDecimationInScreenSpace ), sizeof( bool ) );
+	properties.write( reinterpret_cast< const char * >( & mRootsOrder ), sizeof( unsigned __int32 ) );
+	properties.write( reinterpret_cast< const char * >( & mCommitSize ), sizeof( unsigned __int32 ) );
 	// Write number of guides to interpolate from
-	aOutputStream.write( reinterpret_cast< const char * >( &mNumberOfGuidesToInterpolateFrom ), 
+	properties.write( reinterpret_cast< const char * >( &mNumberOfGuidesToInterpolateFrom ), 
 		sizeof( unsigned __int32 ) );
+	// Write whether the guides triangulation is used
+	properties.write( reinterpret_cast< const char * >( &mIsGuidesTriangulationUsed ), 
+		sizeof( bool ) );
 	// Write whether the normals should be calculated 
-	aOutputStream.write( reinterpret_cast< const char * >( &mAreNormalsCalculated ), 
+	properties.write( reinterpret_cast< const char * >( &mAreNormalsCalculated ), 
 		sizeof( bool ) );
+	// Write limits of procedural split
+	properties.write( reinterpret_cast< const char * >( & mMaxProceduralCommitsCount ), sizeof( unsigned __int32 ) );
+	properties.write( reinterpret_cast< const char * >( & mMaxProceduralChildrenCount ), sizeof( unsigned __int32 ) );
+	aFrameFile.endSection();
 	// Write rest positions of guides
-	mGuidesRestPositionsDS->exportToFile( aOutputStream );
+	mGuidesRestPositionsDS->exportToFile( aFrameFile.beginSection( REST_POSITIONS_SECTION, true ) );
+	aFrameFile.endSection();
+	// Write already built KD trees of rest positions, so the renderer does not have to rebuild them
+	mGuidesRestPositionsDS->exportKdForestToFile( aFrameFile.beginSection( KD_FOREST_SECTION, true ) );
+	aFrameFile.endSection();
+	// Export guides segments ( uncompressed, so the renderer can copy them at once )
+	std::ostream & segments = aFrameFile.beginSection( GUIDES_SEGMENTS_SECTION, false );
 	// Export guides count
 	unsigned __int32 size = static_cast< unsigned __int32 >( mGuidesSegments->size() );
-	aOutputStream.write( reinterpret_cast< const char *>( &size ), sizeof( unsigned __int32 ) );
-	// For each guide
+	segments.write( reinterpret_cast< const char *>( &size ), sizeof( unsigned __int32 ) );
+	// Export vertices count of every guide
 	for ( HairComponents::GuidesSegments::const_iterator it = mGuidesSegments->begin(); 
 		it != mGuidesSegments->end(); ++it )
 	{
-		// Export vertices count
 		size = static_cast< unsigned __int32 >( it->mSegments.size() );
-		aOutputStream.write( reinterpret_cast< const char *>( &size ), sizeof( unsigned __int32 ) );
-		// For each hair vertex
-		for ( HairComponents::Segments::const_iterator segIt = it->mSegments.begin(); segIt != it->mSegments.end(); ++segIt )
+		segments.write( reinterpret_cast< const char *>( &size ), sizeof( unsigned __int32 ) );
+	}
+	SectionedFileWriter::writePadding( segments, ( mGuidesSegments->size() + 1 ) * sizeof( unsigned __int32 ),
+		SectionedFileWriter::SECTION_ALIGNMENT );
+	// Export vertices of all guides as one array
+	for ( HairComponents::GuidesSegments::const_iterator it = mGuidesSegments->begin(); 
+		it != mGuidesSegments->end(); ++it )
+	{
+		if ( !it->mSegments.empty() )
 		{
-			aOutputStream << *segIt;
+			segments.write( reinterpret_cast< const char *>( &it->mSegments[ 0 ] ), 
+				it->mSegments.size() * sizeof( Vector3D< Real > ) );
 		}
 	}
+	aFrameFile.endSection();
 }
 
 MayaHairProperties::MayaHairProperties():
@@ -466,6 +514,7 @@ MayaHairProperties::MayaHairProperties():
 	mOffsetTexture = new Texture( 1 );
 	mAspectTexture = new Texture( 1 );
 	mRandomizeStrandTexture = new Texture( 1 );
+	updateAttributeAtlas();
 }
 
 MStatus MayaHairProperties::initializeAttributes()
@@ -481,6 +530,7 @@ MStatus MayaHairProperties::initializeAttributes()
 		addFloatAttribute( "density_texture", "dtxt", densityTextureAttr, 1, 0, 1, 0, 1 );
 		addColorAttribute( "interpolation_groups_texture", "itxt", interpolationGroupsTextureAttr, 1, 1, 1 );
 		addIntAttribute( "interpolation_samples", "ints", numberOfGuidesToInterpolateFromAttr, 3, 3, 20, 3, 20 );
+		addBoolAttribute( "guides_triangulation", "gdtri", isGuidesTriangulationUsedAttr, false );
 		addFloatAttribute( "cut_texture", "ctxt", cutTextureAttr, 1, 0, 1, 0, 1 );
 		addBoolAttribute( "calculate_normals", "clcn", areNormalsCalculatedAttr, false );
 		addFloatAttribute( "scale_texture", "scltxt", scaleTextureAttr, 1, 0, 1, 0, 1 );
@@ -561,6 +611,24 @@ MStatus MayaHairProperties::initializeAttributes()
 		addFloatAttribute( "aspect", "asp", aspectAttr, 1, 0, float_max, 0, 5 );
 		addFloatAttribute( "randomize_strand_texture", "rstrtxt", randomizeStrandTextureAttr, 1, 0, 1, 0, 1 );
 		addFloatAttribute( "randomize_strand", "rstr", randomizeStrandAttr, 0, 0, 1, 0, 1 );
+		/* RANDOM GENERATOR PROPERTIES */
+		addBoolAttribute( "counter_based_random", "cbrnd", isRandomCounterBasedAttr, false );
+		addIntAttribute( "random_seed", "rndsd", randomSeedAttr, 0, 0, int_max, 0, 1000 );
+		/* ROOTS ORDER PROPERTIES */
+		addIntAttribute( "roots_order", "rtord", rootsOrderAttr, 0, 0, ROOTS_ORDERS_COUNT - 1, 0, 
+			ROOTS_ORDERS_COUNT - 1 );
+		/* LEVEL OF DETAIL PROPERTIES */
+		addBoolAttribute( "level_of_detail", "lod", isLevelOfDetailUsedAttr, false );
+		addFloatAttribute( "lod_full_detail_size", "lodfds", lodFullDetailSizeAttr, 10000, 1, float_max, 100, 100000 );
+		addFloatAttribute( "lod_minimum_hair_ratio", "lodmhr", lodMinimumHairRatioAttr, 0.05f, 0.001f, 1, 0.001f, 1 );
+		addFloatAttribute( "lod_minimum_segments_ratio", "lodmsr", lodMinimumSegmentsRatioAttr, 0.25f, 0, 1, 0, 1 );
+		/* DECIMATION PROPERTIES */
+		addFloatAttribute( "decimation_tolerance", "dctol", decimationToleranceAttr, 0, 0, float_max, 0, 1 );
+		addBoolAttribute( "decimation_in_screen_space", "dcscr", isDecimationInScreenSpaceAttr, false );
+		/* RENDERER PROPERTIES */
+		addIntAttribute( "commit_size", "cmtsz", commitSizeAttr, 1000000, 1000, int_max, 100000, 10000000 );
+		addIntAttribute( "procedural_commits_count", "prccmt", maxProceduralCommitsCountAttr, 4, 1, int_max, 1, 64 );
+		addIntAttribute( "procedural_children_count", "prcchd", maxProceduralChildrenCountAttr, 16, 2, int_max, 2, 256 );
 		/* TEXTURE DIMENSIONS FOR SAMPLING ATTRIBUTES */
 		addIntAttribute( "density_texture_sampling_u_dimension", "dtxtsmpludm",
 			densityTextureSamplingUDimensionAttr, 128, 1, 4096, 32, 1024);
@@ -767,6 +835,12 @@ bool MayaHairProperties::setAttributesValues( const MPlug& aPlug, const MDataHan
 		aHairPropertiesChanged = true;
 		return false;
 	}
+	if ( aPlug == isGuidesTriangulationUsedAttr )
+	{
+		mIsGuidesTriangulationUsed = aDataHandle.asBool();
+		aHairPropertiesChanged = true;
+		return false;
+	}
 	if ( aPlug == areNormalsCalculatedAttr )
 	{
 		mAreNormalsCalculated = aDataHandle.asBool();
@@ -995,6 +1069,78 @@ bool MayaHairProperties::setAttributesValues( const MPlug& aPlug, const MDataHan
 		mRandomizeStrandTexture->setConnection( aPlug );
 		return true;
 	}
+	if ( aPlug == isRandomCounterBasedAttr )
+	{
+		mIsRandomCounterBased = aDataHandle.asBool();
+		aHairPropertiesChanged = true;
+		return false;
+	}
+	if ( aPlug == randomSeedAttr )
+	{
+		mRandomSeed = static_cast< unsigned __int32 >( aDataHandle.asInt() );
+		aHairPropertiesChanged = true;
+		return false;
+	}
+	if ( aPlug == rootsOrderAttr )
+	{
+		mRootsOrder = static_cast< unsigned __int32 >( aDataHandle.asInt() );
+		aHairPropertiesChanged = true;
+		return false;
+	}
+	if ( aPlug == isLevelOfDetailUsedAttr )
+	{
+		mIsLevelOfDetailUsed = aDataHandle.asBool();
+		aHairPropertiesChanged = true;
+		return false;
+	}
+	if ( aPlug == lodFullDetailSizeAttr )
+	{
+		mLodFullDetailSize = static_cast< Real >( aDataHandle.asFloat() );
+		aHairPropertiesChanged = true;
+		return false;
+	}
+	if ( aPlug == lodMinimumHairRatioAttr )
+	{
+		mLodMinimumHairRatio = static_cast< Real >( aDataHandle.asFloat() );
+		aHairPropertiesChanged = true;
+		return false;
+	}
+	if ( aPlug == lodMinimumSegmentsRatioAttr )
+	{
+		mLodMinimumSegmentsRatio = static_cast< Real >( aDataHandle.asFloat() );
+		aHairPropertiesChanged = true;
+		return false;
+	}
+	if ( aPlug == decimationToleranceAttr )
+	{
+		mDecimationTolerance = static_cast< Real >( aDataHandle.asFloat() );
+		aHairPropertiesChanged = true;
+		return false;
+	}
+	if ( aPlug == isDecimationInScreenSpaceAttr )
+	{
+		mIsDecimationInScreenSpace = aDataHandle.asBool();
+		aHairPropertiesChanged = true;
+		return false;
+	}
+	if ( aPlug == commitSizeAttr )
+	{
+		mCommitSize = static_cast< unsigned __int32 >( aDataHandle.asInt() );
+		aHairPropertiesChanged = true;
+		return false;
+	}
+	if ( aPlug == maxProceduralCommitsCountAttr )
+	{
+		mMaxProceduralCommitsCount = static_cast< unsigned __int32 >( aDataHandle.asInt() );
+		aHairPropertiesChanged = true;
+		return false;
+	}
+	if ( aPlug == maxProceduralChildrenCountAttr )
+	{
+		mMaxProceduralChildrenCount = static_cast< unsigned __int32 >( aDataHandle.asInt() );
+		aHairPropertiesChanged = true;
+		return false;
+	}
 	if ( aPlug == randScaleAttr )
 	{
 		mRandScale = static_cast< Real >( aDataHandle.asFloat() );
@@ -2057,6 +2203,11 @@ void MayaHairProperties::refreshTextures( unsigned __int32 aTextureSamples, bool
 			mValueVariationTextureSamplingVDimension);
 		aHairPropertiesChanged = true;
 	}
+	// Rebuild atlas of all resampled per hair attributes
+	if ( aHairPropertiesChanged )
+	{
+		updateAttributeAtlas();
+	}
 }
 
 void MayaHairProperties::setCurrentTime( Time aTime )
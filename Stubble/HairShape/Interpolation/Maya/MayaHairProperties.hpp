@@ -2,6 +2,8 @@
 #define STUBBLE_MAYA_HAIR_PROPERTIES_HPP
 
 #include "../HairProperties.hpp"
+#include "Common/CommonConstants.hpp"
+#include "Common/SectionedFile.hpp"
 
 #include <ostream>
 
@@ -34,13 +36,13 @@ class MayaHairProperties : public HairProperties
 public:
 
 	///----------------------------------------------------------------------------------------------------
-	/// Export hair properties to file.
+	/// Export hair properties to sections of frame file.
 	/// This is necessary for rendering hair in for example render man ( RMHairProperties will import the
 	/// hair properties ).
 	///
-	/// \param [in,out]	aOutputStream	The file output stream. 
+	/// \param [in,out]	aFrameFile	The frame file writer. 
 	///----------------------------------------------------------------------------------------------------
-	void exportToFile( std::ostream & aOutputStream ) const;
+	void exportToFile( SectionedFileWriter & aFrameFile ) const;
 	
 	/* MAYA BASIC PROPERTIES */
 	static MObject densityTextureAttr; ///< The density texture attribute
@@ -57,6 +59,8 @@ public:
 
 	static MObject numberOfGuidesToInterpolateFromAttr; ///< Number of guides to interpolate from attribute
 
+	static MObject isGuidesTriangulationUsedAttr; ///< The is guides triangulation used attribute
+
 	static MObject areNormalsCalculatedAttr;	///< The are normals calculated attribute
 
 	static MObject scaleTextureAttr;	///< The scale texture attribute
@@ -207,6 +211,30 @@ public:
 
 	static MObject randomizeStrandAttr;	///< The randomizeStrand attribute
 
+	static MObject isRandomCounterBasedAttr;	///< The is random counter based attribute
+
+	static MObject randomSeedAttr;	///< The random seed attribute
+
+	static MObject rootsOrderAttr;	///< The roots order attribute
+
+	static MObject isLevelOfDetailUsedAttr;	///< The is level of detail used attribute
+
+	static MObject lodFullDetailSizeAttr;	///< The level of detail full detail size attribute
+
+	static MObject lodMinimumHairRatioAttr;	///< The level of detail minimum hair ratio attribute
+
+	static MObject lodMinimumSegmentsRatioAttr;	///< The level of detail minimum segments ratio attribute
+
+	static MObject decimationToleranceAttr;	///< The decimation tolerance attribute
+
+	static MObject isDecimationInScreenSpaceAttr;	///< The is decimation in screen space attribute
+
+	static MObject commitSizeAttr;	///< The commit size attribute
+
+	static MObject maxProceduralCommitsCountAttr;	///< The maximal procedural commits count attribute
+
+	static MObject maxProceduralChildrenCountAttr;	///< The maximal procedural children count attribute
+
 	/* TEXTURE DIMENSIONS FOR SAMPLING ATTRIBUTES */
 
 	/// The density texture sampling dimesion in U attribute
@@ -96,7 +96,7 @@ public:
 	/// \param	aMaxHairCount	Number of a maximum hair. 
 	/// \param	aMaxPointsCount	Number of a maximum points. 
 	///-------------------------------------------------------------------------------------------------
-	inline void beginOutput( unsigned __int32 aMaxHairCount, unsigned __int32 aMaxPointsCount );
+	inline void beginOutput( unsigned __int64 aMaxHairCount, unsigned __int32 aMaxPointsCount );
 
 	///----------------------------------------------------------------------------------------------------
 	/// Ends an output.
@@ -104,6 +104,13 @@ public:
 	///----------------------------------------------------------------------------------------------------
 	inline void endOutput();
 
+	///-------------------------------------------------------------------------------------------------
+	/// Query if normals are used. Normals are always used to build hair ribbons.
+	///
+	/// \return	true. 
+	///-------------------------------------------------------------------------------------------------
+	inline bool areNormalsUsed() const;
+
 	///-------------------------------------------------------------------------------------------------
 	/// Begins an output of single interpolated hair.
 	/// The upper estimate of points on hair must be known to make sure enough resources are be 
@@ -315,7 +322,7 @@ inline void MayaOutputGenerator::clear()
 	mIndexBO = 0;  
 }
 
-inline void MayaOutputGenerator::beginOutput( unsigned __int32 aMaxHairCount, unsigned __int32 aMaxPointsCount )
+inline void MayaOutputGenerator::beginOutput( unsigned __int64 aMaxHairCount, unsigned __int32 aMaxPointsCount )
 {
 	mDirty = true;
 	// Memory is not sufficient
@@ -327,11 +334,16 @@ inline void MayaOutputGenerator::beginOutput( unsigned __int32 aMaxHairCount, un
 			clear();
 			// Sets new limits
 			mMaxPointsCount = aMaxPointsCount;
-			mMaxHairCount = aMaxHairCount;
+			mMaxHairCount = narrowCount< unsigned __int32 >( aMaxHairCount );
+			//		2 vertices for each point, indexed by GLuint
+			const unsigned __int64 totalVerticesCount = multiplyCounts( multiplyCounts( aMaxHairCount, 
+				aMaxPointsCount ), 2 );
+			narrowCount< GLuint >( totalVerticesCount );
 			//		( XYZ + RGBA ) * totalPoints * 2 vertices for each point
-			unsigned __int32 verticesCount =  7 * mMaxHairCount * aMaxPointsCount * 2; 
+			const size_t verticesCount = narrowCount< size_t >( multiplyCounts( totalVerticesCount, 7 ) ); 
 			//		2 triangles for each hair segment
-			unsigned __int32 indicesCount = 6 * mMaxHairCount * ( aMaxPointsCount - 1 );	
+			const size_t indicesCount = narrowCount< size_t >( 
+				multiplyCounts( multiplyCounts( aMaxHairCount, aMaxPointsCount - 1 ), 6 ) );	
 			// Allocate sufficient memory for GL drawing
 			mVertices = new GLfloat[ verticesCount ];
 			mIndices = new GLuint[ indicesCount ];
@@ -362,6 +374,11 @@ inline void MayaOutputGenerator::endOutput()
 	/* EMPTY */
 }
 
+inline bool MayaOutputGenerator::areNormalsUsed() const
+{
+	return true;
+}
+
 inline void MayaOutputGenerator::beginHair( unsigned __int32 aMaxPointsCount )
 {
 	/* EMPTY */
@@ -86,7 +86,7 @@ public:
 	///
 	/// \return	The hair count. 
 	///-------------------------------------------------------------------------------------------------
-	inline unsigned __int32 getHairCount() const;
+	inline unsigned __int64 getHairCount() const;
 
 	///-------------------------------------------------------------------------------------------------
 	/// Gets the index of first hair which position is generated by this generator. 
@@ -94,7 +94,7 @@ public:
 	///
 	/// \return	The index of first hair which position is generated by this generator. 
 	///-------------------------------------------------------------------------------------------------
-	inline unsigned __int32 getHairStartIndex() const;
+	inline unsigned __int64 getHairStartIndex() const;
 
 	///-------------------------------------------------------------------------------------------------
 	/// Resets distributing generated values.
@@ -141,12 +141,12 @@ inline void MayaPositionGenerator::generate( MeshPoint & aCurrentPosition, MeshP
 	generate( aCurrentPosition, aRestPosition ); // Displacement will not be used
 }
 
-inline unsigned __int32 MayaPositionGenerator::getHairCount() const
+inline unsigned __int64 MayaPositionGenerator::getHairCount() const
 {
 	return mCount;
 }
 
-inline unsigned __int32 MayaPositionGenerator::getHairStartIndex() const
+inline unsigned __int64 MayaPositionGenerator::getHairStartIndex() const
 {
 	return static_cast< unsigned __int32 >( mCurrentPosition - mGeneratedPositions ) + mHairIndex;
 }
@@ -33,10 +33,12 @@ public:
 	/// \param [in,out]	aUVPointGenerator	The uv point generator. 
 	/// \param	aHairCount					Number of the hairs. 
 	/// \param	aHairStartIndex				Index of first hair.
+	/// \param	aRoots						The ordered roots of hair ( see HairRootsOrder ) or NULL if
+	/// 									roots are generated by uv point generator. 
 	///-------------------------------------------------------------------------------------------------
 	inline SimplePositionGenerator( const Mesh & aRestPoseMesh, const Mesh & aCurrentMesh,
-		UVPointGenerator & aUVPointGenerator, unsigned __int32 aHairCount,
-		unsigned __int32 aHairStartIndex );
+		UVPointGenerator & aUVPointGenerator, unsigned __int64 aHairCount,
+		unsigned __int64 aHairStartIndex, const UVPoint * aRoots = 0 );
 
 	///-------------------------------------------------------------------------------------------------
 	/// Finaliser. 
@@ -67,38 +69,51 @@ public:
 	///
 	/// \return	The hair count. 
 	///-------------------------------------------------------------------------------------------------
-	inline unsigned __int32 getHairCount() const;
+	inline unsigned __int64 getHairCount() const;
 	
 	///-------------------------------------------------------------------------------------------------
 	/// Gets the index of first hair which position is generated by this generator. 
 	///
 	/// \return	The index of first hair which position is generated by this generator. 
 	///-------------------------------------------------------------------------------------------------
-	inline unsigned __int32 getHairStartIndex() const;
+	inline unsigned __int64 getHairStartIndex() const;
 
 private:
 
+	///-------------------------------------------------------------------------------------------------
+	/// Generates position of next hair root on mesh.
+	///
+	/// \return	The position of next hair root. 
+	///-------------------------------------------------------------------------------------------------
+	inline UVPoint nextUVPoint();
+
 	const Mesh & mCurrentMesh;	///< The current mesh
 
 	const Mesh & mRestPoseMesh;   ///< The rest pose mesh
 
 	UVPointGenerator & mUVPointGenerator;   ///< The uv point generator
 
-	unsigned __int32 mHairCount;	///< Number of the interpolated hair.
+	const UVPoint * mRoots;	///< The ordered roots of hair ( NULL if roots are generated )
+
+	unsigned __int64 mHairCount;	///< Number of the interpolated hair.
 
-	unsigned __int32 mHairStartIndex;   ///< The start index of hair
+	unsigned __int64 mHairStartIndex;   ///< The start index of hair
+
+	unsigned __int64 mNextHairIndex;	///< The index of next generated hair
 };
 
 // inline functions implementation
 
 inline SimplePositionGenerator::SimplePositionGenerator( const Mesh & aRestPoseMesh, const Mesh & aCurrentMesh,
-	UVPointGenerator & aUVPointGenerator, unsigned __int32 aHairCount,
-	unsigned __int32 aHairStartIndex ):
+	UVPointGenerator & aUVPointGenerator, unsigned __int64 aHairCount,
+	unsigned __int64 aHairStartIndex, const UVPoint * aRoots ):
 	mRestPoseMesh( aRestPoseMesh ),
 	mCurrentMesh( aCurrentMesh ),
 	mUVPointGenerator( aUVPointGenerator ),
+	mRoots( aRoots ),
 	mHairCount( aHairCount ),
-	mHairStartIndex( aHairStartIndex )
+	mHairStartIndex( aHairStartIndex ),
+	mNextHairIndex( aHairStartIndex )
 {
 }
 
@@ -108,7 +123,7 @@ inline SimplePositionGenerator::~SimplePositionGenerator()
 
 inline void SimplePositionGenerator::generate( MeshPoint & aCurrentPosition, MeshPoint & aRestPosition )
 {
-	UVPoint uv = mUVPointGenerator.next(); // Generate uv pos
+	UVPoint uv = nextUVPoint(); // Generate uv pos
 	aCurrentPosition = mCurrentMesh.getMeshPoint( uv );
 	aRestPosition = mRestPoseMesh.getMeshPoint( uv );
 }
@@ -116,21 +131,30 @@ inline void SimplePositionGenerator::generate( MeshPoint & aCurrentPosition, Mes
 inline void SimplePositionGenerator::generate( MeshPoint & aCurrentPosition, MeshPoint & aRestPosition,
 	const Texture & aDisplacementTexture, Real aDisplacementFactor )
 {
-	UVPoint uv = mUVPointGenerator.next(); // Generate uv pos
+	UVPoint uv = nextUVPoint(); // Generate uv pos
 	aCurrentPosition = mCurrentMesh.getDisplacedMeshPoint( uv, aDisplacementTexture, aDisplacementFactor );
 	aRestPosition = mRestPoseMesh.getMeshPoint( uv );
 }
 
-inline unsigned __int32 SimplePositionGenerator::getHairCount() const
+inline unsigned __int64 SimplePositionGenerator::getHairCount() const
 {
 	return mHairCount;
 }
 
-inline unsigned __int32 SimplePositionGenerator::getHairStartIndex() const
+inline unsigned __int64 SimplePositionGenerator::getHairStartIndex() const
 {
 	return mHairStartIndex;
 }
 
+inline UVPoint SimplePositionGenerator::nextUVPoint()
+{
+	if ( mRoots != 0 ) // Ordered roots are stored in hair order
+	{
+		return mRoots[ mNextHairIndex++ - mHairStartIndex ];
+	}
+	return mUVPointGenerator.next( mNextHairIndex++ );
+}
+
 } // namespace Maya
 
 } // namespace Interpolation
@@ -1,5 +1,7 @@
 #include "Voxelization.hpp"
 
+#include <algorithm>
+
 namespace Stubble
 {
 
@@ -13,11 +15,16 @@ namespace Maya
 {
 
 Voxelization::Voxelization( const Mesh & aRestPoseMesh, const Texture & aDensityTexture, 
-	const Dimensions3 & aResolution )
+	const Dimensions3 & aResolution, unsigned __int32 aTotalHairCount, unsigned __int32 aLeafHairBudget )
 {
 	BoundingBox bbox = aRestPoseMesh.getBoundingBox();
 	unsigned __int32 total = aResolution[ 0 ] * aResolution[ 1 ] * aResolution[ 2 ];
-	mVoxels.resize( total );
+	std::vector< TrianglesEstimates > cells( aLeafHairBudget > 0 ? total : 0 );
+	if ( aLeafHairBudget == 0 )
+	{
+		mVoxels.resize( total );
+	}
+	Real totalEstimate = 0;
 	Vector3D< Real > bsize = ( bbox.max() - bbox.min() ) * 1.001f; // Resize size to avoid voxel id overflow
 	Vector3D< Real > voxelSize( bsize.x / aResolution[ 0 ],
 		bsize.y / aResolution[ 1 ],
@@ -34,9 +41,49 @@ Voxelization::Voxelization( const Mesh & aRestPoseMesh, const Texture & aDensity
 		unsigned __int32 z = static_cast< unsigned __int32 >( floor( ( barycenter.z - bbox.min().z ) / voxelSize.z ) );
 		// Calculate voxel id
 		unsigned __int32 id = z + aResolution[ 2 ] * ( y + aResolution[ 1 ] * x );
-		Voxel & v = mVoxels[ id ];
-		// Add triangle id to voxel
-		v.mTrianglesIds.push_back( it.getTriangleID() );
+		if ( aLeafHairBudget == 0 )
+		{
+			Voxel & v = mVoxels[ id ];
+			// Add triangle id to voxel
+			v.mTrianglesIds.push_back( it.getTriangleID() );
+			continue;
+		}
+		// Estimate density of triangle by density texture at its vertices and center
+		const MeshPoint & p1 = t.getVertex1();
+		const MeshPoint & p2 = t.getVertex2();
+		const MeshPoint & p3 = t.getVertex3();
+		Real density = ( aDensityTexture.realAtUV( p1.getUCoordinate(), p1.getVCoordinate() ) +
+			aDensityTexture.realAtUV( p2.getUCoordinate(), p2.getVCoordinate() ) +
+			aDensityTexture.realAtUV( p3.getUCoordinate(), p3.getVCoordinate() ) +
+			aDensityTexture.realAtUV( ( p1.getUCoordinate() + p2.getUCoordinate() + p3.getUCoordinate() ) / 3, 
+				( p1.getVCoordinate() + p2.getVCoordinate() + p3.getVCoordinate() ) / 3 ) ) / 4;
+		Real area = Vector3D< Real >::crossProduct( p2.getPosition() - p1.getPosition(), 
+			p3.getPosition() - p1.getPosition() ).size() / 2;
+		// Add triangle to grid cell, hair count is normalized later
+		TriangleEstimate estimate;
+		estimate.mBarycenter = barycenter;
+		estimate.mHairCount = area * density;
+		estimate.mTriangleId = it.getTriangleID();
+		cells[ id ].push_back( estimate );
+		totalEstimate += estimate.mHairCount;
+	}
+	// Adaptive voxelization -> split every grid cell to leaves with estimated hair count within budget
+	if ( aLeafHairBudget > 0 )
+	{
+		const Real hairPerEstimate = totalEstimate > 0 ? aTotalHairCount / totalEstimate : 0;
+		for ( std::vector< TrianglesEstimates >::iterator cellIt = cells.begin(); cellIt != cells.end(); ++cellIt )
+		{
+			Real cellHairCount = 0;
+			for ( TrianglesEstimates::iterator it = cellIt->begin(); it != cellIt->end(); ++it )
+			{
+				it->mHairCount *= hairPerEstimate;
+				cellHairCount += it->mHairCount;
+			}
+			if ( !cellIt->empty() )
+			{
+				splitCell( cellIt->begin(), cellIt->end(), cellHairCount, static_cast< Real >( aLeafHairBudget ), 0 );
+			}
+		}
 	}
 	// For each voxel
     #ifdef _OPENMP
@@ -65,8 +112,68 @@ Voxelization::Voxelization( const Mesh & aRestPoseMesh, const Texture & aDensity
 	}
 }
 
+void Voxelization::splitCell( TrianglesEstimates::iterator aBegin, TrianglesEstimates::iterator aEnd, Real aHairCount,
+	Real aLeafHairBudget, unsigned __int32 aDepth )
+{
+	if ( aHairCount > aLeafHairBudget && aDepth < MAX_SPLIT_DEPTH && ( aEnd - aBegin ) > 1 )
+	{
+		// Select longest axis of barycenters bounding box
+		BoundingBox bbox;
+		for ( TrianglesEstimates::iterator it = aBegin; it != aEnd; ++it )
+		{
+			bbox.expand( it->mBarycenter );
+		}
+		Vector3D< Real > size = bbox.max() - bbox.min();
+		unsigned __int32 axis = size.x >= size.y ? ( size.x >= size.z ? 0 : 2 ) : ( size.y >= size.z ? 1 : 2 );
+		if ( size[ axis ] > 0 ) // Barycenters can be separated ?
+		{
+			// Find hair count weighted median of barycenters along the axis
+			std::sort( aBegin, aEnd, BarycenterComparator( axis ) );
+			const Real half = aHairCount / 2;
+			Real lowerHairCount = 0;
+			TrianglesEstimates::iterator median = aBegin;
+			while ( median != aEnd && lowerHairCount + median->mHairCount <= half )
+			{
+				lowerHairCount += median->mHairCount;
+				++median;
+			}
+			// Both halves must contain at least one triangle
+			if ( median == aBegin )
+			{
+				lowerHairCount += median->mHairCount;
+				++median;
+			}
+			else if ( median == aEnd )
+			{
+				--median;
+				lowerHairCount -= median->mHairCount;
+			}
+			// Triangles with same barycenter coordinate must stay in the same half, so halves do not overlap
+			while ( median != aEnd && ( median - 1 )->mBarycenter[ axis ] == median->mBarycenter[ axis ] )
+			{
+				lowerHairCount += median->mHairCount;
+				++median;
+			}
+			if ( median != aEnd )
+			{
+				splitCell( aBegin, median, lowerHairCount, aLeafHairBudget, aDepth + 1 );
+				splitCell( median, aEnd, aHairCount - lowerHairCount, aLeafHairBudget, aDepth + 1 );
+				return;
+			}
+		}
+	}
+	// Cell is leaf -> creates new voxel
+	mVoxels.push_back( Voxel() );
+	Voxel & vx = mVoxels.back();
+	vx.mTrianglesIds.reserve( aEnd - aBegin );
+	for ( TrianglesEstimates::iterator it = aBegin; it != aEnd; ++it )
+	{
+		vx.mTrianglesIds.push_back( it->mTriangleId );
+	}
+}
+
 void Voxelization::updateVoxels( const MayaMesh & aCurrentMesh, const Interpolation::HairProperties & aHairProperties,
-	unsigned __int32 aTotalHairCount )
+	unsigned __int32 aTotalHairCount, bool aExactBoundingBoxes )
 {
 	Real totalDensity = 0;
 	// For each voxel => calculate total density
@@ -78,13 +185,13 @@ void Voxelization::updateVoxels( const MayaMesh & aCurrentMesh, const Interpolat
 		}
 	}
 	Real inverseDensity = 1 / totalDensity;
-	unsigned __int32 index = 0;
+	unsigned __int64 index = 0;
 	// Calculate hair count and hair index for each voxel
 	for ( Voxels::iterator it = mVoxels.begin(); it != mVoxels.end(); ++it )
 	{
 		if ( it->mUVPointGenerator != 0 )
 		{
-			it->mHairCount = static_cast< unsigned __int32 >( std::ceil( it->mUVPointGenerator->getDensity() * inverseDensity *
+			it->mHairCount = static_cast< unsigned __int64 >( std::ceil( it->mUVPointGenerator->getDensity() * inverseDensity *
 				aTotalHairCount ) );
 			if ( ( it->mHairCount + index ) > aTotalHairCount ) // Must not exceed total hair count
 			{
@@ -94,6 +201,8 @@ void Voxelization::updateVoxels( const MayaMesh & aCurrentMesh, const Interpolat
 			index += it->mHairCount; // Increase hair index
 		}
 	}
+	// Hair reach does not depend on voxel, so it is calculated only once
+	const Real maxHairReach = aExactBoundingBoxes ? 0 : aHairProperties.calculateMaxHairReach();
 	// For each voxel -> calculate bounding box
 	#ifdef _OPENMP
 	#pragma omp parallel for schedule( guided )
@@ -108,34 +217,152 @@ void Voxelization::updateVoxels( const MayaMesh & aCurrentMesh, const Interpolat
 			aCurrentMesh.getRequestedTriangles( vx.mTrianglesIds, triangles );
 			delete vx.mCurrentMesh;
 			vx.mCurrentMesh = new Mesh( triangles, true );
-			// Create simple hair position generator & output generator
-			SimpleOutputGenerator output;
-			SimplePositionGenerator posGenerator( *vx.mRestPoseMesh, *vx.mCurrentMesh,
-				*vx.mUVPointGenerator, vx.mHairCount, vx.mHairIndex );
-			// Interpolate hair in order to calculate bounding box
-			HairGenerator< SimplePositionGenerator, SimpleOutputGenerator > generator( posGenerator, output );
 			vx.mBoundingBox.clear();
-			vx.mRandom.reset();
-			generator.calculateBoundingBox( aHairProperties, 1.0f, vx.mBoundingBox );
+			if ( aExactBoundingBoxes )
+			{
+				// Create simple hair position generator & output generator
+				SimpleOutputGenerator output;
+				resetRandom( vx.mRandom, aHairProperties );
+				// Roots ordered by space filling curve must be generated for whole voxel at once
+				std::vector< UVPoint > orderedRoots;
+				if ( HairRootsOrder::isOrdered( aHairProperties ) )
+				{
+					const unsigned __int32 count = narrowCount< unsigned __int32 >( vx.mHairCount );
+					orderedRoots.resize( count );
+					HairRootsOrder::generateRoots( aHairProperties, *vx.mUVPointGenerator, *vx.mRestPoseMesh,
+						vx.mHairIndex, count, &orderedRoots[ 0 ] );
+				}
+				SimplePositionGenerator posGenerator( *vx.mRestPoseMesh, *vx.mCurrentMesh,
+					*vx.mUVPointGenerator, vx.mHairCount, vx.mHairIndex, 
+					orderedRoots.empty() ? 0 : &orderedRoots[ 0 ] );
+				// Interpolate hair in order to calculate bounding box
+				HairGenerator< SimplePositionGenerator, SimpleOutputGenerator > generator( posGenerator, output );
+				generator.calculateBoundingBox( aHairProperties, 1.0f, vx.mBoundingBox );
+			}
+			else
+			{
+				// Hair roots lie on current mesh triangles of voxel
+				for ( TriangleConstIterator it = vx.mCurrentMesh->getTriangleConstIterator(); !it.end(); ++it )
+				{
+					const Triangle & t = it.getTriangle();
+					vx.mBoundingBox.expand( t.getVertex1().getPosition() );
+					vx.mBoundingBox.expand( t.getVertex2().getPosition() );
+					vx.mBoundingBox.expand( t.getVertex3().getPosition() );
+				}
+				// Hair points are generated in single precision, so bounding box must also cover rounding errors
+				static const Real ROUNDING_TOLERANCE = 1e-5;
+				Vector3D< Real > minCorner = vx.mBoundingBox.min();
+				Vector3D< Real > maxCorner = vx.mBoundingBox.max();
+				Real magnitude = std::max( std::max( std::max( fabs( minCorner.x ), fabs( minCorner.y ) ), fabs( minCorner.z ) ),
+					std::max( std::max( fabs( maxCorner.x ), fabs( maxCorner.y ) ), fabs( maxCorner.z ) ) ) + maxHairReach;
+				Real enlarge = maxHairReach + magnitude * ROUNDING_TOLERANCE;
+				// Enlarge bounding box by maximal hair reach
+				Vector3D< Real > enlargeVector( enlarge, enlarge, enlarge );
+				vx.mBoundingBox.expand( maxCorner + enlargeVector );
+				vx.mBoundingBox.expand( minCorner - enlargeVector );
+			}
 		}
 	}
 }
 
-BoundingBox Voxelization::exportVoxel( std::ostream & aOutputStream, unsigned __int32 aVoxelId )
+BoundingBox Voxelization::exportVoxel( std::ostream & aOutputStream, unsigned __int32 aVoxelId, 
+	const Interpolation::HairProperties & aHairProperties, bool aBakeHairRoots )
 {
 	Voxel & voxel = mVoxels[ aVoxelId ];
 	// Export hair index
-	aOutputStream.write( reinterpret_cast< const char *>( &voxel.mHairIndex ), sizeof( unsigned __int32 ) );
+	aOutputStream.write( reinterpret_cast< const char *>( &voxel.mHairIndex ), sizeof( unsigned __int64 ) );
 	// Export hair count
-	aOutputStream.write( reinterpret_cast< const char *>( &voxel.mHairCount ), sizeof( unsigned __int32 ) );
+	aOutputStream.write( reinterpret_cast< const char *>( &voxel.mHairCount ), sizeof( unsigned __int64 ) );
 	// Export rest pose mesh
 	voxel.mRestPoseMesh->exportMesh( aOutputStream );
 	// Export current mesh
 	voxel.mCurrentMesh->exportMesh( aOutputStream );
+	// Export baked roots
+	aOutputStream.write( reinterpret_cast< const char *>( &aBakeHairRoots ), sizeof( bool ) );
+	if ( aBakeHairRoots )
+	{
+		// Generates same roots as SimplePositionGenerator during voxel update
+		resetRandom( voxel.mRandom, aHairProperties );
+		std::vector< UVPoint > orderedRoots;
+		if ( HairRootsOrder::isOrdered( aHairProperties ) && voxel.mHairCount > 0 )
+		{
+			const unsigned __int32 count = narrowCount< unsigned __int32 >( voxel.mHairCount );
+			orderedRoots.resize( count );
+			HairRootsOrder::generateRoots( aHairProperties, *voxel.mUVPointGenerator, *voxel.mRestPoseMesh,
+				voxel.mHairIndex, count, &orderedRoots[ 0 ] );
+		}
+		// Roots are baked in chunks, closest guides of whole chunk are queried at once
+		static const unsigned __int32 CHUNK_SIZE = 4096;
+		const unsigned __int32 queryCount = BakedHairRoot::getClosestGuidesQueryCount( aHairProperties );
+		std::vector< BakedHairRoot > roots( static_cast< size_t >( 
+			std::min( static_cast< unsigned __int64 >( CHUNK_SIZE ), voxel.mHairCount ) ) );
+		std::vector< Vector3D< Real > > positions( roots.size() );
+		std::vector< unsigned __int32 > groupIds( roots.size() );
+		std::vector< unsigned __int32 > rootIndices( roots.size() );
+		std::vector< HairComponents::IdAndDistance > closestGuides( roots.size() * queryCount );
+		std::vector< unsigned __int32 > closestGuidesCounts( roots.size() );
+		HairComponents::ClosestGuidesQuery query;
+		for ( unsigned __int64 chunkStart = 0; chunkStart < voxel.mHairCount; chunkStart += CHUNK_SIZE )
+		{
+			const unsigned __int32 chunkSize = static_cast< unsigned __int32 >( 
+				std::min( static_cast< unsigned __int64 >( CHUNK_SIZE ), voxel.mHairCount - chunkStart ) );
+			// Generate roots of chunk and select interpolation groups of not cut hair
+			unsigned __int32 queriesSize = 0;
+			for ( unsigned __int32 i = 0; i < chunkSize; ++i )
+			{
+				BakedHairRoot & root = roots[ i ];
+				root.mUVPoint = orderedRoots.empty() ? voxel.mUVPointGenerator->next( voxel.mHairIndex + chunkStart + i ) :
+					orderedRoots[ chunkStart + i ];
+				MeshPoint restPos = voxel.mRestPoseMesh->getMeshPoint( root.mUVPoint );
+				if ( aHairProperties.getCutTexture().realAtUV( restPos.getUCoordinate(), restPos.getVCoordinate() ) == 0 )
+				{
+					// The hair has been cut at root, guides are not needed
+					root.mInterpolationGroupId = 0;
+					root.mGuidesCount = 0;
+				}
+				else
+				{
+					root.selectInterpolationGroup( aHairProperties, restPos );
+					if ( root.selectTriangleGuides( aHairProperties, restPos ) )
+					{
+						continue; // Guides of enclosing triangle are used, no query needed
+					}
+					positions[ queriesSize ] = restPos.getPosition();
+					groupIds[ queriesSize ] = root.mInterpolationGroupId;
+					rootIndices[ queriesSize ] = i;
+					++queriesSize;
+				}
+			}
+			// Query closest guides of all not cut hair and calculate weights
+			if ( queriesSize > 0 )
+			{
+				aHairProperties.getGuidesRestPositionsDS().getNClosestGuides( &positions[ 0 ], &groupIds[ 0 ], 
+					queriesSize, queryCount, query, &closestGuides[ 0 ], &closestGuidesCounts[ 0 ] );
+			}
+			for ( unsigned __int32 i = 0; i < queriesSize; ++i )
+			{
+				roots[ rootIndices[ i ] ].calculateWeights( &closestGuides[ i * queryCount ], closestGuidesCounts[ i ] );
+			}
+			// Export roots in order of hair
+			for ( unsigned __int32 i = 0; i < chunkSize; ++i )
+			{
+				roots[ i ].exportToFile( aOutputStream );
+			}
+		}
+	}
 	// Finally return bbox
 	return voxel.mBoundingBox;
 }
 
+void Voxelization::resetRandom( RandomGenerator & aRandom, const Interpolation::HairProperties & aHairProperties )
+{
+	aRandom = RandomGenerator(); // James random generator with default seed
+	if ( aHairProperties.isRandomCounterBased() )
+	{
+		aRandom.resetCounterBased( aHairProperties.getRandomSeed(), RandomGenerator::HAIR_ROOTS_DOMAIN );
+	}
+}
+
 } // namespace Maya
 
 } // namespace Interpolation
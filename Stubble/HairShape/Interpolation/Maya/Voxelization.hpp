@@ -3,8 +3,10 @@
 
 #include "Common/CommonTypes.hpp"
 #include "HairShape/Generators/UVPointGenerator.hpp"
+#include "../BakedHairRoot.hpp"
 #include "../HairGenerator.tmpl.hpp"
 #include "../HairProperties.hpp"
+#include "../HairRootsOrder.hpp"
 #include "SimplePositionGenerator.hpp"
 #include "SimpleOutputGenerator.hpp"
 #include "HairShape/Mesh/MayaMesh.hpp"
@@ -29,7 +31,9 @@ namespace Maya
 ///-------------------------------------------------------------------------------------------------
 /// Class for dividing hair object to several voxels which will be rendered independently.
 /// Voxels are cells of 3D uniform grid defined by rest position mesh bounding box and user defined
-/// resolution.
+/// resolution. Optionally cells are adaptively refined by kd splits until estimated hair count of
+/// every leaf fits into user defined hair budget, so dense regions are divided to more voxels
+/// than sparse ones.
 /// Each voxel contain its own rest pose and current geometry and each hair belong only to one
 /// voxel.
 /// Voxel can be exported to binary stream and then used in 3Delight or other renderer.
@@ -41,15 +45,20 @@ public:
 	///-------------------------------------------------------------------------------------------------
 	/// Constructor. 
 	/// Voxelizes and stores rest pose mesh to several voxels ( voxels count is defined by aResolution 
-	/// parameter, triangle is put in voxel depending on his barycentr position ). Constructs samples 
-	/// generator for each voxel of mesh and stores them.
+	/// parameter, triangle is put in voxel depending on his barycentr position ). If leaf hair budget
+	/// is set, every grid cell is recursively split by hair count weighted median of triangles
+	/// barycenters along its longest axis until estimated hair count of cell ( area of triangles 
+	/// multiplied by density ) does not exceed the budget. Constructs samples generator for each voxel
+	/// of mesh and stores them.
 	///
 	/// \param	aRestPoseMesh		The rest pose mesh. 
 	/// \param	aDensityTexture		The hair density texture. 
 	/// \param	aResolution		The 3D resolution of voxelization
+	/// \param	aTotalHairCount		The total hair count used for leaves hair count estimation.
+	/// \param	aLeafHairBudget		The target hair count of one voxel ( 0 for uniform grid only ).
 	///-------------------------------------------------------------------------------------------------
 	Voxelization( const Mesh & aRestPoseMesh, const Texture & aDensityTexture, 
-		const Dimensions3 & aResolution );
+		const Dimensions3 & aResolution, unsigned __int32 aTotalHairCount, unsigned __int32 aLeafHairBudget );
 
 	///-------------------------------------------------------------------------------------------------
 	/// Finaliser. 
@@ -60,25 +69,32 @@ public:
 	/// Updates voxel data and properties.
 	/// Voxelizes current mesh and calculates bounding box of hair curves and hair count for each voxel
 	/// ( samples generators total densities are used for hair count calculation ). Bounding box is 
-	/// calculated by complete generation of hair geometry.
+	/// either calculated by complete generation of hair geometry ( exact ) or analytically as current
+	/// mesh bounding box enlarged by maximal hair reach ( conservative, but much faster ).
 	///
-	/// \param	aCurrentMesh	The current mesh. 
-	/// \param	aHairProperties	The hair properties. 
-	/// \param	aTotalHairCount	The total hair count
+	/// \param	aCurrentMesh		The current mesh. 
+	/// \param	aHairProperties		The hair properties. 
+	/// \param	aTotalHairCount		The total hair count
+	/// \param	aExactBoundingBoxes	true to calculate exact bounding boxes by hair generation.
 	///-------------------------------------------------------------------------------------------------
 	void updateVoxels( const MayaMesh & aCurrentMesh, const Interpolation::HairProperties & aHairProperties,
-		unsigned __int32 aTotalHairCount );
+		unsigned __int32 aTotalHairCount, bool aExactBoundingBoxes );
 
 	///-------------------------------------------------------------------------------------------------
 	/// Exports requested voxel data to binary stream.
 	/// Hair count, hair start index, current and rest pose mesh of requested voxel are exported.
+	/// Optionally baked roots of all hair in voxel are exported ( see BakedHairRoot ), so renderer
+	/// does not need to sample hair roots and query closest guides.
 	/// 
 	/// \param [in,out]	aOutputStream	The output stream. 
 	/// \param	aVoxelId				Requested voxel identifier.
+	/// \param	aHairProperties			The hair properties. 
+	/// \param	aBakeHairRoots			true to export baked roots of hair. 
 	/// 
 	/// \return the bounding box of exported voxel
 	///-------------------------------------------------------------------------------------------------
-	BoundingBox exportVoxel( std::ostream & aOutputStream, unsigned __int32 aVoxelId );
+	BoundingBox exportVoxel( std::ostream & aOutputStream, unsigned __int32 aVoxelId, 
+		const Interpolation::HairProperties & aHairProperties, bool aBakeHairRoots );
 
 	///-------------------------------------------------------------------------------------------------
 	/// Gets a number of hair in requested voxel.
@@ -87,7 +103,7 @@ public:
 	///
 	/// \return	The voxel hair count. 
 	///-------------------------------------------------------------------------------------------------
-	inline unsigned __int32 getVoxelHairCount( unsigned __int32 aVoxelId ) const;
+	inline unsigned __int64 getVoxelHairCount( unsigned __int32 aVoxelId ) const;
 
 	///-------------------------------------------------------------------------------------------------
 	/// Gets the voxels count. 
@@ -108,14 +124,83 @@ private:
 	///-------------------------------------------------------------------------------------------------
 	typedef TrianglesIds VoxelsIds;
 
+	///-------------------------------------------------------------------------------------------------
+	/// Resets random generator of voxel to mode and seed selected by hair properties. 
+	///
+	/// \param [in,out]	aRandom		The random generator of voxel. 
+	/// \param	aHairProperties		The hair properties. 
+	///-------------------------------------------------------------------------------------------------
+	static void resetRandom( RandomGenerator & aRandom, const Interpolation::HairProperties & aHairProperties );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Triangle of rest pose mesh with its estimated hair count used by adaptive voxelization. 
+	///-------------------------------------------------------------------------------------------------
+	struct TriangleEstimate
+	{
+		Vector3D< Real > mBarycenter;	///< The barycenter of triangle
+
+		Real mHairCount;	///< The estimated number of hair on triangle
+
+		unsigned __int32 mTriangleId;	///< The triangle identifier
+	};
+
+	///-------------------------------------------------------------------------------------------------
+	/// Defines an alias representing the triangles estimates array.
+	///-------------------------------------------------------------------------------------------------
+	typedef std::vector< TriangleEstimate > TrianglesEstimates;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Compares triangles estimates by one coordinate of barycenter. 
+	///-------------------------------------------------------------------------------------------------
+	class BarycenterComparator
+	{
+	public:
+
+		///-------------------------------------------------------------------------------------------------
+		/// Constructor. 
+		///
+		/// \param	aAxis	The compared coordinate.
+		///-------------------------------------------------------------------------------------------------
+		explicit inline BarycenterComparator( unsigned __int32 aAxis );
+
+		///-------------------------------------------------------------------------------------------------
+		/// Compares two triangles estimates. 
+		///
+		/// \param	aEstimate1	The first estimate. 
+		/// \param	aEstimate2	The second estimate. 
+		///
+		/// \return	true if first barycenter lies before second one. 
+		///-------------------------------------------------------------------------------------------------
+		inline bool operator() ( const TriangleEstimate & aEstimate1, const TriangleEstimate & aEstimate2 ) const;
+
+	private:
+
+		unsigned __int32 mAxis; ///< The compared coordinate
+	};
+
+	///-------------------------------------------------------------------------------------------------
+	/// Recursively splits cell of adaptive voxelization until its estimated hair count fits into leaf
+	/// hair budget. Leaves are appended to voxels.
+	///
+	/// \param	aBegin				The first triangle estimate of cell. 
+	/// \param	aEnd				The end of triangles estimates of cell. 
+	/// \param	aHairCount			The estimated hair count of cell. 
+	/// \param	aLeafHairBudget		The target hair count of one voxel. 
+	/// \param	aDepth				The depth of cell. 
+	///-------------------------------------------------------------------------------------------------
+	void splitCell( TrianglesEstimates::iterator aBegin, TrianglesEstimates::iterator aEnd, Real aHairCount,
+		Real aLeafHairBudget, unsigned __int32 aDepth );
+
+	static const unsigned __int32 MAX_SPLIT_DEPTH = 24; ///< The maximal depth of adaptive splits of grid cell
+
 	///-------------------------------------------------------------------------------------------------
 	/// Class for holding one voxel data and properties. 
 	///-------------------------------------------------------------------------------------------------
 	struct Voxel
 	{
-		unsigned __int32 mHairCount;	///< Number of hair inside this voxel
+		unsigned __int64 mHairCount;	///< Number of hair inside this voxel
 
-		unsigned __int32 mHairIndex;	///< Index of first hair inside this voxel
+		unsigned __int64 mHairIndex;	///< Index of first hair inside this voxel
 
 		TrianglesIds mTrianglesIds; ///< List of identifiers for the triangles
 
@@ -151,7 +236,7 @@ inline Voxelization::~Voxelization()
 	}
 }
 
-inline unsigned __int32 Voxelization::getVoxelHairCount( unsigned __int32 aVoxelId ) const
+inline unsigned __int64 Voxelization::getVoxelHairCount( unsigned __int32 aVoxelId ) const
 {
 	return mVoxels[ aVoxelId ].mHairCount;
 }
@@ -161,6 +246,17 @@ inline unsigned __int32 Voxelization::getVoxelsCount() const
 	return static_cast< unsigned __int32 >( mVoxels.size() );
 }
 
+inline Voxelization::BarycenterComparator::BarycenterComparator( unsigned __int32 aAxis ):
+	mAxis( aAxis )
+{
+}
+
+inline bool Voxelization::BarycenterComparator::operator() ( const TriangleEstimate & aEstimate1, 
+	const TriangleEstimate & aEstimate2 ) const
+{
+	return aEstimate1.mBarycenter[ mAxis ] < aEstimate2.mBarycenter[ mAxis ];
+}
+
 } // namespace Maya
 
 } // namespace Interpolation
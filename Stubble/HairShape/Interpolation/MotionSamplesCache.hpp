@@ -0,0 +1,189 @@
+#ifndef STUBBLE_MOTION_SAMPLES_CACHE_HPP
+#define STUBBLE_MOTION_SAMPLES_CACHE_HPP
+
+#include "BakedHairRoot.hpp"
+#include "Common/CommonFunctions.hpp"
+
+#include <vector>
+
+namespace Stubble
+{
+
+namespace HairShape
+{
+
+namespace Interpolation
+{
+
+///-------------------------------------------------------------------------------------------------
+/// Cache of frame invariant data of interpolated hair shared by motion samples of motion blur.
+/// The first motion sample stores for every main hair everything, that does not depend on time
+/// ( selected guides, cut, scale, static frizz, color, opacity, width and multi strand properties
+/// including the random numbers ). Following motion samples of the same hair range only evaluate
+/// parts depending on time ( current mesh position, guides shapes and animated frizz ).
+/// Values are stored in float, which is precision of all output generators.
+///-------------------------------------------------------------------------------------------------
+class MotionSamplesCache
+{
+public:
+
+	///-------------------------------------------------------------------------------------------------
+	/// Values that represent state of hair after the first motion sample.
+	///-------------------------------------------------------------------------------------------------
+	enum HairState
+	{
+		HAIR_GENERATED,	///< Hair has been generated
+		HAIR_SKIPPED,   ///< Hair has been cut at root, has degenerated or has been dropped without using random numbers
+		HAIR_DROPPED	///< Hair has been dropped by level of detail after it had used random numbers
+	};
+
+	///-------------------------------------------------------------------------------------------------
+	/// Frame invariant data of single main hair.
+	///-------------------------------------------------------------------------------------------------
+	struct Hair
+	{
+		HairState mState;   ///< The state of hair
+
+		BakedHairRoot mHairRoot;	///< The interpolation group and guides to interpolate from
+
+		float mCutFactor;   ///< The cut factor
+
+		float mScale;   ///< The scale factor
+
+		Real mFrizzFrequency[ 3 ];  ///< The frizz frequencies
+
+		Real mRootFrizz;	///< The root frizz
+
+		Real mTipFrizz; ///< The tip frizz
+
+		Real mFrizzAnim;	///< The frizz animation factor
+
+		Real mFrizzAnimSpeed;   ///< The frizz animation speed
+
+		Real mStaticFrizz[ 3 ]; ///< The displacement by static frizz noise
+
+		float mRootColor[ 3 ];  ///< The root color ( in HSV )
+
+		float mTipColor[ 3 ];   ///< The tip color ( in HSV )
+
+		float mHueDistance; ///< The distance in hue between root and tip color
+
+		float mRootOpacity; ///< The root opacity
+
+		float mTipOpacity;  ///< The tip opacity
+
+		float mRootWidth;   ///< Width of the root
+
+		float mTipWidth;	///< Width of the tip
+
+		float mTwist;   ///< The twist angle of whole hair
+
+		float mTipSplay;	///< The tip splay
+
+		float mCenterSplay; ///< The center splay
+
+		float mRootSplay;   ///< The root splay
+
+		float mRandomizeScale;  ///< The randomize scale factor
+
+		float mOffset;  ///< The offset of tips
+
+		float mAspect;  ///< The aspect ratio of disk samples
+	};
+
+	///-------------------------------------------------------------------------------------------------
+	/// Frame invariant data of single hair in strand.
+	///-------------------------------------------------------------------------------------------------
+	struct Strand
+	{
+		float mCutFactor;   ///< The randomized cut factor
+
+		float mCosPhi;  ///< The cosine of angle of hair position on disk
+
+		float mSinPhi;  ///< The sine of angle of hair position on disk
+	};
+
+	///-------------------------------------------------------------------------------------------------
+	/// Default constructor.
+	///-------------------------------------------------------------------------------------------------
+	inline MotionSamplesCache();
+
+	///-------------------------------------------------------------------------------------------------
+	/// Prepares cache for new range of hair. Must be called before the first motion sample of the
+	/// range is generated.
+	///
+	/// \param	aHairStartIndex	Index of the first hair of range.
+	/// \param	aHairCount		Number of main hair in range.
+	/// \param	aStrandsCount	Maximum number of hair in strand of all motion samples.
+	///-------------------------------------------------------------------------------------------------
+	inline void reset( unsigned __int64 aHairStartIndex, unsigned __int64 aHairCount,
+		unsigned __int32 aStrandsCount );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the data of main hair.
+	///
+	/// \param	aHairIndex	Index of the main hair ( must be in range selected by reset ).
+	///
+	/// \return	The hair data.
+	///-------------------------------------------------------------------------------------------------
+	inline Hair & getHair( unsigned __int64 aHairIndex );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the data of all hair in strand of main hair.
+	///
+	/// \param	aHairIndex	Index of the main hair ( must be in range selected by reset ).
+	///
+	/// \return	The data of hair in strand.
+	///-------------------------------------------------------------------------------------------------
+	inline Strand * getStrands( unsigned __int64 aHairIndex );
+
+private:
+
+	std::vector< Hair > mHair;  ///< The main hair data
+
+	std::vector< Strand > mStrands; ///< The hair in strands data
+
+	unsigned __int64 mHairStartIndex;   ///< Index of the first hair of range
+
+	unsigned __int32 mStrandsCount; ///< Number of hair in strand
+};
+
+// inline functions implementation
+
+inline MotionSamplesCache::MotionSamplesCache():
+	mHairStartIndex( 0 ),
+	mStrandsCount( 0 )
+{
+}
+
+inline void MotionSamplesCache::reset( unsigned __int64 aHairStartIndex, unsigned __int64 aHairCount,
+	unsigned __int32 aStrandsCount )
+{
+	mHairStartIndex = aHairStartIndex;
+	mStrandsCount = aStrandsCount;
+	mHair.resize( narrowCount< size_t >( aHairCount ) );
+	mStrands.resize( narrowCount< size_t >( multiplyCounts( aHairCount, aStrandsCount ) ) );
+	// Hair not visited by the first motion sample are never generated
+	for ( std::vector< Hair >::iterator it = mHair.begin(); it != mHair.end(); ++it )
+	{
+		it->mState = HAIR_SKIPPED;
+	}
+}
+
+inline MotionSamplesCache::Hair & MotionSamplesCache::getHair( unsigned __int64 aHairIndex )
+{
+	return mHair[ static_cast< size_t >( aHairIndex - mHairStartIndex ) ];
+}
+
+inline MotionSamplesCache::Strand * MotionSamplesCache::getStrands( unsigned __int64 aHairIndex )
+{
+	return mStrands.empty() ? 0 : &mStrands[ static_cast< size_t >( aHairIndex - mHairStartIndex ) * mStrandsCount ];
+}
+
+} // namespace Interpolation
+
+} // namespace HairShape
+
+} // namespace Stubble
+
+#endif // STUBBLE_MOTION_SAMPLES_CACHE_HPP
@@ -1,6 +1,7 @@
 #ifndef STUBBLE_OUTPUT_GENERATOR_HPP
 #define STUBBLE_OUTPUT_GENERATOR_HPP
 
+#include "Common/CommonFunctions.hpp"
 #include "Common/StubbleException.hpp"
 
 namespace Stubble
@@ -36,10 +37,13 @@ public:
 	/// Begins an output of interpolated hair.
 	/// Must be called before any hair is outputed. 
 	///
+	/// Hair count is 64 bit, because main hair count multiplied by hair in strand count may not fit
+	/// into 32 bits. Implementations must check their buffers sizes for overflow.
+	///
 	/// \param	aMaxHairCount	Number of a maximum hair. 
 	/// \param	aMaxPointsCount	Number of a maximum points. 
 	///-------------------------------------------------------------------------------------------------
-	inline void beginOutput( unsigned __int32 aMaxHairCount, unsigned __int32 aMaxPointsCount );
+	inline void beginOutput( unsigned __int64 aMaxHairCount, unsigned __int32 aMaxPointsCount );
 
 	///----------------------------------------------------------------------------------------------------
 	/// Ends an output.
@@ -47,6 +51,14 @@ public:
 	///----------------------------------------------------------------------------------------------------
 	inline void endOutput();
 
+	///-------------------------------------------------------------------------------------------------
+	/// Query if outputed normals are used. If not, HairGenerator does not calculate normals and
+	/// content of normals buffer is undefined.
+	///
+	/// \return	true if normals are used. 
+	///-------------------------------------------------------------------------------------------------
+	inline bool areNormalsUsed() const;
+
 	///-------------------------------------------------------------------------------------------------
 	/// Begins an output of single interpolated hair.
 	/// The upper estimate of points on hair must be known to make sure enough resources are be 
@@ -151,7 +163,7 @@ protected:
 
 template< typename tOutputGeneratorTypes >
 inline void OutputGenerator< tOutputGeneratorTypes >::beginOutput
-	( unsigned __int32 aMaxHairCount, unsigned __int32 aMaxPointsCount )
+	( unsigned __int64 aMaxHairCount, unsigned __int32 aMaxPointsCount )
 {
 	throw StubbleException( "OutputGenerator::beginOutput : this method is not implemented !" ); 
 }
@@ -162,6 +174,12 @@ inline void OutputGenerator< tOutputGeneratorTypes >::endOutput()
 	throw StubbleException( "OutputGenerator::endOutput : this method is not implemented !" ); 
 }
 
+template< typename tOutputGeneratorTypes >
+inline bool OutputGenerator< tOutputGeneratorTypes >::areNormalsUsed() const
+{
+	throw StubbleException( "OutputGenerator::areNormalsUsed : this method is not implemented !" ); 
+}
+
 
 template< typename tOutputGeneratorTypes >
 inline void OutputGenerator< tOutputGeneratorTypes >::beginHair
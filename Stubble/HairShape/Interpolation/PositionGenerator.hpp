@@ -16,6 +16,8 @@ namespace HairShape
 namespace Interpolation
 {
 
+struct BakedHairRoot;
+
 ///-------------------------------------------------------------------------------------------------
 /// Interface of position generator of interpolated hair. No virtual functions are used, this class
 /// here only represents the interface for classes used as HairGenerator template argument.
@@ -48,14 +50,22 @@ public:
 	///
 	/// \return	The hair count. 
 	///-------------------------------------------------------------------------------------------------
-	inline unsigned __int32 getHairCount() const;
+	inline unsigned __int64 getHairCount() const;
 
 	///-------------------------------------------------------------------------------------------------
 	/// Gets the index of first hair which position is generated by this generator. 
 	///
 	/// \return	The index of first hair which position is generated by this generator. 
 	///-------------------------------------------------------------------------------------------------
-	inline unsigned __int32 getHairStartIndex() const;
+	inline unsigned __int64 getHairStartIndex() const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the baked root of the last generated hair. Default implementation returns NULL, so hair 
+	/// generator selects interpolation group and closest guides by itself.
+	///
+	/// \return	The baked root of the last generated hair or NULL if roots are not baked. 
+	///-------------------------------------------------------------------------------------------------
+	inline const BakedHairRoot * getBakedRoot() const;
 
 protected:
 	///-------------------------------------------------------------------------------------------------
@@ -77,16 +87,21 @@ inline void PositionGenerator::generate( MeshPoint & aCurrentPosition, MeshPoint
 	throw StubbleException( "PositionGenerator::generate : this method is not implemented !" );
 }
 
-inline unsigned __int32 PositionGenerator::getHairCount() const
+inline unsigned __int64 PositionGenerator::getHairCount() const
 {
 	throw StubbleException( "PositionGenerator::getHairCount : this method is not implemented !" );
 }
 
-inline unsigned __int32 PositionGenerator::getHairStartIndex() const
+inline unsigned __int64 PositionGenerator::getHairStartIndex() const
 {
 	throw StubbleException( "PositionGenerator::getHairStartIndex : this method is not implemented !" );
 }
 
+inline const BakedHairRoot * PositionGenerator::getBakedRoot() const
+{
+	return 0;
+}
+
 inline PositionGenerator::PositionGenerator()
 {
 }
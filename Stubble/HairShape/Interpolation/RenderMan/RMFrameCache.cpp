@@ -0,0 +1,128 @@
+#define NOMINMAX  // windows.h: don't define min() and max() macros!
+#include "RMFrameCache.hpp"
+
+#include "Common/CriticalSection.hpp"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+namespace Stubble
+{
+
+namespace HairShape
+{
+
+namespace Interpolation
+{
+
+namespace
+{
+
+CriticalSection gCacheLock; ///< The lock of the frame cache
+
+ConditionVariable gFrameDecoded;	///< Notified whenever decoding of some frame ends
+
+} // unnamed namespace
+
+RMFrameCache::CachedFrames RMFrameCache::mCachedFrames;
+
+RMFrameCache::FrameKey RMFrameCache::registerFrame( const std::string & aFrameFileName )
+{
+	FrameKey key;
+	key.mFrameFileName = aFrameFileName;
+	// Get modification time, missing file will throw later when frame is decoded
+	struct __stat64 fileInfo;
+	key.mModificationTime = _stat64( aFrameFileName.c_str(), &fileInfo ) == 0 ? fileInfo.st_mtime : 0;
+	ScopedLock lock( gCacheLock );
+	CachedFrames::iterator it = mCachedFrames.find( key );
+	if ( it == mCachedFrames.end() )
+	{
+		CachedFrame frame;
+		frame.mHairProperties = 0;
+		frame.mIsDecoding = false;
+		frame.mReferencesCount = 1;
+		mCachedFrames.insert( std::make_pair( key, frame ) );
+	}
+	else
+	{
+		++it->second.mReferencesCount;
+	}
+	return key;
+}
+
+void RMFrameCache::registerFrame( const FrameKey & aKey )
+{
+	ScopedLock lock( gCacheLock );
+	CachedFrames::iterator it = mCachedFrames.find( aKey );
+	if ( it == mCachedFrames.end() )
+	{
+		throw StubbleException( " RMFrameCache::registerFrame : frame has not been registered ! " );
+	}
+	++it->second.mReferencesCount;
+}
+
+const RMHairProperties & RMFrameCache::getFrame( const FrameKey & aKey )
+{
+	ScopedLock lock( gCacheLock );
+	CachedFrames::iterator it = mCachedFrames.find( aKey );
+	if ( it == mCachedFrames.end() )
+	{
+		throw StubbleException( " RMFrameCache::getFrame : frame has not been registered ! " );
+	}
+	// Frame can not be unregistered meanwhile, caller holds a registration
+	CachedFrame & frame = it->second;
+	while ( frame.mIsDecoding ) // Wait for another thread decoding the frame
+	{
+		gFrameDecoded.wait( gCacheLock );
+	}
+	if ( frame.mHairProperties != 0 )
+	{
+		return *frame.mHairProperties;
+	}
+	// Decode frame without holding the lock, so other frames can be decoded meanwhile
+	frame.mIsDecoding = true;
+	gCacheLock.unlock();
+	RMHairProperties * hairProperties = 0;
+	try
+	{
+		hairProperties = new RMHairProperties( aKey.mFrameFileName );
+	}
+	catch( ... )
+	{
+		// Waiting threads will try to decode the frame on their own
+		gCacheLock.lock();
+		frame.mIsDecoding = false;
+		gFrameDecoded.notifyAll();
+		throw;
+	}
+	gCacheLock.lock();
+	frame.mHairProperties = hairProperties;
+	frame.mIsDecoding = false;
+	gFrameDecoded.notifyAll();
+	return *hairProperties;
+}
+
+void RMFrameCache::unregisterFrame( const FrameKey & aKey )
+{
+	RMHairProperties * hairProperties = 0;
+	{
+		ScopedLock lock( gCacheLock );
+		CachedFrames::iterator it = mCachedFrames.find( aKey );
+		if ( it == mCachedFrames.end() )
+		{
+			return;
+		}
+		if ( --it->second.mReferencesCount == 0 )
+		{
+			hairProperties = it->second.mHairProperties;
+			mCachedFrames.erase( it );
+		}
+	}
+	delete hairProperties;
+}
+
+} // namespace Interpolation
+
+} // namespace HairShape
+
+} // namespace Stubble
@@ -0,0 +1,120 @@
+#ifndef STUBBLE_RM_FRAME_CACHE_HPP
+#define STUBBLE_RM_FRAME_CACHE_HPP
+
+#include "RMHairProperties.hpp"
+
+#include <map>
+#include <string>
+
+namespace Stubble
+{
+
+namespace HairShape
+{
+
+namespace Interpolation
+{
+
+///-------------------------------------------------------------------------------------------------
+/// Process-wide cache of decoded frame files. Every voxel procedural of one frame registers the
+/// frame file, the first procedural that needs it decodes it and all others share the same read-only
+/// RMHairProperties. Frame is freed when the last procedural that registered it unregisters it.
+/// All methods are thread-safe.
+///-------------------------------------------------------------------------------------------------
+class RMFrameCache
+{
+public:
+
+	///-------------------------------------------------------------------------------------------------
+	/// Identifies cached frame by frame file name and its last modification time.
+	///-------------------------------------------------------------------------------------------------
+	struct FrameKey
+	{
+		std::string mFrameFileName; ///< Filename of the frame file
+
+		__int64 mModificationTime;  ///< The last modification time of the frame file
+
+		///-------------------------------------------------------------------------------------------------
+		/// Less-than comparison operator.
+		///
+		/// \param	aKey	The key to compare to.
+		///
+		/// \return	true if the first parameter is less than the second.
+		///-------------------------------------------------------------------------------------------------
+		inline bool operator<( const FrameKey & aKey ) const;
+	};
+
+	///-------------------------------------------------------------------------------------------------
+	/// Registers the frame file. Frame is not decoded until getFrame is called.
+	///
+	/// \param	aFrameFileName	Filename of the frame file.
+	///
+	/// \return	Key of the registered frame.
+	///-------------------------------------------------------------------------------------------------
+	static FrameKey registerFrame( const std::string & aFrameFileName );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Registers already registered frame once more ( child procedural shares frame with its parent ).
+	///
+	/// \param	aKey	The key of registered frame.
+	///-------------------------------------------------------------------------------------------------
+	static void registerFrame( const FrameKey & aKey );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the decoded frame. Frame file is decoded only once, callers requesting frame which is
+	/// being decoded by another thread wait for the result. Frame must be registered.
+	///
+	/// \param	aKey	The key of registered frame.
+	///
+	/// \return	The hair properties of the frame.
+	///-------------------------------------------------------------------------------------------------
+	static const RMHairProperties & getFrame( const FrameKey & aKey );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Unregisters the frame. Decoded frame is freed when it is unregistered as many times as it
+	/// has been registered.
+	///
+	/// \param	aKey	The key of registered frame.
+	///-------------------------------------------------------------------------------------------------
+	static void unregisterFrame( const FrameKey & aKey );
+
+private:
+
+	///-------------------------------------------------------------------------------------------------
+	/// Single cached frame.
+	///-------------------------------------------------------------------------------------------------
+	struct CachedFrame
+	{
+		RMHairProperties * mHairProperties; ///< The decoded hair properties ( NULL if not decoded yet )
+
+		bool mIsDecoding;   ///< true if frame is being decoded by some thread
+
+		unsigned __int32 mReferencesCount;  ///< Number of registrations of the frame
+	};
+
+	///-------------------------------------------------------------------------------------------------
+	/// Defines an alias representing the cached frames .
+	///-------------------------------------------------------------------------------------------------
+	typedef std::map< FrameKey, CachedFrame > CachedFrames;
+
+	static CachedFrames mCachedFrames;  ///< The cached frames
+};
+
+// inline functions implementation
+
+inline bool RMFrameCache::FrameKey::operator<( const FrameKey & aKey ) const
+{
+	if ( mModificationTime != aKey.mModificationTime )
+	{
+		return mModificationTime < aKey.mModificationTime;
+	}
+	return mFrameFileName < aKey.mFrameFileName;
+}
+
+} // namespace Interpolation
+
+} // namespace HairShape
+
+} // namespace Stubble
+
+#endif // STUBBLE_RM_FRAME_CACHE_HPP
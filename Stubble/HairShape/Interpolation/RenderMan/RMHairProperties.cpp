@@ -16,12 +16,31 @@ namespace Interpolation
 {
 
 
-RMHairProperties::RMHairProperties( const std::string & aFrameFileName )
+RMHairProperties::RMHairProperties( const std::string & aFrameFileName ):
+	mFrameFile( 0 ),
+	mGuidesSegmentsMutable( 0 ),
+	mGuidesRestPositionsDSMutable( 0 )
+{
+	if ( SectionedFileReader::isSectionedFile( aFrameFileName, SECTIONED_FRAME_FILE_ID ) )
+	{
+		importSectionedFile( aFrameFileName );
+	}
+	else if ( SectionedFileReader::isSectionedFile( aFrameFileName, UNVERSIONED_SECTIONED_FRAME_FILE_ID ) )
+	{
+		throw StubbleException( " RMHairProperties::RMHairProperties : unsupported frame file version, export frame again ! " );
+	}
+	else
+	{
+		importZippedFile( aFrameFileName );
+	}
+}
+
+void RMHairProperties::importZippedFile( const std::string & aFrameFileName )
 {
 	std::ifstream file( aFrameFileName.c_str(), std::ios::binary );
 	if ( !file )
 	{
-		throw StubbleException(" RMHairProperties::RMHairProperties : file can not be opened ! ");
+		throw StubbleException(" RMHairProperties::importZippedFile : file can not be opened ! ");
 	}
 	zlib_stream::zip_istream unzipper( file, 15, BUFFER_SIZE, BUFFER_SIZE );
 	char fileid[20];
@@ -30,93 +49,18 @@ RMHairProperties::RMHairProperties( const std::string & aFrameFileName )
 	if ( memcmp( reinterpret_cast< const void * >( fileid ), reinterpret_cast< const void * >( FRAME_FILE_ID ), 
 		FRAME_FILE_ID_SIZE ) != 0 )
 	{
-		throw StubbleException(" RMHairProperties::RMHairProperties : wrong file format ! ");
+		throw StubbleException(" RMHairProperties::importZippedFile : wrong file format ! ");
 	}
-	mDensityTexture = new Texture( unzipper );
-	mInterpolationGroupsTexture = new Texture( unzipper );
-	mCutTexture = new Texture( unzipper );
-	mScaleTexture = new Texture( unzipper );
-	mRandScaleTexture = new Texture( unzipper );
-	mRootThicknessTexture = new Texture( unzipper );
-	mTipThicknessTexture = new Texture( unzipper );
-	mDisplacementTexture = new Texture( unzipper );
-	mRootOpacityTexture = new Texture( unzipper );
-	mTipOpacityTexture = new Texture( unzipper );
-	mRootColorTexture = new Texture( unzipper );
-	mTipColorTexture = new Texture( unzipper );
-	mHueVariationTexture = new Texture( unzipper );
-	mValueVariationTexture = new Texture( unzipper );
-	mMutantHairColorTexture = new Texture( unzipper );
-	mPercentMutantHairTexture = new Texture( unzipper );
-	mRootFrizzTexture = new Texture( unzipper );
-	mTipFrizzTexture = new Texture( unzipper );
-	mFrizzXFrequencyTexture = new Texture( unzipper );
-	mFrizzYFrequencyTexture = new Texture( unzipper );
-	mFrizzZFrequencyTexture = new Texture( unzipper );
-	mFrizzAnimTexture = new Texture( unzipper );
-	mFrizzAnimSpeedTexture = new Texture( unzipper );
-	mRootKinkTexture = new Texture( unzipper );
-	mTipKinkTexture = new Texture( unzipper );
-	mKinkXFrequencyTexture = new Texture( unzipper );
-	mKinkYFrequencyTexture = new Texture( unzipper );
-	mKinkZFrequencyTexture = new Texture( unzipper );
-	mRootSplayTexture = new Texture( unzipper );
-	mTipSplayTexture = new Texture( unzipper );
-	mCenterSplayTexture = new Texture( unzipper );
-	mTwistTexture = new Texture( unzipper );
-	mOffsetTexture = new Texture( unzipper );
-	mAspectTexture = new Texture( unzipper );
-	mRandomizeStrandTexture = new Texture( unzipper );
+	importTextures( unzipper );
 	// Read segments count
 	mInterpolationGroups = new InterpolationGroups( *mInterpolationGroupsTexture, DEFAULT_SEGMENTS_COUNT );
 	mInterpolationGroups->importSegmentsCountFromFile( unzipper );
-	// Read non-texture hair properties
-	unzipper.read( reinterpret_cast< char * >( & mCurrentTime ), sizeof( Time ) );	
-	unzipper.read( reinterpret_cast< char * >( & mScale ), sizeof( Real ) );	
-	unzipper.read( reinterpret_cast< char * >( & mRandScale ), sizeof( Real ) );	
-	unzipper.read( reinterpret_cast< char * >( & mRootThickness ), sizeof( Real ) );	
-	unzipper.read( reinterpret_cast< char * >( & mTipThickness ), sizeof( Real ) );	
-	unzipper.read( reinterpret_cast< char * >( & mDisplacement ), sizeof( Real ) );	
-	unzipper.read( reinterpret_cast< char * >( & mSkipThreshold ), sizeof( Real ) );
-	unzipper.read( reinterpret_cast< char * >( & mRootOpacity ), sizeof( Real ) );	
-	unzipper.read( reinterpret_cast< char * >( & mTipOpacity ), sizeof( Real ) );	
-	unzipper.read( reinterpret_cast< char * >( mRootColor ), 3 * sizeof( Real ) );	
-	unzipper.read( reinterpret_cast< char * >( mTipColor ), 3 * sizeof( Real ) );	
-	unzipper.read( reinterpret_cast< char * >( & mHueVariation ), sizeof( Real ) );	
-	unzipper.read( reinterpret_cast< char * >( & mValueVariation ), sizeof( Real ) );	
-	unzipper.read( reinterpret_cast< char * >( mMutantHairColor ), 3 * sizeof( Real ) );	
-	unzipper.read( reinterpret_cast< char * >( & mPercentMutantHair ), sizeof( Real ) );
-	unzipper.read( reinterpret_cast< char * >( & mRootFrizz ), sizeof( Real ) );	
-	unzipper.read( reinterpret_cast< char * >( & mTipFrizz ), sizeof( Real ) );	
-	unzipper.read( reinterpret_cast< char * >( & mFrizzXFrequency ), sizeof( Real ) );	
-	unzipper.read( reinterpret_cast< char * >( & mFrizzYFrequency ), sizeof( Real ) );	
-	unzipper.read( reinterpret_cast< char * >( & mFrizzZFrequency ), sizeof( Real ) );	
-	unzipper.read( reinterpret_cast< char * >( & mFrizzAnim ), sizeof( Real ) );	
-	unzipper.read( reinterpret_cast< char * >( & mFrizzAnimSpeed ), sizeof( Real ) );	
-	unzipper >> mFrizzAnimDirection;
-	unzipper.read( reinterpret_cast< char * >( & mRootKink ), sizeof( Real ) );	
-	unzipper.read( reinterpret_cast< char * >( & mTipKink ), sizeof( Real ) );	
-	unzipper.read( reinterpret_cast< char * >( & mKinkXFrequency ), sizeof( Real ) );	
-	unzipper.read( reinterpret_cast< char * >( & mKinkYFrequency ), sizeof( Real ) );	
-	unzipper.read( reinterpret_cast< char * >( & mKinkZFrequency ), sizeof( Real ) );	
-	unzipper.read( reinterpret_cast< char * >( & mMultiStrandCount ), sizeof( unsigned __int32 ) );	
-	unzipper.read( reinterpret_cast< char * >( & mRootSplay ), sizeof( Real ) );	
-	unzipper.read( reinterpret_cast< char * >( & mTipSplay ), sizeof( Real ) );	
-	unzipper.read( reinterpret_cast< char * >( & mCenterSplay ), sizeof( Real ) );	
-	unzipper.read( reinterpret_cast< char * >( & mTwist ), sizeof( Real ) );	
-	unzipper.read( reinterpret_cast< char * >( & mOffset ), sizeof( Real ) );	
-	unzipper.read( reinterpret_cast< char * >( & mAspect ), sizeof( Real ) );	
-	unzipper.read( reinterpret_cast< char * >( & mRandomizeStrand ), sizeof( Real ) );
-	// Read number of guides to interpolate from
-	unzipper.read( reinterpret_cast< char * >( &mNumberOfGuidesToInterpolateFrom ), 
-		sizeof( unsigned __int32 ) );
-	// Read whether the normals should be calculated 
-	unzipper.read( reinterpret_cast< char * >( &mAreNormalsCalculated ), 
-		sizeof( bool ) );
+	// Read non-texture hair properties ( zipped files were written only before any property was added )
+	importScalarProperties( unzipper, ZIPPED_SCALAR_PROPERTIES_VERSION );
 	// Read rest positions of guides
 	mGuidesRestPositionsDSMutable = new HairComponents::RestPositionsDS();
 	mGuidesRestPositionsDS = mGuidesRestPositionsDSMutable;
-	mGuidesRestPositionsDSMutable->importFromFile( unzipper, *mInterpolationGroups );
+	mGuidesRestPositionsDSMutable->importFromFile( unzipper, *mInterpolationGroups, mIsGuidesTriangulationUsed );
 	// Import guides count
 	unsigned __int32 size;
 	unzipper.read( reinterpret_cast< char * >( &size ), sizeof( unsigned __int32 ) );
@@ -135,15 +79,191 @@ RMHairProperties::RMHairProperties( const std::string & aFrameFileName )
 			unzipper >> *segIt;
 		}
 	}
-	if ( !file )
+	file.close();
+}
+
+void RMHairProperties::importSectionedFile( const std::string & aFrameFileName )
+{
+	mFrameFile = new SectionedFileReader( aFrameFileName, SECTIONED_FRAME_FILE_ID );
+	// Textures are used in place from mapped file
+	const char * textures = mFrameFile->getSectionData( TEXTURES_SECTION );
+	importTextures( textures );
+	// Read segments count
+	MemoryInputStream groups( mFrameFile->getSectionData( INTERPOLATION_GROUPS_SECTION ),
+		mFrameFile->getSectionSize( INTERPOLATION_GROUPS_SECTION ) );
+	mInterpolationGroups = new InterpolationGroups( *mInterpolationGroupsTexture, DEFAULT_SEGMENTS_COUNT );
+	mInterpolationGroups->importSegmentsCountFromFile( groups );
+	// Read non-texture hair properties
+	MemoryInputStream properties( mFrameFile->getSectionData( SCALAR_PROPERTIES_SECTION ),
+		mFrameFile->getSectionSize( SCALAR_PROPERTIES_SECTION ) );
+	unsigned __int32 version;
+	properties.read( reinterpret_cast< char * >( &version ), sizeof( unsigned __int32 ) );
+	importScalarProperties( properties, version );
+	// Read rest positions of guides
+	MemoryInputStream restPositions( mFrameFile->getSectionData( REST_POSITIONS_SECTION ),
+		mFrameFile->getSectionSize( REST_POSITIONS_SECTION ) );
+	mGuidesRestPositionsDSMutable = new HairComponents::RestPositionsDS();
+	mGuidesRestPositionsDS = mGuidesRestPositionsDSMutable;
+	if ( mFrameFile->hasSection( KD_FOREST_SECTION ) )
 	{
-//		throw StubbleException(" RMHairProperties::RMHairProperties : file can not be opened ! ");
+		// Read already balanced KD trees of rest positions
+		MemoryInputStream kdForest( mFrameFile->getSectionData( KD_FOREST_SECTION ),
+			mFrameFile->getSectionSize( KD_FOREST_SECTION ) );
+		mGuidesRestPositionsDSMutable->importFromFile( restPositions, kdForest, *mInterpolationGroups,
+			mIsGuidesTriangulationUsed );
+	}
+	else // KD trees must be rebuild
+	{
+		mGuidesRestPositionsDSMutable->importFromFile( restPositions, *mInterpolationGroups, 
+			mIsGuidesTriangulationUsed );
+	}
+	// Read guides count and vertices counts of all guides
+	const char * segments = mFrameFile->getSectionData( GUIDES_SEGMENTS_SECTION );
+	const unsigned __int32 * counts = reinterpret_cast< const unsigned __int32 * >( segments );
+	unsigned __int32 size = *( counts++ );
+	mGuidesSegmentsMutable = new HairComponents::GuidesSegments( size );
+	mGuidesSegments = mGuidesSegmentsMutable;
+	// Vertices of all guides are stored as one aligned array behind the counts
+	const unsigned __int64 countsSize = ( size + 1 ) * sizeof( unsigned __int32 );
+	const Vector3D< Real > * vertices = reinterpret_cast< const Vector3D< Real > * >( segments +
+		( countsSize + SectionedFileWriter::SECTION_ALIGNMENT - 1 ) / SectionedFileWriter::SECTION_ALIGNMENT * 
+		SectionedFileWriter::SECTION_ALIGNMENT );
+	// For each guide copy its vertices at once
+	for ( HairComponents::GuidesSegments::iterator it = mGuidesSegmentsMutable->begin(); 
+		it != mGuidesSegmentsMutable->end(); ++it, ++counts )
+	{
+		it->mSegments.assign( vertices, vertices + *counts );
+		vertices += *counts;
 	}
-	file.close();
+}
+
+template< typename tSource >
+void RMHairProperties::importTextures( tSource & aSource )
+{
+	mDensityTexture = new Texture( aSource );
+	mInterpolationGroupsTexture = new Texture( aSource );
+	mCutTexture = new Texture( aSource );
+	mScaleTexture = new Texture( aSource );
+	mRandScaleTexture = new Texture( aSource );
+	mRootThicknessTexture = new Texture( aSource );
+	mTipThicknessTexture = new Texture( aSource );
+	mDisplacementTexture = new Texture( aSource );
+	mRootOpacityTexture = new Texture( aSource );
+	mTipOpacityTexture = new Texture( aSource );
+	mRootColorTexture = new Texture( aSource );
+	mTipColorTexture = new Texture( aSource );
+	mHueVariationTexture = new Texture( aSource );
+	mValueVariationTexture = new Texture( aSource );
+	mMutantHairColorTexture = new Texture( aSource );
+	mPercentMutantHairTexture = new Texture( aSource );
+	mRootFrizzTexture = new Texture( aSource );
+	mTipFrizzTexture = new Texture( aSource );
+	mFrizzXFrequencyTexture = new Texture( aSource );
+	mFrizzYFrequencyTexture = new Texture( aSource );
+	mFrizzZFrequencyTexture = new Texture( aSource );
+	mFrizzAnimTexture = new Texture( aSource );
+	mFrizzAnimSpeedTexture = new Texture( aSource );
+	mRootKinkTexture = new Texture( aSource );
+	mTipKinkTexture = new Texture( aSource );
+	mKinkXFrequencyTexture = new Texture( aSource );
+	mKinkYFrequencyTexture = new Texture( aSource );
+	mKinkZFrequencyTexture = new Texture( aSource );
+	mRootSplayTexture = new Texture( aSource );
+	mTipSplayTexture = new Texture( aSource );
+	mCenterSplayTexture = new Texture( aSource );
+	mTwistTexture = new Texture( aSource );
+	mOffsetTexture = new Texture( aSource );
+	mAspectTexture = new Texture( aSource );
+	mRandomizeStrandTexture = new Texture( aSource );
+	// Textures never change during rendering, so the atlas is built only once
+	updateAttributeAtlas();
+}
+
+void RMHairProperties::importScalarProperties( std::istream & aInputStream, unsigned __int32 aLayoutVersion )
+{
+	if ( aLayoutVersion != ZIPPED_SCALAR_PROPERTIES_VERSION && aLayoutVersion != UNSPLIT_SCALAR_PROPERTIES_VERSION &&
+		aLayoutVersion != SCALAR_PROPERTIES_VERSION )
+	{
+		throw StubbleException( " RMHairProperties::importScalarProperties : unsupported properties version ! " );
+	}
+	aInputStream.read( reinterpret_cast< char * >( & mCurrentTime ), sizeof( Time ) );	
+	aInputStream.read( reinterpret_cast< char * >( & mScale ), sizeof( Real ) );	
+	aInputStream.read( reinterpret_cast< char * >( & mRandScale ), sizeof( Real ) );	
+	aInputStream.read( reinterpret_cast< char * >( & mRootThickness ), sizeof( Real ) );	
+	aInputStream.read( reinterpret_cast< char * >( & mTipThickness ), sizeof( Real ) );	
+	aInputStream.read( reinterpret_cast< char * >( & mDisplacement ), sizeof( Real ) );	
+	aInputStream.read( reinterpret_cast< char * >( & mSkipThreshold ), sizeof( Real ) );
+	aInputStream.read( reinterpret_cast< char * >( & mRootOpacity ), sizeof( Real ) );	
+	aInputStream.read( reinterpret_cast< char * >( & mTipOpacity ), sizeof( Real ) );	
+	aInputStream.read( reinterpret_cast< char * >( mRootColor ), 3 * sizeof( Real ) );	
+	aInputStream.read( reinterpret_cast< char * >( mTipColor ), 3 * sizeof( Real ) );	
+	aInputStream.read( reinterpret_cast< char * >( & mHueVariation ), sizeof( Real ) );	
+	aInputStream.read( reinterpret_cast< char * >( & mValueVariation ), sizeof( Real ) );	
+	aInputStream.read( reinterpret_cast< char * >( mMutantHairColor ), 3 * sizeof( Real ) );	
+	aInputStream.read( reinterpret_cast< char * >( & mPercentMutantHair ), sizeof( Real ) );
+	aInputStream.read( reinterpret_cast< char * >( & mRootFrizz ), sizeof( Real ) );	
+	aInputStream.read( reinterpret_cast< char * >( & mTipFrizz ), sizeof( Real ) );	
+	aInputStream.read( reinterpret_cast< char * >( & mFrizzXFrequency ), sizeof( Real ) );	
+	aInputStream.read( reinterpret_cast< char * >( & mFrizzYFrequency ), sizeof( Real ) );	
+	aInputStream.read( reinterpret_cast< char * >( & mFrizzZFrequency ), sizeof( Real ) );	
+	aInputStream.read( reinterpret_cast< char * >( & mFrizzAnim ), sizeof( Real ) );	
+	aInputStream.read( reinterpret_cast< char * >( & mFrizzAnimSpeed ), sizeof( Real ) );	
+	aInputStream >> mFrizzAnimDirection;
+	aInputStream.read( reinterpret_cast< char * >( & mRootKink ), sizeof( Real ) );	
+	aInputStream.read( reinterpret_cast< char * >( & mTipKink ), sizeof( Real ) );	
+	aInputStream.read( reinterpret_cast< char * >( & mKinkXFrequency ), sizeof( Real ) );	
+	aInputStream.read( reinterpret_cast< char * >( & mKinkYFrequency ), sizeof( Real ) );	
+	aInputStream.read( reinterpret_cast< char * >( & mKinkZFrequency ), sizeof( Real ) );	
+	aInputStream.read( reinterpret_cast< char * >( & mMultiStrandCount ), sizeof( unsigned __int32 ) );	
+	aInputStream.read( reinterpret_cast< char * >( & mRootSplay ), sizeof( Real ) );	
+	aInputStream.read( reinterpret_cast< char * >( & mTipSplay ), sizeof( Real ) );	
+	aInputStream.read( reinterpret_cast< char * >( & mCenterSplay ), sizeof( Real ) );	
+	aInputStream.read( reinterpret_cast< char * >( & mTwist ), sizeof( Real ) );	
+	aInputStream.read( reinterpret_cast< char * >( & mOffset ), sizeof( Real ) );	
+	aInputStream.read( reinterpret_cast< char * >( & mAspect ), sizeof( Real ) );	
+	aInputStream.read( reinterpret_cast< char * >( & mRandomizeStrand ), sizeof( Real ) );
+	if ( aLayoutVersion == ZIPPED_SCALAR_PROPERTIES_VERSION )
+	{
+		// Read number of guides to interpolate from
+		aInputStream.read( reinterpret_cast< char * >( &mNumberOfGuidesToInterpolateFrom ), 
+			sizeof( unsigned __int32 ) );
+		// Read whether the normals should be calculated 
+		aInputStream.read( reinterpret_cast< char * >( &mAreNormalsCalculated ), 
+			sizeof( bool ) );
+		return;
+	}
+	aInputStream.read( reinterpret_cast< char * >( & mIsRandomCounterBased ), sizeof( bool ) );
+	aInputStream.read( reinterpret_cast< char * >( & mRandomSeed ), sizeof( unsigned __int32 ) );
+	aInputStream.read( reinterpret_cast< char * >( & mIsLevelOfDetailUsed ), sizeof( bool ) );
+	aInputStream.read( reinterpret_cast< char * >( & mLodFullDetailSize ), sizeof( Real ) );
+	aInputStream.read( reinterpret_cast< char * >( & mLodMinimumHairRatio ), sizeof( Real ) );
+	aInputStream.read( reinterpret_cast< char * >( & mLodMinimumSegmentsRatio ), sizeof( Real ) );
+	aInputStream.read( reinterpret_cast< char * >( & mDecimationTolerance ), sizeof( Real ) );
+	aInputStream.read( reinterpret_cast< char * >( & mIsDecimationInScreenSpace ), sizeof( bool ) );
+	aInputStream.read( reinterpret_cast< char * >( & mRootsOrder ), sizeof( unsigned __int32 ) );
+	aInputStream.read( reinterpret_cast< char * >( & mCommitSize ), sizeof( unsigned __int32 ) );
+	// Read number of guides to interpolate from
+	aInputStream.read( reinterpret_cast< char * >( &mNumberOfGuidesToInterpolateFrom ), 
+		sizeof( unsigned __int32 ) );
+	// Read whether the guides triangulation is used
+	aInputStream.read( reinterpret_cast< char * >( &mIsGuidesTriangulationUsed ), 
+		sizeof( bool ) );
+	// Read whether the normals should be calculated 
+	aInputStream.read( reinterpret_cast< char * >( &mAreNormalsCalculated ), 
+		sizeof( bool ) );
+	if ( aLayoutVersion == UNSPLIT_SCALAR_PROPERTIES_VERSION )
+	{
+		return; // Default limits of procedural split are used
+	}
+	// Read limits of procedural split
+	aInputStream.read( reinterpret_cast< char * >( & mMaxProceduralCommitsCount ), sizeof( unsigned __int32 ) );
+	aInputStream.read( reinterpret_cast< char * >( & mMaxProceduralChildrenCount ), sizeof( unsigned __int32 ) );
 }
 
 RMHairProperties::~RMHairProperties()
 {
+	delete mFrameFile;
+
 	delete mGuidesSegmentsMutable;
 
 	delete mGuidesRestPositionsDSMutable;
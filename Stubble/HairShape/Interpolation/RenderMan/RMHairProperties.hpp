@@ -2,6 +2,7 @@
 #define STUBBLE_RM_HAIR_PROPERTIES_HPP
 
 #include "../HairProperties.hpp"
+#include "Common/SectionedFile.hpp"
 
 #include <fstream>
 #include <string>
@@ -37,6 +38,40 @@ public:
 	~RMHairProperties();
 
 private:
+
+	///-------------------------------------------------------------------------------------------------
+	/// Imports properties from version 1 frame file ( whole file compressed by zlib stream ). 
+	///
+	/// \param	aFrameFileName	Filename of a frame file. 
+	///-------------------------------------------------------------------------------------------------
+	void importZippedFile( const std::string & aFrameFileName );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Imports properties from memory mapped sectioned frame file. Textures are used in place.
+	///
+	/// \param	aFrameFileName	Filename of a frame file. 
+	///-------------------------------------------------------------------------------------------------
+	void importSectionedFile( const std::string & aFrameFileName );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Imports all textures in order they had been exported.
+	///
+	/// \param [in,out]	aSource	Source of textures ( input stream or pointer to mapped data ).
+	///-------------------------------------------------------------------------------------------------
+	template< typename tSource >
+	void importTextures( tSource & aSource );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Imports non-texture hair properties. Properties which are not stored in given layout keep
+	/// their default values, so the hair are generated as before these properties were introduced.
+	///
+	/// \param [in,out]	aInputStream	The input stream.
+	/// \param	aLayoutVersion			The version of properties layout ( see SCALAR_PROPERTIES_VERSION ).
+	///-------------------------------------------------------------------------------------------------
+	void importScalarProperties( std::istream & aInputStream, unsigned __int32 aLayoutVersion );
+
+	SectionedFileReader * mFrameFile;   ///< The mapped frame file ( NULL for version 1 file )
+
 	/* RMHairProperties owns guides data */
 	HairComponents::GuidesSegments * mGuidesSegmentsMutable;   ///< The guides segments
 
@@ -9,13 +9,15 @@ namespace HairShape
 namespace Interpolation
 {
 
-const RtString RMOutputGenerator::HAIR_UV_COORDINATE_TOKEN = "UV";
+// Variables are declared inline, RiDeclare would modify global declarations shared by all threads
 
-const RtString RMOutputGenerator::STRAND_UV_COORDINATE_TOKEN = "UV_strand";
+const RtString RMOutputGenerator::HAIR_UV_COORDINATE_TOKEN = const_cast< RtString >( "uniform float[2] UV" );
 
-const RtString RMOutputGenerator::HAIR_INDEX_TOKEN = "ID";
+const RtString RMOutputGenerator::STRAND_UV_COORDINATE_TOKEN = const_cast< RtString >( "uniform float[2] UV_strand" );
 
-const RtString RMOutputGenerator::STRAND_INDEX_TOKEN = "ID_strand";
+const RtString RMOutputGenerator::HAIR_INDEX_TOKEN = const_cast< RtString >( "uniform int ID" );
+
+const RtString RMOutputGenerator::STRAND_INDEX_TOKEN = const_cast< RtString >( "uniform int ID_strand" );
 
 } // namespace Interpolation
 
@@ -6,6 +6,8 @@
 
 #include "ri.h"
 
+#include <algorithm>
+
 namespace Stubble
 {
 
@@ -64,15 +66,22 @@ struct RMTypes
 /// Class for drawing generated hair inside RenderMan plugin.
 /// This class implements OutputGenerator which is the standard interface for 
 /// communication with hair generator class.
+/// Generated hair are sent to RenderMan by RiCurves calls, each call contains at most commit size 
+/// points, so memory used by this class does not depend on hair count.
 ///-------------------------------------------------------------------------------------------------
 class RMOutputGenerator : public OutputGenerator< RMTypes >, public RMTypes
 {
 public:
 
 	///-------------------------------------------------------------------------------------------------
-	/// Default constructor. 
+	/// Constructor. 
+	/// Memory is allocated in beginOutput, buffers are never larger than commit size ( only if single
+	/// hair does not fit into commit size ). Generated hair are sent to RenderMan when buffers are full 
+	/// or end of output is signaled.
+	/// 
+	/// \param	aCommitSize	Number of hair points in single commit. 
 	///-------------------------------------------------------------------------------------------------
-	inline RMOutputGenerator();
+	inline RMOutputGenerator( unsigned __int32 aCommitSize );
 
 	///-------------------------------------------------------------------------------------------------
 	/// Finaliser. 
@@ -86,6 +95,13 @@ public:
 	///-------------------------------------------------------------------------------------------------
 	inline void setOutputNormals( bool aOutputNormals );
 
+	///-------------------------------------------------------------------------------------------------
+	/// Query if normals are outputed to RenderMan.
+	///
+	/// \return	true if normals are used. 
+	///-------------------------------------------------------------------------------------------------
+	inline bool areNormalsUsed() const;
+
 	///-------------------------------------------------------------------------------------------------
 	/// Begins an output of interpolated hair.
 	/// Must be called before any hair is outputed. 
@@ -93,7 +109,7 @@ public:
 	/// \param	aMaxHairCount	Number of a maximum hair. 
 	/// \param	aMaxPointsCount	Number of a maximum points. 
 	///-------------------------------------------------------------------------------------------------
-	inline void beginOutput( unsigned __int32 aMaxHairCount, unsigned __int32 aMaxPointsCount );
+	inline void beginOutput( unsigned __int64 aMaxHairCount, unsigned __int32 aMaxPointsCount );
 
 	///----------------------------------------------------------------------------------------------------
 	/// Ends an output.
@@ -194,11 +210,6 @@ public:
 	///-------------------------------------------------------------------------------------------------
 	inline IndexType * strandIndexPointer();
 
-	///-------------------------------------------------------------------------------------------------
-	/// Declares renderman variables. 
-	///-------------------------------------------------------------------------------------------------
-	inline static void declareVariables();
-
 private:
 
 	static const RtString HAIR_UV_COORDINATE_TOKEN;	///< The hair uv coordinate token
@@ -224,6 +235,8 @@ private:
 	///----------------------------------------------------------------------------------------------------
 	inline void freeMemory();
 
+	const unsigned __int32 mCommitSize;   ///< Size of the commit
+
 	unsigned __int32 mBuffersSize;   ///< Size of the internal buffers ( hair points mutliplied by hair count )
 
 	unsigned __int32 mMaxHairCount; ///< Number of maximum hairs
@@ -273,7 +286,7 @@ private:
 
 // inline functions implementation
 
-inline RMOutputGenerator::RMOutputGenerator():
+inline RMOutputGenerator::RMOutputGenerator( unsigned __int32 aCommitSize ):
 	mSegmentsCount( 0 ),
 	mPositionData( 0 ),
 	mColorData( 0 ),
@@ -294,8 +307,10 @@ inline RMOutputGenerator::RMOutputGenerator():
 	mStrandUVCoordinateDataPointer( 0 ),
 	mHairIndexDataPointer( 0 ),
 	mStrandIndexDataPointer( 0 ),
+	mCommitSize( aCommitSize ),
 	mBuffersSize( 0 ),
-	mMaxHairCount( 0 )
+	mMaxHairCount( 0 ),
+	mOutputNormals( false )
 {
 }
 
@@ -309,25 +324,37 @@ inline void RMOutputGenerator::setOutputNormals( bool aOutputNormals )
 	mOutputNormals = aOutputNormals;
 }
 
-inline void RMOutputGenerator::beginOutput( unsigned __int32 aMaxHairCount, unsigned __int32 aMaxPointsCount )
+inline bool RMOutputGenerator::areNormalsUsed() const
 {
-	// Calculate needed buffers size
-	unsigned __int32 newBuffersSize = aMaxHairCount * aMaxPointsCount;
+	return mOutputNormals;
+}
+
+inline void RMOutputGenerator::beginOutput( unsigned __int64 aMaxHairCount, unsigned __int32 aMaxPointsCount )
+{
+	// Calculate needed buffers size, buffers are limited by commit size, but single hair must always fit
+	const unsigned __int64 allHairSize = multiplyCounts( aMaxHairCount, aMaxPointsCount );
+	const unsigned __int32 newBuffersSize = static_cast< unsigned __int32 >( 
+		std::min( allHairSize, static_cast< unsigned __int64 >( std::max( mCommitSize, aMaxPointsCount ) ) ) );
+	// Points buffers have up to 3 components
+	narrowCount< size_t >( multiplyCounts( newBuffersSize, 3 ) );
+	// Every hair has at least 2 points
+	const unsigned __int32 newMaxHairCount = static_cast< unsigned __int32 >( 
+		std::min( aMaxHairCount, static_cast< unsigned __int64 >( newBuffersSize / 2 ) ) );
 	// Need to allocate more memory ?
-	if ( newBuffersSize > mBuffersSize || aMaxHairCount > mMaxHairCount )
+	if ( newBuffersSize > mBuffersSize || newMaxHairCount > mMaxHairCount )
 	{
 		try
 		{
 			// Kill old memory
 			freeMemory();
 			// Allocate new memory
-			mMaxHairCount = aMaxHairCount;
+			mMaxHairCount = newMaxHairCount;
 			mBuffersSize = newBuffersSize;
-			mPositionData = new RMTypes::PositionType[ mBuffersSize * 3 ];
-			mColorData = new RMTypes::ColorType[ mBuffersSize * 3 ];
-			mNormalData = new RMTypes::NormalType[ mBuffersSize * 3];
+			mPositionData = new RMTypes::PositionType[ static_cast< size_t >( mBuffersSize ) * 3 ];
+			mColorData = new RMTypes::ColorType[ static_cast< size_t >( mBuffersSize ) * 3 ];
+			mNormalData = new RMTypes::NormalType[ static_cast< size_t >( mBuffersSize ) * 3 ];
 			mWidthData = new RMTypes::WidthType[ mBuffersSize ];
-			mOpacityData = new RMTypes::OpacityType[ mBuffersSize * 3 ];
+			mOpacityData = new RMTypes::OpacityType[ static_cast< size_t >( mBuffersSize ) * 3 ];
 			mSegmentsCount = new RtInt[ mMaxHairCount ]; 
 			mHairUVCoordinateData = new RMTypes::UVCoordinateType[ mMaxHairCount * 2 ];
 			mStrandUVCoordinateData = new RMTypes::UVCoordinateType[ mMaxHairCount * 2 ];
@@ -351,7 +378,14 @@ inline void RMOutputGenerator::endOutput()
 
 inline void RMOutputGenerator::beginHair( unsigned __int32 aMaxPointsCount )
 {
-	/* EMPTY */
+	// If the added hair won't fit into the buffers, commit and reset them
+	if ( ( mPositionDataPointer + static_cast< size_t >( aMaxPointsCount ) * 3 ) > 
+		( mPositionData + static_cast< size_t >( mBuffersSize ) * 3 ) ||
+		( mSegmentsCountPointer == mSegmentsCount + mMaxHairCount ) )
+	{
+		commit();
+		reset();
+	}
 }
 
 inline void RMOutputGenerator::endHair( unsigned __int32 aPointsCount )
@@ -419,14 +453,6 @@ inline RMTypes::IndexType * RMOutputGenerator::strandIndexPointer()
 	return mStrandIndexDataPointer;
 }
 
-inline void RMOutputGenerator::declareVariables()
-{
-	RiDeclare( HAIR_UV_COORDINATE_TOKEN, "uniform float[2]" );
-	RiDeclare( STRAND_UV_COORDINATE_TOKEN, "uniform float[2]" );
-	RiDeclare( HAIR_INDEX_TOKEN, "uniform int" );
-	RiDeclare( STRAND_INDEX_TOKEN, "uniform int" );
-}
-
 inline void RMOutputGenerator::reset()
 {
 	mSegmentsCountPointer = mSegmentsCount;
@@ -469,25 +495,25 @@ inline void RMOutputGenerator::commit()
 
 inline void RMOutputGenerator::freeMemory()
 {
-	delete mSegmentsCount;
+	delete [] mSegmentsCount;
 	mSegmentsCount = 0;
-	delete mPositionData;
+	delete [] mPositionData;
 	mPositionData = 0;
-	delete mColorData;
+	delete [] mColorData;
 	mColorData = 0;
-	delete mNormalData;
+	delete [] mNormalData;
 	mNormalData = 0;
-	delete mWidthData;
+	delete [] mWidthData;
 	mWidthData = 0;
-	delete mOpacityData;
+	delete [] mOpacityData;
 	mOpacityData = 0;
-	delete mHairUVCoordinateData;
+	delete [] mHairUVCoordinateData;
 	mHairUVCoordinateData = 0;
-	delete mStrandUVCoordinateData;
+	delete [] mStrandUVCoordinateData;
 	mStrandUVCoordinateData = 0;
-	delete mHairIndexData;
+	delete [] mHairIndexData;
 	mHairIndexData = 0;
-	delete mStrandIndexData;
+	delete [] mStrandIndexData;
 	mStrandIndexData = 0;
 }
 
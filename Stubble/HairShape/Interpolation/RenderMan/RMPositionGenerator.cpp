@@ -1,7 +1,10 @@
 #include "Common\CommonConstants.hpp"
+#include "Common\CommonFunctions.hpp"
 
 #include "RMPositionGenerator.hpp"
 
+#include "Common/SectionedFile.hpp"
+
 #include <fstream>
 #include <zipstream.hpp>
 
@@ -16,58 +19,140 @@ namespace HairShape
 namespace Interpolation
 {
 
-RMPositionGenerator::RMPositionGenerator( const Texture & aDensityTexture, const std::string & aVoxelFileName ):
+RMPositionGenerator::RMPositionGenerator( const HairProperties & aHairProperties, const std::string & aVoxelFileName ):
 	mRestPoseMesh( 0 ),
 	mCurrentMesh( 0 ),
-	mUVPointGenerator( 0 )
+	mUVPointGenerator( 0 ),
+	mBakedRoots( 0 ),
+	mOrderedRoots( 0 ),
+	mLastBakedRoot( 0 )
 {
 	try {
-		std::ifstream file( aVoxelFileName.c_str(), std::ios::binary );
-		if ( !file )
+		if ( SectionedFileReader::isSectionedFile( aVoxelFileName, SECTIONED_VOXEL_FILE_ID ) )
 		{
-			throw StubbleException(" RMPositionGenerator::RMPositionGenerator : file can not be opened ! ");
+			SectionedFileReader voxelFile( aVoxelFileName, SECTIONED_VOXEL_FILE_ID );
+			MemoryInputStream voxelSection( voxelFile.getSectionData( VOXEL_SECTION ),
+				voxelFile.getSectionSize( VOXEL_SECTION ) );
+			importVoxel( voxelSection, aHairProperties, true );
 		}
-		zlib_stream::zip_istream unzipper( file, 15, BUFFER_SIZE, BUFFER_SIZE );
-		char fileid[20];
-		// Read file id
-		unzipper.read( fileid, VOXEL_FILE_ID_SIZE );
-		if ( memcmp( reinterpret_cast< const void * >( fileid ), reinterpret_cast< const void * >( VOXEL_FILE_ID ), 
-			VOXEL_FILE_ID_SIZE ) != 0 )
+		else if ( SectionedFileReader::isSectionedFile( aVoxelFileName, NARROW_SECTIONED_VOXEL_FILE_ID ) )
 		{
-			throw StubbleException(" RMPositionGenerator::RMPositionGenerator : wrong file format ! ");
+			SectionedFileReader voxelFile( aVoxelFileName, NARROW_SECTIONED_VOXEL_FILE_ID );
+			MemoryInputStream voxelSection( voxelFile.getSectionData( VOXEL_SECTION ),
+				voxelFile.getSectionSize( VOXEL_SECTION ) );
+			importVoxel( voxelSection, aHairProperties, false );
 		}
-		// Read hair start index
-		unzipper.read( reinterpret_cast< char * >( &mStartIndex ), sizeof( unsigned __int32 ) );
-		// Read hair count
-		unzipper.read( reinterpret_cast< char * >( &mCount ), sizeof( unsigned __int32 ) );
-		// Read rest pose mesh
-		mRestPoseMesh = new Mesh( unzipper, false );
-		// Read current mesh
-		mCurrentMesh = new Mesh( unzipper, true );
-		// Create uv point generator
-		mUVPointGenerator = new UVPointGenerator( aDensityTexture, mRestPoseMesh->getTriangleConstIterator(), randomGenerator );
-		// Read bounding box
-		Vector3D< Real > tmp;
-		unzipper >> tmp;
-		mVoxelBoundingBox.expand( tmp );
-		unzipper >> tmp;
-		mVoxelBoundingBox.expand( tmp );
-		// Close file
-		if ( !file )
+		else // Version 1 file
 		{
-//			throw StubbleException(" RMPositionGenerator::RMPositionGenerator : file can not be opened ! ");
+			std::ifstream file( aVoxelFileName.c_str(), std::ios::binary );
+			if ( !file )
+			{
+				throw StubbleException(" RMPositionGenerator::RMPositionGenerator : file can not be opened ! ");
+			}
+			zlib_stream::zip_istream unzipper( file, 15, BUFFER_SIZE, BUFFER_SIZE );
+			char fileid[20];
+			// Read file id
+			unzipper.read( fileid, VOXEL_FILE_ID_SIZE );
+			if ( memcmp( reinterpret_cast< const void * >( fileid ), reinterpret_cast< const void * >( VOXEL_FILE_ID ), 
+				VOXEL_FILE_ID_SIZE ) == 0 )
+			{
+				importVoxel( unzipper, aHairProperties, false );
+			}
+			else if ( memcmp( reinterpret_cast< const void * >( fileid ), 
+				reinterpret_cast< const void * >( UNBAKED_VOXEL_FILE_ID ), VOXEL_FILE_ID_SIZE ) == 0 )
+			{
+				// Files exported before roots baking have no baked roots flag
+				importVoxel( unzipper, aHairProperties, false, false );
+			}
+			else
+			{
+				throw StubbleException(" RMPositionGenerator::RMPositionGenerator : wrong file format ! ");
+			}
+			file.close();
 		}
-		file.close();
 	}
 	catch( ... )
 	{
 		delete mRestPoseMesh;
 		delete mCurrentMesh;
 		delete mUVPointGenerator;
+		delete [] mBakedRoots;
+		delete [] mOrderedRoots;
+		throw;
 	}
 	
 }
 
+void RMPositionGenerator::importVoxel( std::istream & aInputStream, const HairProperties & aHairProperties,
+	bool aAreCountsWide, bool aHasBakedRootsFlag )
+{
+	// Read hair start index and hair count
+	if ( aAreCountsWide )
+	{
+		aInputStream.read( reinterpret_cast< char * >( &mStartIndex ), sizeof( unsigned __int64 ) );
+		aInputStream.read( reinterpret_cast< char * >( &mCount ), sizeof( unsigned __int64 ) );
+	}
+	else // Older files store 32 bit counts
+	{
+		unsigned __int32 startIndex, count;
+		aInputStream.read( reinterpret_cast< char * >( &startIndex ), sizeof( unsigned __int32 ) );
+		aInputStream.read( reinterpret_cast< char * >( &count ), sizeof( unsigned __int32 ) );
+		mStartIndex = startIndex;
+		mCount = count;
+	}
+	mNextIndex = mStartIndex;
+	// Whole voxel is selected by default
+	mEndIndex = mStartIndex + mCount;
+	mRangeStartIndex = mStartIndex;
+	mRangeCount = mCount;
+	// Read rest pose mesh
+	mRestPoseMesh = new Mesh( aInputStream, false );
+	// Read current mesh
+	mCurrentMesh = new Mesh( aInputStream, true );
+	// Read baked roots flag
+	bool areRootsBaked = false;
+	if ( aHasBakedRootsFlag )
+	{
+		aInputStream.read( reinterpret_cast< char * >( &areRootsBaked ), sizeof( bool ) );
+	}
+	if ( areRootsBaked )
+	{
+		// Read baked roots
+		const size_t count = narrowCount< size_t >( mCount );
+		mBakedRoots = new BakedHairRoot[ count ];
+		for ( BakedHairRoot * it = mBakedRoots, * end = mBakedRoots + count; it != end; ++it )
+		{
+			it->importFromFile( aInputStream );
+		}
+	}
+	else
+	{
+		// Select random generator
+		if ( aHairProperties.isRandomCounterBased() )
+		{
+			randomGenerator.resetCounterBased( aHairProperties.getRandomSeed(), RandomGenerator::HAIR_ROOTS_DOMAIN );
+		}
+		// Create uv point generator
+		mUVPointGenerator = new UVPointGenerator( aHairProperties.getDensityTexture(), 
+			mRestPoseMesh->getTriangleConstIterator(), randomGenerator );
+		// Roots ordered by space filling curve are generated for whole voxel at once ( same as in Maya )
+		if ( HairRootsOrder::isOrdered( aHairProperties ) && mCount > 0 )
+		{
+			// Ordered roots of whole voxel are held in memory, so their count is limited to 32 bits
+			const unsigned __int32 count = narrowCount< unsigned __int32 >( mCount );
+			mOrderedRoots = new UVPoint[ count ];
+			HairRootsOrder::generateRoots( aHairProperties, *mUVPointGenerator, *mRestPoseMesh, mStartIndex,
+				count, mOrderedRoots );
+		}
+	}
+	// Read bounding box
+	Vector3D< Real > tmp;
+	aInputStream >> tmp;
+	mVoxelBoundingBox.expand( tmp );
+	aInputStream >> tmp;
+	mVoxelBoundingBox.expand( tmp );
+}
+
 } // namespace Interpolation
 
 } // namespace HairShape
@@ -3,6 +3,9 @@
 
 #include "HairShape/Generators/UVPointGenerator.hpp"
 #include "HairShape/Mesh/Mesh.hpp"
+#include "../BakedHairRoot.hpp"
+#include "../HairProperties.hpp"
+#include "../HairRootsOrder.hpp"
 #include "../PositionGenerator.hpp"
 #include "Primitives/BoundingBox.hpp"
 
@@ -18,19 +21,21 @@ namespace Interpolation
 ///-------------------------------------------------------------------------------------------------
 /// The position generator of interpolated hair used in RenderMan plugin.
 /// This class loads voxel data ( current mesh, rest pose mesh, hair count etc. ) from selected file 
-/// and creates samples generator, which is then used for hair positions generation.
+/// and creates samples generator, which is then used for hair positions generation. If voxel file
+/// contains baked hair roots, they are used instead of samples generator.
+/// Hair of voxel can be generated in parts, each part is selected by selectNextRange.
 ///-------------------------------------------------------------------------------------------------
 class RMPositionGenerator : public PositionGenerator
 {
 public:
 
 	///-------------------------------------------------------------------------------------------------
-	/// Constructor. Loads mesh data from voxel file and creates UV point generator.
+	/// Constructor. Loads mesh data from voxel file and creates UV point generator ( or loads baked roots ).
 	///
-	/// \param	aDensityTexture	The density texture. 
+	/// \param	aHairProperties	The hair properties ( density texture and random generator settings ). 
 	/// \param	aVoxelFileName	Filename of the voxel file. 
 	///-------------------------------------------------------------------------------------------------
-	RMPositionGenerator( const Texture & aDensityTexture, const std::string & aVoxelFileName );
+	RMPositionGenerator( const HairProperties & aHairProperties, const std::string & aVoxelFileName );
 
 	///-------------------------------------------------------------------------------------------------
 	/// Finaliser. 
@@ -57,18 +62,45 @@ public:
 		const Texture & aDisplacementTexture, Real aDisplacementFactor );
 
 	///-------------------------------------------------------------------------------------------------
-	/// Gets the number of the hair to be interpolated.
+	/// Gets the number of the hair to be interpolated in selected range ( whole voxel by default ).
 	///
 	/// \return	The hair count. 
 	///-------------------------------------------------------------------------------------------------
-	inline unsigned __int32 getHairCount() const;
+	inline unsigned __int64 getHairCount() const;
 	
 	///-------------------------------------------------------------------------------------------------
-	/// Gets the index of first hair which position is generated by this generator. 
+	/// Gets the index of first hair in selected range ( first hair of voxel by default ). 
 	///
 	/// \return	The index of first hair which position is generated by this generator. 
 	///-------------------------------------------------------------------------------------------------
-	inline unsigned __int32 getHairStartIndex() const;
+	inline unsigned __int64 getHairStartIndex() const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the number of all hair in voxel.
+	///
+	/// \return	The voxel hair count. 
+	///-------------------------------------------------------------------------------------------------
+	inline unsigned __int64 getVoxelHairCount() const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Selects range of hair starting with the next not generated hair. All hair of previous range
+	/// must have been generated.
+	///
+	/// \param	aMaxHairCount	The maximum number of hair in range. 
+	///
+	/// \return	Number of hair in selected range ( 0 if all hair of voxel have been generated ). 
+	///-------------------------------------------------------------------------------------------------
+	inline unsigned __int64 selectNextRange( unsigned __int64 aMaxHairCount );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Restricts generated hair to contiguous part of voxel hair, next generated hair is the first hair
+	/// of part and following ranges are selected only inside it. Roots of part are the same as if
+	/// whole voxel was generated only if random generator is counter based ( or roots are baked ).
+	///
+	/// \param	aStartIndex	Index of the first hair of part.
+	/// \param	aCount		Number of hair in part.
+	///-------------------------------------------------------------------------------------------------
+	inline void restrictToPart( unsigned __int64 aStartIndex, unsigned __int64 aCount );
 
 	///-------------------------------------------------------------------------------------------------
 	/// Gets the voxel bounding box. 
@@ -78,19 +110,59 @@ public:
 	///-------------------------------------------------------------------------------------------------
 	inline const BoundingBox & getVoxelBoundingBox() const;
 
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the baked root of the last generated hair.
+	///
+	/// \return	The baked root of the last generated hair or NULL if voxel file has no baked roots. 
+	///-------------------------------------------------------------------------------------------------
+	inline const BakedHairRoot * getBakedRoot() const;
+
 private:
 
+	///-------------------------------------------------------------------------------------------------
+	/// Imports voxel data ( hair count, meshes, baked roots and bounding box ) from stream.
+	///
+	/// \param [in,out]	aInputStream	The input stream. 
+	/// \param	aHairProperties			The hair properties. 
+	/// \param	aAreCountsWide			true if hair start index and count are stored in 64 bits. 
+	/// \param	aHasBakedRootsFlag		true if baked roots flag is stored after meshes ( false for the
+	/// 								oldest zipped files, which have no baked roots ). 
+	///-------------------------------------------------------------------------------------------------
+	void importVoxel( std::istream & aInputStream, const HairProperties & aHairProperties, bool aAreCountsWide,
+		bool aHasBakedRootsFlag = true );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Generates position of next hair root on mesh.
+	///
+	/// \return	The position of next hair root. 
+	///-------------------------------------------------------------------------------------------------
+	inline UVPoint nextUVPoint();
+
 	Mesh * mCurrentMesh;	///< The current mesh
 
 	Mesh * mRestPoseMesh;   ///< The rest pose mesh
 
-	UVPointGenerator * mUVPointGenerator;   ///< The uv point generator
+	UVPointGenerator * mUVPointGenerator;   ///< The uv point generator ( NULL if roots are baked )
+
+	BakedHairRoot * mBakedRoots;	///< The baked roots of hair ( NULL if roots are not baked )
+
+	UVPoint * mOrderedRoots;	///< The roots ordered by space filling curve ( NULL if not ordered or baked )
+
+	const BakedHairRoot * mLastBakedRoot;	///< The baked root of the last generated hair
 
 	RandomGenerator randomGenerator;	///< The random generator
 	
-	unsigned __int32 mCount;	///< Number of the interpolated hair.
+	unsigned __int64 mCount;	///< Number of the interpolated hair.
+
+	unsigned __int64 mStartIndex;   ///< The start index of hair
+
+	unsigned __int64 mNextIndex;	///< The index of next generated hair
 
-	unsigned __int32 mStartIndex;   ///< The start index of hair
+	unsigned __int64 mEndIndex; ///< The index after the last generated hair ( end of voxel or its part )
+
+	unsigned __int64 mRangeStartIndex;  ///< The index of first hair in selected range
+
+	unsigned __int64 mRangeCount;   ///< Number of hair in selected range
 
 	BoundingBox mVoxelBoundingBox;  ///< The voxel bounding box
 };
@@ -102,11 +174,13 @@ inline RMPositionGenerator::~RMPositionGenerator()
 	delete mCurrentMesh;
 	delete mRestPoseMesh;
 	delete mUVPointGenerator;
+	delete [] mBakedRoots;
+	delete [] mOrderedRoots;
 }
 
 inline void RMPositionGenerator::generate( MeshPoint & aCurrentPosition, MeshPoint & aRestPosition )
 {
-	UVPoint uv = mUVPointGenerator->next(); // Generate uv pos
+	UVPoint uv = nextUVPoint(); // Generate uv pos
 	aCurrentPosition = mCurrentMesh->getMeshPoint( uv );
 	aRestPosition = mRestPoseMesh->getMeshPoint( uv );
 }
@@ -114,19 +188,44 @@ inline void RMPositionGenerator::generate( MeshPoint & aCurrentPosition, MeshPoi
 inline void RMPositionGenerator::generate( MeshPoint & aCurrentPosition, MeshPoint & aRestPosition,
 	const Texture & aDisplacementTexture, Real aDisplacementFactor )
 {
-	UVPoint uv = mUVPointGenerator->next(); // Generate uv pos
+	UVPoint uv = nextUVPoint(); // Generate uv pos
 	aCurrentPosition = mCurrentMesh->getDisplacedMeshPoint( uv, aDisplacementTexture, aDisplacementFactor );
 	aRestPosition = mRestPoseMesh->getMeshPoint( uv );
 }
 
-inline unsigned __int32 RMPositionGenerator::getHairCount() const
+inline unsigned __int64 RMPositionGenerator::getHairCount() const
+{
+	return mRangeCount;
+}
+
+inline unsigned __int64 RMPositionGenerator::getHairStartIndex() const
+{
+	return mRangeStartIndex;
+}
+
+inline unsigned __int64 RMPositionGenerator::getVoxelHairCount() const
 {
 	return mCount;
 }
 
-inline unsigned __int32 RMPositionGenerator::getHairStartIndex() const
+inline unsigned __int64 RMPositionGenerator::selectNextRange( unsigned __int64 aMaxHairCount )
+{
+	const unsigned __int64 remainingCount = mEndIndex - mNextIndex;
+	mRangeStartIndex = mNextIndex;
+	mRangeCount = remainingCount < aMaxHairCount ? remainingCount : aMaxHairCount;
+	return mRangeCount;
+}
+
+inline void RMPositionGenerator::restrictToPart( unsigned __int64 aStartIndex, unsigned __int64 aCount )
 {
-	return mStartIndex;
+	if ( aStartIndex < mStartIndex || aCount > mStartIndex + mCount - aStartIndex )
+	{
+		throw StubbleException( " RMPositionGenerator::restrictToPart : part is not inside voxel ! " );
+	}
+	mNextIndex = aStartIndex;
+	mEndIndex = aStartIndex + aCount;
+	mRangeStartIndex = aStartIndex;
+	mRangeCount = aCount;
 }
 
 inline const BoundingBox & RMPositionGenerator::getVoxelBoundingBox() const
@@ -134,6 +233,25 @@ inline const BoundingBox & RMPositionGenerator::getVoxelBoundingBox() const
 	return mVoxelBoundingBox;
 }
 
+inline const BakedHairRoot * RMPositionGenerator::getBakedRoot() const
+{
+	return mLastBakedRoot;
+}
+
+inline UVPoint RMPositionGenerator::nextUVPoint()
+{
+	if ( mBakedRoots != 0 ) // Baked roots are stored in hair order
+	{
+		mLastBakedRoot = mBakedRoots + ( mNextIndex++ - mStartIndex );
+		return mLastBakedRoot->mUVPoint;
+	}
+	if ( mOrderedRoots != 0 ) // Ordered roots are stored in hair order
+	{
+		return mOrderedRoots[ mNextIndex++ - mStartIndex ];
+	}
+	return mUVPointGenerator->next( mNextIndex++ );
+}
+
 } // namespace Interpolation
 
 } // namespace HairShape
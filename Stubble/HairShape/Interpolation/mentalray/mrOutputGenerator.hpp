@@ -91,6 +91,13 @@ public:
 	///-------------------------------------------------------------------------------------------------
 	inline void setOutputNormals( bool aOutputNormals );
 
+	///-------------------------------------------------------------------------------------------------
+	/// Query if normals are outputed to mental ray.
+	///
+	/// \return	true if normals are used. 
+	///-------------------------------------------------------------------------------------------------
+	inline bool areNormalsUsed() const;
+
 	///-------------------------------------------------------------------------------------------------
 	/// Begins an output of interpolated hair.
 	/// Must be called before any hair is outputed. 
@@ -98,7 +105,7 @@ public:
 	/// \param	aMaxHairCount	Number of a maximum hair. 
 	/// \param	aMaxPointsCount	Number of a maximum points. 
 	///-------------------------------------------------------------------------------------------------
-	inline void beginOutput( unsigned __int32 aMaxHairCount, unsigned __int32 aMaxPointsCount );
+	inline void beginOutput( unsigned __int64 aMaxHairCount, unsigned __int32 aMaxPointsCount );
 
 	///----------------------------------------------------------------------------------------------------
 	/// Ends an output.
@@ -291,7 +298,8 @@ inline MROutputGenerator::MROutputGenerator( unsigned __int32 aCommitSize ):
 	mStrandUVCoordinateDataPointer( 0 ),
 	mHairIndexDataPointer( 0 ),
 	mStrandIndexDataPointer( 0 ),
-	mCommitSize( aCommitSize )
+	mCommitSize( aCommitSize ),
+	mOutputNormals( false )
 {
 	try
 	{
@@ -326,7 +334,12 @@ inline void MROutputGenerator::setOutputNormals( bool aOutputNormals )
 	mOutputNormals = aOutputNormals;
 }
 
-inline void MROutputGenerator::beginOutput( unsigned __int32 aMaxHairCount, unsigned __int32 aMaxPointsCount )
+inline bool MROutputGenerator::areNormalsUsed() const
+{
+	return mOutputNormals;
+}
+
+inline void MROutputGenerator::beginOutput( unsigned __int64 aMaxHairCount, unsigned __int32 aMaxPointsCount )
 {
 	reset();
 }
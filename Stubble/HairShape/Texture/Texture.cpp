@@ -1,6 +1,7 @@
 #include "Texture.hpp"
 
 #include "math.h"
+#include "Common\SectionedFile.hpp"
 #include "Common\StubbleException.hpp"
 #include "Common\StubbleTimer.hpp"
 
@@ -45,6 +46,24 @@ Texture::Texture( std::istream & aIsStream )
 	mTexture = new float[ mWidth * mHeight * mColorComponents ];
 	aIsStream.read( reinterpret_cast< char * >( mTexture ), 
 		mWidth * mHeight * mColorComponents * sizeof( float ) );
+	mOwnsTexture = true;
+	mDirty = false;
+	mIsAnimated = false;
+	computeInverseSize();
+}
+
+Texture::Texture( const char *& aMappedData )
+{
+	const unsigned __int32 * header = reinterpret_cast< const unsigned __int32 * >( aMappedData );
+	mWidth = header[ 0 ];
+	mHeight = header[ 1 ];
+	mColorComponents = header[ 2 ];
+	aMappedData += DATA_ALIGNMENT;
+	// Mapped data are only read, so the texture matrix is never modified
+	mTexture = reinterpret_cast< float * >( const_cast< char * >( aMappedData ) );
+	mOwnsTexture = false;
+	unsigned __int32 size = mWidth * mHeight * mColorComponents * sizeof( float );
+	aMappedData += ( size + DATA_ALIGNMENT - 1 ) / DATA_ALIGNMENT * DATA_ALIGNMENT;
 	mDirty = false;
 	mIsAnimated = false;
 	computeInverseSize();
@@ -52,7 +71,10 @@ Texture::Texture( std::istream & aIsStream )
 
 Texture::~Texture()
 {
-	delete[] mTexture;
+	if ( mOwnsTexture )
+	{
+		delete[] mTexture;
+	}
 }
 
 void Texture::init()
@@ -62,6 +84,7 @@ void Texture::init()
 	mHeight = 1;
 	mDirty = false;
 	mTexture = new float[mWidth * mHeight * mColorComponents];
+	mOwnsTexture = true;
 	for ( unsigned int i = 0; i < mColorComponents; ++i )
 	{
 		mTexture[ i ] = 1.0f;
@@ -80,6 +103,16 @@ void Texture::exportToFile( std::ostream &aOutStream ) const
 	/* TODO : export must also save current time value or only data for current time */
 }
 
+void Texture::exportAlignedToFile( std::ostream &aOutStream ) const
+{
+	// Header is padded to DATA_ALIGNMENT bytes
+	unsigned __int32 header[ DATA_ALIGNMENT / sizeof( unsigned __int32 ) ] = { mWidth, mHeight, mColorComponents, 0 };
+	aOutStream.write( reinterpret_cast< const char * >( header ), DATA_ALIGNMENT );
+	unsigned __int32 size = mWidth * mHeight * mColorComponents * sizeof( float );
+	aOutStream.write( reinterpret_cast< const char * >( mTexture ), size );
+	SectionedFileWriter::writePadding( aOutStream, size, DATA_ALIGNMENT );
+}
+
 void Texture::setDirty()
 {
 	mDirty = true;
@@ -110,6 +143,18 @@ float *Texture::getRawData() const
 	return mTexture;
 }
 
+float Texture::getMaxAbsoluteValue() const
+{
+	float maxValue = 0;
+	const float * end = mTexture + mWidth * mHeight * mColorComponents;
+	// For every texel ( only first color component is used by realAtUV )
+	for ( const float * it = mTexture; it < end; it += mColorComponents )
+	{
+		maxValue = std::max( maxValue, static_cast< float >( fabs( *it ) ) );
+	}
+	return maxValue;
+}
+
 bool Texture::isAnimated() const
 {
 	return mIsAnimated;
@@ -107,6 +107,14 @@ public:
 	///----------------------------------------------------------------------------------------------------
 	Texture( std::istream & aIsStream );
 
+	///----------------------------------------------------------------------------------------------------
+	/// Memory mapped file constructor. Uses texture data stored by exportAlignedToFile in place, 
+	/// without copying. The data must not be released before texture.
+	///
+	/// \param [in,out]	aMappedData	The mapped data, pointer is moved behind the texture data.
+	///----------------------------------------------------------------------------------------------------
+	Texture( const char *& aMappedData );
+
 	///----------------------------------------------------------------------------------------------------
 	/// Finalizer
 	///----------------------------------------------------------------------------------------------------
@@ -161,6 +169,16 @@ public:
 	///----------------------------------------------------------------------------------------------------
 	void exportToFile( std::ostream &aOutStream ) const;
 
+	///----------------------------------------------------------------------------------------------------
+	/// Puts texture in stream, so it can be used in place from memory mapped file. Header and data
+	/// of texture are padded to DATA_ALIGNMENT bytes.
+	///
+	/// \param aOutStream	output stream for saving
+	///----------------------------------------------------------------------------------------------------
+	void exportAlignedToFile( std::ostream &aOutStream ) const;
+
+	static const unsigned __int32 DATA_ALIGNMENT = 16;  ///< The alignment of texture data in aligned export
+
 	///----------------------------------------------------------------------------------------------------
 	/// Marks the texture as dirty.
 	///----------------------------------------------------------------------------------------------------
@@ -193,6 +211,14 @@ public:
 	///----------------------------------------------------------------------------------------------------
 	float *getRawData() const;
 
+	///----------------------------------------------------------------------------------------------------
+	/// Gets maximal absolute value of the first color component over all texels.
+	/// No value returned by realAtUV can exceed it.
+	///
+	/// \return maximal absolute texture value
+	///----------------------------------------------------------------------------------------------------
+	float getMaxAbsoluteValue() const;
+
 	///----------------------------------------------------------------------------------------------------
 	/// Gets info about texture animation
 	///----------------------------------------------------------------------------------------------------
@@ -255,6 +281,8 @@ private:
 
 	float *mTexture;	///< Texture matrix
 
+	bool mOwnsTexture;  ///< false if texture matrix is used in place from memory mapped file
+
 	unsigned __int32 mWidth;	///< Texture width
 
 	unsigned __int32 mHeight;	///< Texture height
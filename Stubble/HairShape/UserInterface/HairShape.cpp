@@ -4,6 +4,7 @@
 #include "Common/Base64.hpp"
 #include "Common/GLExtensions.hpp"
 #include "Common/CommonConstants.hpp"
+#include "Common/SectionedFile.hpp"
 
 #include <maya/MAttributeSpecArray.h>
 #include <maya/MAttributeSpec.h>
@@ -30,7 +31,6 @@
 #include <fstream>
 #include <limits>
 #include <sstream>
-#include <zipstream.hpp>
 
 namespace Stubble
 {
@@ -50,6 +50,10 @@ MObject HairShape::voxelsResolutionAttr;
 MObject HairShape::voxelsXResolutionAttr;
 MObject HairShape::voxelsYResolutionAttr;
 MObject HairShape::voxelsZResolutionAttr;
+MObject HairShape::voxelHairBudgetAttr;
+MObject HairShape::bakeHairRootsAttr;
+MObject HairShape::exactVoxelBoundsAttr;
+MObject HairShape::exportCompressionLevelAttr;
 MObject HairShape::timeAttr;
 MObject HairShape::timeChangeAttr;
 MObject HairShape::genDisplayCountAttr;
@@ -73,6 +77,10 @@ HairShape::HairShape():
 	mVoxelization( 0 ),
 	mGuidesHairCount( 100 ),
 	mGeneratedHairCount( 10000 ),
+	mVoxelHairBudget( 0 ),
+	mBakeHairRoots( false ),
+	mExactVoxelBounds( false ),
+	mExportCompressionLevel( COMPRESSION ),
 	mTime( 0 ),
 	mIsTopologyModified( false ),
 	mIsTopologyCallbackRegistered( false ),
@@ -286,6 +294,11 @@ bool HairShape::setInternalValueInContext( const MPlug& aPlug, const MDataHandle
 	if ( aPlug == genCountAttr ) // Generated hair count was changed
 	{
 		mGeneratedHairCount = static_cast< unsigned __int32 >( aDataHandle.asInt() );
+		if ( mVoxelHairBudget > 0 ) // Adaptive voxels depend on hair count
+		{
+			delete mVoxelization; // Throw away old voxelization
+			mVoxelization = 0;
+		}
 		return false;
 	}
 	if ( aPlug == voxelsResolutionAttr ) // Voxels resolution was changed
@@ -319,6 +332,28 @@ bool HairShape::setInternalValueInContext( const MPlug& aPlug, const MDataHandle
 		mVoxelization = 0;
 		return false;
 	}
+	if ( aPlug == voxelHairBudgetAttr ) // Voxel hair budget was changed
+	{
+		mVoxelHairBudget = static_cast< unsigned __int32 >( aDataHandle.asInt() );
+		delete mVoxelization; // Throw away old voxelization
+		mVoxelization = 0;
+		return false;
+	}
+	if ( aPlug == bakeHairRootsAttr ) // Baking of hair roots was turned on/off
+	{
+		mBakeHairRoots = aDataHandle.asBool();
+		return false;
+	}
+	if ( aPlug == exactVoxelBoundsAttr ) // Exact calculation of voxel bounds was turned on/off
+	{
+		mExactVoxelBounds = aDataHandle.asBool();
+		return false;
+	}
+	if ( aPlug == exportCompressionLevelAttr ) // Compression level of exported files was changed
+	{
+		mExportCompressionLevel = aDataHandle.asInt();
+		return false;
+	}
 	if ( aPlug == genDisplayCountAttr ) // Number of interpolated hair to be displayed: delay if interpolated hair is shown
 	{
 		mGenDisplayCount = static_cast< unsigned __int32 >( aDataHandle.asInt() );
@@ -391,6 +426,11 @@ bool HairShape::setInternalValueInContext( const MPlug& aPlug, const MDataHandle
 	}
 	if ( hairPropertiesChanged )
 	{
+		// Guides triangulations are built once triangulation interpolation is switched on
+		if ( mHairGuides != 0 )
+		{
+			refreshPointersToGuidesForInterpolation();
+		}
 		if ( mDisplayInterpolated )
 		{
 			mInterpolatedHair.propertiesUpdate( *this );
@@ -936,6 +976,15 @@ MStatus HairShape::initialize()
 		addIntAttribute( "voxels_Z_dimensions", "vxszdim", voxelsZResolutionAttr, 1, 1, 10, 1, 10 );
 		addParentAttribute( "voxels_dimensions", "vxsdim", voxelsResolutionAttr, voxelsXResolutionAttr, 
 			voxelsYResolutionAttr, voxelsZResolutionAttr );
+		// define voxel hair budget attribute ( 0 = uniform voxels only )
+		addIntAttribute( "voxel_hair_budget", "vxhb", voxelHairBudgetAttr, 0, 0, 
+			std::numeric_limits< int >::max(), 0, 1000000 );
+		// define bake hair roots attribute
+		addBoolAttribute( "bake_hair_roots", "bkhr", bakeHairRootsAttr, false );
+		// define exact voxel bounds attribute
+		addBoolAttribute( "exact_voxel_bounds", "exvxb", exactVoxelBoundsAttr, false );
+		// define export compression level attribute
+		addIntAttribute( "export_compression_level", "excl", exportCompressionLevelAttr, COMPRESSION, 0, 9, 0, 9 );
 		//define gen. display count attribute
 		addIntAttribute( "displayed_hair_count", "dhc", genDisplayCountAttr, 1000, 1, 10000, 1, 10000 );
 		//define display guides attribute
@@ -1003,14 +1052,10 @@ void HairShape::sampleTime( Time aSampleTime, const std::string & aFileName, Bou
 	std::string mainFileName = aFileName;
 	mainFileName += ".FRM" ;
 	std::ofstream mainFile( mainFileName.c_str(), ios::binary );
-	zlib_stream::zip_ostream zipper( mainFile, ios::out, false, COMPRESSION, 
-		zlib_stream::StrategyFiltered, 15, 9, BUFFER_SIZE );
-	// Write id
-	zipper.write( FRAME_FILE_ID, FRAME_FILE_ID_SIZE );
-	// Write all hair properties ( textures, guides ... )
-	MayaHairProperties::exportToFile( zipper );
-	// Flush zipper
-	zipper.zflush();
+	// Write all hair properties ( textures, guides ... ) to sections of frame file
+	SectionedFileWriter frameFile( SECTIONED_FRAME_FILE_ID, mExportCompressionLevel );
+	MayaHairProperties::exportToFile( frameFile );
+	frameFile.writeToFile( mainFile );
 	// Closes main file
 	mainFile.close();
 	// Prepare voxelization
@@ -1018,33 +1063,65 @@ void HairShape::sampleTime( Time aSampleTime, const std::string & aFileName, Bou
 	{
 		// Creates voxelization
 		mVoxelization = new Interpolation::Maya::Voxelization( mMayaMesh->getRestPose(), getDensityTexture(), 
-			mVoxelsResolution );
+			mVoxelsResolution, mGeneratedHairCount, mVoxelHairBudget );
 	}
-	mVoxelization->updateVoxels( *mMayaMesh, *this, mGeneratedHairCount );
-	// For every voxel
+	mVoxelization->updateVoxels( *mMayaMesh, *this, mGeneratedHairCount, mExactVoxelBounds );
+	// Select not empty voxels, their files are numbered in order of voxels
+	std::vector< unsigned __int32 > exportedVoxels;
 	for ( unsigned __int32 i = 0; i < mVoxelization->getVoxelsCount(); ++i )
 	{
 		if ( mVoxelization->getVoxelHairCount( i ) > 0 )
+		{
+			exportedVoxels.push_back( i );
+		}
+	}
+	const size_t firstBoxIndex = aVoxelBoundingBoxes.size();
+	aVoxelBoundingBoxes.resize( firstBoxIndex + exportedVoxels.size() );
+	std::string error;
+	// Every voxel is exported and compressed to its own file in parallel
+	#ifdef _OPENMP
+	#pragma omp parallel for schedule( dynamic )
+	#endif
+	for ( int i = 0; i < static_cast< int >( exportedVoxels.size() ); ++i )
+	{
+		try
 		{
 			// Open file 
-			std::ostringstream voxelFileName; aFileName;
-			voxelFileName << aFileName << ".VX" << aVoxelBoundingBoxes.size();
+			std::ostringstream voxelFileName;
+			voxelFileName << aFileName << ".VX" << firstBoxIndex + i;
 			std::ofstream voxelFile( voxelFileName.str().c_str(), ios::binary );
-			zlib_stream::zip_ostream zipper( voxelFile, ios::out, false, COMPRESSION, 
-				zlib_stream::StrategyFiltered, 15, 9, BUFFER_SIZE );
-			// Write id
-			zipper.write( VOXEL_FILE_ID, VOXEL_FILE_ID_SIZE );
+			SectionedFileWriter voxelFileWriter( SECTIONED_VOXEL_FILE_ID, mExportCompressionLevel );
+			std::ostream & voxelSection = voxelFileWriter.beginSection( VOXEL_SECTION, true );
 			// Write voxel to file and stores voxel bounding box
-			BoundingBox box = mVoxelization->exportVoxel( zipper, i );
-			aVoxelBoundingBoxes.push_back( box );
+			BoundingBox box = mVoxelization->exportVoxel( voxelSection, exportedVoxels[ i ], *this, mBakeHairRoots );
+			aVoxelBoundingBoxes[ firstBoxIndex + i ] = box;
 			// Write voxel bounding box
-			zipper << box.max();
-			zipper << box.min();
-			// Flush zipper
-			zipper.zflush();
+			voxelSection << box.max();
+			voxelSection << box.min();
+			voxelFileWriter.endSection();
+			voxelFileWriter.writeToFile( voxelFile );
 			// Closes voxel file
 			voxelFile.close();
 		}
+		// Exceptions must not leave parallel region, they are rethrown after all voxels are processed
+		catch( std::exception & ex )
+		{
+			#ifdef _OPENMP
+			#pragma omp critical
+			#endif
+			error = ex.what();
+		}
+		catch( ... )
+		{
+			#ifdef _OPENMP
+			#pragma omp critical
+			#endif
+			error = " HairShape::sampleTime : unknown error during voxel export ! ";
+		}
+	}
+	if ( !error.empty() )
+	{
+		throw StubbleException( error.c_str() );
 	}
 }
 
@@ -1264,7 +1341,7 @@ void HairShape::setCurrentTime( Time aTime )
 inline void HairShape::refreshPointersToGuidesForInterpolation()
 {
 	MayaHairProperties::refreshPointersToGuides( & mHairGuides->getCurrentFrameSegments().mSegments,
-		& mHairGuides->getGuidesPositionsDS( getInterpolationGroups() ) );
+		& mHairGuides->getGuidesPositionsDS( getInterpolationGroups(), isGuidesTriangulationUsed() ) );
 }
 
 // Inline, but only called inside HairGuides.cpp
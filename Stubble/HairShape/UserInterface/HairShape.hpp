@@ -56,6 +56,14 @@ public:
 
 	static MObject voxelsZResolutionAttr;   ///< The voxels z coordinate resolution attribute
 
+	static MObject voxelHairBudgetAttr;   ///< The voxel hair budget attribute
+
+	static MObject bakeHairRootsAttr;   ///< The bake hair roots attribute
+
+	static MObject exactVoxelBoundsAttr;   ///< The exact voxel bounds attribute
+
+	static MObject exportCompressionLevelAttr;   ///< The export compression level attribute
+
 	static MObject timeAttr;	///< The time attribute
 
 	static MObject timeChangeAttr; ///< The time changed attribute ( set whenever time is changed )
@@ -294,6 +302,7 @@ public:
 	/// Hair guides and interpolation properties are stored in one file and current and rest pose mesh  
 	/// are voxelized and stored in separate files for each voxel.
 	/// Bounding boxes of each voxel are calculated using all interpolated hair geometry.
+	/// Voxels files are exported and compressed in parallel.
 	///
 	/// \param	aSampleTime					Time of the sample. 
 	/// \param	aFileName					Filename of the file. 
@@ -589,6 +598,14 @@ private:
 
 	Dimensions3 mVoxelsResolution;  ///< The voxels resolution
 
+	unsigned __int32 mVoxelHairBudget;  ///< The target hair count of adaptive voxel ( 0 for uniform voxels )
+
+	bool mBakeHairRoots;	///< Should hair roots be baked into voxel files ?
+
+	bool mExactVoxelBounds;	///< Should voxel bounding boxes be calculated by complete hair generation ?
+
+	int mExportCompressionLevel;	///< The compression level of exported files ( 0 = NONE - 9 = BEST )
+
 	Time mTime; ///< The current time
 
 	bool mDisplayGuides;   ///< Should guides be displayed ?
@@ -372,7 +372,7 @@ template < typename Type >
 inline Vector3D< Type >::Vector3D( const Type *aVector ):
 	x( aVector[ 0 ] ),
 	y( aVector[ 1 ] ),
-	z( aVector[ 2 ] ),
+	z( aVector[ 2 ] )
 {
 }
 
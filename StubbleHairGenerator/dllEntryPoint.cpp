@@ -10,18 +10,27 @@
 // generation ( for debug purpose )
 #define CALCULATE_BBOX
 
+// If defined, mental ray shaders are not compiled, so the plugin can be built without mental ray 
+// headers ( RenderMan procedural only )
+// #define NO_MENTAL_RAY
+
 #include "HairShape/Interpolation/HairGenerator.tmpl.hpp"
+#include "HairShape/Interpolation/RenderMan/RMFrameCache.hpp"
 #include "HairShape/Interpolation/RenderMan/RMHairProperties.hpp"
 #include "HairShape/Interpolation/RenderMan/RMOutputGenerator.hpp"
 #include "HairShape/Interpolation/RenderMan/RMPositionGenerator.hpp"
+#include "Common/CriticalSection.hpp"
 #include "Common/StubbleTimer.hpp"
 
 #include "ri.h"
 
+#ifndef NO_MENTAL_RAY
 #include "HairShape/Interpolation/mentalray/mrOutputGenerator.hpp"
 #include "shader.h"
 #include "geoshader.h"
+#endif
 
+#include <cmath>
 #include <ctime>
 #include <iostream>
 #include <sstream>
@@ -48,12 +57,14 @@ RtPointer DLLEXPORT ConvertParameters( RtString aParamString );
 RtVoid DLLEXPORT Subdivide( RtPointer aData, float aDetailSize );
 RtVoid DLLEXPORT Free( RtPointer aData );
 
+#ifndef NO_MENTAL_RAY
 /* Declarations for mental ray */
 int DLLEXPORT stubble_geometry_version( void );
 miBoolean DLLEXPORT stubble_geometry( miTag* result, miState* state, void* paras );
 miBoolean DLLEXPORT stubble_geometry_callback( miTag tag, void *args );
 int DLLEXPORT stubble_hair_color_version( void );
 miBoolean DLLEXPORT stubble_hair_color( miColor* result, miState* state, void* paras );
+#endif
 
 #ifdef __cplusplus
 }
@@ -71,6 +82,85 @@ typedef std::string * FileNames;
 ///----------------------------------------------------------------------------------------------------
 typedef RtFloat * TimeSamples;
 
+///----------------------------------------------------------------------------------------------------
+/// Defines an alias representing the keys of registered frames in frame cache .
+///----------------------------------------------------------------------------------------------------
+typedef RMFrameCache::FrameKey * FrameKeys;
+
+namespace
+{
+
+CriticalSection gLogLock; ///< Guards standard error output shared by all procedurals
+
+///-------------------------------------------------------------------------------------------------
+/// Writes all messages of single procedural call at once. Renderer may expand procedurals in
+/// parallel, so messages are collected by every call and written under lock to not interleave.
+///
+/// \param	aMessages	The messages.
+///-------------------------------------------------------------------------------------------------
+void writeMessages( const std::string & aMessages )
+{
+	if ( aMessages.empty() )
+	{
+		return;
+	}
+	ScopedLock lock( gLogLock );
+	std::cerr << aMessages << std::flush;
+}
+
+CriticalSection gActiveCallsLock; ///< Guards number of procedurals expanded at once
+
+int gActiveCallsCount = 0; ///< Number of procedurals expanded at once
+
+///-------------------------------------------------------------------------------------------------
+/// Counts procedural call as active for the lifetime of the object and selects number of threads
+/// of the call. Renderer may expand procedurals in parallel and every call generates hair by OpenMP
+/// team, so cores are split between active calls instead of running team of all cores by each call.
+///-------------------------------------------------------------------------------------------------
+class ActiveCall
+{
+public:
+
+	///-------------------------------------------------------------------------------------------------
+	/// Default constructor. Registers the call and selects its threads count.
+	///-------------------------------------------------------------------------------------------------
+	ActiveCall()
+	{
+		ScopedLock lock( gActiveCallsLock );
+		++gActiveCallsCount;
+#ifdef _OPENMP
+		mThreadsCount = std::max( omp_get_num_procs() / gActiveCallsCount, 1 );
+#else
+		mThreadsCount = 1;
+#endif
+	}
+
+	///-------------------------------------------------------------------------------------------------
+	/// Finaliser. Unregisters the call.
+	///-------------------------------------------------------------------------------------------------
+	~ActiveCall()
+	{
+		ScopedLock lock( gActiveCallsLock );
+		--gActiveCallsCount;
+	}
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the number of threads, which may be used by this call.
+	///
+	/// \return	The threads count. 
+	///-------------------------------------------------------------------------------------------------
+	int getThreadsCount() const
+	{
+		return mThreadsCount;
+	}
+
+private:
+
+	int mThreadsCount;  ///< The threads count of the call
+};
+
+} // unnamed namespace
+
 ///----------------------------------------------------------------------------------------------------
 /// Parameters of this hair generator plugin in binary format
 ///----------------------------------------------------------------------------------------------------
@@ -80,11 +170,153 @@ struct BinaryParams
 	
 	FileNames mFileNames;   ///< List of names of the files
 
+	FrameKeys mFrameKeys;   ///< The keys of frames registered in frame cache
+
 	unsigned __int32 mSamplesCount; ///< Number of samples
 
 	unsigned __int32 mVoxelId;  ///< Identifier for the current voxel
+
+	unsigned __int64 mHairStartIndex;   ///< Index of the first hair of voxel part ( child procedural only )
+
+	unsigned __int64 mHairCount;	///< Number of hair of voxel part ( 0 if whole voxel is generated )
+
+	RtFloat mDetailSize;	///< Detail size of the whole voxel ( negative if detail size of call is used )
 };
 
+namespace
+{
+
+///-------------------------------------------------------------------------------------------------
+/// Calculates bound of hair of voxel part in single sample : bound of current roots enlarged by 
+/// maximal hair reach and clipped by voxel bounding box.
+///
+/// \param [in,out]	aPositionGenerator	The position generator of sample.
+/// \param	aHairStartIndex				Index of the first hair of part.
+/// \param	aHairCount					Number of hair of part.
+/// \param	aMaxHairReach				The maximal hair reach of sample.
+/// \param [in,out]	aBound				The bound, will be expanded.
+///-------------------------------------------------------------------------------------------------
+void expandPartBound( RMPositionGenerator & aPositionGenerator, unsigned __int64 aHairStartIndex, 
+	unsigned __int64 aHairCount, Real aMaxHairReach, BoundingBox & aBound )
+{
+	BoundingBox roots;
+	aPositionGenerator.restrictToPart( aHairStartIndex, aHairCount );
+	for ( unsigned __int64 i = 0; i < aHairCount; ++i )
+	{
+		HairShape::MeshPoint currPos;
+		HairShape::MeshPoint restPos;
+		aPositionGenerator.generate( currPos, restPos );
+		roots.expand( currPos.getPosition() );
+	}
+	// Hair points are generated in single precision, so bound must also cover rounding errors
+	static const Real ROUNDING_TOLERANCE = 1e-5;
+	const Vector3D< Real > minCorner = roots.min();
+	const Vector3D< Real > maxCorner = roots.max();
+	Real magnitude = aMaxHairReach;
+	for ( unsigned __int32 j = 0; j < 3; ++j )
+	{
+		magnitude = std::max( magnitude, std::max( fabs( minCorner[ j ] ), fabs( maxCorner[ j ] ) ) + aMaxHairReach );
+	}
+	const Real enlarge = aMaxHairReach + magnitude * ROUNDING_TOLERANCE;
+	// Voxel bounding box covers all hair of voxel ( it may even be exact )
+	const BoundingBox & voxelBound = aPositionGenerator.getVoxelBoundingBox();
+	Vector3D< Real > partMin, partMax;
+	for ( unsigned __int32 j = 0; j < 3; ++j )
+	{
+		partMin[ j ] = std::max( minCorner[ j ] - enlarge, voxelBound.min()[ j ] );
+		partMax[ j ] = std::min( maxCorner[ j ] + enlarge, voxelBound.max()[ j ] );
+	}
+	aBound.expand( partMin );
+	aBound.expand( partMax );
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Splits overloaded voxel ( or its part ) to child procedurals. Every child covers contiguous part
+/// of voxel hair with its own bound, so renderer can cull and schedule children independently. 
+/// Children of overloaded children are split again. Limits of split are given by hair properties of
+/// the first sample.
+///
+/// \param	aParams						The parameters of split procedural.
+/// \param	aHairProperties				The hair properties of samples.
+/// \param [in,out]	aPositionGenerators	The position generators of samples.
+/// \param	aMaxHairPointsCount			Maximum number of points generated from single main hair.
+/// \param	aDetailSize					Size of a detail of the whole voxel.
+/// \param [in,out]	aMessages			The messages of call.
+///
+/// \return	true if children have been emitted, so this procedural must not generate any hair.
+///-------------------------------------------------------------------------------------------------
+bool emitChildren( const BinaryParams & aParams, const std::vector< const RMHairProperties * > & aHairProperties,
+	const std::vector< RMPositionGenerator * > & aPositionGenerators, unsigned __int32 aMaxHairPointsCount, 
+	RtFloat aDetailSize, std::ostream & aMessages )
+{
+	const unsigned __int64 hairStartIndex = aPositionGenerators[ 0 ]->getHairStartIndex();
+	const unsigned __int64 hairCount = aPositionGenerators[ 0 ]->getHairCount();
+	const unsigned __int64 pointsCount = multiplyCounts( hairCount, aMaxHairPointsCount );
+	const unsigned __int64 maxPointsCount = multiplyCounts( aHairProperties[ 0 ]->getCommitSize(), 
+		std::max( aHairProperties[ 0 ]->getMaxProceduralCommitsCount(), static_cast< unsigned __int32 >( 1 ) ) );
+	if ( pointsCount <= maxPointsCount || hairCount < 2 )
+	{
+		return false; // Not overloaded
+	}
+	// Roots and random numbers of hair in part do not depend on other hair only if random generator 
+	// is counter based, otherwise hair can only be generated from the beginning of voxel
+	for ( unsigned __int32 i = 0; i < aParams.mSamplesCount; ++i )
+	{
+		if ( !aHairProperties[ i ]->isRandomCounterBased() )
+		{
+			aMessages << "StubbleHairGenerator.dll::Subdivide voxel " << aParams.mVoxelId << " with " << hairCount
+				<< " hair is not split, split requires counter based random generator !" << std::endl;
+			return false;
+		}
+	}
+	const unsigned __int64 maxChildrenCount = 
+		std::max( aHairProperties[ 0 ]->getMaxProceduralChildrenCount(), static_cast< unsigned __int32 >( 2 ) );
+	const unsigned __int32 childrenCount = static_cast< unsigned __int32 >( std::min( 
+		( pointsCount + maxPointsCount - 1 ) / maxPointsCount, std::min( maxChildrenCount, hairCount ) ) );
+	// Hair reach depends only on hair properties of sample
+	std::vector< Real > maxHairReaches( aParams.mSamplesCount );
+	for ( unsigned __int32 i = 0; i < aParams.mSamplesCount; ++i )
+	{
+		maxHairReaches[ i ] = aHairProperties[ i ]->calculateMaxHairReach();
+	}
+	// Every child covers contiguous part of hair ( roots ordered by space filling curve lie close together )
+	for ( unsigned __int32 c = 0; c < childrenCount; ++c )
+	{
+		const unsigned __int64 childStartIndex = hairStartIndex + hairCount * c / childrenCount;
+		const unsigned __int64 childEndIndex = hairStartIndex + hairCount * ( c + 1 ) / childrenCount;
+		// Bound must cover hair of all motion samples
+		BoundingBox bound;
+		for ( unsigned __int32 i = 0; i < aParams.mSamplesCount; ++i )
+		{
+			expandPartBound( *aPositionGenerators[ i ], childStartIndex, childEndIndex - childStartIndex, 
+				maxHairReaches[ i ], bound );
+		}
+		RtBound childBound = { 
+			static_cast< RtFloat >( bound.min().x ), static_cast< RtFloat >( bound.max().x ),
+			static_cast< RtFloat >( bound.min().y ), static_cast< RtFloat >( bound.max().y ),
+			static_cast< RtFloat >( bound.min().z ), static_cast< RtFloat >( bound.max().z ) };
+		// Child shares frames and voxel files with its parent, level of detail is selected by whole voxel
+		BinaryParams * child = new BinaryParams( aParams );
+		child->mTimeSamples = new RtFloat[ aParams.mSamplesCount ];
+		child->mFileNames = new std::string[ aParams.mSamplesCount ];
+		child->mFrameKeys = new RMFrameCache::FrameKey[ aParams.mSamplesCount ];
+		for ( unsigned __int32 i = 0; i < aParams.mSamplesCount; ++i )
+		{
+			child->mTimeSamples[ i ] = aParams.mTimeSamples[ i ];
+			child->mFileNames[ i ] = aParams.mFileNames[ i ];
+			child->mFrameKeys[ i ] = aParams.mFrameKeys[ i ];
+			RMFrameCache::registerFrame( aParams.mFrameKeys[ i ] );
+		}
+		child->mHairStartIndex = childStartIndex;
+		child->mHairCount = childEndIndex - childStartIndex;
+		child->mDetailSize = aDetailSize;
+		RiProcedural( reinterpret_cast< RtPointer >( child ), childBound, Subdivide, Free );
+	}
+	return true;
+}
+
+} // unnamed namespace
+
 ///-------------------------------------------------------------------------------------------------
 /// Convert parameters to binary representation. 
 ///
@@ -94,6 +326,8 @@ struct BinaryParams
 ///-------------------------------------------------------------------------------------------------
 RtPointer DLLEXPORT ConvertParameters( RtString aParamString )
 {
+	// Load stubble workdir
+	std::string stubbleWorkDir = Stubble::getEnvironmentVariable("STUBBLE_WORKDIR") + "\\";
 	// Convert params to string stream
 	std::istringstream str( aParamString );
 	// Prepare binary params structure
@@ -102,17 +336,27 @@ RtPointer DLLEXPORT ConvertParameters( RtString aParamString )
 	str >> bp->mVoxelId;
 	// Read samples count
 	str >> bp->mSamplesCount;
+	// Whole voxel is generated
+	bp->mHairStartIndex = 0;
+	bp->mHairCount = 0;
+	bp->mDetailSize = -1;
 	// Allocate memory for time samples and file names
 	bp->mTimeSamples = new RtFloat[ bp->mSamplesCount ];
 	bp->mFileNames = new std::string[ bp->mSamplesCount ];
+	bp->mFrameKeys = new RMFrameCache::FrameKey[ bp->mSamplesCount ];
 	// Convert time samples and file names from string to binary format
 	TimeSamples timeIt = bp->mTimeSamples;
 	FileNames fileIt = bp->mFileNames;
+	FrameKeys keyIt = bp->mFrameKeys;
 	// For every sample
-	for ( unsigned __int32 i = 0; i < bp->mSamplesCount; ++i, ++timeIt, ++fileIt )
+	for ( unsigned __int32 i = 0; i < bp->mSamplesCount; ++i, ++timeIt, ++fileIt, ++keyIt )
 	{
 		str >> *timeIt;
 		str >> *fileIt;
+		// Get file prefix
+		*fileIt = stubbleWorkDir + *fileIt;
+		// Frame will be decoded once and shared by all voxels of this frame
+		*keyIt = RMFrameCache::registerFrame( *fileIt + ".FRM" );
 	}
 	// Return binary params
 	return reinterpret_cast< RtPointer >( bp );
@@ -121,9 +365,12 @@ RtPointer DLLEXPORT ConvertParameters( RtString aParamString )
 ///-------------------------------------------------------------------------------------------------
 /// Subdivides procedural command to other renderman commands.
 /// This function loads exported data from Maya and generate all hair using RenderMan commands. 
+/// Function is reentrant : all state is held by the call and the read-only parameters, frames are 
+/// shared through thread-safe frame cache, so renderer may expand many voxels at once.
 ///
 /// \param	aData		Parameters in binary format. 
-/// \param	aDetailSize	Size of a detail. 
+/// \param	aDetailSize	Size of a detail ( area of voxel bounding box on screen in pixels ), used
+/// 					for level of detail selection. 
 ///-------------------------------------------------------------------------------------------------
 RtVoid DLLEXPORT Subdivide( RtPointer aData, RtFloat aDetailSize )
 {
@@ -133,61 +380,166 @@ RtVoid DLLEXPORT Subdivide( RtPointer aData, RtFloat aDetailSize )
 #endif
 	// Get params
 	const BinaryParams & bp = * reinterpret_cast< BinaryParams * >( aData );
-	// Load stubble workdir
-	std::string stubbleWorkDir = Stubble::getEnvironmentVariable("STUBBLE_WORKDIR") + "\\";
-	// Prepare rendering params
-	RiBasis( RiCatmullRomBasis, RI_CATMULLROMSTEP, RiCatmullRomBasis, RI_CATMULLROMSTEP );
-	// Declare output variables
-	RMOutputGenerator::declareVariables();
-	if ( bp.mSamplesCount > 1 )
-	{
-		// Start motion blur
-		RiMotionBeginV( static_cast< RtInt >( bp.mSamplesCount ), bp.mTimeSamples );
-	}
-	// Create output generator
-	RMOutputGenerator outputGenerator;
-	// For every sample
-	for ( FileNames it = bp.mFileNames, end = bp.mFileNames + bp.mSamplesCount; it != end; ++it )
-	{
-		try {
-			// Get file prefix
-			std::string filePrefix = stubbleWorkDir + *it;
-			// Read frame file with hair properties
-			RMHairProperties hairProperties( filePrefix + ".FRM" );
+	// Children select level of detail by the whole voxel
+	const RtFloat detailSize = bp.mDetailSize < 0 ? aDetailSize : bp.mDetailSize;
+	// Messages of this call
+	std::ostringstream messages;
+	// Calls expanded at once share cores
+	const ActiveCall activeCall;
+	// True if curves basis is set in attribute block of this call
+	bool isAttributeBlockOpen = false;
+	// True if motion block of the current part is open
+	bool isMotionBlockOpen = false;
+	// Hair of all samples are generated in parts, every part is sent to RenderMan in single motion block
+	std::vector< const RMHairProperties * > hairProperties( bp.mSamplesCount, 0 );
+	std::vector< RMPositionGenerator * > positionGenerators( bp.mSamplesCount, 0 );
+	std::vector< HairShape::RandomGenerator > randoms( bp.mSamplesCount );
+	// Frame invariant data of hair in part are evaluated by the first sample and shared by all samples
+	MotionSamplesCache motionSamplesCache;
+	try {
+		// For every sample
+		unsigned __int32 maxHairPointsCount = 0;
+		FrameKeys keyIt = bp.mFrameKeys;
+		for ( unsigned __int32 i = 0; i < bp.mSamplesCount; ++i, ++keyIt )
+		{
+			// Get frame with hair properties ( shared with other voxels )
+			hairProperties[ i ] = &RMFrameCache::getFrame( *keyIt );
 			// Get voxel file name
 			std::ostringstream str;
-			str << filePrefix << ".VX" << bp.mVoxelId;
+			str << bp.mFileNames[ i ] << ".VX" << bp.mVoxelId;
 			// Read voxel file with mesh geometry and create position generator
-			RMPositionGenerator positionGenerator( hairProperties.getDensityTexture(), str.str() );
-			// Create hair generator
-			HairGenerator< RMPositionGenerator, RMOutputGenerator > hairGenerator( positionGenerator, outputGenerator );
-			// Should normals be outputed ?
-			outputGenerator.setOutputNormals( hairProperties.areNormalsCalculated() );
-			// Finally begin generating hair
-			hairGenerator.generate( hairProperties );
-#ifdef CALCULATE_BBOX
-		if ( !positionGenerator.getVoxelBoundingBox().contains( hairGenerator.getBoundingBox() ) )
+			positionGenerators[ i ] = new RMPositionGenerator( *hairProperties[ i ], str.str() );
+			// Child procedural generates only its part of voxel
+			if ( bp.mHairCount > 0 )
+			{
+				positionGenerators[ i ]->restrictToPart( bp.mHairStartIndex, bp.mHairCount );
+			}
+			// Maximum number of points generated from single main hair
+			const unsigned __int32 hairPointsCount = 
+				( hairProperties[ i ]->getInterpolationGroups().getMaxSegmentsCount() + 3 ) *
+				std::max( hairProperties[ i ]->getMultiStrandCount(), static_cast< unsigned __int32 >( 1 ) );
+			maxHairPointsCount = std::max( maxHairPointsCount, hairPointsCount );
+		}
+		// Overloaded voxel is not generated at once, it is split to child procedurals, which generate all hair
+		const bool isSplit = emitChildren( bp, hairProperties, positionGenerators, maxHairPointsCount, detailSize, 
+			messages );
+		if ( !isSplit )
 		{
-			std::cerr << "StubbleHairGenerator.dll::Subdivide containment failed !!!";
+			// Prepare rendering params once for all curves of this call, basis is scoped by attribute block 
+			// ( output variables are declared inline ), so no renderer state outside of this call is modified
+			RiAttributeBegin();
+			isAttributeBlockOpen = true;
+			RiBasis( RiCatmullRomBasis, RI_CATMULLROMSTEP, RiCatmullRomBasis, RI_CATMULLROMSTEP );
 		}
-#endif
+		// Samples can only share data if they generate the same hair in strand
+		bool useMotionSamplesCache = bp.mSamplesCount > 1;
+		for ( unsigned __int32 i = 1; i < bp.mSamplesCount; ++i )
+		{
+			useMotionSamplesCache = useMotionSamplesCache && 
+				hairProperties[ i ]->getMultiStrandCount() == hairProperties[ 0 ]->getMultiStrandCount();
 		}
-		catch ( StubbleException & ex )
+		// Create output generator
+		const unsigned __int32 commitSize = hairProperties[ 0 ]->getCommitSize();
+		RMOutputGenerator outputGenerator( commitSize );
+		// Select part size, so every part of every sample fits into single commit ( RiCurves call ),
+		// otherwise motion block would contain more than one primitive for each sample
+		const unsigned __int32 partSize = std::max( commitSize / maxHairPointsCount, static_cast< unsigned __int32 >( 1 ) );
+		// For every part
+		for ( unsigned __int64 partStart = 0; !isSplit && positionGenerators[ 0 ]->selectNextRange( partSize ) > 0; 
+			partStart += partSize )
 		{
-			std::cerr << ex.what();
-			return;
+			if ( bp.mSamplesCount > 1 )
+			{
+				// Start motion blur
+				RiMotionBeginV( static_cast< RtInt >( bp.mSamplesCount ), bp.mTimeSamples );
+				isMotionBlockOpen = true;
+			}
+			if ( useMotionSamplesCache )
+			{
+				motionSamplesCache.reset( positionGenerators[ 0 ]->getHairStartIndex(), 
+					positionGenerators[ 0 ]->getHairCount(), hairProperties[ 0 ]->getMultiStrandCount() );
+			}
+			// For every sample
+			for ( unsigned __int32 i = 0; i < bp.mSamplesCount; ++i )
+			{
+				if ( i > 0 )
+				{
+					positionGenerators[ i ]->selectNextRange( partSize );
+				}
+				// Create hair generator
+				HairGenerator< RMPositionGenerator, RMOutputGenerator > hairGenerator( *positionGenerators[ i ], 
+					outputGenerator );
+				// Level of detail is selected by voxel size on screen
+				hairGenerator.setDetailSize( static_cast< Real >( detailSize ) );
+				hairGenerator.setThreadsCount( activeCall.getThreadsCount() );
+				// Voxel bound covers about sqrt( detail size ) pixels along its diagonal, which gives
+				// pixel size for decimation in screen space
+				if ( detailSize > 0 )
+				{
+					hairGenerator.setPixelSize( positionGenerators[ i ]->getVoxelBoundingBox().diagonal() /
+						std::sqrt( static_cast< Real >( detailSize ) ) );
+				}
+				// Should normals be outputed ?
+				outputGenerator.setOutputNormals( hairProperties[ i ]->areNormalsCalculated() );
+				if ( useMotionSamplesCache )
+				{
+					// The first sample fills cache, other samples only evaluate time dependent data
+					hairGenerator.setMotionSamplesCache( &motionSamplesCache, i == 0 );
+				}
+				// Finally begin generating hair ( in multiple threads ), next parts continue with random 
+				// generator state, in which previous part has ended
+				if ( partStart == 0 )
+				{
+					hairGenerator.generateParallel( *hairProperties[ i ] );
+				}
+				else
+				{
+					hairGenerator.generateParallel( *hairProperties[ i ], randoms[ i ] );
+				}
+				randoms[ i ] = hairGenerator.getRandom();
+#ifdef CALCULATE_BBOX
+				if ( !positionGenerators[ i ]->getVoxelBoundingBox().contains( hairGenerator.getBoundingBox() ) )
+				{
+					messages << "StubbleHairGenerator.dll::Subdivide containment failed !!!" << std::endl;
+				}
+#endif
+			}
+			if ( bp.mSamplesCount > 1 )
+			{
+				// End motion blur
+				RiMotionEnd();
+				isMotionBlockOpen = false;
+			}
 		}
 	}
-	if ( bp.mSamplesCount > 1 )
+	catch ( std::exception & ex )
+	{
+		messages << ex.what() << std::endl;
+	}
+	catch ( ... )
+	{
+		messages << "StubbleHairGenerator.dll::Subdivide unknown error !" << std::endl;
+	}
+	// Blocks left open by error are closed, so renderer state outside of this call is not modified
+	if ( isMotionBlockOpen )
 	{
-		// End motion blur
 		RiMotionEnd();
 	}
+	if ( isAttributeBlockOpen )
+	{
+		RiAttributeEnd();
+	}
+	// Free position generators
+	for ( unsigned __int32 i = 0; i < bp.mSamplesCount; ++i )
+	{
+		delete positionGenerators[ i ];
+	}
 #ifdef REPORT
 	timer.stop();
-	std::cerr << "StubbleHairGenerator.dll::Subdivide run time: " << timer.getElapsedTime()
+	messages << "StubbleHairGenerator.dll::Subdivide run time: " << timer.getElapsedTime()
 		<< std::endl;
 #endif
+	writeMessages( messages.str() );
 }
 
 ///-------------------------------------------------------------------------------------------------
@@ -199,12 +551,19 @@ RtVoid DLLEXPORT Free( RtPointer aData )
 {
 	// Get params
 	BinaryParams * bp = reinterpret_cast< BinaryParams * >( aData );
+	// Release frames, last voxel of the frame frees decoded frame
+	for ( unsigned __int32 i = 0; i < bp->mSamplesCount; ++i )
+	{
+		RMFrameCache::unregisterFrame( bp->mFrameKeys[ i ] );
+	}
 	// Free memory
+	delete [] bp->mFrameKeys;
 	delete [] bp->mTimeSamples;
 	delete [] bp->mFileNames;
 	delete bp;
 }
 
+#ifndef NO_MENTAL_RAY
 
 ///-------------------------------------------------------------------------------------------------
 /// Returns the geometry shader version. Called by mental ray.
@@ -267,27 +626,26 @@ DLLEXPORT miBoolean stubble_geometry_callback( miTag tag, void *args )
 	obj->visible = miTRUE;
 	obj->shadow = obj->reflection = obj->refraction = 0x03;
 
-	// Create output generator
-	MROutputGenerator outputGenerator( 1000000 ); // One million segments max. for each commit
-
 	// Use only a single voxel for output.
 	try {
 		// Get file prefix
 		std::string filePrefix = stubbleWorkDir + "stubble_mr_hair";
 		// Read frame file with hair properties
 		RMHairProperties hairProperties( filePrefix + ".FRM" );
+		// Create output generator
+		MROutputGenerator outputGenerator( hairProperties.getCommitSize() );
 		// Get voxel file name
 		std::ostringstream str;
 		str << filePrefix << ".VX0";
 		// Read voxel file with mesh geometry and create position generator (it's OK to use RenderMan's)
-		RMPositionGenerator positionGenerator( hairProperties.getDensityTexture(), str.str() );
+		RMPositionGenerator positionGenerator( hairProperties, str.str() );
 		// Create hair generator
 		HairGenerator< RMPositionGenerator, MROutputGenerator > hairGenerator( positionGenerator, outputGenerator );
 		// Should normals be output?
 		outputGenerator.setOutputNormals( hairProperties.areNormalsCalculated() );
 
-		// Generate hair
-		hairGenerator.generate( hairProperties );
+		// Generate hair ( in multiple threads )
+		hairGenerator.generateParallel( hairProperties );
 
 		// Set bounding box
 		BoundingBox bb = hairGenerator.getBoundingBox();
@@ -298,11 +656,15 @@ DLLEXPORT miBoolean stubble_geometry_callback( miTag tag, void *args )
 		obj->bbox_max.y = miScalar( bb.max()[ 1 ] );
 		obj->bbox_max.z = miScalar( bb.max()[ 2 ] );
 
-		std::cerr << "Stubble for mental ray: hair object generated successfully." << std::endl;
+		writeMessages( "Stubble for mental ray: hair object generated successfully.\n" );
 	}
-	catch ( StubbleException & ex )
+	catch ( std::exception & ex )
 	{
-		std::cerr << "Stubble for mental ray error: " << ex.what() << std::endl;
+		writeMessages( std::string( "Stubble for mental ray error: " ) + ex.what() + "\n" );
+	}
+	catch ( ... )
+	{
+		writeMessages( "Stubble for mental ray error: unknown error.\n" );
 	}
 
 	// Close mental ray object.
@@ -334,3 +696,5 @@ miBoolean DLLEXPORT stubble_hair_color(miColor* result, miState* state, void* pa
 	result->b *= result->a;
 	return miTRUE;
 } 
+
+#endif // NO_MENTAL_RAY
@@ -0,0 +1,178 @@
+///-------------------------------------------------------------------------------------------------
+/// Checks that attribute atlas returns the same values as sampling of single textures. Some
+/// textures of the test scene are replaced by varying textures ( with different resolution and
+/// components count ), so they are stored in atlas, while other textures stay constant and are
+/// folded to uniforms. Textures with atlas resolution must match Texture::realAtUV and
+/// Texture::colorAtUV at any point, texture with lower resolution must match them at atlas texels.
+/// Hair generated from textures stored in frame file must be the same as hair of the scene.
+///-------------------------------------------------------------------------------------------------
+
+#include "Common/RecordingOutputGenerator.hpp"
+#include "Common/TestResult.hpp"
+#include "Common/TestScene.hpp"
+
+#include "HairShape/Generators/RandomGenerator.hpp"
+#include "HairShape/Generators/UVPointGenerator.hpp"
+#include "HairShape/Interpolation/AttributeAtlas.hpp"
+#include "HairShape/Interpolation/HairGenerator.tmpl.hpp"
+#include "HairShape/Interpolation/Maya/SimplePositionGenerator.hpp"
+#include "HairShape/Interpolation/RenderMan/RMHairProperties.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+
+using namespace Stubble;
+using namespace Stubble::HairShape;
+using namespace Stubble::HairShape::Interpolation;
+using namespace Stubble::Tests;
+
+namespace
+{
+
+typedef HairGenerator< Maya::SimplePositionGenerator, RecordingOutputGenerator > TestHairGenerator;
+
+const unsigned __int32 SAMPLES_COUNT = 10000;   ///< Number of random sampling points
+
+const unsigned __int32 VARYING_CHANNELS_COUNT = 9;  ///< Number of atlas channels of varying textures
+
+const float TOLERANCE = 1e-5f;  ///< The tolerance of rounding to float
+
+const unsigned __int32 HAIR_COUNT = 2000;   ///< Number of generated hair
+
+///-------------------------------------------------------------------------------------------------
+/// Checks that sampled value of attribute equals the value of texture.
+///
+/// \param	aValues			The values sampled from atlas.
+/// \param	aAttribute		The attribute.
+/// \param	aTexture		The texture of attribute.
+/// \param	aValuesCount	Number of values of attribute ( 3 for colors, 1 otherwise ).
+/// \param	aU				The u coordinate.
+/// \param	aV				The v coordinate.
+///
+/// \return	true if values are equal.
+///-------------------------------------------------------------------------------------------------
+bool isEqual( const float * aValues, AttributeAtlas::Attribute aAttribute, const Texture & aTexture,
+	unsigned __int32 aValuesCount, Real aU, Real aV )
+{
+	Texture::Color3 color;
+	if ( aTexture.getColorCompomentsCount() >= aValuesCount && aValuesCount == 3 )
+	{
+		aTexture.colorAtUV( aU, aV, color );
+	}
+	else // Missing components are replaced by the first one
+	{
+		color[ 0 ] = color[ 1 ] = color[ 2 ] = aTexture.realAtUV( aU, aV );
+	}
+	for ( unsigned __int32 i = 0; i < aValuesCount; ++i )
+	{
+		if ( fabs( aValues[ aAttribute + i ] - color[ i ] ) > TOLERANCE )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Generates hair of the test scene mesh with given hair properties.
+///
+/// \param	aScene						The scene ( meshes ).
+/// \param	aHairProperties				The hair properties.
+/// \param [in,out]	aOutputGenerator	The output generator.
+///-------------------------------------------------------------------------------------------------
+void generate( const TestScene & aScene, const HairProperties & aHairProperties,
+	RecordingOutputGenerator & aOutputGenerator )
+{
+	RandomGenerator rootsRandom;
+	UVPointGenerator uvPointGenerator( aHairProperties.getDensityTexture(),
+		aScene.getRestPoseMesh().getTriangleConstIterator(), rootsRandom );
+	Maya::SimplePositionGenerator positionGenerator( aScene.getRestPoseMesh(), aScene.getCurrentMesh(),
+		uvPointGenerator, HAIR_COUNT, 0 );
+	TestHairGenerator hairGenerator( positionGenerator, aOutputGenerator );
+	hairGenerator.generate( aHairProperties );
+}
+
+} // unnamed namespace
+
+int main()
+{
+	TestResult result( "AttributeAtlasTest" );
+	TestScene scene( 50 );
+	result.check( scene.getAttributeAtlas().getChannelsCount() == 0, "Constant textures are not stored in atlas" );
+	scene.setVaryingTextures( 42 );
+	const AttributeAtlas & atlas = scene.getAttributeAtlas();
+	std::ostringstream channels;
+	channels << "Varying textures are stored in atlas ( " << atlas.getChannelsCount() << " channels )";
+	result.check( atlas.getChannelsCount() == VARYING_CHANNELS_COUNT, channels.str() );
+	// Textures with atlas resolution and constant textures at random points
+	RandomGenerator random;
+	unsigned __int32 differentCount = 0;
+	unsigned __int32 differentUniformsCount = 0;
+	float values[ AttributeAtlas::ATTRIBUTES_COUNT ];
+	for ( unsigned __int32 i = 0; i < SAMPLES_COUNT; ++i )
+	{
+		// Points outside of texture are clamped
+		const Real u = random.randomReal( -0.1, 1.1 );
+		const Real v = random.randomReal( -0.1, 1.1 );
+		atlas.sample( u, v, values );
+		differentCount += isEqual( values, AttributeAtlas::SCALE, scene.getScaleTexture(), 1, u, v ) &&
+			isEqual( values, AttributeAtlas::ROOT_COLOR, scene.getRootColorTexture(), 3, u, v ) &&
+			isEqual( values, AttributeAtlas::MUTANT_HAIR_COLOR, scene.getMutantHairColorTexture(), 3, u, v ) &&
+			isEqual( values, AttributeAtlas::ROOT_FRIZZ, scene.getRootFrizzTexture(), 1, u, v ) ? 0 : 1;
+		differentUniformsCount += isEqual( values, AttributeAtlas::RAND_SCALE, scene.getRandScaleTexture(), 1, u, v ) &&
+			isEqual( values, AttributeAtlas::TIP_COLOR, scene.getTipColorTexture(), 3, u, v ) &&
+			isEqual( values, AttributeAtlas::RANDOMIZE_STRAND, scene.getRandomizeStrandTexture(), 1, u, v ) ? 0 : 1;
+	}
+	std::ostringstream different;
+	different << "Atlas differs from textures of its resolution at " << differentCount << " of " << SAMPLES_COUNT
+		<< " points";
+	result.check( differentCount == 0, different.str() );
+	std::ostringstream differentUniforms;
+	differentUniforms << "Atlas differs from constant textures at " << differentUniformsCount << " of "
+		<< SAMPLES_COUNT << " points";
+	result.check( differentUniformsCount == 0, differentUniforms.str() );
+	// Texture with lower resolution at atlas texels
+	const unsigned __int32 resolution = TestScene::VARYING_TEXTURE_RESOLUTION;
+	differentCount = 0;
+	for ( unsigned __int32 y = 0; y < resolution; ++y )
+	{
+		for ( unsigned __int32 x = 0; x < resolution; ++x )
+		{
+			const Real u = static_cast< Real >( x ) / ( resolution - 1 );
+			const Real v = static_cast< Real >( y ) / ( resolution - 1 );
+			atlas.sample( u, v, values );
+			differentCount += isEqual( values, AttributeAtlas::TIP_THICKNESS, scene.getTipThicknessTexture(), 1, u, v ) ?
+				0 : 1;
+		}
+	}
+	std::ostringstream resampled;
+	resampled << "Atlas differs from resampled texture at " << differentCount << " of " << resolution * resolution
+		<< " texels";
+	result.check( differentCount == 0, resampled.str() );
+	// Atlas built from textures of frame file
+	char directory[] = "/tmp/StubbleAtlasTestXXXXXX";
+	if ( mkdtemp( directory ) == 0 )
+	{
+		std::cerr << "Temporary directory can not be created !" << std::endl;
+		return 1;
+	}
+	const std::string frameFile = std::string( directory ) + "/frame.FRM";
+	scene.exportFrameToFile( frameFile );
+	{
+		RMHairProperties frame( frameFile );
+		RecordingOutputGenerator expected( false );
+		RecordingOutputGenerator imported( false );
+		generate( scene, scene, expected );
+		generate( scene, frame, imported );
+		std::string difference;
+		const bool areEqual = expected.compare( imported, difference );
+		result.check( expected.getHairCount() > 0 && areEqual, "Hair of frame file : " + difference );
+	}
+	remove( frameFile.c_str() );
+	rmdir( directory );
+	return result.getExitCode();
+}
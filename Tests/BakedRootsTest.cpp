@@ -0,0 +1,108 @@
+///-------------------------------------------------------------------------------------------------
+/// Checks that hair roots baked into voxel file give the same hair as roots selected by renderer.
+/// Voxel of the test scene is exported with and without baked roots ( closest guides of all baked
+/// roots are queried at once, as by Voxelization::exportVoxel ), hair of both voxels is generated
+/// by RenderMan position generator and compared buffer by buffer for both random generators, cut
+/// hair and both interpolation modes.
+///-------------------------------------------------------------------------------------------------
+
+#include "Common/RecordingOutputGenerator.hpp"
+#include "Common/TestResult.hpp"
+#include "Common/TestScene.hpp"
+
+#include "HairShape/Interpolation/HairGenerator.tmpl.hpp"
+#include "HairShape/Interpolation/RenderMan/RMPositionGenerator.hpp"
+
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+
+using namespace Stubble;
+using namespace Stubble::HairShape;
+using namespace Stubble::HairShape::Interpolation;
+using namespace Stubble::Tests;
+
+namespace
+{
+
+typedef HairGenerator< RMPositionGenerator, RecordingOutputGenerator > TestHairGenerator;
+
+const unsigned __int64 HAIR_START_INDEX = 700;  ///< Index of the first hair of voxel
+
+const unsigned __int64 HAIR_COUNT = 3000;   ///< Number of hair of voxel
+
+///-------------------------------------------------------------------------------------------------
+/// Generates hair of voxel file.
+///
+/// \param	aScene						The scene ( hair properties of frame ).
+/// \param	aFileName					Filename of the voxel file.
+/// \param [in,out]	aOutputGenerator	The output generator.
+///
+/// \return	true if voxel file contains baked roots.
+///-------------------------------------------------------------------------------------------------
+bool generate( const TestScene & aScene, const std::string & aFileName, RecordingOutputGenerator & aOutputGenerator )
+{
+	RMPositionGenerator positionGenerator( aScene, aFileName );
+	TestHairGenerator hairGenerator( positionGenerator, aOutputGenerator );
+	hairGenerator.generate( aScene );
+	return positionGenerator.getBakedRoot() != 0;
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Compares hair of voxel with baked roots and without them.
+///
+/// \param	aScene			The scene.
+/// \param	aDirectory		The directory of voxel files.
+/// \param	aName			The name of scene configuration.
+/// \param [in,out]	aResult	The test result.
+///-------------------------------------------------------------------------------------------------
+void compare( const TestScene & aScene, const std::string & aDirectory, const std::string & aName,
+	TestResult & aResult )
+{
+	const std::string unbakedFile = aDirectory + "/unbaked.VX0";
+	const std::string bakedFile = aDirectory + "/baked.VX0";
+	aScene.exportVoxelToFile( unbakedFile, HAIR_START_INDEX, HAIR_COUNT, false );
+	aScene.exportVoxelToFile( bakedFile, HAIR_START_INDEX, HAIR_COUNT, true );
+	RecordingOutputGenerator unbaked( aScene.areNormalsCalculated() );
+	RecordingOutputGenerator baked( aScene.areNormalsCalculated() );
+	aResult.check( !generate( aScene, unbakedFile, unbaked ), aName + " : unbaked voxel has no baked roots" );
+	aResult.check( generate( aScene, bakedFile, baked ), aName + " : baked voxel has baked roots" );
+	std::ostringstream hairCount;
+	hairCount << aName << " : hair generated ( " << unbaked.getHairCount() << " )";
+	aResult.check( unbaked.getHairCount() > 0, hairCount.str() );
+	std::string difference;
+	const bool areEqual = unbaked.compare( baked, difference );
+	aResult.check( areEqual, aName + " : " + difference );
+	remove( unbakedFile.c_str() );
+	remove( bakedFile.c_str() );
+}
+
+} // unnamed namespace
+
+int main()
+{
+	TestResult result( "BakedRootsTest" );
+	char directory[] = "/tmp/StubbleBakedRootsTestXXXXXX";
+	if ( mkdtemp( directory ) == 0 )
+	{
+		std::cerr << "Temporary directory can not be created !" << std::endl;
+		return 1;
+	}
+	for ( int counterBased = 0; counterBased < 2; ++counterBased )
+	{
+		const std::string random = counterBased != 0 ? "counter based" : "James";
+		TestScene scene( 50 );
+		scene.setRandomCounterBased( counterBased != 0, 1234 );
+		compare( scene, directory, random + " random", result );
+		scene.setInterpolation( false, 7 );
+		compare( scene, directory, random + " random with 7 closest guides", result );
+		scene.setInterpolation( true, 3 );
+		compare( scene, directory, random + " random with guides triangulation", result );
+		scene.setCut( 0, 0.7f );
+		compare( scene, directory, random + " random with cut hair", result );
+	}
+	rmdir( directory );
+	return result.getExitCode();
+}
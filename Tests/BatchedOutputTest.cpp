@@ -0,0 +1,167 @@
+///-------------------------------------------------------------------------------------------------
+/// Checks colors, opacities and widths of hair points, which are output in batches. Hair of the test
+/// scene is generated with constant root and tip colors, so every point must have width, opacity and
+/// color interpolated from root to tip by the same curve parameter. Curve parameter of point is
+/// recovered from its width, opacity and color are then compared with values computed point by
+/// point ( color by HSVtoRGB ). Hair with constant hue ( converted by precomputed hue sector ) and
+/// varying hue are checked with cut, decimated and multi strand hair, so points counts of hair are
+/// not multiples of batch size.
+///-------------------------------------------------------------------------------------------------
+
+#include "Common/RecordingOutputGenerator.hpp"
+#include "Common/TestResult.hpp"
+#include "Common/TestScene.hpp"
+
+#include "Common/CommonFunctions.hpp"
+#include "HairShape/Generators/UVPointGenerator.hpp"
+#include "HairShape/Interpolation/HairGenerator.tmpl.hpp"
+#include "HairShape/Interpolation/Maya/SimplePositionGenerator.hpp"
+
+#include <cmath>
+#include <sstream>
+#include <string>
+
+using namespace Stubble;
+using namespace Stubble::HairShape;
+using namespace Stubble::HairShape::Interpolation;
+using namespace Stubble::Tests;
+
+namespace
+{
+
+typedef HairGenerator< Maya::SimplePositionGenerator, RecordingOutputGenerator > TestHairGenerator;
+
+const unsigned __int32 HAIR_COUNT = 2000;   ///< Number of generated hair
+
+const float TOLERANCE = 1e-4f;  ///< The tolerance of interpolated values
+
+///-------------------------------------------------------------------------------------------------
+/// Generates hair of the test scene.
+///
+/// \param	aScene						The scene.
+/// \param [in,out]	aOutputGenerator	The output generator.
+///-------------------------------------------------------------------------------------------------
+void generate( const TestScene & aScene, RecordingOutputGenerator & aOutputGenerator )
+{
+	RandomGenerator rootsRandom;
+	UVPointGenerator uvPointGenerator( aScene.getDensityTexture(),
+		aScene.getRestPoseMesh().getTriangleConstIterator(), rootsRandom );
+	Maya::SimplePositionGenerator positionGenerator( aScene.getRestPoseMesh(), aScene.getCurrentMesh(),
+		uvPointGenerator, HAIR_COUNT, 0 );
+	TestHairGenerator hairGenerator( positionGenerator, aOutputGenerator );
+	hairGenerator.generate( aScene );
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Generates hair of the scene and checks colors, opacities and widths of all points.
+///
+/// \param	aScene			The scene.
+/// \param	aRootColor		The root color ( RGB ) set to scene.
+/// \param	aTipColor		The tip color ( RGB ) set to scene.
+/// \param	aName			The name of scene configuration.
+/// \param [in,out]	aResult	The test result.
+///-------------------------------------------------------------------------------------------------
+void check( const TestScene & aScene, const float * aRootColor, const float * aTipColor, const std::string & aName,
+	TestResult & aResult )
+{
+	RecordingOutputGenerator output( aScene.areNormalsCalculated() );
+	generate( aScene, output );
+	// Constant textures, so hair properties are the same at every root
+	const float rootWidth = static_cast< float >( aScene.getRootThickness() * 
+		aScene.getRootThicknessTexture().realAtUV( 0, 0 ) );
+	const float tipWidth = static_cast< float >( aScene.getTipThickness() * 
+		aScene.getTipThicknessTexture().realAtUV( 0, 0 ) );
+	const float rootOpacity = static_cast< float >( aScene.getRootOpacity() * 
+		aScene.getRootOpacityTexture().realAtUV( 0, 0 ) );
+	const float tipOpacity = static_cast< float >( aScene.getTipOpacity() * 
+		aScene.getTipOpacityTexture().realAtUV( 0, 0 ) );
+	aResult.check( rootWidth != tipWidth, aName + " : root and tip widths differ" );
+	float rootHSV[ 3 ], tipHSV[ 3 ];
+	RGBtoHSV( rootHSV, aRootColor );
+	RGBtoHSV( tipHSV, aTipColor );
+	// Shorter way around the hue circle
+	const float hueDistanceCW = rootHSV[ 0 ] >= tipHSV[ 0 ] ? tipHSV[ 0 ] + 360 - rootHSV[ 0 ] :
+		tipHSV[ 0 ] - rootHSV[ 0 ];
+	const float hueDistanceCCW = rootHSV[ 0 ] >= tipHSV[ 0 ] ? rootHSV[ 0 ] - tipHSV[ 0 ] :
+		rootHSV[ 0 ] + 360 - tipHSV[ 0 ];
+	const float hueDistance = hueDistanceCW <= hueDistanceCCW ? hueDistanceCW : -hueDistanceCCW;
+	size_t pointIndex = 0;
+	unsigned __int32 partialBatchesCount = 0;
+	unsigned __int32 differentHairCount = 0;
+	for ( std::vector< unsigned __int32 >::const_iterator it = output.mPointsCounts.begin();
+		it != output.mPointsCounts.end(); ++it )
+	{
+		// Colors, opacities and widths are not duplicated for the first and the last point
+		const unsigned __int32 count = *it - 2;
+		partialBatchesCount += count % 4 != 0 ? 1 : 0;
+		bool isDifferent = fabs( output.mWidths[ pointIndex ] - rootWidth ) > TOLERANCE;
+		for ( unsigned __int32 i = 0; i < count; ++i, ++pointIndex )
+		{
+			const float t = ( rootWidth - output.mWidths[ pointIndex ] ) / ( rootWidth - tipWidth );
+			const float opacity = clamp( t * tipOpacity + ( 1 - t ) * rootOpacity, 0.0f, 1.0f );
+			const float hsv[ 3 ] = { circleValue( t * hueDistance + rootHSV[ 0 ], 0.0f, 360.0f ),
+				t * tipHSV[ 1 ] + ( 1 - t ) * rootHSV[ 1 ], t * tipHSV[ 2 ] + ( 1 - t ) * rootHSV[ 2 ] };
+			float rgb[ 3 ];
+			HSVtoRGB( rgb, hsv );
+			isDifferent = isDifferent || t < -TOLERANCE || t > 1 + TOLERANCE;
+			for ( unsigned __int32 j = 0; j < 3; ++j )
+			{
+				isDifferent = isDifferent || fabs( output.mOpacities[ pointIndex * 3 + j ] - opacity ) > TOLERANCE ||
+					fabs( output.mColors[ pointIndex * 3 + j ] - rgb[ j ] ) > TOLERANCE;
+			}
+		}
+		differentHairCount += isDifferent ? 1 : 0;
+	}
+	std::ostringstream hairCount;
+	hairCount << aName << " : hair generated ( " << output.getHairCount() << " ), " << partialBatchesCount
+		<< " with partial batch";
+	aResult.check( output.getHairCount() > 0 && partialBatchesCount > 0, hairCount.str() );
+	aResult.check( pointIndex == output.mWidths.size(), aName + " : all points checked" );
+	std::ostringstream different;
+	different << aName << " : " << differentHairCount << " of " << output.getHairCount() << " hair differ";
+	aResult.check( differentHairCount == 0, different.str() );
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Checks hair of scene configurations with given root and tip colors.
+///
+/// \param	aRootColor		The root color ( RGB ).
+/// \param	aTipColor		The tip color ( RGB ).
+/// \param	aName			The name of colors.
+/// \param [in,out]	aResult	The test result.
+///-------------------------------------------------------------------------------------------------
+void checkColors( const float * aRootColor, const float * aTipColor, const std::string & aName, TestResult & aResult )
+{
+	const Real rootColor[ 3 ] = { aRootColor[ 0 ], aRootColor[ 1 ], aRootColor[ 2 ] };
+	const Real tipColor[ 3 ] = { aTipColor[ 0 ], aTipColor[ 1 ], aTipColor[ 2 ] };
+	TestScene scene( 50 );
+	scene.setColors( rootColor, tipColor );
+	check( scene, aRootColor, aTipColor, aName, aResult );
+	scene.setCut( 0.1f, 0.8f );
+	check( scene, aRootColor, aTipColor, aName + " with cut hair", aResult );
+	scene.setDecimationTolerance( 0.01 );
+	check( scene, aRootColor, aTipColor, aName + " with decimated hair", aResult );
+	scene.setNormalsCalculated( true );
+	scene.setMultiStrandCount( 3 );
+	check( scene, aRootColor, aTipColor, aName + " with multi strands", aResult );
+}
+
+} // unnamed namespace
+
+int main()
+{
+	TestResult result( "BatchedOutputTest" );
+	// Binary fractions, so root and tip hue are exactly the same
+	const float rootColor[ 3 ] = { 0.5f, 0.25f, 0.125f };
+	const float tipColor[ 3 ] = { 1.0f, 0.5f, 0.25f };
+	float rootHSV[ 3 ], tipHSV[ 3 ];
+	RGBtoHSV( rootHSV, rootColor );
+	RGBtoHSV( tipHSV, tipColor );
+	result.check( rootHSV[ 0 ] == tipHSV[ 0 ], "Constant hue colors have the same hue" );
+	checkColors( rootColor, tipColor, "Constant hue", result );
+	// Hue goes counterclockwise from root to tip
+	const float varyingTipColor[ 3 ] = { 0.25f, 0.5f, 1.0f };
+	checkColors( rootColor, varyingTipColor, "Varying hue", result );
+	checkColors( varyingTipColor, rootColor, "Varying hue reversed", result );
+	return result.getExitCode();
+}
@@ -0,0 +1,135 @@
+///-------------------------------------------------------------------------------------------------
+/// Compares speed of closest guides queries of RestPositionsDS : the query allocating its result
+/// for every position, the query reusing caller owned query object and the batched query.
+/// Queries are made for hair roots of the test scene in order of their generation.
+///
+/// Usage : ClosestGuidesBenchmark [ guides count ] [ queries count ] [ closest guides count ]
+/// Defaults are 10000 guides, 1000000 queries and 3 closest guides.
+///-------------------------------------------------------------------------------------------------
+
+#include "Common/TestScene.hpp"
+
+#include "Common/StubbleTimer.hpp"
+#include "HairShape/Generators/UVPointGenerator.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace Stubble;
+using namespace Stubble::HairShape;
+using namespace Stubble::HairShape::HairComponents;
+using namespace Stubble::Tests;
+
+namespace
+{
+
+const unsigned __int32 BATCH_SIZE = 4096;   ///< Number of positions of one batched query
+
+///-------------------------------------------------------------------------------------------------
+/// Sums identifiers of found guides, so the results of different queries can be compared and the
+/// queries can not be optimized out.
+///
+/// \param	aClosestGuides	The closest guides.
+/// \param	aCount			Number of closest guides.
+///
+/// \return	The sum of guides identifiers.
+///-------------------------------------------------------------------------------------------------
+unsigned __int64 checksum( const IdAndDistance * aClosestGuides, size_t aCount )
+{
+	unsigned __int64 sum = 0;
+	for ( const IdAndDistance * it = aClosestGuides, * end = aClosestGuides + aCount; it != end; ++it )
+	{
+		sum += it->mGuideId;
+	}
+	return sum;
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Reports result of one benchmark.
+///
+/// \param	aName			The benchmark name.
+/// \param	aTimer			The stopped timer.
+/// \param	aQueriesCount	Number of queries.
+/// \param	aChecksum		The checksum of found guides.
+///-------------------------------------------------------------------------------------------------
+void report( const char * aName, Timer & aTimer, unsigned __int32 aQueriesCount, unsigned __int64 aChecksum )
+{
+	std::cout << aName << " : " << aTimer.getElapsedTime() << " s, "
+		<< aTimer.getElapsedTime() * 1e9 / aQueriesCount << " ns per query ( checksum " << aChecksum << " )"
+		<< std::endl;
+}
+
+} // unnamed namespace
+
+int main( int argc, char ** argv )
+{
+	const unsigned __int32 guidesCount = argc > 1 ? static_cast< unsigned __int32 >( atoi( argv[ 1 ] ) ) : 10000;
+	const unsigned __int32 queriesCount = argc > 2 ? static_cast< unsigned __int32 >( atoi( argv[ 2 ] ) ) : 1000000;
+	const unsigned __int32 n = argc > 3 ? static_cast< unsigned __int32 >( atoi( argv[ 3 ] ) ) : 3;
+	std::cout << "Closest guides queries : " << guidesCount << " guides, " << queriesCount << " queries, "
+		<< n << " closest guides" << std::endl;
+	// Prepare hair roots positions
+	TestScene scene( guidesCount );
+	const RestPositionsDS & restPositionsDS = scene.getGuidesRestPositionsDS();
+	RandomGenerator random;
+	UVPointGenerator uvPointGenerator( scene.getDensityTexture(),
+		scene.getRestPoseMesh().getTriangleConstIterator(), random );
+	std::vector< Vector3D< Real > > positions( queriesCount );
+	std::vector< unsigned __int32 > interpolationGroupIds( queriesCount, 0 );
+	for ( unsigned __int32 i = 0; i < queriesCount; ++i )
+	{
+		positions[ i ] = scene.getRestPoseMesh().getPosition( uvPointGenerator.next() );
+	}
+	// Old query, result is allocated for every position
+	Timer timer;
+	unsigned __int64 sum = 0;
+	ClosestGuides closestGuides;
+	timer.start();
+	for ( unsigned __int32 i = 0; i < queriesCount; ++i )
+	{
+		restPositionsDS.getNClosestGuides( positions[ i ], 0, n, closestGuides );
+		sum += checksum( &closestGuides.front(), closestGuides.size() );
+	}
+	timer.stop();
+	report( "Allocating query", timer, queriesCount, sum );
+	const unsigned __int64 expectedSum = sum;
+	// Reusable query
+	ClosestGuidesQuery query;
+	timer.reset();
+	sum = 0;
+	timer.start();
+	for ( unsigned __int32 i = 0; i < queriesCount; ++i )
+	{
+		restPositionsDS.getNClosestGuides( positions[ i ], 0, n, query );
+		sum += checksum( &query.getClosestGuides().front(), query.getClosestGuides().size() );
+	}
+	timer.stop();
+	report( "Reusable query", timer, queriesCount, sum );
+	bool isEqual = sum == expectedSum;
+	// Batched query
+	std::vector< IdAndDistance > batchClosestGuides( BATCH_SIZE * n );
+	std::vector< unsigned __int32 > batchCounts( BATCH_SIZE );
+	timer.reset();
+	sum = 0;
+	timer.start();
+	for ( unsigned __int32 i = 0; i < queriesCount; i += BATCH_SIZE )
+	{
+		const unsigned __int32 count = queriesCount - i < BATCH_SIZE ? queriesCount - i : BATCH_SIZE;
+		restPositionsDS.getNClosestGuides( &positions[ i ], &interpolationGroupIds[ i ], count, n, query,
+			&batchClosestGuides.front(), &batchCounts.front() );
+		for ( unsigned __int32 j = 0; j < count; ++j )
+		{
+			sum += checksum( &batchClosestGuides[ j * n ], batchCounts[ j ] );
+		}
+	}
+	timer.stop();
+	report( "Batched query", timer, queriesCount, sum );
+	isEqual = isEqual && sum == expectedSum;
+	if ( !isEqual )
+	{
+		std::cerr << "Queries have found different guides !" << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,196 @@
+#ifndef STUBBLE_COUNTING_OUTPUT_GENERATOR_HPP
+#define STUBBLE_COUNTING_OUTPUT_GENERATOR_HPP
+
+#include "RecordingOutputGenerator.hpp"
+
+#include <vector>
+
+namespace Stubble
+{
+
+namespace Tests
+{
+
+///-------------------------------------------------------------------------------------------------
+/// Output generator, which only counts generated hair and points. Every hair is written to the
+/// same buffers of single hair, so any number of points can be generated without allocating them.
+///-------------------------------------------------------------------------------------------------
+class CountingOutputGenerator : public HairShape::Interpolation::OutputGenerator< RecordingTypes >,
+	public RecordingTypes
+{
+public:
+
+	///-------------------------------------------------------------------------------------------------
+	/// Default constructor.
+	///-------------------------------------------------------------------------------------------------
+	inline CountingOutputGenerator();
+
+	inline void beginOutput( unsigned __int64 aMaxHairCount, unsigned __int32 aMaxPointsCount );
+
+	inline void endOutput();
+
+	inline bool areNormalsUsed() const;
+
+	inline void beginHair( unsigned __int32 aMaxPointsCount );
+
+	inline void endHair( unsigned __int32 aPointsCount );
+
+	inline PositionType * positionPointer();
+
+	inline ColorType * colorPointer();
+
+	inline NormalType * normalPointer();
+
+	inline WidthType * widthPointer();
+
+	inline OpacityType * opacityPointer();
+
+	inline UVCoordinateType * hairUVCoordinatePointer();
+
+	inline UVCoordinateType * strandUVCoordinatePointer();
+
+	inline IndexType * hairIndexPointer();
+
+	inline IndexType * strandIndexPointer();
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets number of generated hair.
+	///
+	/// \return	The hair count.
+	///-------------------------------------------------------------------------------------------------
+	inline unsigned __int64 getHairCount() const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets number of generated points.
+	///
+	/// \return	The points count.
+	///-------------------------------------------------------------------------------------------------
+	inline unsigned __int64 getPointsCount() const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets sum of maximal hair counts passed to beginOutput.
+	///
+	/// \return	The maximal hair count.
+	///-------------------------------------------------------------------------------------------------
+	inline unsigned __int64 getMaxHairCount() const;
+
+private:
+
+	unsigned __int64 mHairCount;	///< Number of generated hair
+
+	unsigned __int64 mPointsCount;  ///< Number of generated points
+
+	unsigned __int64 mMaxHairCount; ///< Sum of maximal hair counts passed to beginOutput
+
+	std::vector< PositionType > mPositions; ///< The positions of current hair
+
+	std::vector< ColorType > mValues;   ///< The colors, normals, widths and opacities of current hair
+
+	UVCoordinateType mUVCoordinates[ 4 ];   ///< The hair and strand uv coordinates of current hair
+
+	IndexType mIndices[ 2 ];	///< The hair and strand index of current hair
+};
+
+// inline functions implementation
+
+inline CountingOutputGenerator::CountingOutputGenerator():
+	mHairCount( 0 ),
+	mPointsCount( 0 ),
+	mMaxHairCount( 0 )
+{
+}
+
+inline void CountingOutputGenerator::beginOutput( unsigned __int64 aMaxHairCount, unsigned __int32 aMaxPointsCount )
+{
+	mMaxHairCount += aMaxHairCount;
+	mPositions.resize( aMaxPointsCount * 3 );
+	// Colors, normals and opacities have 3 components, widths have 1
+	mValues.resize( aMaxPointsCount * 10 );
+}
+
+inline void CountingOutputGenerator::endOutput()
+{
+	/* EMPTY */
+}
+
+inline bool CountingOutputGenerator::areNormalsUsed() const
+{
+	return false;
+}
+
+inline void CountingOutputGenerator::beginHair( unsigned __int32 aMaxPointsCount )
+{
+	/* EMPTY */
+}
+
+inline void CountingOutputGenerator::endHair( unsigned __int32 aPointsCount )
+{
+	++mHairCount;
+	mPointsCount += aPointsCount;
+}
+
+inline RecordingTypes::PositionType * CountingOutputGenerator::positionPointer()
+{
+	return &mPositions.front();
+}
+
+inline RecordingTypes::ColorType * CountingOutputGenerator::colorPointer()
+{
+	return &mValues.front();
+}
+
+inline RecordingTypes::NormalType * CountingOutputGenerator::normalPointer()
+{
+	return &mValues.front() + mPositions.size();
+}
+
+inline RecordingTypes::WidthType * CountingOutputGenerator::widthPointer()
+{
+	return &mValues.front() + 2 * mPositions.size();
+}
+
+inline RecordingTypes::OpacityType * CountingOutputGenerator::opacityPointer()
+{
+	return &mValues.front() + 2 * mPositions.size() + mPositions.size() / 3;
+}
+
+inline RecordingTypes::UVCoordinateType * CountingOutputGenerator::hairUVCoordinatePointer()
+{
+	return mUVCoordinates;
+}
+
+inline RecordingTypes::UVCoordinateType * CountingOutputGenerator::strandUVCoordinatePointer()
+{
+	return mUVCoordinates + 2;
+}
+
+inline RecordingTypes::IndexType * CountingOutputGenerator::hairIndexPointer()
+{
+	return mIndices;
+}
+
+inline RecordingTypes::IndexType * CountingOutputGenerator::strandIndexPointer()
+{
+	return mIndices + 1;
+}
+
+inline unsigned __int64 CountingOutputGenerator::getHairCount() const
+{
+	return mHairCount;
+}
+
+inline unsigned __int64 CountingOutputGenerator::getPointsCount() const
+{
+	return mPointsCount;
+}
+
+inline unsigned __int64 CountingOutputGenerator::getMaxHairCount() const
+{
+	return mMaxHairCount;
+}
+
+} // namespace Tests
+
+} // namespace Stubble
+
+#endif // STUBBLE_COUNTING_OUTPUT_GENERATOR_HPP
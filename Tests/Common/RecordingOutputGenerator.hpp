@@ -0,0 +1,308 @@
+#ifndef STUBBLE_RECORDING_OUTPUT_GENERATOR_HPP
+#define STUBBLE_RECORDING_OUTPUT_GENERATOR_HPP
+
+#include "HairShape/Interpolation/OutputGenerator.hpp"
+
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace Stubble
+{
+
+namespace Tests
+{
+
+///-------------------------------------------------------------------------------------------------
+/// The types of recording output generator ( same as RenderMan output generator types ).
+///-------------------------------------------------------------------------------------------------
+struct RecordingTypes
+{
+	typedef float PositionType;
+
+	typedef float ColorType;
+
+	typedef float NormalType;
+
+	typedef float WidthType;
+
+	typedef float OpacityType;
+
+	typedef float UVCoordinateType;
+
+	typedef int IndexType;
+};
+
+///-------------------------------------------------------------------------------------------------
+/// Output generator, which records all generated hair to its buffers, so the output of two hair
+/// generators can be compared buffer by buffer.
+///-------------------------------------------------------------------------------------------------
+class RecordingOutputGenerator : public HairShape::Interpolation::OutputGenerator< RecordingTypes >,
+	public RecordingTypes
+{
+public:
+
+	///-------------------------------------------------------------------------------------------------
+	/// Constructor.
+	///
+	/// \param	aNormalsUsed	true if normals are used ( and recorded ).
+	///-------------------------------------------------------------------------------------------------
+	inline RecordingOutputGenerator( bool aNormalsUsed );
+
+	inline void beginOutput( unsigned __int64 aMaxHairCount, unsigned __int32 aMaxPointsCount );
+
+	inline void endOutput();
+
+	inline bool areNormalsUsed() const;
+
+	inline void beginHair( unsigned __int32 aMaxPointsCount );
+
+	inline void endHair( unsigned __int32 aPointsCount );
+
+	inline PositionType * positionPointer();
+
+	inline ColorType * colorPointer();
+
+	inline NormalType * normalPointer();
+
+	inline WidthType * widthPointer();
+
+	inline OpacityType * opacityPointer();
+
+	inline UVCoordinateType * hairUVCoordinatePointer();
+
+	inline UVCoordinateType * strandUVCoordinatePointer();
+
+	inline IndexType * hairIndexPointer();
+
+	inline IndexType * strandIndexPointer();
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets number of recorded hair.
+	///
+	/// \return	The hair count.
+	///-------------------------------------------------------------------------------------------------
+	inline size_t getHairCount() const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets number of beginOutput calls.
+	///
+	/// \return	The outputs count.
+	///-------------------------------------------------------------------------------------------------
+	inline unsigned __int32 getOutputsCount() const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Compares recorded buffers with buffers of other output generator.
+	///
+	/// \param	aOutputGenerator	The other output generator.
+	/// \param [out]	aDifference	The name of the first different buffer and the index of the first
+	/// 							different item ( empty if buffers are equal ).
+	///
+	/// \return	true if all buffers are equal.
+	///-------------------------------------------------------------------------------------------------
+	inline bool compare( const RecordingOutputGenerator & aOutputGenerator, std::string & aDifference ) const;
+
+	std::vector< unsigned __int32 > mPointsCounts;  ///< The points counts of hair
+
+	std::vector< PositionType > mPositions; ///< The positions of hair points
+
+	std::vector< ColorType > mColors;   ///< The colors of hair points
+
+	std::vector< NormalType > mNormals; ///< The normals of hair points ( undefined if normals are not used )
+
+	std::vector< WidthType > mWidths;   ///< The widths of hair points
+
+	std::vector< OpacityType > mOpacities;  ///< The opacities of hair points
+
+	std::vector< UVCoordinateType > mHairUVCoordinates; ///< The uv coordinates of hair
+
+	std::vector< UVCoordinateType > mStrandUVCoordinates;   ///< The uv coordinates of strands
+
+	std::vector< IndexType > mHairIndices;  ///< The indices of hair
+
+	std::vector< IndexType > mStrandIndices;	///< The indices of strands
+
+private:
+
+	///-------------------------------------------------------------------------------------------------
+	/// Resizes all per point buffers to given points count of current hair.
+	///
+	/// \param	aPointsCount	Number of the points of current hair.
+	///-------------------------------------------------------------------------------------------------
+	inline void resizeBuffers( unsigned __int32 aPointsCount );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Compares two buffers.
+	///
+	/// \param	aBuffer1		The first buffer.
+	/// \param	aBuffer2		The second buffer.
+	/// \param	aName			The buffer name.
+	/// \param [out]	aDifference	The name of buffer and the index of the first different item.
+	///
+	/// \return	true if buffers are equal.
+	///-------------------------------------------------------------------------------------------------
+	template< typename tType >
+	static inline bool compareBuffers( const std::vector< tType > & aBuffer1, const std::vector< tType > & aBuffer2,
+		const char * aName, std::string & aDifference );
+
+	bool mNormalsUsed;  ///< true if normals are used
+
+	unsigned __int32 mOutputsCount;   ///< Number of beginOutput calls
+
+	size_t mPositionsSize;  ///< Number of positions of finished hair ( buffers may be larger )
+
+	size_t mColorsSize; ///< Number of colors of finished hair ( buffers may be larger )
+};
+
+// inline functions implementation
+
+inline RecordingOutputGenerator::RecordingOutputGenerator( bool aNormalsUsed ):
+	mNormalsUsed( aNormalsUsed ),
+	mOutputsCount( 0 ),
+	mPositionsSize( 0 ),
+	mColorsSize( 0 )
+{
+}
+
+inline void RecordingOutputGenerator::beginOutput( unsigned __int64 aMaxHairCount, unsigned __int32 aMaxPointsCount )
+{
+	++mOutputsCount;
+}
+
+inline void RecordingOutputGenerator::endOutput()
+{
+	/* EMPTY */
+}
+
+inline bool RecordingOutputGenerator::areNormalsUsed() const
+{
+	return mNormalsUsed;
+}
+
+inline void RecordingOutputGenerator::beginHair( unsigned __int32 aMaxPointsCount )
+{
+	resizeBuffers( aMaxPointsCount );
+	mHairUVCoordinates.resize( mHairUVCoordinates.size() + 2 );
+	mStrandUVCoordinates.resize( mStrandUVCoordinates.size() + 2 );
+	mHairIndices.resize( mHairIndices.size() + 1 );
+	mStrandIndices.resize( mStrandIndices.size() + 1 );
+}
+
+inline void RecordingOutputGenerator::endHair( unsigned __int32 aPointsCount )
+{
+	resizeBuffers( aPointsCount );
+	mPositionsSize = mPositions.size();
+	mColorsSize = mColors.size();
+	mPointsCounts.push_back( aPointsCount );
+}
+
+inline RecordingTypes::PositionType * RecordingOutputGenerator::positionPointer()
+{
+	return &mPositions[ mPositionsSize ];
+}
+
+inline RecordingTypes::ColorType * RecordingOutputGenerator::colorPointer()
+{
+	return &mColors[ mColorsSize ];
+}
+
+inline RecordingTypes::NormalType * RecordingOutputGenerator::normalPointer()
+{
+	return &mNormals[ mColorsSize ];
+}
+
+inline RecordingTypes::WidthType * RecordingOutputGenerator::widthPointer()
+{
+	return &mWidths[ mColorsSize / 3 ];
+}
+
+inline RecordingTypes::OpacityType * RecordingOutputGenerator::opacityPointer()
+{
+	return &mOpacities[ mColorsSize ];
+}
+
+inline RecordingTypes::UVCoordinateType * RecordingOutputGenerator::hairUVCoordinatePointer()
+{
+	return &mHairUVCoordinates[ mHairUVCoordinates.size() - 2 ];
+}
+
+inline RecordingTypes::UVCoordinateType * RecordingOutputGenerator::strandUVCoordinatePointer()
+{
+	return &mStrandUVCoordinates[ mStrandUVCoordinates.size() - 2 ];
+}
+
+inline RecordingTypes::IndexType * RecordingOutputGenerator::hairIndexPointer()
+{
+	return &mHairIndices.back();
+}
+
+inline RecordingTypes::IndexType * RecordingOutputGenerator::strandIndexPointer()
+{
+	return &mStrandIndices.back();
+}
+
+inline size_t RecordingOutputGenerator::getHairCount() const
+{
+	return mPointsCounts.size();
+}
+
+inline unsigned __int32 RecordingOutputGenerator::getOutputsCount() const
+{
+	return mOutputsCount;
+}
+
+inline bool RecordingOutputGenerator::compare( const RecordingOutputGenerator & aOutputGenerator,
+	std::string & aDifference ) const
+{
+	aDifference.clear();
+	return compareBuffers( mPointsCounts, aOutputGenerator.mPointsCounts, "points counts", aDifference ) &&
+		compareBuffers( mPositions, aOutputGenerator.mPositions, "positions", aDifference ) &&
+		compareBuffers( mColors, aOutputGenerator.mColors, "colors", aDifference ) &&
+		( !mNormalsUsed || compareBuffers( mNormals, aOutputGenerator.mNormals, "normals", aDifference ) ) &&
+		compareBuffers( mWidths, aOutputGenerator.mWidths, "widths", aDifference ) &&
+		compareBuffers( mOpacities, aOutputGenerator.mOpacities, "opacities", aDifference ) &&
+		compareBuffers( mHairUVCoordinates, aOutputGenerator.mHairUVCoordinates, "hair uvs", aDifference ) &&
+		compareBuffers( mStrandUVCoordinates, aOutputGenerator.mStrandUVCoordinates, "strand uvs", aDifference ) &&
+		compareBuffers( mHairIndices, aOutputGenerator.mHairIndices, "hair indices", aDifference ) &&
+		compareBuffers( mStrandIndices, aOutputGenerator.mStrandIndices, "strand indices", aDifference );
+}
+
+inline void RecordingOutputGenerator::resizeBuffers( unsigned __int32 aPointsCount )
+{
+	// Other data than points have 2 fewer items
+	const size_t countMinus2 = aPointsCount - 2;
+	mPositions.resize( mPositionsSize + aPointsCount * 3 );
+	mColors.resize( mColorsSize + countMinus2 * 3 );
+	mNormals.resize( mColorsSize + countMinus2 * 3 );
+	mWidths.resize( mColorsSize / 3 + countMinus2 );
+	mOpacities.resize( mColorsSize + countMinus2 * 3 );
+}
+
+template< typename tType >
+inline bool RecordingOutputGenerator::compareBuffers( const std::vector< tType > & aBuffer1, 
+	const std::vector< tType > & aBuffer2, const char * aName, std::string & aDifference )
+{
+	// Buffers are compared bitwise, so even the sign of zero must match
+	const size_t size = std::min( aBuffer1.size(), aBuffer2.size() );
+	size_t i = 0;
+	while ( i < size && memcmp( &aBuffer1[ i ], &aBuffer2[ i ], sizeof( tType ) ) == 0 )
+	{
+		++i;
+	}
+	if ( i == size && aBuffer1.size() == aBuffer2.size() )
+	{
+		return true;
+	}
+	std::ostringstream difference;
+	difference << aName << " differ at item " << i << " ( sizes " << aBuffer1.size() << " and " 
+		<< aBuffer2.size() << " )";
+	aDifference = difference.str();
+	return false;
+}
+
+} // namespace Tests
+
+} // namespace Stubble
+
+#endif // STUBBLE_RECORDING_OUTPUT_GENERATOR_HPP
@@ -0,0 +1,318 @@
+#include "RiRecorder.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <new>
+#include <sstream>
+
+namespace Stubble
+{
+
+namespace Tests
+{
+
+namespace
+{
+
+__thread RiRecorder * gCurrentRecorder = 0; ///< The recorder selected for the calling thread
+
+} // unnamed namespace
+
+RiRecorder::RiRecorder():
+	mIsMotionBlockOpen( false ),
+	mMotionTimesCount( 0 ),
+	mMotionPrimitivesCount( 0 ),
+	mCurvesCount( 0 ),
+	mCurvesCallsCount( 0 ),
+	mFailingCurvesCall( std::numeric_limits< unsigned __int64 >::max() ),
+	mProceduralsCount( 0 )
+{
+}
+
+void RiRecorder::expand( RtPointer aData, RtProcSubdivFunc aSubdivideFunction, RtProcFreeFunc aFreeFunction,
+	RtFloat aDetailSize )
+{
+	RiRecorder * previousRecorder = gCurrentRecorder;
+	gCurrentRecorder = this;
+	// Children of parent procedural are kept aside, so only children of this call are collected
+	std::vector< Procedural > parentChildren;
+	parentChildren.swap( mChildren );
+	aSubdivideFunction( aData, aDetailSize );
+	// Procedural must close all blocks, which it has opened
+	if ( !mAttributeBlocks.empty() || mIsMotionBlockOpen )
+	{
+		addError( "Procedural has not closed its attribute or motion block" );
+		mAttributeBlocks.clear();
+		mIsMotionBlockOpen = false;
+	}
+	std::vector< Procedural > children;
+	children.swap( mChildren );
+	mChildren.swap( parentChildren );
+	// Renderer expands children later, this thread expands them right after their parent
+	for ( unsigned __int32 i = 0; i < children.size(); ++i )
+	{
+		recordCall( "Expand" );
+		recordData( &i, sizeof( unsigned __int32 ) );
+		expand( children[ i ].mData, children[ i ].mSubdivideFunction, children[ i ].mFreeFunction, aDetailSize );
+	}
+	aFreeFunction( aData );
+	gCurrentRecorder = previousRecorder;
+}
+
+RiRecorder & RiRecorder::getCurrent()
+{
+	if ( gCurrentRecorder == 0 )
+	{
+		std::cerr << "RenderMan call outside of procedural expansion !" << std::endl;
+		abort();
+	}
+	return *gCurrentRecorder;
+}
+
+void RiRecorder::attributeBegin()
+{
+	recordCall( "AttributeBegin" );
+	mAttributeBlocks.push_back( false );
+}
+
+void RiRecorder::attributeEnd()
+{
+	recordCall( "AttributeEnd" );
+	if ( mAttributeBlocks.empty() )
+	{
+		addError( "AttributeEnd without AttributeBegin" );
+		return;
+	}
+	if ( mIsMotionBlockOpen )
+	{
+		addError( "AttributeEnd in motion block" );
+	}
+	mAttributeBlocks.pop_back();
+}
+
+void RiRecorder::basis( RtBasis aUBasis, RtInt aUStep, RtBasis aVBasis, RtInt aVStep )
+{
+	recordCall( "Basis" );
+	recordData( aUBasis, sizeof( RtBasis ) );
+	recordData( &aUStep, sizeof( RtInt ) );
+	recordData( aVBasis, sizeof( RtBasis ) );
+	recordData( &aVStep, sizeof( RtInt ) );
+	// Basis set outside of attribute block would change basis of all following primitives
+	if ( mAttributeBlocks.empty() )
+	{
+		addError( "Basis outside of attribute block" );
+		return;
+	}
+	if ( mIsMotionBlockOpen )
+	{
+		addError( "Basis in motion block" );
+	}
+	mAttributeBlocks.back() = true;
+}
+
+void RiRecorder::curves( RtToken aType, RtInt aCurvesCount, RtInt * aVerticesCounts, RtToken aWrap,
+	va_list aParameters )
+{
+	if ( mCurvesCallsCount++ == mFailingCurvesCall )
+	{
+		throw std::bad_alloc();
+	}
+	recordCall( "Curves" );
+	recordData( aType, strlen( aType ) + 1 );
+	recordData( &aCurvesCount, sizeof( RtInt ) );
+	recordData( aVerticesCounts, aCurvesCount * sizeof( RtInt ) );
+	recordData( aWrap, strlen( aWrap ) + 1 );
+	if ( aCurvesCount <= 0 )
+	{
+		addError( "Curves without any curve" );
+	}
+	if ( mAttributeBlocks.empty() || !mAttributeBlocks.back() )
+	{
+		addError( "Curves without basis of procedural" );
+	}
+	countMotionPrimitive();
+	mCurvesCount += aCurvesCount;
+	// Sizes of parameters are given by vertices count, varying values are not stored for end points
+	size_t verticesCount = 0;
+	for ( RtInt i = 0; i < aCurvesCount; ++i )
+	{
+		verticesCount += aVerticesCounts[ i ];
+	}
+	const size_t varyingCount = verticesCount - 2 * aCurvesCount;
+	for ( RtToken token = va_arg( aParameters, RtToken ); token != RI_NULL; token = va_arg( aParameters, RtToken ) )
+	{
+		const RtPointer value = va_arg( aParameters, RtPointer );
+		size_t size;
+		if ( strcmp( token, RI_P ) == 0 )
+		{
+			size = 3 * verticesCount * sizeof( RtFloat );
+		}
+		else if ( strcmp( token, RI_CS ) == 0 || strcmp( token, RI_OS ) == 0 || strcmp( token, RI_N ) == 0 )
+		{
+			size = 3 * varyingCount * sizeof( RtFloat );
+		}
+		else if ( strcmp( token, RI_WIDTH ) == 0 )
+		{
+			size = varyingCount * sizeof( RtFloat );
+		}
+		else if ( strstr( token, "uniform float[2]" ) == token )
+		{
+			size = 2 * aCurvesCount * sizeof( RtFloat );
+		}
+		else if ( strstr( token, "uniform int" ) == token )
+		{
+			size = aCurvesCount * sizeof( RtInt );
+		}
+		else
+		{
+			addError( std::string( "Curves with unknown parameter " ) + token );
+			return;
+		}
+		recordData( token, strlen( token ) + 1 );
+		recordData( value, size );
+	}
+}
+
+void RiRecorder::motionBegin( RtInt aTimesCount, RtFloat * aTimes )
+{
+	recordCall( "MotionBegin" );
+	recordData( &aTimesCount, sizeof( RtInt ) );
+	recordData( aTimes, aTimesCount * sizeof( RtFloat ) );
+	if ( mIsMotionBlockOpen )
+	{
+		addError( "MotionBegin in motion block" );
+	}
+	mIsMotionBlockOpen = true;
+	mMotionTimesCount = aTimesCount;
+	mMotionPrimitivesCount = 0;
+}
+
+void RiRecorder::motionEnd()
+{
+	recordCall( "MotionEnd" );
+	if ( !mIsMotionBlockOpen )
+	{
+		addError( "MotionEnd without MotionBegin" );
+		return;
+	}
+	// Every time sample must be given by exactly one primitive
+	if ( mMotionPrimitivesCount != mMotionTimesCount )
+	{
+		std::ostringstream error;
+		error << "Motion block with " << mMotionTimesCount << " times contains " << mMotionPrimitivesCount
+			<< " primitives";
+		addError( error.str() );
+	}
+	mIsMotionBlockOpen = false;
+}
+
+void RiRecorder::procedural( RtPointer aData, RtBound aBound, RtProcSubdivFunc aSubdivideFunction,
+	RtProcFreeFunc aFreeFunction )
+{
+	recordCall( "Procedural" );
+	recordData( aBound, sizeof( RtBound ) );
+	if ( mIsMotionBlockOpen )
+	{
+		addError( "Procedural in motion block" );
+	}
+	if ( aBound[ 0 ] > aBound[ 1 ] || aBound[ 2 ] > aBound[ 3 ] || aBound[ 4 ] > aBound[ 5 ] )
+	{
+		addError( "Procedural with empty bound" );
+	}
+	Procedural child = { aData, aSubdivideFunction, aFreeFunction };
+	mChildren.push_back( child );
+	++mProceduralsCount;
+}
+
+void RiRecorder::recordCall( const char * aName )
+{
+	mRecord.append( aName );
+	mRecord.push_back( '\0' );
+}
+
+void RiRecorder::recordData( const void * aData, size_t aSize )
+{
+	mRecord.append( reinterpret_cast< const char * >( aData ), aSize );
+}
+
+void RiRecorder::addError( const std::string & aError )
+{
+	mErrors += aError + "\n";
+}
+
+void RiRecorder::countMotionPrimitive()
+{
+	if ( mIsMotionBlockOpen )
+	{
+		++mMotionPrimitivesCount;
+	}
+}
+
+} // namespace Tests
+
+} // namespace Stubble
+
+// RenderMan interface used by the hair generator, calls are recorded by the recorder of the thread
+
+using Stubble::Tests::RiRecorder;
+
+RtBasis RiCatmullRomBasis = {
+	{ -0.5f, 1.5f, -1.5f, 0.5f },
+	{ 1.0f, -2.5f, 2.0f, -0.5f },
+	{ -0.5f, 0.0f, 0.5f, 0.0f },
+	{ 0.0f, 1.0f, 0.0f, 0.0f } };
+
+RtToken RI_CUBIC = const_cast< RtToken >( "cubic" );
+
+RtToken RI_NONPERIODIC = const_cast< RtToken >( "nonperiodic" );
+
+RtToken RI_P = const_cast< RtToken >( "P" );
+
+RtToken RI_CS = const_cast< RtToken >( "Cs" );
+
+RtToken RI_OS = const_cast< RtToken >( "Os" );
+
+RtToken RI_N = const_cast< RtToken >( "N" );
+
+RtToken RI_WIDTH = const_cast< RtToken >( "width" );
+
+RtVoid RiAttributeBegin()
+{
+	RiRecorder::getCurrent().attributeBegin();
+}
+
+RtVoid RiAttributeEnd()
+{
+	RiRecorder::getCurrent().attributeEnd();
+}
+
+RtVoid RiBasis( RtBasis aUBasis, RtInt aUStep, RtBasis aVBasis, RtInt aVStep )
+{
+	RiRecorder::getCurrent().basis( aUBasis, aUStep, aVBasis, aVStep );
+}
+
+RtVoid RiCurves( RtToken aType, RtInt aCurvesCount, RtInt * aVerticesCounts, RtToken aWrap, ... )
+{
+	va_list parameters;
+	va_start( parameters, aWrap );
+	RiRecorder::getCurrent().curves( aType, aCurvesCount, aVerticesCounts, aWrap, parameters );
+	va_end( parameters );
+}
+
+RtVoid RiMotionBeginV( RtInt aTimesCount, RtFloat * aTimes )
+{
+	RiRecorder::getCurrent().motionBegin( aTimesCount, aTimes );
+}
+
+RtVoid RiMotionEnd()
+{
+	RiRecorder::getCurrent().motionEnd();
+}
+
+RtVoid RiProcedural( RtPointer aData, RtBound aBound, RtProcSubdivFunc aSubdivideFunction,
+	RtProcFreeFunc aFreeFunction )
+{
+	RiRecorder::getCurrent().procedural( aData, aBound, aSubdivideFunction, aFreeFunction );
+}
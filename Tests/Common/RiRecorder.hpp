@@ -0,0 +1,201 @@
+#ifndef STUBBLE_RI_RECORDER_HPP
+#define STUBBLE_RI_RECORDER_HPP
+
+#include "ri.h"
+
+#include <cstdarg>
+#include <string>
+#include <vector>
+
+namespace Stubble
+{
+
+namespace Tests
+{
+
+///-------------------------------------------------------------------------------------------------
+/// Recording stand-in of RenderMan renderer. RenderMan calls of the thread are recorded by the
+/// recorder selected for that thread, so every thread may expand its own procedurals. All call
+/// arguments ( including data of curves ) are recorded in binary form, so records of two expansions
+/// can be compared byte by byte. The recorder also checks that calls are properly nested : curves
+/// basis is set only in attribute block, motion blocks are balanced and contain one primitive per
+/// time sample and all blocks are closed by procedural, which opened them.
+///-------------------------------------------------------------------------------------------------
+class RiRecorder
+{
+public:
+
+	///-------------------------------------------------------------------------------------------------
+	/// Default constructor.
+	///-------------------------------------------------------------------------------------------------
+	RiRecorder();
+
+	///-------------------------------------------------------------------------------------------------
+	/// Expands procedural in the calling thread : calls its subdivide function with this recorder
+	/// selected, then recursively expands child procedurals emitted by the call in order of their
+	/// emission and finally calls free function of procedural.
+	///
+	/// \param	aData				The procedural data.
+	/// \param	aSubdivideFunction	The subdivide function.
+	/// \param	aFreeFunction		The free function.
+	/// \param	aDetailSize			Size of the detail passed to subdivide function.
+	///-------------------------------------------------------------------------------------------------
+	void expand( RtPointer aData, RtProcSubdivFunc aSubdivideFunction, RtProcFreeFunc aFreeFunction,
+		RtFloat aDetailSize );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the record of all calls.
+	///
+	/// \return	The record.
+	///-------------------------------------------------------------------------------------------------
+	inline const std::string & getRecord() const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the errors of calls nesting ( empty if calls were properly nested ).
+	///
+	/// \return	The errors.
+	///-------------------------------------------------------------------------------------------------
+	inline const std::string & getErrors() const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets number of recorded curves.
+	///
+	/// \return	The curves count.
+	///-------------------------------------------------------------------------------------------------
+	inline unsigned __int64 getCurvesCount() const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets number of recorded child procedurals.
+	///
+	/// \return	The procedurals count.
+	///-------------------------------------------------------------------------------------------------
+	inline unsigned __int32 getProceduralsCount() const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Makes RiCurves call with given index fail ( simulates renderer out of memory ), the call throws
+	/// std::bad_alloc instead of being recorded.
+	///
+	/// \param	aCurvesCallIndex	Zero based index of failing RiCurves call.
+	///-------------------------------------------------------------------------------------------------
+	inline void setFailingCurvesCall( unsigned __int64 aCurvesCallIndex );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets recorder selected for the calling thread, reports error and aborts if there is none.
+	///
+	/// \return	The recorder.
+	///-------------------------------------------------------------------------------------------------
+	static RiRecorder & getCurrent();
+
+	// RenderMan calls ( see ri.h )
+
+	void attributeBegin();
+
+	void attributeEnd();
+
+	void basis( RtBasis aUBasis, RtInt aUStep, RtBasis aVBasis, RtInt aVStep );
+
+	void curves( RtToken aType, RtInt aCurvesCount, RtInt * aVerticesCounts, RtToken aWrap, va_list aParameters );
+
+	void motionBegin( RtInt aTimesCount, RtFloat * aTimes );
+
+	void motionEnd();
+
+	void procedural( RtPointer aData, RtBound aBound, RtProcSubdivFunc aSubdivideFunction,
+		RtProcFreeFunc aFreeFunction );
+
+private:
+
+	///-------------------------------------------------------------------------------------------------
+	/// Child procedural emitted by RiProcedural call.
+	///-------------------------------------------------------------------------------------------------
+	struct Procedural
+	{
+		RtPointer mData;	///< The procedural data
+
+		RtProcSubdivFunc mSubdivideFunction;	///< The subdivide function
+
+		RtProcFreeFunc mFreeFunction;   ///< The free function
+	};
+
+	///-------------------------------------------------------------------------------------------------
+	/// Records call name.
+	///
+	/// \param	aName	The call name.
+	///-------------------------------------------------------------------------------------------------
+	void recordCall( const char * aName );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Records binary data.
+	///
+	/// \param	aData	The data.
+	/// \param	aSize	The size of data in bytes.
+	///-------------------------------------------------------------------------------------------------
+	void recordData( const void * aData, size_t aSize );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Adds error of calls nesting.
+	///
+	/// \param	aError	The error.
+	///-------------------------------------------------------------------------------------------------
+	void addError( const std::string & aError );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Counts primitive of motion block ( if any is open ).
+	///-------------------------------------------------------------------------------------------------
+	void countMotionPrimitive();
+
+	std::string mRecord;	///< The record of calls
+
+	std::string mErrors;	///< The errors of calls nesting
+
+	std::vector< bool > mAttributeBlocks;   ///< Is curves basis set in each open attribute block ?
+
+	bool mIsMotionBlockOpen;	///< true if motion block is open
+
+	RtInt mMotionTimesCount;	///< Number of time samples of open motion block
+
+	RtInt mMotionPrimitivesCount;   ///< Number of primitives in open motion block
+
+	unsigned __int64 mCurvesCount;  ///< Number of recorded curves
+
+	unsigned __int64 mCurvesCallsCount; ///< Number of RiCurves calls
+
+	unsigned __int64 mFailingCurvesCall;	///< Index of failing RiCurves call
+
+	std::vector< Procedural > mChildren;	///< The children emitted by the current subdivide call
+
+	unsigned __int32 mProceduralsCount; ///< Number of recorded child procedurals
+};
+
+// inline functions implementation
+
+inline const std::string & RiRecorder::getRecord() const
+{
+	return mRecord;
+}
+
+inline const std::string & RiRecorder::getErrors() const
+{
+	return mErrors;
+}
+
+inline unsigned __int64 RiRecorder::getCurvesCount() const
+{
+	return mCurvesCount;
+}
+
+inline unsigned __int32 RiRecorder::getProceduralsCount() const
+{
+	return mProceduralsCount;
+}
+
+inline void RiRecorder::setFailingCurvesCall( unsigned __int64 aCurvesCallIndex )
+{
+	mFailingCurvesCall = aCurvesCallIndex;
+}
+
+} // namespace Tests
+
+} // namespace Stubble
+
+#endif // STUBBLE_RI_RECORDER_HPP
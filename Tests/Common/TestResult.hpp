@@ -0,0 +1,85 @@
+#ifndef STUBBLE_TEST_RESULT_HPP
+#define STUBBLE_TEST_RESULT_HPP
+
+#include <iostream>
+#include <string>
+
+namespace Stubble
+{
+
+namespace Tests
+{
+
+///-------------------------------------------------------------------------------------------------
+/// Collects failed checks of single test program. Every failure is reported immediately, the
+/// summary is reported when the exit code of the program is requested.
+///-------------------------------------------------------------------------------------------------
+class TestResult
+{
+public:
+
+	///-------------------------------------------------------------------------------------------------
+	/// Constructor.
+	///
+	/// \param	aTestName	Name of the test.
+	///-------------------------------------------------------------------------------------------------
+	inline TestResult( const std::string & aTestName );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Checks condition, failure is reported.
+	///
+	/// \param	aCondition	The checked condition.
+	/// \param	aMessage	The message describing the check.
+	///
+	/// \return	aCondition.
+	///-------------------------------------------------------------------------------------------------
+	inline bool check( bool aCondition, const std::string & aMessage );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Reports summary of the test and gets exit code of the test program.
+	///
+	/// \return	0 if all checks have passed, 1 otherwise.
+	///-------------------------------------------------------------------------------------------------
+	inline int getExitCode() const;
+
+private:
+
+	std::string mTestName;  ///< Name of the test
+
+	unsigned __int32 mChecksCount;  ///< Number of checks
+
+	unsigned __int32 mFailuresCount;	///< Number of failed checks
+};
+
+// inline functions implementation
+
+inline TestResult::TestResult( const std::string & aTestName ):
+	mTestName( aTestName ),
+	mChecksCount( 0 ),
+	mFailuresCount( 0 )
+{
+}
+
+inline bool TestResult::check( bool aCondition, const std::string & aMessage )
+{
+	++mChecksCount;
+	if ( !aCondition )
+	{
+		++mFailuresCount;
+		std::cerr << mTestName << " : FAILED : " << aMessage << std::endl;
+	}
+	return aCondition;
+}
+
+inline int TestResult::getExitCode() const
+{
+	std::cout << mTestName << " : " << mChecksCount - mFailuresCount << " of " << mChecksCount
+		<< " checks passed" << std::endl;
+	return mFailuresCount == 0 ? 0 : 1;
+}
+
+} // namespace Tests
+
+} // namespace Stubble
+
+#endif // STUBBLE_TEST_RESULT_HPP
@@ -0,0 +1,466 @@
+#include "TestScene.hpp"
+
+#include "Common/CommonConstants.hpp"
+#include "Common/SectionedFile.hpp"
+#include "HairShape/Generators/RandomGenerator.hpp"
+#include "HairShape/Generators/UVPointGenerator.hpp"
+#include "HairShape/Interpolation/BakedHairRoot.hpp"
+#include "HairShape/Interpolation/HairRootsOrder.hpp"
+
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+namespace Stubble
+{
+
+namespace Tests
+{
+
+using namespace HairShape;
+
+const Real TestScene::MESH_SIZE = 10;
+
+TestScene::TestScene( unsigned __int32 aGuidesCount, unsigned __int32 aSeed, unsigned __int32 aSegmentsCount ):
+	mRestPoseMesh( 0 ),
+	mCurrentMesh( 0 )
+{
+	// All textures are constant
+	mDensityTexture = new Texture( 1 );
+	mInterpolationGroupsTexture = new Texture( 1 );
+	mCutTexture = new Texture( 1 );
+	mScaleTexture = new Texture( 1 );
+	mRandScaleTexture = new Texture( 0.2f );
+	mRootThicknessTexture = new Texture( 1 );
+	mTipThicknessTexture = new Texture( 0.5f );
+	mDisplacementTexture = new Texture( 0 );
+	mRootOpacityTexture = new Texture( 1 );
+	mTipOpacityTexture = new Texture( 0.5f );
+	mRootColorTexture = new Texture( 0.4f, 0.2f, 0.1f );
+	mTipColorTexture = new Texture( 0.8f, 0.7f, 0.5f );
+	mHueVariationTexture = new Texture( 0.1f );
+	mValueVariationTexture = new Texture( 0.1f );
+	mMutantHairColorTexture = new Texture( 1, 0, 0 );
+	mPercentMutantHairTexture = new Texture( 0.05f );
+	mRootFrizzTexture = new Texture( 0.2f );
+	mTipFrizzTexture = new Texture( 0.4f );
+	mFrizzXFrequencyTexture = new Texture( 1 );
+	mFrizzYFrequencyTexture = new Texture( 1 );
+	mFrizzZFrequencyTexture = new Texture( 1 );
+	mFrizzAnimTexture = new Texture( 0 );
+	mFrizzAnimSpeedTexture = new Texture( 0 );
+	mRootKinkTexture = new Texture( 0.1f );
+	mTipKinkTexture = new Texture( 0.2f );
+	mKinkXFrequencyTexture = new Texture( 1 );
+	mKinkYFrequencyTexture = new Texture( 1 );
+	mKinkZFrequencyTexture = new Texture( 1 );
+	mRootSplayTexture = new Texture( 0.5f );
+	mTipSplayTexture = new Texture( 1 );
+	mCenterSplayTexture = new Texture( 0.5f );
+	mTwistTexture = new Texture( 0.5f );
+	mOffsetTexture = new Texture( 0 );
+	mAspectTexture = new Texture( 1 );
+	mRandomizeStrandTexture = new Texture( 0.5f );
+	mInterpolationGroups = new Interpolation::InterpolationGroups( *mInterpolationGroupsTexture,
+		aSegmentsCount );
+	updateAttributeAtlas();
+	// Meshes
+	mRestPoseMesh = createMesh( Vector3D< Real >( 0, 0, 0 ), 0 );
+	mCurrentMesh = createMesh( Vector3D< Real >( 1, 2, 3 ), 0.05 );
+	// Guides
+	createGuides( aGuidesCount, aSeed, aSegmentsCount );
+	mGuidesSegments = &mGuidesSegmentsStorage;
+	mGuidesRestPositionsDS = &mGuidesRestPositionsDSStorage;
+}
+
+TestScene::~TestScene()
+{
+	delete mRestPoseMesh;
+	delete mCurrentMesh;
+	// Base class forgets root kink texture
+	delete mRootKinkTexture;
+}
+
+void TestScene::setCut( float aLeftCut, float aRightCut )
+{
+	// Texture is stored in the same format as in frame file
+	const unsigned __int32 header[ 3 ] = { 4, 1, 1 };
+	const float texels[ 4 ] = { aLeftCut, aLeftCut, aRightCut, aRightCut };
+	std::stringstream texture;
+	texture.write( reinterpret_cast< const char * >( header ), sizeof( header ) );
+	texture.write( reinterpret_cast< const char * >( texels ), sizeof( texels ) );
+	delete mCutTexture;
+	mCutTexture = 0;
+	mCutTexture = new Texture( texture );
+}
+
+void TestScene::setVaryingTextures( unsigned __int32 aSeed )
+{
+	RandomGenerator random;
+	random.reset( static_cast< __int32 >( aSeed % 31328 ), 9373 );
+	delete mScaleTexture;
+	mScaleTexture = 0;
+	mScaleTexture = createTexture( VARYING_TEXTURE_RESOLUTION, VARYING_TEXTURE_RESOLUTION, 1, random );
+	delete mTipThicknessTexture;
+	mTipThicknessTexture = 0;
+	mTipThicknessTexture = createTexture( 5, 9, 1, random );
+	delete mRootColorTexture;
+	mRootColorTexture = 0;
+	mRootColorTexture = createTexture( VARYING_TEXTURE_RESOLUTION, VARYING_TEXTURE_RESOLUTION, 3, random );
+	delete mMutantHairColorTexture;
+	mMutantHairColorTexture = 0;
+	mMutantHairColorTexture = createTexture( VARYING_TEXTURE_RESOLUTION, VARYING_TEXTURE_RESOLUTION, 1, random );
+	delete mRootFrizzTexture;
+	mRootFrizzTexture = 0;
+	mRootFrizzTexture = createTexture( VARYING_TEXTURE_RESOLUTION, VARYING_TEXTURE_RESOLUTION, 3, random );
+	updateAttributeAtlas();
+}
+
+void TestScene::setColors( const Real * aRootColor, const Real * aTipColor )
+{
+	delete mRootColorTexture;
+	mRootColorTexture = 0;
+	mRootColorTexture = new Texture( 1, 1, 1 );
+	delete mTipColorTexture;
+	mTipColorTexture = 0;
+	mTipColorTexture = new Texture( 1, 1, 1 );
+	for ( unsigned __int32 i = 0; i < 3; ++i )
+	{
+		mRootColor[ i ] = aRootColor[ i ];
+		mTipColor[ i ] = aTipColor[ i ];
+	}
+	mHueVariation = 0;
+	mValueVariation = 0;
+	mPercentMutantHair = 0;
+	updateAttributeAtlas();
+}
+
+void TestScene::exportFrameToFile( const std::string & aFileName ) const
+{
+	// Sections are written in the same way as by MayaHairProperties::exportToFile
+	SectionedFileWriter frameFile( SECTIONED_FRAME_FILE_ID, 1 );
+	// Export textures ( uncompressed, so the renderer can use them in place )
+	std::ostream & textures = frameFile.beginSection( TEXTURES_SECTION, false );
+	mDensityTexture->exportAlignedToFile( textures );
+	mInterpolationGroupsTexture->exportAlignedToFile( textures );
+	mCutTexture->exportAlignedToFile( textures );
+	mScaleTexture->exportAlignedToFile( textures );
+	mRandScaleTexture->exportAlignedToFile( textures );
+	mRootThicknessTexture->exportAlignedToFile( textures );
+	mTipThicknessTexture->exportAlignedToFile( textures );
+	mDisplacementTexture->exportAlignedToFile( textures );
+	mRootOpacityTexture->exportAlignedToFile( textures );
+	mTipOpacityTexture->exportAlignedToFile( textures );
+	mRootColorTexture->exportAlignedToFile( textures );
+	mTipColorTexture->exportAlignedToFile( textures );
+	mHueVariationTexture->exportAlignedToFile( textures );
+	mValueVariationTexture->exportAlignedToFile( textures );
+	mMutantHairColorTexture->exportAlignedToFile( textures );
+	mPercentMutantHairTexture->exportAlignedToFile( textures );
+	mRootFrizzTexture->exportAlignedToFile( textures );
+	mTipFrizzTexture->exportAlignedToFile( textures );
+	mFrizzXFrequencyTexture->exportAlignedToFile( textures );
+	mFrizzYFrequencyTexture->exportAlignedToFile( textures );
+	mFrizzZFrequencyTexture->exportAlignedToFile( textures );
+	mFrizzAnimTexture->exportAlignedToFile( textures );
+	mFrizzAnimSpeedTexture->exportAlignedToFile( textures );
+	mRootKinkTexture->exportAlignedToFile( textures );
+	mTipKinkTexture->exportAlignedToFile( textures );
+	mKinkXFrequencyTexture->exportAlignedToFile( textures );
+	mKinkYFrequencyTexture->exportAlignedToFile( textures );
+	mKinkZFrequencyTexture->exportAlignedToFile( textures );
+	mRootSplayTexture->exportAlignedToFile( textures );
+	mTipSplayTexture->exportAlignedToFile( textures );
+	mCenterSplayTexture->exportAlignedToFile( textures );
+	mTwistTexture->exportAlignedToFile( textures );
+	mOffsetTexture->exportAlignedToFile( textures );
+	mAspectTexture->exportAlignedToFile( textures );
+	mRandomizeStrandTexture->exportAlignedToFile( textures );
+	frameFile.endSection();
+	// Write segments count
+	mInterpolationGroups->exportSegmentsCountToFile( frameFile.beginSection( INTERPOLATION_GROUPS_SECTION, true ) );
+	frameFile.endSection();
+	// Write non-texture hair properties
+	std::ostream & properties = frameFile.beginSection( SCALAR_PROPERTIES_SECTION, true );
+	properties.write( reinterpret_cast< const char * >( & SCALAR_PROPERTIES_VERSION ), sizeof( unsigned __int32 ) );
+	properties.write( reinterpret_cast< const char * >( & mCurrentTime ), sizeof( Time ) );	
+	properties.write( reinterpret_cast< const char * >( & mScale ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mRandScale ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mRootThickness ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mTipThickness ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mDisplacement ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mSkipThreshold ), sizeof( Real ) );
+	properties.write( reinterpret_cast< const char * >( & mRootOpacity ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mTipOpacity ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( mRootColor ), 3 * sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( mTipColor ), 3 * sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mHueVariation ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mValueVariation ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( mMutantHairColor ), 3 * sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mPercentMutantHair ), sizeof( Real ) );
+	properties.write( reinterpret_cast< const char * >( & mRootFrizz ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mTipFrizz ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mFrizzXFrequency ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mFrizzYFrequency ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mFrizzZFrequency ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mFrizzAnim ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mFrizzAnimSpeed ), sizeof( Real ) );	
+	properties << mFrizzAnimDirection;
+	properties.write( reinterpret_cast< const char * >( & mRootKink ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mTipKink ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mKinkXFrequency ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mKinkYFrequency ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mKinkZFrequency ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mMultiStrandCount ), sizeof( unsigned __int32 ) );	
+	properties.write( reinterpret_cast< const char * >( & mRootSplay ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mTipSplay ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mCenterSplay ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mTwist ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mOffset ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mAspect ), sizeof( Real ) );	
+	properties.write( reinterpret_cast< const char * >( & mRandomizeStrand ), sizeof( Real ) );
+	properties.write( reinterpret_cast< const char * >( & mIsRandomCounterBased ), sizeof( bool ) );
+	properties.write( reinterpret_cast< const char * >( & mRandomSeed ), sizeof( unsigned __int32 ) );
+	properties.write( reinterpret_cast< const char * >( & mIsLevelOfDetailUsed ), sizeof( bool ) );
+	properties.write( reinterpret_cast< const char * >( & mLodFullDetailSize ), sizeof( Real ) );
+	properties.write( reinterpret_cast< const char * >( & mLodMinimumHairRatio ), sizeof( Real ) );
+	properties.write( reinterpret_cast< const char * >( & mLodMinimumSegmentsRatio ), sizeof( Real ) );
+	properties.write( reinterpret_cast< const char * >( & mDecimationTolerance ), sizeof( Real ) );
+	properties.write( reinterpret_cast< const char * >( & mIsDecimationInScreenSpace ), sizeof( bool ) );
+	properties.write( reinterpret_cast< const char * >( & mRootsOrder ), sizeof( unsigned __int32 ) );
+	properties.write( reinterpret_cast< const char * >( & mCommitSize ), sizeof( unsigned __int32 ) );
+	// Write number of guides to interpolate from
+	properties.write( reinterpret_cast< const char * >( &mNumberOfGuidesToInterpolateFrom ), 
+		sizeof( unsigned __int32 ) );
+	// Write whether the guides triangulation is used
+	properties.write( reinterpret_cast< const char * >( &mIsGuidesTriangulationUsed ), 
+		sizeof( bool ) );
+	// Write whether the normals should be calculated 
+	properties.write( reinterpret_cast< const char * >( &mAreNormalsCalculated ), 
+		sizeof( bool ) );
+	// Write limits of procedural split
+	properties.write( reinterpret_cast< const char * >( & mMaxProceduralCommitsCount ), sizeof( unsigned __int32 ) );
+	properties.write( reinterpret_cast< const char * >( & mMaxProceduralChildrenCount ), sizeof( unsigned __int32 ) );
+	frameFile.endSection();
+	// Write rest positions of guides
+	mGuidesRestPositionsDS->exportToFile( frameFile.beginSection( REST_POSITIONS_SECTION, true ) );
+	frameFile.endSection();
+	// Write already built KD trees of rest positions, so the renderer does not have to rebuild them
+	mGuidesRestPositionsDS->exportKdForestToFile( frameFile.beginSection( KD_FOREST_SECTION, true ) );
+	frameFile.endSection();
+	// Export guides segments ( uncompressed, so the renderer can copy them at once )
+	std::ostream & segments = frameFile.beginSection( GUIDES_SEGMENTS_SECTION, false );
+	// Export guides count
+	unsigned __int32 size = static_cast< unsigned __int32 >( mGuidesSegments->size() );
+	segments.write( reinterpret_cast< const char *>( &size ), sizeof( unsigned __int32 ) );
+	// Export vertices count of every guide
+	for ( HairComponents::GuidesSegments::const_iterator it = mGuidesSegments->begin(); 
+		it != mGuidesSegments->end(); ++it )
+	{
+		size = static_cast< unsigned __int32 >( it->mSegments.size() );
+		segments.write( reinterpret_cast< const char *>( &size ), sizeof( unsigned __int32 ) );
+	}
+	SectionedFileWriter::writePadding( segments, ( mGuidesSegments->size() + 1 ) * sizeof( unsigned __int32 ),
+		SectionedFileWriter::SECTION_ALIGNMENT );
+	// Export vertices of all guides as one array
+	for ( HairComponents::GuidesSegments::const_iterator it = mGuidesSegments->begin(); 
+		it != mGuidesSegments->end(); ++it )
+	{
+		if ( !it->mSegments.empty() )
+		{
+			segments.write( reinterpret_cast< const char *>( &it->mSegments[ 0 ] ), 
+				it->mSegments.size() * sizeof( Vector3D< Real > ) );
+		}
+	}
+	frameFile.endSection();
+	std::ofstream file( aFileName.c_str(), std::ios::binary );
+	frameFile.writeToFile( file );
+}
+
+void TestScene::exportVoxelToFile( const std::string & aFileName, unsigned __int64 aHairStartIndex,
+	unsigned __int64 aHairCount, bool aBakeHairRoots ) const
+{
+	// Voxel is written in the same way as by Voxelization::exportVoxel, it covers the whole mesh
+	SectionedFileWriter voxelFile( SECTIONED_VOXEL_FILE_ID, 1 );
+	std::ostream & voxelSection = voxelFile.beginSection( VOXEL_SECTION, true );
+	voxelSection.write( reinterpret_cast< const char * >( &aHairStartIndex ), sizeof( unsigned __int64 ) );
+	voxelSection.write( reinterpret_cast< const char * >( &aHairCount ), sizeof( unsigned __int64 ) );
+	mRestPoseMesh->exportMesh( voxelSection );
+	mCurrentMesh->exportMesh( voxelSection );
+	voxelSection.write( reinterpret_cast< const char * >( &aBakeHairRoots ), sizeof( bool ) );
+	if ( aBakeHairRoots )
+	{
+		exportBakedRoots( voxelSection, aHairStartIndex, aHairCount );
+	}
+	const BoundingBox box = calculateVoxelBoundingBox();
+	voxelSection << box.max();
+	voxelSection << box.min();
+	voxelFile.endSection();
+	std::ofstream file( aFileName.c_str(), std::ios::binary );
+	voxelFile.writeToFile( file );
+}
+
+BoundingBox TestScene::calculateVoxelBoundingBox() const
+{
+	const BoundingBox meshBox = mCurrentMesh->getBoundingBox();
+	const Real enlarge = calculateMaxHairReach() * 1.01;
+	const Vector3D< Real > enlargeVector( enlarge, enlarge, enlarge );
+	BoundingBox box;
+	box.expand( meshBox.max() + enlargeVector );
+	box.expand( meshBox.min() - enlargeVector );
+	return box;
+}
+
+void TestScene::exportBakedRoots( std::ostream & aOutputStream, unsigned __int64 aHairStartIndex,
+	unsigned __int64 aHairCount ) const
+{
+	using namespace Interpolation;
+	// Same roots as generated by RMPositionGenerator, closest guides of all hair are queried at once
+	RandomGenerator random;
+	if ( isRandomCounterBased() )
+	{
+		random.resetCounterBased( getRandomSeed(), RandomGenerator::HAIR_ROOTS_DOMAIN );
+	}
+	UVPointGenerator uvPointGenerator( getDensityTexture(), mRestPoseMesh->getTriangleConstIterator(), random );
+	const unsigned __int32 count = static_cast< unsigned __int32 >( aHairCount );
+	std::vector< UVPoint > orderedRoots;
+	if ( HairRootsOrder::isOrdered( *this ) && count > 0 )
+	{
+		orderedRoots.resize( count );
+		HairRootsOrder::generateRoots( *this, uvPointGenerator, *mRestPoseMesh, aHairStartIndex, count,
+			&orderedRoots[ 0 ] );
+	}
+	const unsigned __int32 queryCount = BakedHairRoot::getClosestGuidesQueryCount( *this );
+	std::vector< BakedHairRoot > roots( count );
+	std::vector< Vector3D< Real > > positions( count );
+	std::vector< unsigned __int32 > groupIds( count );
+	std::vector< unsigned __int32 > rootIndices( count );
+	std::vector< HairComponents::IdAndDistance > closestGuides( count * queryCount );
+	std::vector< unsigned __int32 > closestGuidesCounts( count );
+	unsigned __int32 queriesSize = 0;
+	for ( unsigned __int32 i = 0; i < count; ++i )
+	{
+		BakedHairRoot & root = roots[ i ];
+		root.mUVPoint = orderedRoots.empty() ? uvPointGenerator.next( aHairStartIndex + i ) : orderedRoots[ i ];
+		MeshPoint restPos = mRestPoseMesh->getMeshPoint( root.mUVPoint );
+		if ( mCutTexture->realAtUV( restPos.getUCoordinate(), restPos.getVCoordinate() ) == 0 )
+		{
+			// The hair has been cut at root, guides are not needed
+			root.mInterpolationGroupId = 0;
+			root.mGuidesCount = 0;
+			continue;
+		}
+		root.selectInterpolationGroup( *this, restPos );
+		if ( !root.selectTriangleGuides( *this, restPos ) )
+		{
+			positions[ queriesSize ] = restPos.getPosition();
+			groupIds[ queriesSize ] = root.mInterpolationGroupId;
+			rootIndices[ queriesSize ] = i;
+			++queriesSize;
+		}
+	}
+	if ( queriesSize > 0 )
+	{
+		HairComponents::ClosestGuidesQuery query;
+		mGuidesRestPositionsDS->getNClosestGuides( &positions[ 0 ], &groupIds[ 0 ], queriesSize, queryCount, query,
+			&closestGuides[ 0 ], &closestGuidesCounts[ 0 ] );
+	}
+	for ( unsigned __int32 i = 0; i < queriesSize; ++i )
+	{
+		roots[ rootIndices[ i ] ].calculateWeights( &closestGuides[ i * queryCount ], closestGuidesCounts[ i ] );
+	}
+	for ( unsigned __int32 i = 0; i < count; ++i )
+	{
+		roots[ i ].exportToFile( aOutputStream );
+	}
+}
+
+Mesh * TestScene::createMesh( const Vector3D< Real > & aOffset, Real aBending )
+{
+	// Mesh lies in xy plane, mesh point at [ x, y ] has uv coordinates [ x / size, y / size ]
+	const Real step = MESH_SIZE / MESH_RESOLUTION;
+	const Vector3D< Real > tangent( 1, 0, 0 );
+	MeshPoint grid[ MESH_RESOLUTION + 1 ][ MESH_RESOLUTION + 1 ];
+	for ( unsigned __int32 i = 0; i <= MESH_RESOLUTION; ++i )
+	{
+		for ( unsigned __int32 j = 0; j <= MESH_RESOLUTION; ++j )
+		{
+			const Real x = i * step;
+			const Real y = j * step;
+			// Mesh is bent to parabola along x axis
+			Vector3D< Real > normal( -2 * aBending * ( x - MESH_SIZE / 2 ), 0, 1 );
+			normal.normalize();
+			const Vector3D< Real > position( x, y, aBending * ( x - MESH_SIZE / 2 ) * ( x - MESH_SIZE / 2 ) );
+			grid[ i ][ j ] = MeshPoint( position + aOffset, normal, tangent, x / MESH_SIZE, y / MESH_SIZE );
+		}
+	}
+	Triangles triangles;
+	for ( unsigned __int32 i = 0; i < MESH_RESOLUTION; ++i )
+	{
+		for ( unsigned __int32 j = 0; j < MESH_RESOLUTION; ++j )
+		{
+			triangles.push_back( Triangle( grid[ i ][ j ], grid[ i + 1 ][ j ], grid[ i + 1 ][ j + 1 ] ) );
+			triangles.push_back( Triangle( grid[ i ][ j ], grid[ i + 1 ][ j + 1 ], grid[ i ][ j + 1 ] ) );
+		}
+	}
+	return new Mesh( triangles, true );
+}
+
+Texture * TestScene::createTexture( unsigned __int32 aWidth, unsigned __int32 aHeight,
+	unsigned __int32 aComponentsCount, RandomGenerator & aRandom )
+{
+	// Texture is stored in the same format as in frame file
+	const unsigned __int32 header[ 3 ] = { aWidth, aHeight, aComponentsCount };
+	std::vector< float > texels( aWidth * aHeight * aComponentsCount );
+	for ( std::vector< float >::iterator it = texels.begin(); it != texels.end(); ++it )
+	{
+		*it = static_cast< float >( aRandom.randomReal( 0.5, 1.5 ) );
+	}
+	std::stringstream texture;
+	texture.write( reinterpret_cast< const char * >( header ), sizeof( header ) );
+	texture.write( reinterpret_cast< const char * >( &texels[ 0 ] ), texels.size() * sizeof( float ) );
+	return new Texture( texture );
+}
+
+void TestScene::createGuides( unsigned __int32 aGuidesCount, unsigned __int32 aSeed, unsigned __int32 aSegmentsCount )
+{
+	RandomGenerator random;
+	random.reset( static_cast< __int32 >( aSeed % 31328 ), 9373 );
+	const __int32 trianglesCount = static_cast< __int32 >( mRestPoseMesh->getTriangleCount() );
+	mGuidesRestPositions.resize( aGuidesCount );
+	mGuidesSegmentsStorage.resize( aGuidesCount );
+	for ( unsigned __int32 i = 0; i < aGuidesCount; ++i )
+	{
+		// Random position on random triangle
+		Real u = random.uniformNumber();
+		Real v = random.uniformNumber();
+		if ( u + v > 1 )
+		{
+			u = 1 - u;
+			v = 1 - v;
+		}
+		const UVPoint uvPoint( u, v, static_cast< unsigned __int32 >( random.randomInteger( 0, trianglesCount - 1 ) ) );
+		mGuidesRestPositions[ i ].mUVPoint = uvPoint;
+		mGuidesRestPositions[ i ].mPosition = mRestPoseMesh->getMeshPoint( uvPoint );
+		// Guide grows along normal ( z axis of local space ) and curls around it
+		HairComponents::OneGuideSegments & guide = mGuidesSegmentsStorage[ i ];
+		guide.mSegmentLength = random.randomReal( 0.2, 0.4 ) * DEFAULT_SEGMENTS_COUNT / aSegmentsCount;
+		const Real curl = random.randomReal( 0.5, 1.5 );
+		const Real radius = random.randomReal( 0, 0.3 );
+		guide.mSegments.resize( aSegmentsCount + 1 );
+		for ( unsigned __int32 j = 0; j <= aSegmentsCount; ++j )
+		{
+			// Curl angle is given by position along guide, so guides differ only by sampling
+			const Real t = static_cast< Real >( j ) / aSegmentsCount;
+			guide.mSegments[ j ] = Vector3D< Real >( radius * t * cos( curl * DEFAULT_SEGMENTS_COUNT * t ),
+				radius * t * sin( curl * DEFAULT_SEGMENTS_COUNT * t ), guide.mSegmentLength * j );
+		}
+	}
+	// Interpolation mode may be selected later ( see setInterpolation ), so triangulations are always built
+	mGuidesRestPositionsDSStorage.build( mGuidesRestPositions, *mInterpolationGroups, true );
+}
+
+} // namespace Tests
+
+} // namespace Stubble
@@ -0,0 +1,319 @@
+#ifndef STUBBLE_TEST_SCENE_HPP
+#define STUBBLE_TEST_SCENE_HPP
+
+#include "HairShape/Generators/RandomGenerator.hpp"
+#include "HairShape/HairComponents/GuidePosition.hpp"
+#include "HairShape/HairComponents/RestPositionsDS.hpp"
+#include "HairShape/HairComponents/Segments.hpp"
+#include "HairShape/Interpolation/HairProperties.hpp"
+#include "HairShape/Mesh/Mesh.hpp"
+
+#include <ostream>
+#include <string>
+
+namespace Stubble
+{
+
+namespace Tests
+{
+
+///-------------------------------------------------------------------------------------------------
+/// Synthetic scene of the tests : square mesh covered by randomly placed and randomly curled guides.
+/// All textures are constant, so the hair properties are given by scalar properties only. The scene
+/// is fully determined by its guides count and seed.
+///-------------------------------------------------------------------------------------------------
+class TestScene : public HairShape::Interpolation::HairProperties
+{
+public:
+
+	///-------------------------------------------------------------------------------------------------
+	/// Constructor.
+	///
+	/// \param	aGuidesCount	Number of the guides.
+	/// \param	aSeed			The seed of guides placement and shapes.
+	/// \param	aSegmentsCount	Number of segments of guides.
+	///-------------------------------------------------------------------------------------------------
+	TestScene( unsigned __int32 aGuidesCount, unsigned __int32 aSeed = 1,
+		unsigned __int32 aSegmentsCount = DEFAULT_SEGMENTS_COUNT );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Finaliser.
+	///-------------------------------------------------------------------------------------------------
+	~TestScene();
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the rest pose mesh.
+	///
+	/// \return	The rest pose mesh.
+	///-------------------------------------------------------------------------------------------------
+	inline const HairShape::Mesh & getRestPoseMesh() const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the current mesh ( rest pose mesh moved and bent ).
+	///
+	/// \return	The current mesh.
+	///-------------------------------------------------------------------------------------------------
+	inline const HairShape::Mesh & getCurrentMesh() const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Gets the guides rest positions.
+	///
+	/// \return	The guides rest positions.
+	///-------------------------------------------------------------------------------------------------
+	inline const HairShape::HairComponents::GuidesRestPositions & getGuidesRestPositions() const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Selects random generator of hair.
+	///
+	/// \param	aIsCounterBased	true to use counter based random generator.
+	/// \param	aSeed			The seed of counter based random generator.
+	///-------------------------------------------------------------------------------------------------
+	inline void setRandomCounterBased( bool aIsCounterBased, unsigned __int32 aSeed );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Sets number of hair in one strand.
+	///
+	/// \param	aMultiStrandCount	Number of hair in one strand ( 0 if multi strands are not used ).
+	///-------------------------------------------------------------------------------------------------
+	inline void setMultiStrandCount( unsigned __int32 aMultiStrandCount );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Sets whether the normals should be calculated.
+	///
+	/// \param	aAreNormalsCalculated	true if normals should be calculated.
+	///-------------------------------------------------------------------------------------------------
+	inline void setNormalsCalculated( bool aAreNormalsCalculated );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Sets frizz and kink of hair roots and tips.
+	///
+	/// \param	aFrizz	The frizz ( 0 if frizz is not applied ).
+	/// \param	aKink	The kink ( 0 if kink is not applied ).
+	///-------------------------------------------------------------------------------------------------
+	inline void setFrizzAndKink( Real aFrizz, Real aKink );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Selects interpolation of hair from guides.
+	///
+	/// \param	aIsGuidesTriangulationUsed			true to interpolate from enclosing triangle of guides.
+	/// \param	aNumberOfGuidesToInterpolateFrom	Number of closest guides to interpolate from.
+	///-------------------------------------------------------------------------------------------------
+	inline void setInterpolation( bool aIsGuidesTriangulationUsed, unsigned __int32 aNumberOfGuidesToInterpolateFrom );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Replaces the cut texture by texture, which has different cut in left ( u < 1/3 ) and right
+	/// ( u > 2/3 ) part of mesh.
+	///
+	/// \param	aLeftCut	The cut of left part ( 0 cuts hair at root, 1 keeps whole hair ).
+	/// \param	aRightCut	The cut of right part ( 0 cuts hair at root, 1 keeps whole hair ).
+	///-------------------------------------------------------------------------------------------------
+	void setCut( float aLeftCut, float aRightCut );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Replaces scale, tip thickness, root color, mutant hair color and root frizz textures by random
+	/// varying textures. Tip thickness texture has lower resolution than others, mutant hair color
+	/// texture has single component and root frizz texture has three components.
+	///
+	/// \param	aSeed	The seed of texels.
+	///-------------------------------------------------------------------------------------------------
+	void setVaryingTextures( unsigned __int32 aSeed );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Sets root and tip colors of all hair. Color textures are replaced by white textures, hue and
+	/// value variation and mutant hair are turned off.
+	///
+	/// \param	aRootColor	The root color ( RGB ).
+	/// \param	aTipColor	The tip color ( RGB ).
+	///-------------------------------------------------------------------------------------------------
+	void setColors( const Real * aRootColor, const Real * aTipColor );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Sets maximal number of points sent to RenderMan by single commit.
+	///
+	/// \param	aCommitSize	The commit size.
+	///-------------------------------------------------------------------------------------------------
+	inline void setCommitSize( unsigned __int32 aCommitSize );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Sets decimation tolerance in world space.
+	///
+	/// \param	aDecimationTolerance	The decimation tolerance ( 0 if points are not decimated ).
+	///-------------------------------------------------------------------------------------------------
+	inline void setDecimationTolerance( Real aDecimationTolerance );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Sets limits of split of RenderMan procedurals.
+	///
+	/// \param	aMaxCommitsCount	The maximal commits count of procedural.
+	/// \param	aMaxChildrenCount	The maximal children count of procedural.
+	///-------------------------------------------------------------------------------------------------
+	inline void setProceduralSplit( unsigned __int32 aMaxCommitsCount, unsigned __int32 aMaxChildrenCount );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Selects order of hair roots in voxel.
+	///
+	/// \param	aRootsOrder	The roots order.
+	///-------------------------------------------------------------------------------------------------
+	inline void setRootsOrder( RootsOrder aRootsOrder );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Exports the scene to frame file read by the RenderMan plugin ( see RMHairProperties ).
+	///
+	/// \param	aFileName	Filename of the frame file.
+	///-------------------------------------------------------------------------------------------------
+	void exportFrameToFile( const std::string & aFileName ) const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Exports voxel covering the whole mesh to voxel file read by the RenderMan plugin ( see
+	/// RMPositionGenerator ).
+	///
+	/// \param	aFileName		Filename of the voxel file.
+	/// \param	aHairStartIndex	Index of the first hair of voxel.
+	/// \param	aHairCount		Number of hair of voxel.
+	/// \param	aBakeHairRoots	true to bake roots of hair into voxel file.
+	///-------------------------------------------------------------------------------------------------
+	void exportVoxelToFile( const std::string & aFileName, unsigned __int64 aHairStartIndex,
+		unsigned __int64 aHairCount, bool aBakeHairRoots = false ) const;
+
+	///-------------------------------------------------------------------------------------------------
+	/// Calculates bounding box of voxel covering the whole mesh : bounding box of current mesh
+	/// enlarged by maximal hair reach.
+	///
+	/// \return	The voxel bounding box.
+	///-------------------------------------------------------------------------------------------------
+	BoundingBox calculateVoxelBoundingBox() const;
+
+	static const unsigned __int32 MESH_RESOLUTION = 8;  ///< Number of mesh squares along one side
+
+	static const Real MESH_SIZE;	///< The size of mesh side in world units
+
+	static const unsigned __int32 VARYING_TEXTURE_RESOLUTION = 16; ///< Resolution of varying textures
+
+private:
+
+	///-------------------------------------------------------------------------------------------------
+	/// Creates square mesh ( two triangles in each square of grid ).
+	///
+	/// \param	aOffset		The offset of all mesh points.
+	/// \param	aBending	The bending of mesh along x axis ( 0 for flat mesh ).
+	///
+	/// \return	The mesh.
+	///-------------------------------------------------------------------------------------------------
+	static HairShape::Mesh * createMesh( const Vector3D< Real > & aOffset, Real aBending );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Creates texture with random texels.
+	///
+	/// \param	aWidth				The texture width.
+	/// \param	aHeight				The texture height.
+	/// \param	aComponentsCount	Number of color components.
+	/// \param [in,out]	aRandom	The random generator of texels.
+	///
+	/// \return	The texture.
+	///-------------------------------------------------------------------------------------------------
+	static HairShape::Texture * createTexture( unsigned __int32 aWidth, unsigned __int32 aHeight,
+		unsigned __int32 aComponentsCount, HairShape::RandomGenerator & aRandom );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Creates randomly placed and curled guides.
+	///
+	/// \param	aGuidesCount	Number of the guides.
+	/// \param	aSeed			The seed of guides placement and shapes.
+	/// \param	aSegmentsCount	Number of segments of guides.
+	///-------------------------------------------------------------------------------------------------
+	void createGuides( unsigned __int32 aGuidesCount, unsigned __int32 aSeed, unsigned __int32 aSegmentsCount );
+
+	///-------------------------------------------------------------------------------------------------
+	/// Exports baked roots of voxel covering the whole mesh.
+	///
+	/// \param [in,out]	aOutputStream	The output stream.
+	/// \param	aHairStartIndex			Index of the first hair of voxel.
+	/// \param	aHairCount				Number of hair of voxel.
+	///-------------------------------------------------------------------------------------------------
+	void exportBakedRoots( std::ostream & aOutputStream, unsigned __int64 aHairStartIndex,
+		unsigned __int64 aHairCount ) const;
+
+	HairShape::Mesh * mRestPoseMesh;	///< The rest pose mesh
+
+	HairShape::Mesh * mCurrentMesh; ///< The current mesh
+
+	HairShape::HairComponents::GuidesRestPositions mGuidesRestPositions;	///< The guides rest positions
+
+	HairShape::HairComponents::GuidesSegments mGuidesSegmentsStorage;   ///< The guides segments
+
+	HairShape::HairComponents::RestPositionsDS mGuidesRestPositionsDSStorage;   ///< The guides rest positions DS
+};
+
+// inline functions implementation
+
+inline const HairShape::Mesh & TestScene::getRestPoseMesh() const
+{
+	return *mRestPoseMesh;
+}
+
+inline const HairShape::Mesh & TestScene::getCurrentMesh() const
+{
+	return *mCurrentMesh;
+}
+
+inline const HairShape::HairComponents::GuidesRestPositions & TestScene::getGuidesRestPositions() const
+{
+	return mGuidesRestPositions;
+}
+
+inline void TestScene::setRandomCounterBased( bool aIsCounterBased, unsigned __int32 aSeed )
+{
+	mIsRandomCounterBased = aIsCounterBased;
+	mRandomSeed = aSeed;
+}
+
+inline void TestScene::setMultiStrandCount( unsigned __int32 aMultiStrandCount )
+{
+	mMultiStrandCount = aMultiStrandCount;
+}
+
+inline void TestScene::setNormalsCalculated( bool aAreNormalsCalculated )
+{
+	mAreNormalsCalculated = aAreNormalsCalculated;
+}
+
+inline void TestScene::setFrizzAndKink( Real aFrizz, Real aKink )
+{
+	mRootFrizz = mTipFrizz = aFrizz;
+	mRootKink = mTipKink = aKink;
+}
+
+inline void TestScene::setInterpolation( bool aIsGuidesTriangulationUsed,
+	unsigned __int32 aNumberOfGuidesToInterpolateFrom )
+{
+	mIsGuidesTriangulationUsed = aIsGuidesTriangulationUsed;
+	mNumberOfGuidesToInterpolateFrom = aNumberOfGuidesToInterpolateFrom;
+}
+
+inline void TestScene::setCommitSize( unsigned __int32 aCommitSize )
+{
+	mCommitSize = aCommitSize;
+}
+
+inline void TestScene::setDecimationTolerance( Real aDecimationTolerance )
+{
+	mDecimationTolerance = aDecimationTolerance;
+	mIsDecimationInScreenSpace = false;
+}
+
+inline void TestScene::setProceduralSplit( unsigned __int32 aMaxCommitsCount, unsigned __int32 aMaxChildrenCount )
+{
+	mMaxProceduralCommitsCount = aMaxCommitsCount;
+	mMaxProceduralChildrenCount = aMaxChildrenCount;
+}
+
+inline void TestScene::setRootsOrder( RootsOrder aRootsOrder )
+{
+	mRootsOrder = static_cast< unsigned __int32 >( aRootsOrder );
+}
+
+} // namespace Tests
+
+} // namespace Stubble
+
+#endif // STUBBLE_TEST_SCENE_HPP
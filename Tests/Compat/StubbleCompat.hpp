@@ -0,0 +1,50 @@
+#ifndef STUBBLE_COMPAT_HPP
+#define STUBBLE_COMPAT_HPP
+
+///-------------------------------------------------------------------------------------------------
+/// Compatibility prelude of the tests build. It is included before every translation unit, so the
+/// sources of the hair generator, written for Visual C++, can be compiled by GCC on Linux.
+///-------------------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+// Visual C++ sized integer types
+
+#define __int8 char
+#define __int16 short
+#define __int32 int
+#define __int64 long long
+
+// Visual C++ CRT functions
+
+#define __stat64 stat
+#define _stat64 stat
+
+typedef int errno_t;
+
+///-------------------------------------------------------------------------------------------------
+/// Gets copy of the environment variable value ( Visual C++ CRT function ).
+///
+/// \param [out]	aBuffer	The allocated copy of value ( NULL if variable is not set ).
+/// \param [out]	aSize	The size of copy including terminating zero.
+/// \param	aName			The variable name.
+///
+/// \return	zero on success.
+///-------------------------------------------------------------------------------------------------
+inline errno_t _dupenv_s( char ** aBuffer, size_t * aSize, const char * aName )
+{
+	const char * value = getenv( aName );
+	*aBuffer = value == 0 ? 0 : strdup( value );
+	*aSize = value == 0 ? 0 : strlen( value ) + 1;
+	return value != 0 && *aBuffer == 0 ? 1 : 0;
+}
+
+#endif // STUBBLE_COMPAT_HPP
@@ -0,0 +1,64 @@
+#ifndef STUBBLE_COMPAT_RI_H
+#define STUBBLE_COMPAT_RI_H
+
+///-------------------------------------------------------------------------------------------------
+/// The subset of RenderMan interface used by the hair generator. There is no renderer in the tests
+/// build, the calls are defined by the tests, which use them.
+///-------------------------------------------------------------------------------------------------
+
+typedef float RtFloat;
+
+typedef int RtInt;
+
+typedef char * RtString;
+
+typedef char * RtToken;
+
+typedef void * RtPointer;
+
+typedef void RtVoid;
+
+typedef RtFloat RtBasis[ 4 ][ 4 ];
+
+typedef RtFloat RtBound[ 6 ];
+
+typedef RtVoid ( * RtProcSubdivFunc )( RtPointer, RtFloat );
+
+typedef RtVoid ( * RtProcFreeFunc )( RtPointer );
+
+#define RI_NULL ( static_cast< RtToken >( 0 ) )
+
+#define RI_CATMULLROMSTEP 1
+
+extern RtBasis RiCatmullRomBasis;
+
+extern RtToken RI_CUBIC;
+
+extern RtToken RI_NONPERIODIC;
+
+extern RtToken RI_P;
+
+extern RtToken RI_CS;
+
+extern RtToken RI_OS;
+
+extern RtToken RI_N;
+
+extern RtToken RI_WIDTH;
+
+RtVoid RiAttributeBegin();
+
+RtVoid RiAttributeEnd();
+
+RtVoid RiBasis( RtBasis aUBasis, RtInt aUStep, RtBasis aVBasis, RtInt aVStep );
+
+RtVoid RiCurves( RtToken aType, RtInt aCurvesCount, RtInt * aVerticesCounts, RtToken aWrap, ... );
+
+RtVoid RiMotionBeginV( RtInt aTimesCount, RtFloat * aTimes );
+
+RtVoid RiMotionEnd();
+
+RtVoid RiProcedural( RtPointer aData, RtBound aBound, RtProcSubdivFunc aSubdivideFunction,
+	RtProcFreeFunc aFreeFunction );
+
+#endif // STUBBLE_COMPAT_RI_H
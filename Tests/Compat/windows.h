@@ -0,0 +1,208 @@
+#ifndef STUBBLE_COMPAT_WINDOWS_H
+#define STUBBLE_COMPAT_WINDOWS_H
+
+///-------------------------------------------------------------------------------------------------
+/// The subset of Win32 API used by the hair generator ( critical sections, condition variables,
+/// mapped files and performance counter ) implemented by POSIX functions.
+///-------------------------------------------------------------------------------------------------
+
+#include <fcntl.h>
+#include <map>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef void * HANDLE;
+typedef unsigned long DWORD;
+typedef int BOOL;
+
+union LARGE_INTEGER
+{
+	long long QuadPart;
+};
+
+#define INVALID_HANDLE_VALUE ( reinterpret_cast< HANDLE >( -1 ) )
+#define INFINITE 0xFFFFFFFF
+#define GENERIC_READ 0x80000000
+#define FILE_SHARE_READ 1
+#define OPEN_EXISTING 3
+#define FILE_ATTRIBUTE_NORMAL 0x80
+#define PAGE_READONLY 2
+#define FILE_MAP_READ 4
+
+// Critical sections and condition variables
+
+typedef pthread_mutex_t CRITICAL_SECTION;
+
+typedef pthread_cond_t CONDITION_VARIABLE;
+
+inline void InitializeCriticalSection( CRITICAL_SECTION * aCriticalSection )
+{
+	// Win32 critical sections are recursive
+	pthread_mutexattr_t attributes;
+	pthread_mutexattr_init( &attributes );
+	pthread_mutexattr_settype( &attributes, PTHREAD_MUTEX_RECURSIVE );
+	pthread_mutex_init( aCriticalSection, &attributes );
+	pthread_mutexattr_destroy( &attributes );
+}
+
+inline void DeleteCriticalSection( CRITICAL_SECTION * aCriticalSection )
+{
+	pthread_mutex_destroy( aCriticalSection );
+}
+
+inline void EnterCriticalSection( CRITICAL_SECTION * aCriticalSection )
+{
+	pthread_mutex_lock( aCriticalSection );
+}
+
+inline void LeaveCriticalSection( CRITICAL_SECTION * aCriticalSection )
+{
+	pthread_mutex_unlock( aCriticalSection );
+}
+
+inline void InitializeConditionVariable( CONDITION_VARIABLE * aConditionVariable )
+{
+	pthread_cond_init( aConditionVariable, 0 );
+}
+
+inline BOOL SleepConditionVariableCS( CONDITION_VARIABLE * aConditionVariable, CRITICAL_SECTION * aCriticalSection,
+	DWORD /* aMilliseconds, only INFINITE is used */ )
+{
+	return pthread_cond_wait( aConditionVariable, aCriticalSection ) == 0;
+}
+
+inline void WakeAllConditionVariable( CONDITION_VARIABLE * aConditionVariable )
+{
+	pthread_cond_broadcast( aConditionVariable );
+}
+
+// Mapped files, file and mapping handles both point to the file descriptor
+
+///-------------------------------------------------------------------------------------------------
+/// Opened file or its mapping.
+///-------------------------------------------------------------------------------------------------
+struct CompatFileHandle
+{
+	int mDescriptor;	///< The file descriptor
+
+	bool mIsMapping;	///< true if handle is handle of mapping ( descriptor is owned by file handle )
+};
+
+///-------------------------------------------------------------------------------------------------
+/// Gets the sizes of all mapped views, so they can be unmapped by their address only.
+///
+/// \return	The mapped views sizes.
+///-------------------------------------------------------------------------------------------------
+inline std::map< const void *, size_t > & compatMappedViews()
+{
+	static std::map< const void *, size_t > views;
+	return views;
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Gets the lock of the mapped views sizes.
+///
+/// \return	The lock.
+///-------------------------------------------------------------------------------------------------
+inline pthread_mutex_t & compatMappedViewsLock()
+{
+	static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+	return lock;
+}
+
+inline HANDLE CreateFileA( const char * aFileName, DWORD, DWORD, void *, DWORD, DWORD, HANDLE )
+{
+	const int descriptor = open( aFileName, O_RDONLY );
+	if ( descriptor < 0 )
+	{
+		return INVALID_HANDLE_VALUE;
+	}
+	CompatFileHandle * handle = new CompatFileHandle;
+	handle->mDescriptor = descriptor;
+	handle->mIsMapping = false;
+	return handle;
+}
+
+inline BOOL GetFileSizeEx( HANDLE aFile, LARGE_INTEGER * aFileSize )
+{
+	struct stat fileInfo;
+	if ( fstat( static_cast< CompatFileHandle * >( aFile )->mDescriptor, &fileInfo ) != 0 )
+	{
+		return 0;
+	}
+	aFileSize->QuadPart = fileInfo.st_size;
+	return 1;
+}
+
+inline HANDLE CreateFileMappingA( HANDLE aFile, void *, DWORD, DWORD, DWORD, const char * )
+{
+	CompatFileHandle * handle = new CompatFileHandle;
+	handle->mDescriptor = static_cast< CompatFileHandle * >( aFile )->mDescriptor;
+	handle->mIsMapping = true;
+	return handle;
+}
+
+inline void * MapViewOfFile( HANDLE aMapping, DWORD, DWORD, DWORD, size_t )
+{
+	// Whole file is always mapped
+	const int descriptor = static_cast< CompatFileHandle * >( aMapping )->mDescriptor;
+	struct stat fileInfo;
+	if ( fstat( descriptor, &fileInfo ) != 0 || fileInfo.st_size == 0 )
+	{
+		return 0;
+	}
+	const size_t size = static_cast< size_t >( fileInfo.st_size );
+	void * view = mmap( 0, size, PROT_READ, MAP_PRIVATE, descriptor, 0 );
+	if ( view == MAP_FAILED )
+	{
+		return 0;
+	}
+	pthread_mutex_lock( &compatMappedViewsLock() );
+	compatMappedViews()[ view ] = size;
+	pthread_mutex_unlock( &compatMappedViewsLock() );
+	return view;
+}
+
+inline BOOL UnmapViewOfFile( const void * aView )
+{
+	pthread_mutex_lock( &compatMappedViewsLock() );
+	std::map< const void *, size_t >::iterator it = compatMappedViews().find( aView );
+	const bool found = it != compatMappedViews().end();
+	size_t size = 0;
+	if ( found )
+	{
+		size = it->second;
+		compatMappedViews().erase( it );
+	}
+	pthread_mutex_unlock( &compatMappedViewsLock() );
+	return found && munmap( const_cast< void * >( aView ), size ) == 0;
+}
+
+inline BOOL CloseHandle( HANDLE aHandle )
+{
+	CompatFileHandle * handle = static_cast< CompatFileHandle * >( aHandle );
+	const bool closed = handle->mIsMapping || close( handle->mDescriptor ) == 0;
+	delete handle;
+	return closed;
+}
+
+// Performance counter ( in nanoseconds )
+
+inline BOOL QueryPerformanceFrequency( LARGE_INTEGER * aFrequency )
+{
+	aFrequency->QuadPart = 1000000000LL;
+	return 1;
+}
+
+inline BOOL QueryPerformanceCounter( LARGE_INTEGER * aCounter )
+{
+	timespec time;
+	clock_gettime( CLOCK_MONOTONIC, &time );
+	aCounter->QuadPart = static_cast< long long >( time.tv_sec ) * 1000000000LL + time.tv_nsec;
+	return 1;
+}
+
+#endif // STUBBLE_COMPAT_WINDOWS_H
@@ -0,0 +1,8 @@
+#ifndef STUBBLE_COMPAT_WINSOCK2_H
+#define STUBBLE_COMPAT_WINSOCK2_H
+
+///-------------------------------------------------------------------------------------------------
+/// Windows sockets are not used by the hair generator, timer only includes them before windows.h .
+///-------------------------------------------------------------------------------------------------
+
+#endif // STUBBLE_COMPAT_WINSOCK2_H
@@ -0,0 +1,70 @@
+#ifndef STUBBLE_COMPAT_ZIPSTREAM_HPP
+#define STUBBLE_COMPAT_ZIPSTREAM_HPP
+
+///-------------------------------------------------------------------------------------------------
+/// Reading part of zipstream library used by zipped ( version 1 ) frame and voxel files. The whole
+/// zlib stream is inflated to memory at construction, failed inflation puts stream to failed state.
+///-------------------------------------------------------------------------------------------------
+
+#include <istream>
+#include <iterator>
+#include <sstream>
+#include <string>
+
+#include <zlib.h>
+
+namespace zlib_stream
+{
+
+class zip_istream : public std::istream
+{
+public:
+
+	///-------------------------------------------------------------------------------------------------
+	/// Constructor. Inflates the rest of input stream.
+	///
+	/// \param [in,out]	aInputStream	The zipped input stream.
+	/// \param	aWindowBits				The window bits of zlib stream.
+	///-------------------------------------------------------------------------------------------------
+	zip_istream( std::istream & aInputStream, int aWindowBits = 15, size_t = 0, size_t = 0 ):
+		std::istream( 0 )
+	{
+		rdbuf( &mBuffer );
+		const std::string zipped( ( std::istreambuf_iterator< char >( aInputStream ) ),
+			std::istreambuf_iterator< char >() );
+		std::string inflated;
+		z_stream stream;
+		memset( &stream, 0, sizeof( z_stream ) );
+		if ( inflateInit2( &stream, aWindowBits ) != Z_OK )
+		{
+			setstate( std::ios::badbit );
+			return;
+		}
+		stream.next_in = reinterpret_cast< Bytef * >( const_cast< char * >( zipped.data() ) );
+		stream.avail_in = static_cast< uInt >( zipped.size() );
+		char chunk[ 64 * 1024 ];
+		int result = Z_OK;
+		while ( result == Z_OK )
+		{
+			stream.next_out = reinterpret_cast< Bytef * >( chunk );
+			stream.avail_out = sizeof( chunk );
+			result = inflate( &stream, Z_NO_FLUSH );
+			inflated.append( chunk, sizeof( chunk ) - stream.avail_out );
+		}
+		inflateEnd( &stream );
+		if ( result != Z_STREAM_END )
+		{
+			setstate( std::ios::badbit );
+			return;
+		}
+		mBuffer.str( inflated );
+	}
+
+private:
+
+	std::stringbuf mBuffer; ///< The inflated data
+};
+
+} // namespace zlib_stream
+
+#endif // STUBBLE_COMPAT_ZIPSTREAM_HPP
@@ -0,0 +1,208 @@
+///-------------------------------------------------------------------------------------------------
+/// Checks that decimated hair stays within decimation tolerance from full hair. Hair of the scene is
+/// generated with and without decimation, kept points of every decimated hair must be points of the
+/// full hair and Catmull-Rom curve through kept points ( with duplicated end points as rendered )
+/// must lie within tolerance from all points of the full hair and from middles of its segments.
+///-------------------------------------------------------------------------------------------------
+
+#include "Common/RecordingOutputGenerator.hpp"
+#include "Common/TestResult.hpp"
+#include "Common/TestScene.hpp"
+
+#include "Common/CatmullRomUtilities.hpp"
+#include "HairShape/Generators/UVPointGenerator.hpp"
+#include "HairShape/Interpolation/HairGenerator.tmpl.hpp"
+#include "HairShape/Interpolation/Maya/SimplePositionGenerator.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <vector>
+
+using namespace Stubble;
+using namespace Stubble::HairShape;
+using namespace Stubble::HairShape::Interpolation;
+using namespace Stubble::Tests;
+
+namespace
+{
+
+typedef HairGenerator< Maya::SimplePositionGenerator, RecordingOutputGenerator > TestHairGenerator;
+
+typedef Vector3D< float > Point;
+
+const unsigned __int32 HAIR_COUNT = 2000;   ///< Number of generated hair
+
+const unsigned __int32 SEGMENTS_COUNT = 30;	///< Number of segments of guides ( and hair )
+
+///-------------------------------------------------------------------------------------------------
+/// Generates hair of the scene.
+///
+/// \param	aScene						The scene.
+/// \param [in,out]	aOutputGenerator	The output generator.
+///-------------------------------------------------------------------------------------------------
+void generate( const TestScene & aScene, RecordingOutputGenerator & aOutputGenerator )
+{
+	RandomGenerator rootsRandom;
+	rootsRandom.resetCounterBased( aScene.getRandomSeed(), RandomGenerator::HAIR_ROOTS_DOMAIN );
+	UVPointGenerator uvPointGenerator( aScene.getDensityTexture(),
+		aScene.getRestPoseMesh().getTriangleConstIterator(), rootsRandom );
+	Maya::SimplePositionGenerator positionGenerator( aScene.getRestPoseMesh(), aScene.getCurrentMesh(), 
+		uvPointGenerator, HAIR_COUNT, 0 );
+	TestHairGenerator hairGenerator( positionGenerator, aOutputGenerator );
+	hairGenerator.generate( aScene );
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Gets points of recorded hair without duplicated end points.
+///
+/// \param	aOutputGenerator	The output generator.
+/// \param	aHairIndex			Index of the hair.
+/// \param	aPositionsStart		Index of the first position of hair.
+/// \param [out]	aPoints		The points of hair.
+///-------------------------------------------------------------------------------------------------
+void getHairPoints( const RecordingOutputGenerator & aOutputGenerator, size_t aHairIndex, size_t aPositionsStart,
+	std::vector< Point > & aPoints )
+{
+	const unsigned __int32 count = aOutputGenerator.mPointsCounts[ aHairIndex ];
+	aPoints.resize( count - 2 );
+	for ( unsigned __int32 i = 1; i < count - 1; ++i )
+	{
+		const float * position = &aOutputGenerator.mPositions[ aPositionsStart + 3 * i ];
+		aPoints[ i - 1 ] = Point( position[ 0 ], position[ 1 ], position[ 2 ] );
+	}
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Evaluates segment of Catmull-Rom curve with duplicated end points.
+///
+/// \param	aPoints		The points of curve.
+/// \param	aIndices	The indices of the first and the second point of segment.
+/// \param	aT			The parameter within segment.
+///
+/// \return	The point of curve.
+///-------------------------------------------------------------------------------------------------
+Point evaluateSegment( const std::vector< Point > & aPoints, const size_t aIndices[ 2 ], float aT )
+{
+	const Point controls[ 4 ] = { aPoints[ aIndices[ 0 ] == 0 ? 0 : aIndices[ 0 ] - 1 ], aPoints[ aIndices[ 0 ] ],
+		aPoints[ aIndices[ 1 ] ], aPoints[ std::min( aIndices[ 1 ] + 1, aPoints.size() - 1 ) ] };
+	Point point;
+	catmullRomEval( point, controls, aT );
+	return point;
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Measures deviation of decimated hair from full hair.
+///
+/// \param	aFull		The points of full hair.
+/// \param	aDecimated	The points of decimated hair.
+/// \param [out]	aDeviation	The maximal deviation.
+///
+/// \return	false if decimated hair contains point, which is not point of full hair.
+///-------------------------------------------------------------------------------------------------
+bool measureDeviation( const std::vector< Point > & aFull, const std::vector< Point > & aDecimated, 
+	float & aDeviation )
+{
+	// Kept points are copies of full hair points
+	std::vector< size_t > kept;
+	for ( size_t i = 0, j = 0; j < aDecimated.size(); ++i )
+	{
+		if ( i == aFull.size() )
+		{
+			return false;
+		}
+		if ( memcmp( &aFull[ i ], &aDecimated[ j ], sizeof( Point ) ) == 0 )
+		{
+			kept.push_back( i );
+			++j;
+		}
+	}
+	if ( kept.front() != 0 || kept.back() != aFull.size() - 1 )
+	{
+		return false;
+	}
+	// Full curve is sampled at its points and segment middles, decimated curve at the same parameters
+	aDeviation = 0;
+	for ( size_t k = 0; k + 1 < kept.size(); ++k )
+	{
+		const size_t span[ 2 ] = { k, k + 1 };
+		const float spanLength = static_cast< float >( kept[ k + 1 ] - kept[ k ] );
+		for ( size_t i = kept[ k ]; i < kept[ k + 1 ]; ++i )
+		{
+			const size_t segment[ 2 ] = { i, i + 1 };
+			for ( int half = 0; half < 2; ++half )
+			{
+				const Point full = evaluateSegment( aFull, segment, half * 0.5f );
+				const Point decimated = evaluateSegment( aDecimated, span, ( i - kept[ k ] + half * 0.5f ) / spanLength );
+				aDeviation = std::max( aDeviation, static_cast< float >( ( full - decimated ).size() ) );
+			}
+		}
+	}
+	return true;
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Checks decimation of the scene hair with given tolerance.
+///
+/// \param [in,out]	aScene	The scene.
+/// \param	aTolerance		The decimation tolerance.
+/// \param [in,out]	aResult	The test result.
+///-------------------------------------------------------------------------------------------------
+void checkDecimation( TestScene & aScene, float aTolerance, TestResult & aResult )
+{
+	RecordingOutputGenerator full( false );
+	RecordingOutputGenerator decimated( false );
+	aScene.setDecimationTolerance( 0 );
+	generate( aScene, full );
+	aScene.setDecimationTolerance( aTolerance );
+	generate( aScene, decimated );
+	std::ostringstream name;
+	name << "Tolerance " << aTolerance;
+	aResult.check( full.getHairCount() > 0 && full.getHairCount() == decimated.getHairCount(), 
+		name.str() + " : hair counts" );
+	float maxDeviation = 0;
+	size_t fullPointsCount = 0, decimatedPointsCount = 0, wrongHairCount = 0;
+	std::vector< Point > fullPoints, decimatedPoints;
+	for ( size_t h = 0, fullStart = 0, decimatedStart = 0; h < full.getHairCount() && h < decimated.getHairCount(); 
+		fullStart += 3 * full.mPointsCounts[ h ], decimatedStart += 3 * decimated.mPointsCounts[ h ], ++h )
+	{
+		getHairPoints( full, h, fullStart, fullPoints );
+		getHairPoints( decimated, h, decimatedStart, decimatedPoints );
+		fullPointsCount += fullPoints.size();
+		decimatedPointsCount += decimatedPoints.size();
+		float deviation;
+		if ( !measureDeviation( fullPoints, decimatedPoints, deviation ) )
+		{
+			++wrongHairCount;
+			continue;
+		}
+		maxDeviation = std::max( maxDeviation, deviation );
+	}
+	std::ostringstream counts;
+	counts << name.str() << " : kept " << decimatedPointsCount << " of " << fullPointsCount << " points";
+	aResult.check( decimatedPointsCount < fullPointsCount, counts.str() );
+	std::ostringstream wrong;
+	wrong << name.str() << " : " << wrongHairCount << " decimated hair with points not of full hair";
+	aResult.check( wrongHairCount == 0, wrong.str() );
+	// Single precision rounding of curve evaluation is allowed
+	std::ostringstream deviation;
+	deviation << name.str() << " : maximal deviation " << maxDeviation;
+	aResult.check( maxDeviation <= aTolerance * 1.001f + 1e-5f, deviation.str() );
+}
+
+} // unnamed namespace
+
+int main()
+{
+	TestResult result( "DecimationTest" );
+	TestScene scene( 50, 1, SEGMENTS_COUNT );
+	scene.setRandomCounterBased( true, 1234 );
+	const float tolerances[] = { 0.005f, 0.01f, 0.05f };
+	for ( unsigned __int32 i = 0; i < sizeof( tolerances ) / sizeof( float ); ++i )
+	{
+		checkDecimation( scene, tolerances[ i ], result );
+	}
+	scene.setFrizzAndKink( 0, 0 );
+	checkDecimation( scene, 0.01f, result );
+	return result.getExitCode();
+}
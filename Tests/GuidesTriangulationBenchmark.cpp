@@ -0,0 +1,138 @@
+///-------------------------------------------------------------------------------------------------
+/// Compares interpolation from enclosing triangle of guides triangulation with interpolation from
+/// closest guides ( kNN ). Times build of guides triangulation, selection of guides of hair roots
+/// and whole hair generation of the test scene in both modes.
+///
+/// Usage : GuidesTriangulationBenchmark [ guides count ] [ hair count ] [ closest guides count ]
+/// Defaults are 50000 guides, 1000000 hair roots ( one tenth of them is generated ) and 3 closest
+/// guides.
+///-------------------------------------------------------------------------------------------------
+
+#include "Common/RecordingOutputGenerator.hpp"
+#include "Common/TestScene.hpp"
+
+#include "Common/StubbleTimer.hpp"
+#include "HairShape/Generators/UVPointGenerator.hpp"
+#include "HairShape/HairComponents/GuidesTriangulation.hpp"
+#include "HairShape/Interpolation/BakedHairRoot.hpp"
+#include "HairShape/Interpolation/HairGenerator.tmpl.hpp"
+#include "HairShape/Interpolation/Maya/SimplePositionGenerator.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace Stubble;
+using namespace Stubble::HairShape;
+using namespace Stubble::HairShape::HairComponents;
+using namespace Stubble::HairShape::Interpolation;
+using namespace Stubble::Tests;
+
+namespace
+{
+
+typedef HairGenerator< Maya::SimplePositionGenerator, RecordingOutputGenerator > BenchmarkHairGenerator;
+
+const char * MODES_NAMES[] = { "kNN", "triangulation" };	///< Names of interpolation modes
+
+///-------------------------------------------------------------------------------------------------
+/// Times build of guides triangulation ( single interpolation group ).
+///
+/// \param	aScene	The scene.
+///-------------------------------------------------------------------------------------------------
+void benchmarkBuild( const TestScene & aScene )
+{
+	const GuidesRestPositions & restPositions = aScene.getGuidesRestPositions();
+	std::vector< Real > coordinates( 2 * restPositions.size() );
+	std::vector< GuideId > guidesIds( restPositions.size() );
+	for ( size_t i = 0; i < restPositions.size(); ++i )
+	{
+		coordinates[ 2 * i ] = restPositions[ i ].mPosition.getUCoordinate();
+		coordinates[ 2 * i + 1 ] = restPositions[ i ].mPosition.getVCoordinate();
+		guidesIds[ i ] = static_cast< GuideId >( i );
+	}
+	Timer timer;
+	timer.start();
+	GuidesTriangulation triangulation;
+	triangulation.build( &coordinates.front(), &guidesIds.front(), static_cast< unsigned __int32 >( guidesIds.size() ) );
+	timer.stop();
+	std::cout << "Triangulation build : " << timer.getElapsedTime() << " s" << std::endl;
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Times selection of guides of hair roots.
+///
+/// \param	aScene		The scene ( with selected interpolation mode ).
+/// \param	aRoots		The rest positions of hair roots.
+/// \param	aModeName	The name of interpolation mode.
+///-------------------------------------------------------------------------------------------------
+void benchmarkSelection( const TestScene & aScene, const std::vector< MeshPoint > & aRoots, const char * aModeName )
+{
+	BakedHairRoot root;
+	ClosestGuidesQuery query;
+	unsigned __int64 guidesCount = 0;
+	Timer timer;
+	timer.start();
+	for ( std::vector< MeshPoint >::const_iterator it = aRoots.begin(); it != aRoots.end(); ++it )
+	{
+		root.selectGuides( aScene, *it, query );
+		guidesCount += root.mGuidesCount;
+	}
+	timer.stop();
+	std::cout << "Guides selection ( " << aModeName << " ) : " << timer.getElapsedTime() << " s, "
+		<< timer.getElapsedTime() * 1e9 / aRoots.size() << " ns per hair, "
+		<< static_cast< double >( guidesCount ) / aRoots.size() << " guides per hair" << std::endl;
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Times hair generation.
+///
+/// \param	aScene		The scene ( with selected interpolation mode ).
+/// \param	aHairCount	Number of generated hair.
+/// \param	aModeName	The name of interpolation mode.
+///-------------------------------------------------------------------------------------------------
+void benchmarkGeneration( const TestScene & aScene, unsigned __int32 aHairCount, const char * aModeName )
+{
+	RandomGenerator random;
+	UVPointGenerator uvPointGenerator( aScene.getDensityTexture(),
+		aScene.getRestPoseMesh().getTriangleConstIterator(), random );
+	Maya::SimplePositionGenerator positionGenerator( aScene.getRestPoseMesh(), aScene.getCurrentMesh(),
+		uvPointGenerator, aHairCount, 0 );
+	RecordingOutputGenerator outputGenerator( false );
+	BenchmarkHairGenerator hairGenerator( positionGenerator, outputGenerator );
+	Timer timer;
+	timer.start();
+	hairGenerator.generate( aScene );
+	timer.stop();
+	std::cout << "Hair generation ( " << aModeName << " ) : " << timer.getElapsedTime() << " s, "
+		<< timer.getElapsedTime() * 1e9 / aHairCount << " ns per hair" << std::endl;
+}
+
+} // unnamed namespace
+
+int main( int argc, char ** argv )
+{
+	const unsigned __int32 guidesCount = argc > 1 ? static_cast< unsigned __int32 >( atoi( argv[ 1 ] ) ) : 50000;
+	const unsigned __int32 hairCount = argc > 2 ? static_cast< unsigned __int32 >( atoi( argv[ 2 ] ) ) : 1000000;
+	const unsigned __int32 n = argc > 3 ? static_cast< unsigned __int32 >( atoi( argv[ 3 ] ) ) : 3;
+	std::cout << "Guides triangulation : " << guidesCount << " guides, " << hairCount << " hair, "
+		<< n << " closest guides" << std::endl;
+	TestScene scene( guidesCount );
+	benchmarkBuild( scene );
+	// Prepare hair roots
+	RandomGenerator random;
+	UVPointGenerator uvPointGenerator( scene.getDensityTexture(),
+		scene.getRestPoseMesh().getTriangleConstIterator(), random );
+	std::vector< MeshPoint > roots( hairCount );
+	for ( std::vector< MeshPoint >::iterator it = roots.begin(); it != roots.end(); ++it )
+	{
+		*it = scene.getRestPoseMesh().getMeshPoint( uvPointGenerator.next() );
+	}
+	for ( int mode = 0; mode < 2; ++mode )
+	{
+		scene.setInterpolation( mode != 0, n );
+		benchmarkSelection( scene, roots, MODES_NAMES[ mode ] );
+		benchmarkGeneration( scene, hairCount / 10, MODES_NAMES[ mode ] );
+	}
+	return 0;
+}
@@ -0,0 +1,160 @@
+///-------------------------------------------------------------------------------------------------
+/// Pushes more than 4G points ( 2^32 ) through parallel hair generation into output generator,
+/// which only counts them, so no points are allocated. Hair start index is above 2^32 as well, so
+/// 64 bit hair indices and counter based random streams are also used. Overflow checks of counts
+/// are tested first.
+///
+/// Usage : HairCountsStressTest [ hair roots count ]
+/// Default hair roots count generates about 4.3G points ( several minutes on single core ).
+///-------------------------------------------------------------------------------------------------
+
+#include "Common/CountingOutputGenerator.hpp"
+#include "Common/TestResult.hpp"
+#include "Common/TestScene.hpp"
+
+#include "Common/CommonFunctions.hpp"
+#include "Common/StubbleException.hpp"
+#include "Common/StubbleTimer.hpp"
+#include "HairShape/Generators/UVPointGenerator.hpp"
+#include "HairShape/Interpolation/HairGenerator.tmpl.hpp"
+#include "HairShape/Interpolation/Maya/SimplePositionGenerator.hpp"
+
+#include <cstdlib>
+#include <sstream>
+
+using namespace Stubble;
+using namespace Stubble::HairShape;
+using namespace Stubble::HairShape::Interpolation;
+using namespace Stubble::Tests;
+
+namespace
+{
+
+typedef HairGenerator< Maya::SimplePositionGenerator, CountingOutputGenerator > CountingHairGenerator;
+
+const unsigned __int64 POINTS_LIMIT_32 = static_cast< unsigned __int64 >( 1 ) << 32; ///< Number of points, which does not fit into 32 bits
+
+const unsigned __int64 HAIR_START_INDEX = 5000000000ULL;	///< Index of the first hair ( above 2^32 )
+
+const unsigned __int64 DEFAULT_ROOTS_COUNT = 2100000;   ///< Default number of hair roots
+
+const unsigned __int32 SEGMENTS_COUNT = 100;	///< Number of segments of guides
+
+const unsigned __int32 MULTI_STRAND_COUNT = 20; ///< Number of hair in one strand
+
+const int THREADS_COUNT = 4;	///< Number of threads of parallel generation
+
+///-------------------------------------------------------------------------------------------------
+/// Queries if multiplication of counts throws overflow exception.
+///
+/// \param	aFirst	The first count.
+/// \param	aSecond	The second count.
+///
+/// \return	true if exception is thrown.
+///-------------------------------------------------------------------------------------------------
+bool doesMultiplicationOverflow( unsigned __int64 aFirst, unsigned __int64 aSecond )
+{
+	try
+	{
+		multiplyCounts( aFirst, aSecond );
+	}
+	catch ( const StubbleException & )
+	{
+		return true;
+	}
+	return false;
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Queries if narrowing of count throws overflow exception.
+///
+/// \param	aCount	The count.
+///
+/// \return	true if exception is thrown.
+///-------------------------------------------------------------------------------------------------
+template< typename tType >
+bool doesNarrowingOverflow( unsigned __int64 aCount )
+{
+	try
+	{
+		narrowCount< tType >( aCount );
+	}
+	catch ( const StubbleException & )
+	{
+		return true;
+	}
+	return false;
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Checks overflow checks of counts.
+///
+/// \param [in,out]	aResult	The test result.
+///-------------------------------------------------------------------------------------------------
+void checkOverflows( TestResult & aResult )
+{
+	aResult.check( multiplyCounts( POINTS_LIMIT_32, 16 ) == POINTS_LIMIT_32 * 16, "Product of counts above 2^32" );
+	aResult.check( doesMultiplicationOverflow( POINTS_LIMIT_32, POINTS_LIMIT_32 ), "Product of counts above 2^64" );
+	aResult.check( !doesNarrowingOverflow< unsigned __int32 >( POINTS_LIMIT_32 - 1 ),
+		"Narrowing of the largest 32 bit count" );
+	aResult.check( doesNarrowingOverflow< unsigned __int32 >( POINTS_LIMIT_32 ), "Narrowing of 2^32 to 32 bits" );
+	aResult.check( doesNarrowingOverflow< int >( POINTS_LIMIT_32 / 2 ), "Narrowing of 2^31 to signed 32 bits" );
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Generates hair and checks counts of generated hair and points.
+///
+/// \param	aRootsCount		Number of hair roots.
+/// \param [in,out]	aResult	The test result.
+///-------------------------------------------------------------------------------------------------
+void checkGeneration( unsigned __int64 aRootsCount, TestResult & aResult )
+{
+	// Long hair in large strands without frizz and kink, so the most of time is spent per point
+	TestScene scene( 50, 1, SEGMENTS_COUNT );
+	scene.setMultiStrandCount( MULTI_STRAND_COUNT );
+	scene.setFrizzAndKink( 0, 0 );
+	scene.setRandomCounterBased( true, 4321 );
+	RandomGenerator rootsRandom;
+	rootsRandom.resetCounterBased( scene.getRandomSeed(), RandomGenerator::HAIR_ROOTS_DOMAIN );
+	UVPointGenerator uvPointGenerator( scene.getDensityTexture(),
+		scene.getRestPoseMesh().getTriangleConstIterator(), rootsRandom );
+	Maya::SimplePositionGenerator positionGenerator( scene.getRestPoseMesh(), scene.getCurrentMesh(),
+		uvPointGenerator, aRootsCount, HAIR_START_INDEX );
+	CountingOutputGenerator outputGenerator;
+	CountingHairGenerator hairGenerator( positionGenerator, outputGenerator );
+	hairGenerator.setThreadsCount( THREADS_COUNT );
+	Timer timer;
+	timer.start();
+	hairGenerator.generateParallel( scene );
+	timer.stop();
+	std::cout << "Generated " << outputGenerator.getHairCount() << " hair with " << outputGenerator.getPointsCount()
+		<< " points in " << timer.getElapsedTime() << " s" << std::endl;
+	const unsigned __int64 expectedHairCount = aRootsCount * MULTI_STRAND_COUNT;
+	// Every hair has all guide points and duplicated end points, only degenerated points may be removed
+	const unsigned __int64 maxPointsCount = expectedHairCount * ( SEGMENTS_COUNT + 3 );
+	std::ostringstream counts;
+	counts << "Generated hair " << outputGenerator.getHairCount() << ", maximum "
+		<< outputGenerator.getMaxHairCount() << ", expected " << expectedHairCount;
+	aResult.check( outputGenerator.getHairCount() == expectedHairCount &&
+		outputGenerator.getMaxHairCount() == expectedHairCount, counts.str() );
+	std::ostringstream points;
+	points << "Generated points " << outputGenerator.getPointsCount() << ", expected at most " << maxPointsCount;
+	aResult.check( outputGenerator.getPointsCount() <= maxPointsCount &&
+		outputGenerator.getPointsCount() > maxPointsCount * 99 / 100, points.str() );
+	if ( aRootsCount == DEFAULT_ROOTS_COUNT )
+	{
+		aResult.check( outputGenerator.getPointsCount() > POINTS_LIMIT_32, "More than 2^32 points generated" );
+	}
+}
+
+} // unnamed namespace
+
+int main( int argc, char ** argv )
+{
+	const unsigned __int64 rootsCount = argc > 1 ? static_cast< unsigned __int64 >( atoll( argv[ 1 ] ) ) :
+		DEFAULT_ROOTS_COUNT;
+	TestResult result( "HairCountsStressTest" );
+	checkOverflows( result );
+	checkGeneration( rootsCount, result );
+	return result.getExitCode();
+}
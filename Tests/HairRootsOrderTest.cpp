@@ -0,0 +1,304 @@
+///-------------------------------------------------------------------------------------------------
+/// Checks ordering of hair roots along space filling curves. Morton codes must interleave bits of
+/// cell coordinates, Hilbert codes of corner square of grid must be its permutation with successive
+/// codes in neighbouring cells. Roots of voxel of the test scene ordered by every curve must be a
+/// deterministic permutation of roots in generation order with much shorter distances between
+/// consecutive roots. RenderMan plugin must generate roots in the same order for whole voxel and
+/// for its part and hair of voxel with roots baked in curve order must equal hair of voxel with
+/// roots ordered by plugin.
+///-------------------------------------------------------------------------------------------------
+
+#include "Common/RecordingOutputGenerator.hpp"
+#include "Common/TestResult.hpp"
+#include "Common/TestScene.hpp"
+
+#include "HairShape/Generators/RandomGenerator.hpp"
+#include "HairShape/Generators/UVPointGenerator.hpp"
+#include "HairShape/Interpolation/HairGenerator.tmpl.hpp"
+#include "HairShape/Interpolation/HairRootsOrder.hpp"
+#include "HairShape/Interpolation/RenderMan/RMPositionGenerator.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace Stubble;
+using namespace Stubble::HairShape;
+using namespace Stubble::HairShape::Interpolation;
+using namespace Stubble::Tests;
+
+namespace
+{
+
+typedef HairGenerator< RMPositionGenerator, RecordingOutputGenerator > TestHairGenerator;
+
+const unsigned __int32 GRID_BITS = 8;   ///< Number of bits of cell coordinates of checked grid
+
+const unsigned __int64 HAIR_START_INDEX = 700;  ///< Index of the first hair of voxel
+
+const unsigned __int32 HAIR_COUNT = 3000;   ///< Number of hair of voxel
+
+const unsigned __int32 PART_START = 1000;   ///< Index of the first hair of voxel part ( relative to voxel )
+
+const unsigned __int32 PART_COUNT = 500;	///< Number of hair of voxel part
+
+const Real MAX_DISTANCES_RATIO = 0.25;  ///< Maximal ratio of distances of ordered and generated roots
+
+///-------------------------------------------------------------------------------------------------
+/// Compares two uv points ( by triangle and uv coordinates ).
+///
+/// \param	aPoint1	The first point.
+/// \param	aPoint2	The second point.
+///
+/// \return	true if the first point is less than the second point.
+///-------------------------------------------------------------------------------------------------
+bool isLess( const UVPoint & aPoint1, const UVPoint & aPoint2 )
+{
+	if ( aPoint1.getTriangleID() != aPoint2.getTriangleID() )
+	{
+		return aPoint1.getTriangleID() < aPoint2.getTriangleID();
+	}
+	return aPoint1.getU() != aPoint2.getU() ? aPoint1.getU() < aPoint2.getU() : aPoint1.getV() < aPoint2.getV();
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Compares two uv points.
+///
+/// \param	aPoint1	The first point.
+/// \param	aPoint2	The second point.
+///
+/// \return	true if points are equal.
+///-------------------------------------------------------------------------------------------------
+bool isEqual( const UVPoint & aPoint1, const UVPoint & aPoint2 )
+{
+	return aPoint1.getTriangleID() == aPoint2.getTriangleID() && aPoint1.getU() == aPoint2.getU() &&
+		aPoint1.getV() == aPoint2.getV();
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Generates roots of voxel in order selected by scene.
+///
+/// \param	aScene			The scene.
+/// \param [out]	aRoots	The roots.
+///-------------------------------------------------------------------------------------------------
+void generateRoots( const TestScene & aScene, std::vector< UVPoint > & aRoots )
+{
+	RandomGenerator rootsRandom;
+	if ( aScene.isRandomCounterBased() )
+	{
+		rootsRandom.resetCounterBased( aScene.getRandomSeed(), RandomGenerator::HAIR_ROOTS_DOMAIN );
+	}
+	UVPointGenerator uvPointGenerator( aScene.getDensityTexture(),
+		aScene.getRestPoseMesh().getTriangleConstIterator(), rootsRandom );
+	aRoots.resize( HAIR_COUNT );
+	HairRootsOrder::generateRoots( aScene, uvPointGenerator, aScene.getRestPoseMesh(), HAIR_START_INDEX,
+		HAIR_COUNT, &aRoots[ 0 ] );
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Calculates sum of distances of consecutive roots in rest pose.
+///
+/// \param	aScene	The scene.
+/// \param	aRoots	The roots.
+///
+/// \return	The sum of distances.
+///-------------------------------------------------------------------------------------------------
+Real sumDistances( const TestScene & aScene, const std::vector< UVPoint > & aRoots )
+{
+	Real sum = 0;
+	for ( size_t i = 1; i < aRoots.size(); ++i )
+	{
+		sum += ( aScene.getRestPoseMesh().getMeshPoint( aRoots[ i ] ).getPosition() -
+			aScene.getRestPoseMesh().getMeshPoint( aRoots[ i - 1 ] ).getPosition() ).size();
+	}
+	return sum;
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Queries if RenderMan position generator generates given roots.
+///
+/// \param	aScene		The scene ( hair properties of frame ).
+/// \param	aFileName	Filename of the voxel file.
+/// \param	aRoots		The expected roots of voxel.
+/// \param	aStart		Index of the first generated root ( relative to voxel ).
+/// \param	aCount		Number of generated roots.
+///
+/// \return	true if rest positions of all generated roots are the same.
+///-------------------------------------------------------------------------------------------------
+bool isGenerated( const TestScene & aScene, const std::string & aFileName, const std::vector< UVPoint > & aRoots,
+	unsigned __int32 aStart, unsigned __int32 aCount )
+{
+	RMPositionGenerator positionGenerator( aScene, aFileName );
+	if ( aStart != 0 || aCount != HAIR_COUNT )
+	{
+		positionGenerator.restrictToPart( HAIR_START_INDEX + aStart, aCount );
+	}
+	for ( unsigned __int32 i = aStart; i < aStart + aCount; ++i )
+	{
+		MeshPoint currentPosition;
+		MeshPoint restPosition;
+		positionGenerator.generate( currentPosition, restPosition );
+		if ( !( restPosition.getPosition() == aScene.getRestPoseMesh().getMeshPoint( aRoots[ i ] ).getPosition() ) )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Generates hair of voxel file.
+///
+/// \param	aScene						The scene ( hair properties of frame ).
+/// \param	aFileName					Filename of the voxel file.
+/// \param [in,out]	aOutputGenerator	The output generator.
+///-------------------------------------------------------------------------------------------------
+void generateHair( const TestScene & aScene, const std::string & aFileName,
+	RecordingOutputGenerator & aOutputGenerator )
+{
+	RMPositionGenerator positionGenerator( aScene, aFileName );
+	TestHairGenerator hairGenerator( positionGenerator, aOutputGenerator );
+	hairGenerator.generate( aScene );
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Checks Morton and Hilbert codes.
+///
+/// \param [in,out]	aResult	The test result.
+///-------------------------------------------------------------------------------------------------
+void checkCodes( TestResult & aResult )
+{
+	// Bits of coordinates are interleaved from x in the lowest bit
+	aResult.check( HairRootsOrder::mortonCode( 0xffff, 0 ) == 0x55555555 &&
+		HairRootsOrder::mortonCode( 0, 0xffff ) == 0xaaaaaaaa && HairRootsOrder::mortonCode( 5, 3 ) == 0x1b,
+		"2D Morton code" );
+	aResult.check( HairRootsOrder::mortonCode( 0x3ff, 0, 0 ) == 0x09249249 &&
+		HairRootsOrder::mortonCode( 0, 0x3ff, 0 ) == 0x12492492 &&
+		HairRootsOrder::mortonCode( 0, 0, 0x3ff ) == 0x24924924 && HairRootsOrder::mortonCode( 1, 2, 3 ) == 0x35,
+		"3D Morton code" );
+	// Hilbert curve fills corner square of grid before leaving it
+	const unsigned __int32 size = 1u << GRID_BITS;
+	std::vector< unsigned __int32 > cells( size * size, size * size );
+	bool isInside = true;
+	for ( unsigned __int32 y = 0; y < size; ++y )
+	{
+		for ( unsigned __int32 x = 0; x < size; ++x )
+		{
+			const unsigned __int32 code = HairRootsOrder::hilbertCode( x, y );
+			if ( code < size * size )
+			{
+				cells[ code ] = y * size + x;
+			}
+			else
+			{
+				isInside = false;
+			}
+		}
+	}
+	aResult.check( isInside && std::find( cells.begin(), cells.end(), size * size ) == cells.end(),
+		"Hilbert codes of corner square are its permutation" );
+	unsigned __int32 jumpsCount = 0;
+	for ( unsigned __int32 i = 1; i < size * size; ++i )
+	{
+		const int dx = static_cast< int >( cells[ i ] % size ) - static_cast< int >( cells[ i - 1 ] % size );
+		const int dy = static_cast< int >( cells[ i ] / size ) - static_cast< int >( cells[ i - 1 ] / size );
+		jumpsCount += abs( dx ) + abs( dy ) == 1 ? 0 : 1;
+	}
+	std::ostringstream jumps;
+	jumps << "Successive Hilbert codes are in neighbouring cells ( " << jumpsCount << " jumps )";
+	aResult.check( jumpsCount == 0, jumps.str() );
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Checks roots and hair of voxel in order selected by scene.
+///
+/// \param	aScene			The scene.
+/// \param	aDirectory		The directory of voxel files.
+/// \param	aName			The name of scene configuration.
+/// \param [in,out]	aResult	The test result.
+///-------------------------------------------------------------------------------------------------
+void checkOrder( TestScene & aScene, const std::string & aDirectory, const std::string & aName,
+	TestResult & aResult )
+{
+	const HairProperties::RootsOrder order = aScene.getRootsOrder();
+	aScene.setRootsOrder( HairProperties::ROOTS_GENERATION_ORDER );
+	std::vector< UVPoint > generated;
+	generateRoots( aScene, generated );
+	aScene.setRootsOrder( order );
+	std::vector< UVPoint > ordered;
+	std::vector< UVPoint > orderedAgain;
+	generateRoots( aScene, ordered );
+	generateRoots( aScene, orderedAgain );
+	aResult.check( std::equal( ordered.begin(), ordered.end(), orderedAgain.begin(), isEqual ),
+		aName + " : order is deterministic" );
+	aResult.check( !std::equal( ordered.begin(), ordered.end(), generated.begin(), isEqual ),
+		aName + " : roots are reordered" );
+	std::vector< UVPoint > sortedGenerated( generated );
+	std::vector< UVPoint > sortedOrdered( ordered );
+	std::sort( sortedGenerated.begin(), sortedGenerated.end(), isLess );
+	std::sort( sortedOrdered.begin(), sortedOrdered.end(), isLess );
+	aResult.check( std::equal( sortedOrdered.begin(), sortedOrdered.end(), sortedGenerated.begin(), isEqual ),
+		aName + " : ordered roots are permutation of generated roots" );
+	const Real generatedDistances = sumDistances( aScene, generated );
+	const Real orderedDistances = sumDistances( aScene, ordered );
+	std::ostringstream distances;
+	distances << aName << " : distances of consecutive roots " << orderedDistances << ", in generation order "
+		<< generatedDistances;
+	aResult.check( orderedDistances < MAX_DISTANCES_RATIO * generatedDistances, distances.str() );
+	// Voxel files
+	const std::string unbakedFile = aDirectory + "/unbaked.VX0";
+	const std::string bakedFile = aDirectory + "/baked.VX0";
+	aScene.exportVoxelToFile( unbakedFile, HAIR_START_INDEX, HAIR_COUNT, false );
+	aScene.exportVoxelToFile( bakedFile, HAIR_START_INDEX, HAIR_COUNT, true );
+	aResult.check( isGenerated( aScene, unbakedFile, ordered, 0, HAIR_COUNT ), aName + " : roots of voxel" );
+	aResult.check( isGenerated( aScene, unbakedFile, ordered, PART_START, PART_COUNT ),
+		aName + " : roots of voxel part" );
+	aResult.check( isGenerated( aScene, bakedFile, ordered, 0, HAIR_COUNT ), aName + " : baked roots of voxel" );
+	RecordingOutputGenerator unbaked( false );
+	RecordingOutputGenerator baked( false );
+	generateHair( aScene, unbakedFile, unbaked );
+	generateHair( aScene, bakedFile, baked );
+	std::ostringstream hairCount;
+	hairCount << aName << " : hair generated ( " << unbaked.getHairCount() << " )";
+	aResult.check( unbaked.getHairCount() > 0, hairCount.str() );
+	std::string difference;
+	const bool areEqual = unbaked.compare( baked, difference );
+	aResult.check( areEqual, aName + " : hair of baked voxel : " + difference );
+	remove( unbakedFile.c_str() );
+	remove( bakedFile.c_str() );
+}
+
+} // unnamed namespace
+
+int main()
+{
+	TestResult result( "HairRootsOrderTest" );
+	checkCodes( result );
+	char directory[] = "/tmp/StubbleRootsOrderTestXXXXXX";
+	if ( mkdtemp( directory ) == 0 )
+	{
+		std::cerr << "Temporary directory can not be created !" << std::endl;
+		return 1;
+	}
+	const HairProperties::RootsOrder orders[] = { HairProperties::ROOTS_UV_MORTON_ORDER,
+		HairProperties::ROOTS_UV_HILBERT_ORDER, HairProperties::ROOTS_POSITION_MORTON_ORDER };
+	const char * orderNames[] = { "UV Morton", "UV Hilbert", "Position Morton" };
+	for ( int counterBased = 0; counterBased < 2; ++counterBased )
+	{
+		const std::string random = counterBased != 0 ? " ( counter based random )" : " ( James random )";
+		TestScene scene( 50 );
+		scene.setRandomCounterBased( counterBased != 0, 1234 );
+		for ( unsigned __int32 i = 0; i < 3; ++i )
+		{
+			scene.setRootsOrder( orders[ i ] );
+			checkOrder( scene, directory, orderNames[ i ] + random, result );
+		}
+	}
+	rmdir( directory );
+	return result.getExitCode();
+}
@@ -0,0 +1,207 @@
+///-------------------------------------------------------------------------------------------------
+/// Checks that all implementations of guides interpolation kernel ( scalar, SSE2, AVX ) agree on
+/// randomly generated guides. All implementations must return identical results and they must not
+/// differ from accumulation in hair points precision ( the implementation used before the kernel )
+/// by more than the tolerance documented in GuidesInterpolation.hpp. Finally the whole hair
+/// generation of test scene is compared for all implementations.
+///-------------------------------------------------------------------------------------------------
+
+#include "Common/RecordingOutputGenerator.hpp"
+#include "Common/TestResult.hpp"
+#include "Common/TestScene.hpp"
+
+#include "HairShape/Generators/RandomGenerator.hpp"
+#include "HairShape/Generators/UVPointGenerator.hpp"
+#include "HairShape/Interpolation/BakedHairRoot.hpp"
+#include "HairShape/Interpolation/GuidesInterpolation.hpp"
+#include "HairShape/Interpolation/HairGenerator.tmpl.hpp"
+#include "HairShape/Interpolation/Maya/SimplePositionGenerator.hpp"
+
+#include <cfloat>
+#include <cmath>
+#include <sstream>
+#include <vector>
+
+using namespace Stubble;
+using namespace Stubble::HairShape;
+using namespace Stubble::HairShape::Interpolation;
+using namespace Stubble::Tests;
+
+namespace
+{
+
+typedef HairGenerator< Maya::SimplePositionGenerator, RecordingOutputGenerator > TestHairGenerator;
+
+const unsigned __int32 CASES_COUNT = 2000;  ///< Number of random interpolation cases
+
+const unsigned __int32 MAX_VALUES_COUNT = 3 * 64;   ///< Maximal number of coordinates of one case
+
+const Real MAX_COORDINATE = 10; ///< Maximal absolute value of guide coordinate
+
+const char * INSTRUCTION_SETS_NAMES[] = { "scalar", "SSE2", "AVX" };	///< Names of instruction sets
+
+///-------------------------------------------------------------------------------------------------
+/// Random interpolation case : guides coordinates and normalized weights.
+///-------------------------------------------------------------------------------------------------
+struct InterpolationCase
+{
+	std::vector< std::vector< Real > > mGuides; ///< The guides coordinates
+
+	std::vector< const Real * > mGuidesPointers;	///< The pointers to guides coordinates
+
+	std::vector< Real > mWeights;   ///< The weights of guides
+
+	unsigned __int32 mValuesCount;  ///< Number of coordinates of every guide
+};
+
+///-------------------------------------------------------------------------------------------------
+/// Generates random interpolation case. Coordinates count is random, so all remainders of SIMD
+/// implementations are covered.
+///
+/// \param [in,out]	aRandom	The random generator.
+/// \param [out]	aCase	The generated case.
+///-------------------------------------------------------------------------------------------------
+void generateCase( RandomGenerator & aRandom, InterpolationCase & aCase )
+{
+	const unsigned __int32 guidesCount = static_cast< unsigned __int32 >(
+		aRandom.randomInteger( 1, BakedHairRoot::MAX_GUIDES_COUNT ) );
+	aCase.mValuesCount = static_cast< unsigned __int32 >( aRandom.randomInteger( 1, MAX_VALUES_COUNT ) );
+	aCase.mGuides.resize( guidesCount );
+	aCase.mGuidesPointers.resize( guidesCount );
+	aCase.mWeights.resize( guidesCount );
+	Real weightsSum = 0;
+	for ( unsigned __int32 i = 0; i < guidesCount; ++i )
+	{
+		aCase.mGuides[ i ].resize( aCase.mValuesCount );
+		for ( unsigned __int32 j = 0; j < aCase.mValuesCount; ++j )
+		{
+			aCase.mGuides[ i ][ j ] = aRandom.randomReal( -MAX_COORDINATE, MAX_COORDINATE );
+		}
+		aCase.mGuidesPointers[ i ] = &aCase.mGuides[ i ].front();
+		aCase.mWeights[ i ] = aRandom.uniformNumber();
+		weightsSum += aCase.mWeights[ i ];
+	}
+	// Weights are normalized same as weights of baked hair root
+	for ( unsigned __int32 i = 0; i < guidesCount; ++i )
+	{
+		aCase.mWeights[ i ] /= weightsSum;
+	}
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Compares all supported implementations of kernel on random cases.
+///
+/// \param [in,out]	aResult	The test result.
+///-------------------------------------------------------------------------------------------------
+void compareKernels( TestResult & aResult )
+{
+	const GuidesInterpolation::InstructionSet supported = GuidesInterpolation::getSupportedInstructionSet();
+	std::cout << "Supported instruction set : " << INSTRUCTION_SETS_NAMES[ supported ] << std::endl;
+	RandomGenerator random;
+	random.reset( 1802, 9373 );
+	InterpolationCase interpolationCase;
+	std::vector< Real > results[ GuidesInterpolation::AVX + 1 ];
+	unsigned __int32 differentCount[ GuidesInterpolation::AVX + 1 ] = { 0, 0, 0 };
+	unsigned __int32 outOfToleranceCount = 0;
+	Real maxError = 0;
+	for ( unsigned __int32 i = 0; i < CASES_COUNT; ++i )
+	{
+		generateCase( random, interpolationCase );
+		const unsigned __int32 guidesCount = static_cast< unsigned __int32 >( interpolationCase.mGuides.size() );
+		for ( int set = GuidesInterpolation::SCALAR; set <= supported; ++set )
+		{
+			GuidesInterpolation::setInstructionSet( static_cast< GuidesInterpolation::InstructionSet >( set ) );
+			// Guard values after the result detect writes out of range
+			results[ set ].assign( interpolationCase.mValuesCount + 1, -1 );
+			GuidesInterpolation::interpolate( &results[ set ].front(), &interpolationCase.mGuidesPointers.front(),
+				&interpolationCase.mWeights.front(), guidesCount, interpolationCase.mValuesCount );
+			if ( results[ set ] != results[ GuidesInterpolation::SCALAR ] )
+			{
+				++differentCount[ set ];
+			}
+		}
+		// Accumulation in hair points precision : every guide adds one rounding error of sum
+		const Real tolerance = ( guidesCount + 1 ) * FLT_EPSILON * MAX_COORDINATE;
+		for ( unsigned __int32 j = 0; j < interpolationCase.mValuesCount; ++j )
+		{
+			float sum = 0;
+			for ( unsigned __int32 k = 0; k < guidesCount; ++k )
+			{
+				sum += static_cast< float >( interpolationCase.mGuides[ k ][ j ] * interpolationCase.mWeights[ k ] );
+			}
+			const Real error = fabs( static_cast< float >( results[ GuidesInterpolation::SCALAR ][ j ] ) - sum );
+			maxError = error > maxError ? error : maxError;
+			if ( error > tolerance )
+			{
+				++outOfToleranceCount;
+			}
+		}
+	}
+	for ( int set = GuidesInterpolation::SSE2; set <= supported; ++set )
+	{
+		std::ostringstream message;
+		message << INSTRUCTION_SETS_NAMES[ set ] << " kernel differs from scalar kernel in " << differentCount[ set ]
+			<< " of " << CASES_COUNT << " cases";
+		aResult.check( differentCount[ set ] == 0, message.str() );
+	}
+	std::ostringstream message;
+	message << "Kernel differs from accumulation in hair points precision in " << outOfToleranceCount
+		<< " coordinates ( max error " << maxError << " )";
+	aResult.check( outOfToleranceCount == 0, message.str() );
+	GuidesInterpolation::setInstructionSet( supported );
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Generates hair of the test scene with selected kernel.
+///
+/// \param	aScene					The scene.
+/// \param	aInstructionSet			The instruction set of kernel.
+/// \param [in,out]	aOutputGenerator	The output generator.
+///-------------------------------------------------------------------------------------------------
+void generate( const TestScene & aScene, GuidesInterpolation::InstructionSet aInstructionSet,
+	RecordingOutputGenerator & aOutputGenerator )
+{
+	GuidesInterpolation::setInstructionSet( aInstructionSet );
+	RandomGenerator rootsRandom;
+	UVPointGenerator uvPointGenerator( aScene.getDensityTexture(),
+		aScene.getRestPoseMesh().getTriangleConstIterator(), rootsRandom );
+	Maya::SimplePositionGenerator positionGenerator( aScene.getRestPoseMesh(), aScene.getCurrentMesh(),
+		uvPointGenerator, 2000, 0 );
+	TestHairGenerator hairGenerator( positionGenerator, aOutputGenerator );
+	hairGenerator.generate( aScene );
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Compares hair generated with all supported kernels.
+///
+/// \param [in,out]	aResult	The test result.
+///-------------------------------------------------------------------------------------------------
+void compareHair( TestResult & aResult )
+{
+	const GuidesInterpolation::InstructionSet supported = GuidesInterpolation::getSupportedInstructionSet();
+	TestScene scene( 50 );
+	scene.setNormalsCalculated( true );
+	RecordingOutputGenerator scalar( true );
+	generate( scene, GuidesInterpolation::SCALAR, scalar );
+	aResult.check( scalar.getHairCount() > 0, "Hair generated" );
+	for ( int set = GuidesInterpolation::SSE2; set <= supported; ++set )
+	{
+		RecordingOutputGenerator simd( true );
+		generate( scene, static_cast< GuidesInterpolation::InstructionSet >( set ), simd );
+		std::string difference;
+		const bool areEqual = scalar.compare( simd, difference );
+		aResult.check( areEqual, std::string( "Hair generated with " ) +
+			INSTRUCTION_SETS_NAMES[ set ] + " kernel : " + difference );
+	}
+	GuidesInterpolation::setInstructionSet( supported );
+}
+
+} // unnamed namespace
+
+int main()
+{
+	TestResult result( "InterpolationKernelTest" );
+	compareKernels( result );
+	compareHair( result );
+	return result.getExitCode();
+}
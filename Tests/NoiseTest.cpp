@@ -0,0 +1,175 @@
+///-------------------------------------------------------------------------------------------------
+/// Checks the built-in gradient noise against golden values. The golden values were computed by
+/// independent double precision implementation of the hash, gradients and seed layout documented in
+/// Noise.hpp, so any change of noise ( which would change all frizzed and kinked hair ) is detected.
+/// Noise must also be zero ( 0.5 after mapping ) at lattice points, stay in <0,1> and must not
+/// depend on number of points evaluated at once.
+///-------------------------------------------------------------------------------------------------
+
+#include "Common/TestResult.hpp"
+
+#include "Common/Noise.hpp"
+#include "HairShape/Generators/RandomGenerator.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <sstream>
+#include <vector>
+
+using namespace Stubble;
+using namespace Stubble::HairShape;
+using namespace Stubble::Tests;
+
+namespace
+{
+
+///-------------------------------------------------------------------------------------------------
+/// Noise golden value.
+///-------------------------------------------------------------------------------------------------
+struct GoldenValue
+{
+	float mPoint[ 3 ];  ///< The point
+
+	float mNoise[ 3 ];  ///< The three noise components at point
+};
+
+const GoldenValue GOLDEN_VALUES[] = {
+	{ { 0.5f, 0.5f, 0.5f }, { 0.500000f, 0.437500f, 0.312500f } },
+	{ { 0.25f, 1.75f, -0.5f }, { 0.732600f, 0.625227f, 0.579900f } },
+	{ { -3.3f, 2.1f, 7.9f }, { 0.479686f, 0.399574f, 0.656070f } },
+	{ { 12.345f, -6.789f, 0.001f }, { 0.540740f, 0.386076f, 0.214588f } },
+	{ { 100.5f, 200.25f, -300.125f }, { 0.531691f, 0.455440f, 0.459452f } },
+	{ { -0.1f, -0.2f, -0.3f }, { 0.544294f, 0.597701f, 0.631119f } },
+	{ { 1.9f, 0.6f, 4.4f }, { 0.547513f, 0.577758f, 0.361204f } },
+	{ { -17.77f, 3.14f, -2.72f }, { 0.592953f, 0.355687f, 0.351668f } },
+	{ { 5.5f, 5.5f, 5.5f }, { 0.500000f, 0.500000f, 0.750000f } },
+	{ { 0.999f, 0.001f, 0.5f }, { 0.374250f, 0.250000f, 0.374750f } }
+};
+
+const unsigned __int32 GOLDEN_VALUES_COUNT = sizeof( GOLDEN_VALUES ) / sizeof( GoldenValue ); ///< Number of golden values
+
+const float TOLERANCE = 1e-5f;  ///< Tolerance of single precision evaluation
+
+const unsigned __int32 RANDOM_POINTS_COUNT = 10001;	///< Number of random points ( not multiple of batch size )
+
+///-------------------------------------------------------------------------------------------------
+/// Formats point and its noise to message.
+///
+/// \param	aMessage	The message.
+/// \param	aPoint		The point.
+/// \param	aNoise		The noise at point.
+///
+/// \return	The formatted message.
+///-------------------------------------------------------------------------------------------------
+std::string format( const char * aMessage, const float * aPoint, const float * aNoise )
+{
+	std::ostringstream message;
+	message << aMessage << " at [ " << aPoint[ 0 ] << ", " << aPoint[ 1 ] << ", " << aPoint[ 2 ] << " ] : [ "
+		<< aNoise[ 0 ] << ", " << aNoise[ 1 ] << ", " << aNoise[ 2 ] << " ]";
+	return message.str();
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Compares noise with golden values, every point is evaluated alone and all points at once.
+///
+/// \param [in,out]	aResult	The test result.
+///-------------------------------------------------------------------------------------------------
+void checkGoldenValues( TestResult & aResult )
+{
+	std::vector< float > points( 3 * GOLDEN_VALUES_COUNT ), noise( 3 * GOLDEN_VALUES_COUNT );
+	for ( unsigned __int32 i = 0; i < GOLDEN_VALUES_COUNT; ++i )
+	{
+		memcpy( &points[ 3 * i ], GOLDEN_VALUES[ i ].mPoint, sizeof( GOLDEN_VALUES[ i ].mPoint ) );
+	}
+	Noise::evaluate( &points.front(), GOLDEN_VALUES_COUNT, &noise.front() );
+	for ( unsigned __int32 i = 0; i < GOLDEN_VALUES_COUNT; ++i )
+	{
+		float single[ 3 ];
+		Noise::evaluate( GOLDEN_VALUES[ i ].mPoint, single );
+		bool isEqual = true;
+		for ( unsigned __int32 j = 0; j < 3; ++j )
+		{
+			isEqual = isEqual && fabs( single[ j ] - GOLDEN_VALUES[ i ].mNoise[ j ] ) <= TOLERANCE;
+		}
+		aResult.check( isEqual, format( "Noise differs from golden value", GOLDEN_VALUES[ i ].mPoint, single ) );
+		aResult.check( memcmp( single, &noise[ 3 * i ], sizeof( single ) ) == 0,
+			format( "Noise of batch differs from noise of single point", GOLDEN_VALUES[ i ].mPoint, single ) );
+	}
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Checks that noise is zero ( 0.5 after mapping ) at lattice points.
+///
+/// \param [in,out]	aResult	The test result.
+///-------------------------------------------------------------------------------------------------
+void checkLatticePoints( TestResult & aResult )
+{
+	unsigned __int32 failuresCount = 0;
+	for ( int x = -3; x <= 3; ++x )
+	{
+		for ( int y = -3; y <= 3; ++y )
+		{
+			for ( int z = -3; z <= 3; ++z )
+			{
+				const float point[ 3 ] = { static_cast< float >( x ), static_cast< float >( y ),
+					static_cast< float >( z ) };
+				float noise[ 3 ];
+				Noise::evaluate( point, noise );
+				if ( noise[ 0 ] != 0.5f || noise[ 1 ] != 0.5f || noise[ 2 ] != 0.5f )
+				{
+					++failuresCount;
+				}
+			}
+		}
+	}
+	std::ostringstream message;
+	message << "Noise is not zero at " << failuresCount << " lattice points";
+	aResult.check( failuresCount == 0, message.str() );
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Checks range of noise and independence of batch on random points. Points are evaluated all at
+/// once and shifted by one point, so every point is evaluated at different position in batch.
+///
+/// \param [in,out]	aResult	The test result.
+///-------------------------------------------------------------------------------------------------
+void checkRandomPoints( TestResult & aResult )
+{
+	RandomGenerator random;
+	random.reset( 42, 4242 );
+	std::vector< float > points( 3 * RANDOM_POINTS_COUNT ), noise( 3 * RANDOM_POINTS_COUNT ),
+		shiftedNoise( 3 * RANDOM_POINTS_COUNT );
+	for ( std::vector< float >::iterator it = points.begin(); it != points.end(); ++it )
+	{
+		*it = static_cast< float >( random.randomReal( -1000, 1000 ) );
+	}
+	Noise::evaluate( &points.front(), RANDOM_POINTS_COUNT, &noise.front() );
+	Noise::evaluate( &points.front() + 3, RANDOM_POINTS_COUNT - 1, &shiftedNoise.front() + 3 );
+	Noise::evaluate( &points.front(), 1, &shiftedNoise.front() );
+	unsigned __int32 outOfRangeCount = 0;
+	float min = 1, max = 0;
+	for ( std::vector< float >::const_iterator it = noise.begin(); it != noise.end(); ++it )
+	{
+		outOfRangeCount += *it < 0 || *it > 1 ? 1 : 0;
+		min = *it < min ? *it : min;
+		max = *it > max ? *it : max;
+	}
+	std::ostringstream message;
+	message << "Noise is out of <0,1> in " << outOfRangeCount << " components";
+	aResult.check( outOfRangeCount == 0, message.str() );
+	std::ostringstream spread;
+	spread << "Noise spread is too small ( " << min << ", " << max << " )";
+	aResult.check( min < 0.2f && max > 0.8f, spread.str() );
+	aResult.check( noise == shiftedNoise, "Noise depends on position of point in batch" );
+}
+
+} // unnamed namespace
+
+int main()
+{
+	TestResult result( "NoiseTest" );
+	checkGoldenValues( result );
+	checkLatticePoints( result );
+	checkRandomPoints( result );
+	return result.getExitCode();
+}
@@ -0,0 +1,103 @@
+///-------------------------------------------------------------------------------------------------
+/// Checks error path of RenderMan procedural of the hair generator plugin. Renderer fails in the
+/// middle of motion block ( RiCurves of the second motion sample throws std::bad_alloc ), procedural
+/// must catch the error and close its motion and attribute blocks in correct order, so renderer
+/// state outside of procedural is not modified.
+///-------------------------------------------------------------------------------------------------
+
+#include "Common/RiRecorder.hpp"
+#include "Common/TestResult.hpp"
+#include "Common/TestScene.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace Stubble;
+using namespace Stubble::Tests;
+
+// Procedural of the hair generator plugin ( see dllEntryPoint.cpp )
+extern "C"
+{
+RtPointer ConvertParameters( RtString aParamString );
+RtVoid Subdivide( RtPointer aData, RtFloat aDetailSize );
+RtVoid Free( RtPointer aData );
+}
+
+namespace
+{
+
+const unsigned __int64 VOXEL_HAIR_COUNT = 500;  ///< Hair count of voxel ( not split )
+
+const unsigned __int32 SAMPLES_COUNT = 2;   ///< Number of motion samples
+
+const RtFloat DETAIL_SIZE = 10000;  ///< Size of detail of voxel
+
+///-------------------------------------------------------------------------------------------------
+/// Queries if string ends with given suffix.
+///
+/// \param	aString	The string.
+/// \param	aSuffix	The suffix.
+///
+/// \return	true if string ends with suffix.
+///-------------------------------------------------------------------------------------------------
+bool endsWith( const std::string & aString, const std::string & aSuffix )
+{
+	return aString.size() >= aSuffix.size() &&
+		aString.compare( aString.size() - aSuffix.size(), aSuffix.size(), aSuffix ) == 0;
+}
+
+} // unnamed namespace
+
+int main()
+{
+	TestResult result( "ProceduralErrorTest" );
+	// Export frames and voxel, plugin joins work directory and file names by backslash
+	char directory[] = "/tmp/StubbleProceduralErrorXXXXXX";
+	if ( mkdtemp( directory ) == 0 )
+	{
+		std::cerr << "Temporary directory can not be created !" << std::endl;
+		return 1;
+	}
+	const std::string workDir = std::string( directory ) + "/work";
+	setenv( "STUBBLE_WORKDIR", workDir.c_str(), 1 );
+	TestScene scene( 50 );
+	scene.setRandomCounterBased( true, 1234 );
+	std::vector< std::string > files;
+	std::ostringstream parameters;
+	parameters << 0 << " " << SAMPLES_COUNT;
+	for ( unsigned __int32 i = 0; i < SAMPLES_COUNT; ++i )
+	{
+		std::ostringstream frame;
+		frame << workDir << "\\frame" << i;
+		files.push_back( frame.str() + ".FRM" );
+		scene.exportFrameToFile( files.back() );
+		files.push_back( frame.str() + ".VX0" );
+		scene.exportVoxelToFile( files.back(), 0, VOXEL_HAIR_COUNT );
+		parameters << " " << i << " frame" << i;
+	}
+	// The first sample of the first part is sent to renderer, the second sample fails
+	RiRecorder recorder;
+	recorder.setFailingCurvesCall( 1 );
+	RtPointer data = ConvertParameters( const_cast< RtString >( parameters.str().c_str() ) );
+	recorder.expand( data, Subdivide, Free, DETAIL_SIZE );
+	const std::string & errors = recorder.getErrors();
+	result.check( errors.find( "AttributeEnd in motion block" ) == std::string::npos, 
+		"Attribute block closed before motion block :\n" + errors );
+	result.check( errors.find( "not closed" ) == std::string::npos, "Blocks left open after error :\n" + errors );
+	const std::string closing = std::string( "MotionEnd" ) + '\0' + "AttributeEnd" + '\0';
+	result.check( endsWith( recorder.getRecord(), closing ), "Procedural ends by MotionEnd and AttributeEnd" );
+	result.check( recorder.getCurvesCount() > 0 && recorder.getCurvesCount() < SAMPLES_COUNT * VOXEL_HAIR_COUNT,
+		"Generation stopped by error" );
+	// Remove exported files
+	for ( std::vector< std::string >::const_iterator it = files.begin(); it != files.end(); ++it )
+	{
+		remove( it->c_str() );
+	}
+	rmdir( directory );
+	return result.getExitCode();
+}
@@ -0,0 +1,270 @@
+///-------------------------------------------------------------------------------------------------
+/// Expands RenderMan procedurals of the hair generator plugin concurrently, as a renderer with many
+/// threads does. Frame and voxel files of the test scene are exported to temporary directory, every
+/// voxel is expanded ( with all its child procedurals ) by recording stand-in of renderer first
+/// serially and then many times by concurrent threads. Every concurrent expansion must record the
+/// same calls with the same data as serial expansion of the voxel and all calls must be properly
+/// nested. Voxel is not split, if its frames use legacy random generator or allow more commits.
+///
+/// Usage : ProceduralStressTest [ repetitions count ]
+///-------------------------------------------------------------------------------------------------
+
+#include "Common/RiRecorder.hpp"
+#include "Common/TestResult.hpp"
+#include "Common/TestScene.hpp"
+
+#include "Common/CriticalSection.hpp"
+
+#include <pthread.h>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace Stubble;
+using namespace Stubble::Tests;
+
+// Procedural of the hair generator plugin ( see dllEntryPoint.cpp )
+extern "C"
+{
+RtPointer ConvertParameters( RtString aParamString );
+RtVoid Subdivide( RtPointer aData, RtFloat aDetailSize );
+RtVoid Free( RtPointer aData );
+}
+
+namespace
+{
+
+const unsigned __int32 VOXELS_COUNT = 8;	///< Number of voxels
+
+const unsigned __int64 VOXEL_HAIR_STEP = 1500;  ///< Difference of hair counts of two successive voxels
+
+const unsigned __int64 FIRST_VOXEL_HAIR_COUNT = 500;	///< Hair count of the first voxel ( not split )
+
+const unsigned __int32 COMMIT_SIZE = 2000;  ///< Maximal number of points of one commit ( small, so voxels are split )
+
+const unsigned __int32 SAMPLES_COUNT = 2;   ///< Number of motion samples
+
+const RtFloat DETAIL_SIZE = 10000;  ///< Size of detail of every voxel
+
+const int THREADS_COUNT = 8;	///< Number of threads expanding procedurals
+
+const unsigned __int32 DEFAULT_REPETITIONS_COUNT = 8; ///< Default number of concurrent expansions of every voxel
+
+///-------------------------------------------------------------------------------------------------
+/// Gets hair count of voxel, voxels grow from voxel generated by single procedural to voxels split
+/// recursively.
+///
+/// \param	aVoxelId	Identifier of the voxel.
+///
+/// \return	The voxel hair count.
+///-------------------------------------------------------------------------------------------------
+unsigned __int64 getVoxelHairCount( unsigned __int32 aVoxelId )
+{
+	return FIRST_VOXEL_HAIR_COUNT + aVoxelId * VOXEL_HAIR_STEP;
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Expansion of single voxel.
+///-------------------------------------------------------------------------------------------------
+struct Expansion
+{
+	std::string mRecord;	///< The record of calls
+
+	std::string mErrors;	///< The errors of calls nesting
+
+	unsigned __int64 mCurvesCount;  ///< Number of recorded curves
+
+	unsigned __int32 mProceduralsCount; ///< Number of child procedurals
+};
+
+///-------------------------------------------------------------------------------------------------
+/// Expands voxel procedural with all its children in the calling thread.
+///
+/// \param	aVoxelId			Identifier of the voxel.
+/// \param [out]	aExpansion	The expansion.
+/// \param	aFramePrefix		The prefix of names of frame files.
+///-------------------------------------------------------------------------------------------------
+void expandVoxel( unsigned __int32 aVoxelId, Expansion & aExpansion, const std::string & aFramePrefix = "frame" )
+{
+	// Same parameters as written to RIB by Stubble : voxel id, samples count and pairs of time and file
+	std::ostringstream parameters;
+	parameters << aVoxelId << " " << SAMPLES_COUNT;
+	for ( unsigned __int32 i = 0; i < SAMPLES_COUNT; ++i )
+	{
+		parameters << " " << i << " " << aFramePrefix << i;
+	}
+	RtPointer data = ConvertParameters( const_cast< RtString >( parameters.str().c_str() ) );
+	RiRecorder recorder;
+	recorder.expand( data, Subdivide, Free, DETAIL_SIZE );
+	aExpansion.mRecord = recorder.getRecord();
+	aExpansion.mErrors = recorder.getErrors();
+	aExpansion.mCurvesCount = recorder.getCurvesCount();
+	aExpansion.mProceduralsCount = recorder.getProceduralsCount();
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Concurrent expansions shared by all threads.
+///-------------------------------------------------------------------------------------------------
+struct ConcurrentExpansions
+{
+	const std::vector< Expansion > * mSerialExpansions; ///< The serial expansions of all voxels
+
+	unsigned __int32 mExpansionsCount;  ///< Number of all expansions
+
+	unsigned __int32 mNextExpansion;	///< Index of the next expansion
+
+	unsigned __int32 mDifferentCount;   ///< Number of expansions different from serial expansion
+
+	std::string mErrors;	///< The errors of calls nesting
+
+	CriticalSection mLock;  ///< Guards the next expansion and results
+};
+
+///-------------------------------------------------------------------------------------------------
+/// Thread expanding voxels : takes next expansion until all expansions are done.
+///
+/// \param [in,out]	aExpansions	The concurrent expansions.
+///
+/// \return	null.
+///-------------------------------------------------------------------------------------------------
+void * expandVoxels( void * aExpansions )
+{
+	ConcurrentExpansions & expansions = *reinterpret_cast< ConcurrentExpansions * >( aExpansions );
+	for ( ;; )
+	{
+		unsigned __int32 index;
+		{
+			ScopedLock lock( expansions.mLock );
+			if ( expansions.mNextExpansion == expansions.mExpansionsCount )
+			{
+				return 0;
+			}
+			index = expansions.mNextExpansion++;
+		}
+		// Repetitions of voxels are interleaved, so the same frames are used by many threads at once
+		const unsigned __int32 voxelId = index % VOXELS_COUNT;
+		Expansion expansion;
+		expandVoxel( voxelId, expansion );
+		ScopedLock lock( expansions.mLock );
+		if ( expansion.mRecord != ( *expansions.mSerialExpansions )[ voxelId ].mRecord )
+		{
+			++expansions.mDifferentCount;
+		}
+		expansions.mErrors += expansion.mErrors;
+	}
+}
+
+} // unnamed namespace
+
+int main( int argc, char ** argv )
+{
+	const unsigned __int32 repetitionsCount = argc > 1 ? static_cast< unsigned __int32 >( atoi( argv[ 1 ] ) ) :
+		DEFAULT_REPETITIONS_COUNT;
+	TestResult result( "ProceduralStressTest" );
+	// Export frames and voxels, plugin joins work directory and file names by backslash, which is
+	// ordinary character of file name on Linux
+	char directory[] = "/tmp/StubbleProceduralTestXXXXXX";
+	if ( mkdtemp( directory ) == 0 )
+	{
+		std::cerr << "Temporary directory can not be created !" << std::endl;
+		return 1;
+	}
+	const std::string workDir = std::string( directory ) + "/work";
+	setenv( "STUBBLE_WORKDIR", workDir.c_str(), 1 );
+	TestScene scene( 50 );
+	scene.setRandomCounterBased( true, 1234 );
+	scene.setNormalsCalculated( true );
+	scene.setCommitSize( COMMIT_SIZE );
+	std::vector< std::string > files;
+	for ( unsigned __int32 i = 0; i < SAMPLES_COUNT; ++i )
+	{
+		std::ostringstream frame;
+		frame << workDir << "\\frame" << i;
+		files.push_back( frame.str() + ".FRM" );
+		scene.exportFrameToFile( files.back() );
+		unsigned __int64 hairStartIndex = 0;
+		for ( unsigned __int32 j = 0; j < VOXELS_COUNT; ++j )
+		{
+			std::ostringstream voxel;
+			voxel << frame.str() << ".VX" << j;
+			files.push_back( voxel.str() );
+			scene.exportVoxelToFile( voxel.str(), hairStartIndex, getVoxelHairCount( j ) );
+			hairStartIndex += getVoxelHairCount( j );
+		}
+	}
+	// Serial expansions
+	std::vector< Expansion > serialExpansions( VOXELS_COUNT );
+	unsigned __int32 proceduralsCount = 0;
+	for ( unsigned __int32 i = 0; i < VOXELS_COUNT; ++i )
+	{
+		expandVoxel( i, serialExpansions[ i ] );
+		result.check( serialExpansions[ i ].mErrors.empty(), "Serial expansion calls nesting :\n" +
+			serialExpansions[ i ].mErrors );
+		std::ostringstream curves;
+		curves << "Voxel " << i << " curves " << serialExpansions[ i ].mCurvesCount << ", expected "
+			<< SAMPLES_COUNT * getVoxelHairCount( i );
+		result.check( serialExpansions[ i ].mCurvesCount == SAMPLES_COUNT * getVoxelHairCount( i ),
+			curves.str() );
+		proceduralsCount += serialExpansions[ i ].mProceduralsCount;
+	}
+	std::cout << "Serial expansion emitted " << proceduralsCount << " child procedurals" << std::endl;
+	result.check( serialExpansions.front().mProceduralsCount == 0 && proceduralsCount > VOXELS_COUNT,
+		"Large voxels split to child procedurals" );
+	// The largest voxel is not split with legacy random generator or with more commits allowed
+	const unsigned __int32 largestVoxelId = VOXELS_COUNT - 1;
+	const char * unsplitPrefixes[] = { "legacy", "unsplit" };
+	for ( unsigned __int32 k = 0; k < 2; ++k )
+	{
+		TestScene unsplitScene( 50 );
+		unsplitScene.setRandomCounterBased( k == 1, 1234 );
+		unsplitScene.setNormalsCalculated( true );
+		unsplitScene.setCommitSize( COMMIT_SIZE );
+		unsplitScene.setProceduralSplit( k == 1 ? 1000 : 4, 16 );
+		for ( unsigned __int32 i = 0; i < SAMPLES_COUNT; ++i )
+		{
+			std::ostringstream frame;
+			frame << workDir << "\\" << unsplitPrefixes[ k ] << i;
+			files.push_back( frame.str() + ".FRM" );
+			unsplitScene.exportFrameToFile( files.back() );
+			std::ostringstream voxel;
+			voxel << frame.str() << ".VX" << largestVoxelId;
+			files.push_back( voxel.str() );
+			unsplitScene.exportVoxelToFile( voxel.str(), 0, getVoxelHairCount( largestVoxelId ) );
+		}
+		Expansion expansion;
+		expandVoxel( largestVoxelId, expansion, unsplitPrefixes[ k ] );
+		result.check( expansion.mErrors.empty() && expansion.mProceduralsCount == 0 &&
+			expansion.mCurvesCount == SAMPLES_COUNT * getVoxelHairCount( largestVoxelId ), 
+			std::string( "Voxel is not split with " ) + unsplitPrefixes[ k ] + " frames" );
+	}
+	// Concurrent expansions
+	ConcurrentExpansions expansions;
+	expansions.mSerialExpansions = &serialExpansions;
+	expansions.mExpansionsCount = VOXELS_COUNT * repetitionsCount;
+	expansions.mNextExpansion = 0;
+	expansions.mDifferentCount = 0;
+	pthread_t threads[ THREADS_COUNT ];
+	for ( int i = 0; i < THREADS_COUNT; ++i )
+	{
+		pthread_create( &threads[ i ], 0, expandVoxels, &expansions );
+	}
+	for ( int i = 0; i < THREADS_COUNT; ++i )
+	{
+		pthread_join( threads[ i ], 0 );
+	}
+	std::ostringstream different;
+	different << "Concurrent expansions differ from serial expansion in " << expansions.mDifferentCount << " of "
+		<< expansions.mExpansionsCount << " cases";
+	result.check( expansions.mDifferentCount == 0, different.str() );
+	result.check( expansions.mErrors.empty(), "Concurrent expansion calls nesting :\n" + expansions.mErrors );
+	// Remove exported files
+	for ( std::vector< std::string >::const_iterator it = files.begin(); it != files.end(); ++it )
+	{
+		remove( it->c_str() );
+	}
+	rmdir( directory );
+	return result.getExitCode();
+}
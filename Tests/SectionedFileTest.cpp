@@ -0,0 +1,262 @@
+///-------------------------------------------------------------------------------------------------
+/// Checks sectioned files. Sections written by SectionedFileWriter ( uncompressed, compressed,
+/// deflated in parallel blocks and empty ) must be read back by memory mapped SectionedFileReader
+/// with the same data, uncompressed sections must be aligned. Truncated file, corrupted compressed
+/// section and file with other identifier must be rejected. Finally frame file exported from the
+/// test scene must be imported by RMHairProperties, so it generates the same hair as the scene.
+///-------------------------------------------------------------------------------------------------
+
+#include "Common/RecordingOutputGenerator.hpp"
+#include "Common/TestResult.hpp"
+#include "Common/TestScene.hpp"
+
+#include "Common/CommonConstants.hpp"
+#include "Common/SectionedFile.hpp"
+#include "Common/StubbleException.hpp"
+#include "HairShape/Generators/UVPointGenerator.hpp"
+#include "HairShape/Interpolation/HairGenerator.tmpl.hpp"
+#include "HairShape/Interpolation/Maya/SimplePositionGenerator.hpp"
+#include "HairShape/Interpolation/RenderMan/RMHairProperties.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace Stubble;
+using namespace Stubble::HairShape;
+using namespace Stubble::HairShape::Interpolation;
+using namespace Stubble::Tests;
+
+namespace
+{
+
+typedef HairGenerator< Maya::SimplePositionGenerator, RecordingOutputGenerator > TestHairGenerator;
+
+const char * TEST_FILE_ID = "STUBBLE0001TESTFILE_";   ///< Identifier of the test file
+
+const char * OTHER_FILE_ID = "STUBBLE0001OTHERFILE";  ///< Identifier of other file
+
+const unsigned __int32 SECTIONS_COUNT = 5;  ///< Number of sections of the test file
+
+const unsigned __int32 MISSING_SECTION = 100;   ///< Identifier of section, which is not written
+
+const unsigned __int32 HAIR_COUNT = 2000;   ///< Number of hair generated from frame
+
+///-------------------------------------------------------------------------------------------------
+/// Creates data of section. Data are partly repetitive, so they can be compressed.
+///
+/// \param	aSize	The size of data.
+/// \param	aSeed	The seed of data.
+///
+/// \return	The section data.
+///-------------------------------------------------------------------------------------------------
+std::string createData( size_t aSize, unsigned __int32 aSeed )
+{
+	std::string data( aSize, '\0' );
+	unsigned __int32 state = aSeed;
+	for ( size_t i = 0; i < aSize; ++i )
+	{
+		state = state * 1664525u + 1013904223u;
+		data[ i ] = static_cast< char >( ( state >> 24 ) % 16 + ( i / 1000 ) % 7 );
+	}
+	return data;
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Reads whole file.
+///
+/// \param	aFileName	Filename of the file.
+///
+/// \return	The file content.
+///-------------------------------------------------------------------------------------------------
+std::string readFile( const std::string & aFileName )
+{
+	std::ifstream file( aFileName.c_str(), std::ios::binary );
+	std::ostringstream content;
+	content << file.rdbuf();
+	return content.str();
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Writes whole file.
+///
+/// \param	aFileName	Filename of the file.
+/// \param	aContent	The file content.
+///-------------------------------------------------------------------------------------------------
+void writeFile( const std::string & aFileName, const std::string & aContent )
+{
+	std::ofstream file( aFileName.c_str(), std::ios::binary );
+	file.write( aContent.data(), aContent.size() );
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Queries if file is rejected by reader ( reader can not be created or section can not be read ).
+///
+/// \param	aFileName	Filename of the file.
+/// \param	aSectionId	Identifier of the read section.
+///
+/// \return	true if exception is thrown.
+///-------------------------------------------------------------------------------------------------
+bool isRejected( const std::string & aFileName, unsigned __int32 aSectionId )
+{
+	try
+	{
+		SectionedFileReader reader( aFileName, TEST_FILE_ID );
+		reader.getSectionData( aSectionId );
+	}
+	catch ( const StubbleException & )
+	{
+		return true;
+	}
+	return false;
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Generates hair of the test scene mesh with given hair properties.
+///
+/// \param	aScene						The scene ( meshes ).
+/// \param	aHairProperties				The hair properties.
+/// \param [in,out]	aOutputGenerator	The output generator.
+///-------------------------------------------------------------------------------------------------
+void generate( const TestScene & aScene, const HairProperties & aHairProperties,
+	RecordingOutputGenerator & aOutputGenerator )
+{
+	RandomGenerator rootsRandom;
+	if ( aHairProperties.isRandomCounterBased() )
+	{
+		rootsRandom.resetCounterBased( aHairProperties.getRandomSeed(), RandomGenerator::HAIR_ROOTS_DOMAIN );
+	}
+	UVPointGenerator uvPointGenerator( aHairProperties.getDensityTexture(),
+		aScene.getRestPoseMesh().getTriangleConstIterator(), rootsRandom );
+	Maya::SimplePositionGenerator positionGenerator( aScene.getRestPoseMesh(), aScene.getCurrentMesh(),
+		uvPointGenerator, HAIR_COUNT, 0 );
+	TestHairGenerator hairGenerator( positionGenerator, aOutputGenerator );
+	hairGenerator.generate( aHairProperties );
+}
+
+} // unnamed namespace
+
+int main()
+{
+	TestResult result( "SectionedFileTest" );
+	char directory[] = "/tmp/StubbleSectionedTestXXXXXX";
+	if ( mkdtemp( directory ) == 0 )
+	{
+		std::cerr << "Temporary directory can not be created !" << std::endl;
+		return 1;
+	}
+	const std::string testFile = std::string( directory ) + "/test.bin";
+	const std::string corruptedFile = std::string( directory ) + "/corrupted.bin";
+	const std::string frameFile = std::string( directory ) + "/frame.FRM";
+	// Sections : uncompressed of odd size, small compressed, compressed in parallel blocks, empty
+	// compressed and empty uncompressed
+	const size_t sizes[ SECTIONS_COUNT ] = { 1001, 5000, 3 * SectionedFileWriter::PARALLEL_BLOCK_SIZE + 123, 0, 0 };
+	const bool compressed[ SECTIONS_COUNT ] = { false, true, true, true, false };
+	std::vector< std::string > data( SECTIONS_COUNT );
+	SectionedFileWriter writer( TEST_FILE_ID, 6 );
+	for ( unsigned __int32 i = 0; i < SECTIONS_COUNT; ++i )
+	{
+		data[ i ] = createData( sizes[ i ], i + 1 );
+		writer.beginSection( i + 1, compressed[ i ] ).write( data[ i ].data(), data[ i ].size() );
+		writer.endSection();
+	}
+	{
+		std::ofstream file( testFile.c_str(), std::ios::binary );
+		writer.writeToFile( file );
+	}
+	const std::string content = readFile( testFile );
+	result.check( content.size() < data[ 2 ].size(), "Compressed sections are smaller" );
+	// Read sections back ( in reverse order, so sections are not read in order of file )
+	try
+	{
+		result.check( SectionedFileReader::isSectionedFile( testFile, TEST_FILE_ID ), "File is sectioned file" );
+		SectionedFileReader reader( testFile, TEST_FILE_ID );
+		for ( unsigned __int32 i = SECTIONS_COUNT; i > 0; --i )
+		{
+			std::ostringstream name;
+			name << "Section " << i;
+			result.check( reader.hasSection( i ), name.str() + " exists" );
+			result.check( reader.getSectionSize( i ) == sizes[ i - 1 ], name.str() + " size" );
+			const char * sectionData = reader.getSectionData( i );
+			result.check( memcmp( sectionData, data[ i - 1 ].data(), sizes[ i - 1 ] ) == 0, name.str() + " data" );
+			if ( !compressed[ i - 1 ] )
+			{
+				result.check( reinterpret_cast< size_t >( sectionData ) % SectionedFileWriter::SECTION_ALIGNMENT == 0,
+					name.str() + " is aligned" );
+			}
+		}
+		// Inflated section is kept by reader
+		result.check( reader.getSectionData( 2 ) == reader.getSectionData( 2 ), "Section is inflated once" );
+		result.check( !reader.hasSection( MISSING_SECTION ), "Missing section does not exist" );
+		bool isMissingRejected = false;
+		try
+		{
+			reader.getSectionData( MISSING_SECTION );
+		}
+		catch ( const StubbleException & )
+		{
+			isMissingRejected = true;
+		}
+		result.check( isMissingRejected, "Missing section rejected" );
+	}
+	catch ( const StubbleException & ex )
+	{
+		result.check( false, std::string( "Sectioned file can not be read : " ) + ex.what() );
+	}
+	// Corrupted files
+	result.check( !SectionedFileReader::isSectionedFile( testFile, OTHER_FILE_ID ), "File of other identifier" );
+	bool isOtherRejected = false;
+	try
+	{
+		SectionedFileReader reader( testFile, OTHER_FILE_ID );
+	}
+	catch ( const StubbleException & )
+	{
+		isOtherRejected = true;
+	}
+	result.check( isOtherRejected, "File of other identifier rejected" );
+	writeFile( corruptedFile, content.substr( 0, content.size() / 2 ) );
+	result.check( isRejected( corruptedFile, 1 ), "Truncated file rejected" );
+	writeFile( corruptedFile, content.substr( 0, SectionedFileWriter::FILE_ID_SIZE + 8 ) );
+	result.check( isRejected( corruptedFile, 1 ), "File with truncated section table rejected" );
+	std::string corrupted = content;
+	// Large section takes most of file
+	corrupted[ corrupted.size() * 3 / 4 ] ^= 0x55;
+	writeFile( corruptedFile, corrupted );
+	result.check( !isRejected( corruptedFile, 1 ), "Intact section of corrupted file read" );
+	result.check( isRejected( corruptedFile, 3 ), "Corrupted compressed section rejected" );
+	// Frame file
+	TestScene scene( 50 );
+	scene.setRandomCounterBased( true, 1234 );
+	scene.setNormalsCalculated( true );
+	scene.setCut( 0.2f, 0.9f );
+	scene.exportFrameToFile( frameFile );
+	try
+	{
+		RMHairProperties frame( frameFile );
+		RecordingOutputGenerator expected( true );
+		RecordingOutputGenerator imported( true );
+		generate( scene, scene, expected );
+		generate( scene, frame, imported );
+		std::ostringstream hairCount;
+		hairCount << "Frame : hair generated ( " << expected.getHairCount() << " )";
+		result.check( expected.getHairCount() > 0, hairCount.str() );
+		std::string difference;
+		const bool areEqual = expected.compare( imported, difference );
+		result.check( areEqual, "Frame : " + difference );
+	}
+	catch ( const StubbleException & ex )
+	{
+		result.check( false, std::string( "Frame file can not be read : " ) + ex.what() );
+	}
+	remove( testFile.c_str() );
+	remove( corruptedFile.c_str() );
+	remove( frameFile.c_str() );
+	rmdir( directory );
+	return result.getExitCode();
+}
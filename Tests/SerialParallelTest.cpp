@@ -0,0 +1,114 @@
+///-------------------------------------------------------------------------------------------------
+/// Checks that parallel hair generation produces exactly the same hair as serial generation, buffer
+/// by buffer, for both the F.James and the counter based random generator. Parallel generation
+/// predicts random generator state of every block, so hair cut at root, multi strands and normals
+/// are also checked.
+///-------------------------------------------------------------------------------------------------
+
+#include "Common/RecordingOutputGenerator.hpp"
+#include "Common/TestResult.hpp"
+#include "Common/TestScene.hpp"
+
+#include "HairShape/Generators/UVPointGenerator.hpp"
+#include "HairShape/Interpolation/HairGenerator.tmpl.hpp"
+#include "HairShape/Interpolation/Maya/SimplePositionGenerator.hpp"
+
+#include <sstream>
+
+using namespace Stubble;
+using namespace Stubble::HairShape;
+using namespace Stubble::HairShape::Interpolation;
+using namespace Stubble::Tests;
+
+namespace
+{
+
+typedef HairGenerator< Maya::SimplePositionGenerator, RecordingOutputGenerator > TestHairGenerator;
+
+const unsigned __int32 HAIR_COUNT = 3000;   ///< Number of generated hair ( spans several parallel rounds )
+
+const int THREADS_COUNT = 4;	///< Number of threads of parallel generation
+
+///-------------------------------------------------------------------------------------------------
+/// Generates hair of the scene in two parts, the second part continues with random generator state,
+/// in which the first part has ended ( same as procedurals split to parts ).
+///
+/// \param	aScene					The scene.
+/// \param	aIsParallel				true to generate hair in parallel.
+/// \param [in,out]	aOutputGenerator	The output generator.
+///-------------------------------------------------------------------------------------------------
+void generate( const TestScene & aScene, bool aIsParallel, RecordingOutputGenerator & aOutputGenerator )
+{
+	// Roots are generated by their own random generator ( see RMPositionGenerator )
+	RandomGenerator rootsRandom;
+	if ( aScene.isRandomCounterBased() )
+	{
+		rootsRandom.resetCounterBased( aScene.getRandomSeed(), RandomGenerator::HAIR_ROOTS_DOMAIN );
+	}
+	UVPointGenerator uvPointGenerator( aScene.getDensityTexture(),
+		aScene.getRestPoseMesh().getTriangleConstIterator(), rootsRandom );
+	const unsigned __int32 firstPartCount = HAIR_COUNT / 3;
+	Maya::SimplePositionGenerator firstPart( aScene.getRestPoseMesh(), aScene.getCurrentMesh(), uvPointGenerator,
+		firstPartCount, 0 );
+	Maya::SimplePositionGenerator secondPart( aScene.getRestPoseMesh(), aScene.getCurrentMesh(), uvPointGenerator,
+		HAIR_COUNT - firstPartCount, firstPartCount );
+	TestHairGenerator firstGenerator( firstPart, aOutputGenerator );
+	TestHairGenerator secondGenerator( secondPart, aOutputGenerator );
+	firstGenerator.setThreadsCount( THREADS_COUNT );
+	secondGenerator.setThreadsCount( THREADS_COUNT );
+	if ( aIsParallel )
+	{
+		firstGenerator.generateParallel( aScene );
+		secondGenerator.generateParallel( aScene, firstGenerator.getRandom() );
+	}
+	else
+	{
+		firstGenerator.generate( aScene );
+		secondGenerator.generate( aScene, firstGenerator.getRandom() );
+	}
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Compares serial and parallel generation of the scene.
+///
+/// \param	aScene			The scene.
+/// \param	aName			The name of scene configuration.
+/// \param [in,out]	aResult	The test result.
+///-------------------------------------------------------------------------------------------------
+void compare( const TestScene & aScene, const std::string & aName, TestResult & aResult )
+{
+	RecordingOutputGenerator serial( aScene.areNormalsCalculated() );
+	RecordingOutputGenerator parallel( aScene.areNormalsCalculated() );
+	generate( aScene, false, serial );
+	generate( aScene, true, parallel );
+	std::ostringstream hairCount;
+	hairCount << aName << " : hair generated ( " << serial.getHairCount() << " )";
+	aResult.check( serial.getHairCount() > 0, hairCount.str() );
+	// Difference is filled by comparison, so it must be done before message is composed
+	std::string difference;
+	const bool areEqual = serial.compare( parallel, difference );
+	aResult.check( areEqual, aName + " : " + difference );
+}
+
+} // unnamed namespace
+
+int main()
+{
+	TestResult result( "SerialParallelTest" );
+	for ( int counterBased = 0; counterBased < 2; ++counterBased )
+	{
+		const std::string random = counterBased != 0 ? "counter based" : "James";
+		TestScene scene( 50 );
+		scene.setRandomCounterBased( counterBased != 0, 1234 );
+		compare( scene, random + " random", result );
+		scene.setNormalsCalculated( true );
+		compare( scene, random + " random with normals", result );
+		scene.setCut( 0, 0.7f );
+		compare( scene, random + " random with cut hair", result );
+		scene.setMultiStrandCount( 5 );
+		compare( scene, random + " random with multi strands", result );
+		scene.setFrizzAndKink( 0, 0 );
+		compare( scene, random + " random without frizz and kink", result );
+	}
+	return result.getExitCode();
+}
@@ -0,0 +1,161 @@
+///-------------------------------------------------------------------------------------------------
+/// Checks that voxel files of all versions are read by the RenderMan plugin. Voxel of the test scene
+/// is written in the baseline zipped format ( 32 bit counts, no baked roots flag ), in the zipped
+/// format with baked roots flag and in the current sectioned format. All files must give the same
+/// voxel and the same hair roots, file with unknown identifier must be rejected.
+///-------------------------------------------------------------------------------------------------
+
+#include "Common/TestResult.hpp"
+#include "Common/TestScene.hpp"
+
+#include "Common/CommonConstants.hpp"
+#include "Common/StubbleException.hpp"
+#include "HairShape/Interpolation/RenderMan/RMPositionGenerator.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+
+#include <zlib.h>
+
+using namespace Stubble;
+using namespace Stubble::HairShape;
+using namespace Stubble::HairShape::Interpolation;
+using namespace Stubble::Tests;
+
+namespace
+{
+
+const unsigned __int32 HAIR_START_INDEX = 1000; ///< Index of the first hair of voxel
+
+const unsigned __int32 HAIR_COUNT = 5000;   ///< Number of hair of voxel
+
+///-------------------------------------------------------------------------------------------------
+/// Writes voxel to zipped file in the same way as zipstream library did ( zlib stream ).
+///
+/// \param	aScene				The scene.
+/// \param	aFileName			Filename of the voxel file.
+/// \param	aFileId				Identifier of the file.
+/// \param	aHasBakedRootsFlag	true to write baked roots flag ( roots are not baked ).
+///-------------------------------------------------------------------------------------------------
+void exportZippedVoxel( const TestScene & aScene, const std::string & aFileName, const char * aFileId,
+	bool aHasBakedRootsFlag )
+{
+	std::ostringstream voxel;
+	voxel.write( aFileId, VOXEL_FILE_ID_SIZE );
+	voxel.write( reinterpret_cast< const char * >( &HAIR_START_INDEX ), sizeof( unsigned __int32 ) );
+	voxel.write( reinterpret_cast< const char * >( &HAIR_COUNT ), sizeof( unsigned __int32 ) );
+	aScene.getRestPoseMesh().exportMesh( voxel );
+	aScene.getCurrentMesh().exportMesh( voxel );
+	if ( aHasBakedRootsFlag )
+	{
+		const bool areRootsBaked = false;
+		voxel.write( reinterpret_cast< const char * >( &areRootsBaked ), sizeof( bool ) );
+	}
+	const BoundingBox box = aScene.calculateVoxelBoundingBox();
+	voxel << box.max();
+	voxel << box.min();
+	const std::string data = voxel.str();
+	uLongf zippedSize = compressBound( static_cast< uLong >( data.size() ) );
+	std::string zipped( zippedSize, '\0' );
+	compress2( reinterpret_cast< Bytef * >( &zipped[ 0 ] ), &zippedSize,
+		reinterpret_cast< const Bytef * >( data.data() ), static_cast< uLong >( data.size() ), 9 );
+	std::ofstream file( aFileName.c_str(), std::ios::binary );
+	file.write( zipped.data(), zippedSize );
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Reads voxel file and records its hair count, bounding box and all hair roots.
+///
+/// \param	aScene			The scene ( hair properties of frame ).
+/// \param	aFileName		Filename of the voxel file.
+/// \param [out]	aRecord	The record of voxel.
+///-------------------------------------------------------------------------------------------------
+void recordVoxel( const TestScene & aScene, const std::string & aFileName, std::string & aRecord )
+{
+	RMPositionGenerator positionGenerator( aScene, aFileName );
+	std::ostringstream record;
+	record << positionGenerator.getHairStartIndex() << " " << positionGenerator.getHairCount() << " "
+		<< positionGenerator.getVoxelBoundingBox().min() << positionGenerator.getVoxelBoundingBox().max();
+	for ( unsigned __int64 i = 0; i < positionGenerator.getHairCount(); ++i )
+	{
+		MeshPoint currentPosition;
+		MeshPoint restPosition;
+		positionGenerator.generate( currentPosition, restPosition );
+		record << currentPosition.getPosition() << restPosition.getPosition()
+			<< restPosition.getUCoordinate() << restPosition.getVCoordinate();
+	}
+	aRecord = record.str();
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Queries if voxel file is rejected.
+///
+/// \param	aScene		The scene.
+/// \param	aFileName	Filename of the voxel file.
+///
+/// \return	true if exception is thrown.
+///-------------------------------------------------------------------------------------------------
+bool isRejected( const TestScene & aScene, const std::string & aFileName )
+{
+	try
+	{
+		RMPositionGenerator positionGenerator( aScene, aFileName );
+	}
+	catch ( const StubbleException & )
+	{
+		return true;
+	}
+	return false;
+}
+
+} // unnamed namespace
+
+int main()
+{
+	TestResult result( "VoxelFileTest" );
+	char directory[] = "/tmp/StubbleVoxelTestXXXXXX";
+	if ( mkdtemp( directory ) == 0 )
+	{
+		std::cerr << "Temporary directory can not be created !" << std::endl;
+		return 1;
+	}
+	const std::string baselineFile = std::string( directory ) + "/baseline.VX0";
+	const std::string zippedFile = std::string( directory ) + "/zipped.VX0";
+	const std::string sectionedFile = std::string( directory ) + "/sectioned.VX0";
+	const std::string unknownFile = std::string( directory ) + "/unknown.VX0";
+	TestScene scene( 50 );
+	exportZippedVoxel( scene, baselineFile, UNBAKED_VOXEL_FILE_ID, false );
+	exportZippedVoxel( scene, zippedFile, VOXEL_FILE_ID, true );
+	scene.exportVoxelToFile( sectionedFile, HAIR_START_INDEX, HAIR_COUNT );
+	exportZippedVoxel( scene, unknownFile, "STUBBLE9999VOXELFILE", true );
+	std::string sectioned;
+	recordVoxel( scene, sectionedFile, sectioned );
+	std::ostringstream expected;
+	expected << HAIR_START_INDEX << " " << HAIR_COUNT << " ";
+	result.check( sectioned.compare( 0, expected.str().size(), expected.str() ) == 0, "Sectioned voxel hair count" );
+	try
+	{
+		std::string baseline;
+		recordVoxel( scene, baselineFile, baseline );
+		result.check( baseline == sectioned, "Baseline zipped voxel differs from sectioned voxel" );
+		std::string zipped;
+		recordVoxel( scene, zippedFile, zipped );
+		result.check( zipped == sectioned, "Zipped voxel differs from sectioned voxel" );
+	}
+	catch ( const StubbleException & ex )
+	{
+		result.check( false, std::string( "Zipped voxel can not be read : " ) + ex.what() );
+	}
+	result.check( isRejected( scene, unknownFile ), "Voxel file with unknown identifier rejected" );
+	remove( baselineFile.c_str() );
+	remove( zippedFile.c_str() );
+	remove( sectionedFile.c_str() );
+	remove( unknownFile.c_str() );
+	rmdir( directory );
+	return result.getExitCode();
+}